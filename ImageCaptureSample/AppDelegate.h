@@ -9,10 +9,19 @@
 #import <OLYCameraKit/OLYCamera.h>
 #import <OLYCameraKit/OLYCameraError.h>
 
+@class CameraPropertyCache;
+@class ConnectionHealthMonitor;
+@class ConnectionManager;
+@class ContentDownloadManager;
+
 extern NSString *const kAppDelegateCameraDidChangeConnectionStateNotification;
 extern NSString *const kConnectionStateKey;
 extern NSString *const kConnectionStateConnected;
 extern NSString *const kConnectionStateDisconnected;
+extern NSString *const kAppDelegateContentDownloadDidChangeNotification;
+extern NSString *const kAppDelegateContentThumbnailDidLoadNotification;
+extern NSString *const kContentKey;
+extern NSString *const kThumbnailKey;
 
 extern NSString *ICSCameraPropertyTakemode;
 extern NSString *ICSCameraPropertyDrivemode;
@@ -31,4 +40,12 @@ extern NSString *ICSCameraPropertyRecview;
 @end
 
 extern OLYCamera *AppDelegateCamera();
-extern void AppDelegateCameraDisconnectWithPowerOff(BOOL powerOff);
\ No newline at end of file
+extern void AppDelegateCameraDisconnectWithPowerOff(BOOL powerOff);
+extern CameraPropertyCache *AppDelegateCameraPropertyCache();
+extern ConnectionManager *AppDelegateConnectionManager();
+extern ConnectionHealthMonitor *AppDelegateConnectionHealthMonitor();
+extern ContentDownloadManager *AppDelegateContentDownloadManager();
+extern void AppDelegateResetLiveViewQuality();
+extern void AppDelegateStartDownloadingContents();
+extern void AppDelegateStartBrowsingContents(void (^handler)(NSArray *contentList, NSError *error));
+extern void AppDelegateStopBrowsingContents();
\ No newline at end of file
@@ -6,12 +6,28 @@
 //
 
 #import "AppDelegate.h"
+#import "CameraLogSink.h"
+#import "CameraPropertyCache.h"
+#import "ConnectionHealthMonitor.h"
+#import "ConnectionManager.h"
+#import "ContentDownloadManager.h"
+#if DEBUG
+#import "MockCamera.h"
+#endif
 #import "Reachability.h"
+#import "Trace.h"
 
 NSString *const kAppDelegateCameraDidChangeConnectionStateNotification = @"kAppDelegateCameraDidChangeConnectionStateNotification";
 NSString *const kConnectionStateKey = @"state";
 NSString *const kConnectionStateConnected = @"connected";
 NSString *const kConnectionStateDisconnected = @"disconnected";
+NSString *const kAppDelegateContentDownloadDidChangeNotification = @"kAppDelegateContentDownloadDidChangeNotification";
+NSString *const kAppDelegateContentThumbnailDidLoadNotification = @"kAppDelegateContentThumbnailDidLoadNotification";
+NSString *const kContentKey = @"content";
+NSString *const kThumbnailKey = @"thumbnail";
+
+/** The time the app stays connected while it is inactive but not in the background. */
+static const NSTimeInterval kInactiveDisconnectDelay = 10.0;
 
 NSString *ICSCameraPropertyTakemode = @"TAKEMODE";
 NSString *ICSCameraPropertyDrivemode = @"TAKE_DRIVE";
@@ -23,12 +39,18 @@ NSString *ICSCameraPropertyIsoSensitivity = @"ISO";
 NSString *ICSCameraPropertyBatteryLevel = @"BATTERY_LEVEL";
 NSString *ICSCameraPropertyRecview = @"RECVIEW";
 
-@interface AppDelegate () <OLYCameraConnectionDelegate>
+@interface AppDelegate () <OLYCameraConnectionDelegate, ConnectionHealthMonitorDelegate, ConnectionManagerDelegate, ContentDownloadManagerDelegate>
 
 @property (strong, nonatomic) dispatch_queue_t connectionQueue;
 @property (strong, nonatomic) OLYCamera *camera;
 @property (strong, nonatomic) Reachability *reachabilityForLocalWiFi;
-@property (assign, getter = isConnecting, atomic) BOOL connecting;
+@property (strong, nonatomic) ContentDownloadManager *downloadManager;
+@property (strong, nonatomic) CameraPropertyCache *propertyCache;
+@property (strong, nonatomic) ConnectionManager *connectionManager;
+@property (strong, nonatomic) ConnectionHealthMonitor *healthMonitor;
+@property (strong, nonatomic) CameraLogSink *logSink;
+@property (assign, nonatomic) NSUInteger inactiveGeneration;
+@property (assign, nonatomic) BOOL browsingContents;
 
 @end
 
@@ -42,31 +64,138 @@ NSString *ICSCameraPropertyRecview = @"RECVIEW";
 	NSDictionary *userDefaults = @{@"live_preview_quality": NSStringFromCGSize(OLYCameraLiveViewSizeQVGA),
 								   ICSCameraPropertyTakemode: @"<TAKEMODE/iAuto>",
 								   ICSCameraPropertyDrivemode: @"<TAKE_DRIVE/DRIVE_NORMAL>",
-								   ICSCameraPropertyRecview: @"<RECVIEW/ON>"};
+								   ICSCameraPropertyRecview: @"<RECVIEW/ON>",
+								   @"interval_seconds": @5.0,
+								   @"interval_shots": @0,
+								   @"interval_exposure_ramp": @NO,
+								   @"interval_exposure_start": @0.0,
+								   @"interval_exposure_end": @0.0,
+								   @"clock_sync_ticks": @24,
+								   @"clock_sync_action": @"shutter",
+								   @"midi_actions": @[@{@"message": @"note", @"number": @60, @"action": @"shutter"},
+													  @{@"message": @"note", @"number": @62, @"action": @"movie"},
+													  @{@"message": @"note", @"number": @64, @"action": @"exposure_down"},
+													  @{@"message": @"note", @"number": @65, @"action": @"exposure_up"},
+													  @{@"message": @"note", @"number": @67, @"action": @"interval"},
+													  @{@"message": @"cc", @"number": @1, @"action": @"zoom"}],
+								   @"midi_feedback": @{@"busy": @{@"message": @"note", @"number": @72},
+													   @"recording": @{@"message": @"note", @"number": @74},
+													   @"exposure": @{@"message": @"cc", @"number": @20},
+													   @"battery": @{@"message": @"cc", @"number": @21}},
+								   @"zoom_cc_relative": @NO,
+								   @"level_capture": @NO,
+								   @"level_tolerance": @1.0,
+								   @"level_capture_timeout": @3.0,
+								   @"benchmark_shots": @0,
+								   @"benchmark_interval": @1.5};
 	[[NSUserDefaults standardUserDefaults] registerDefaults:userDefaults];
+	[self migrateUserDefaults];
+}
+
+/**
+ * Carries the settings of earlier versions over to their replacements.
+ */
++ (void)migrateUserDefaults
+{
+	NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+
+	// The zoom controller number became the zoom rule of the MIDI actions.
+	NSNumber *zoomController = [defaults objectForKey:@"zoom_cc"];
+	if (zoomController) {
+		NSDictionary *persistentDefaults = [defaults persistentDomainForName:[[NSBundle mainBundle] bundleIdentifier]];
+		if (!persistentDefaults[@"midi_actions"] && [zoomController respondsToSelector:@selector(integerValue)]) {
+			NSMutableArray *rules = [[NSMutableArray alloc] init];
+			for (NSDictionary *rule in [defaults arrayForKey:@"midi_actions"]) {
+				if ([rule[@"action"] isEqualToString:@"zoom"] && [rule[@"message"] isEqualToString:@"cc"]) {
+					NSMutableDictionary *zoomRule = [rule mutableCopy];
+					zoomRule[@"number"] = @([zoomController integerValue]);
+					[rules addObject:zoomRule];
+				} else {
+					[rules addObject:rule];
+				}
+			}
+			[defaults setObject:rules forKey:@"midi_actions"];
+		}
+		[defaults removeObjectForKey:@"zoom_cc"];
+	}
 }
 
 - (BOOL)application:(UIApplication *)application didFinishLaunchingWithOptions:(NSDictionary *)launchOptions
 {
+	// Keep the messages of the SDK in files instead of writing them to the console on the caller's thread.
+	NSURL *cachesURL = [[[NSFileManager defaultManager] URLsForDirectory:NSCachesDirectory inDomains:NSUserDomainMask] lastObject];
+	_logSink = [[CameraLogSink alloc] initWithDirectoryURL:[cachesURL URLByAppendingPathComponent:@"Logs" isDirectory:YES]];
+	[OLYCameraLog setDelegate:_logSink];
+	
+#if DEBUG
+	// Launch with "-mock_camera YES" to measure the app without a camera.
+	if ([[NSUserDefaults standardUserDefaults] boolForKey:@"mock_camera"]) {
+		_camera = [[MockCamera alloc] init];
+	} else {
+		_camera = [[OLYCamera alloc] init];
+	}
+#else
 	_camera = [[OLYCamera alloc] init];
+#endif
 	[_camera setConnectionDelegate:self];
+	_propertyCache = [[CameraPropertyCache alloc] initWithCamera:_camera];
 	
 	_connectionQueue = dispatch_queue_create([NSString stringWithFormat:@"%@.queue", [NSBundle mainBundle].bundleIdentifier].UTF8String, DISPATCH_QUEUE_SERIAL);
+	_connectionManager = [[ConnectionManager alloc] initWithCamera:_camera propertyCache:_propertyCache queue:_connectionQueue];
+	_connectionManager.restoredPropertyNames = @[ICSCameraPropertyTakemode,
+												 ICSCameraPropertyDrivemode,
+												 ICSCameraPropertyApertureValue,
+												 ICSCameraPropertyShutterSpeed,
+												 ICSCameraPropertyExposureCompensation,
+												 ICSCameraPropertyWhiteBalance,
+												 ICSCameraPropertyIsoSensitivity,
+												 ICSCameraPropertyRecview];
+	_connectionManager.delegate = self;
+	
+	_healthMonitor = [[ConnectionHealthMonitor alloc] init];
+	_healthMonitor.delegate = self;
+	__weak ConnectionHealthMonitor *weakHealthMonitor = _healthMonitor;
+	_propertyCache.roundTripHandler = ^(NSTimeInterval latency) {
+		[weakHealthMonitor recordCommandLatency:latency];
+	};
 	
 	[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(didChangeNetworkReachability:) name:kReachabilityChangedNotification object:nil];
 	_reachabilityForLocalWiFi = [Reachability reachabilityForLocalWiFi];
 	
+	NSURL *documentsURL = [[[NSFileManager defaultManager] URLsForDirectory:NSDocumentDirectory inDomains:NSUserDomainMask] lastObject];
+	_downloadManager = [[ContentDownloadManager alloc] initWithCamera:_camera directory:[documentsURL URLByAppendingPathComponent:@"Camera" isDirectory:YES]];
+	_downloadManager.delegate = self;
+	
     return YES;
 }
 
 - (void)applicationWillResignActive:(UIApplication *)application
 {
-	[self.reachabilityForLocalWiFi stopNotifier];
-	[self disconnectWithPowerOff:NO];
+	// A short interruption such as an alert or the control center keeps the connection, and becoming
+	// active again is a warm start. The app disconnects when it stays inactive or goes to the background.
+	NSUInteger generation = ++self.inactiveGeneration;
+	__weak AppDelegate *weakSelf = self;
+	dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kInactiveDisconnectDelay * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+		AppDelegate *strongSelf = weakSelf;
+		if (strongSelf && strongSelf.inactiveGeneration == generation) {
+			[strongSelf suspendConnection];
+		}
+	});
 }
 
 - (void)applicationDidEnterBackground:(UIApplication *)application
 {
+	self.inactiveGeneration++;
+	[self suspendConnection];
+	[self.logSink flush];
+#if TRACE_ENABLED
+	// Leave the trace where iTunes file sharing or Xcode can pick it up.
+	NSURL *documentsURL = [[[NSFileManager defaultManager] URLsForDirectory:NSDocumentDirectory inDomains:NSUserDomainMask] lastObject];
+	NSError *error = nil;
+	if (!TraceWriteChromeJSON([documentsURL URLByAppendingPathComponent:@"trace.json"], &error)) {
+		NSLog(@"To write the trace is failed: %@", error ? error : @"Unknown error");
+	}
+#endif
 }
 
 - (void)applicationWillEnterForeground:(UIApplication *)application
@@ -75,6 +204,7 @@ NSString *ICSCameraPropertyRecview = @"RECVIEW";
 
 - (void)applicationDidBecomeActive:(UIApplication *)application
 {
+	self.inactiveGeneration++;
 	[self startScanningCamera];
 }
 
@@ -84,9 +214,21 @@ NSString *ICSCameraPropertyRecview = @"RECVIEW";
 
 #pragma mark -
 
+- (void)suspendConnection
+{
+	[self.reachabilityForLocalWiFi stopNotifier];
+	[self disconnectWithPowerOff:NO];
+}
+
 - (void)startScanningCamera
 {
 	[self.reachabilityForLocalWiFi startNotifier];
+#if DEBUG
+	if ([self.camera isKindOfClass:[MockCamera class]]) {
+		[self startConnectingToCamera];
+		return;
+	}
+#endif
 	if (self.reachabilityForLocalWiFi.currentReachabilityStatus == ReachableViaWiFi) {
 		[self startConnectingToCamera];
 	}
@@ -94,109 +236,193 @@ NSString *ICSCameraPropertyRecview = @"RECVIEW";
 
 - (void)startConnectingToCamera
 {
-	if (self.isConnecting) {
+	[self.connectionManager connect];
+}
+
+- (void)disconnectWithPowerOff:(BOOL)powerOff
+{
+	[[NSNotificationCenter defaultCenter] postNotificationName:kAppDelegateCameraDidChangeConnectionStateNotification object:self userInfo:@{kConnectionStateKey: kConnectionStateDisconnected}];
+	
+	[self.healthMonitor stopMonitoring];
+	// The files left would only fail one after another without the camera.
+	[self.downloadManager cancel];
+	[self.connectionManager disconnectWithPowerOff:powerOff];
+}
+
+- (void)startDownloadingContents
+{
+	if (self.downloadManager.downloading) {
 		return;
 	}
-	self.connecting = YES;
-	
 	dispatch_async(self.connectionQueue, ^{
-		// This process will take some time...
+		// The contents can be downloaded only in the playback mode.
 		NSError *error = nil;
-		if (![_camera connect:&error]) {
-			NSLog(@"To connect to the camera is failed: %@", error ? error : @"Unknown error");
-			self.connecting = NO;
+		if (!_camera.connected) {
+			return;
+		}
+		if (![_camera changeRunMode:OLYCameraRunModePlayback error:&error]) {
+			NSLog(@"To change the run-mode is failed: %@", error ? error : @"Unknown error");
 			return;
 		}
-		NSString *userLivePreviewQuality = [[NSUserDefaults standardUserDefaults] stringForKey:@"live_preview_quality"];
-		if (userLivePreviewQuality) {
-			if (![_camera changeLiveViewSize:CGSizeFromString(userLivePreviewQuality) error:&error]) {
-				NSLog(@"To change the live view size is failed: %@", error ? error : @"Unknown error");
+		[self.downloadManager refreshContentList:^(NSArray *newContents, NSError *error) {
+			if (!newContents) {
+				NSLog(@"To download the content list is failed: %@", error ? error : @"Unknown error");
+				[self downloadManagerDidFinish:self.downloadManager];
+				return;
 			}
+			[self.downloadManager startDownloading];
+		}];
+	});
+}
+
+/**
+ * Switches the camera to the playback mode and lists its contents for a browser.
+ *
+ * @param handler Called on the main thread with the content list, or nil and the error.
+ */
+- (void)startBrowsingContents:(void (^)(NSArray *contentList, NSError *error))handler
+{
+	self.browsingContents = YES;
+	dispatch_async(self.connectionQueue, ^{
+		// The thumbnails can be downloaded only in the playback mode.
+		NSError *error = nil;
+		if (!_camera.connected) {
+			dispatch_async(dispatch_get_main_queue(), ^{
+				handler(nil, nil);
+			});
+			return;
 		}
-		if (![_camera changeRunMode:OLYCameraRunModeRecording error:&error]) {
+		if (_camera.runMode != OLYCameraRunModePlayback && ![_camera changeRunMode:OLYCameraRunModePlayback error:&error]) {
 			NSLog(@"To change the run-mode is failed: %@", error ? error : @"Unknown error");
-			self.connecting = NO;
+			dispatch_async(dispatch_get_main_queue(), ^{
+				handler(nil, error);
+			});
 			return;
 		}
-		
-		// Restores my settings.
-		if (_camera.connected) {
-			NSArray *names = @[ICSCameraPropertyTakemode,
-							   ICSCameraPropertyDrivemode,
-							   ICSCameraPropertyApertureValue,
-							   ICSCameraPropertyShutterSpeed,
-							   ICSCameraPropertyExposureCompensation,
-							   ICSCameraPropertyWhiteBalance,
-							   ICSCameraPropertyIsoSensitivity,
-							   ICSCameraPropertyRecview];
-			NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
-			NSMutableDictionary *values = [[NSMutableDictionary alloc] initWithCapacity:names.count];
-			[names enumerateObjectsUsingBlock:^(id name, NSUInteger idx, BOOL *stop) {
-				id value = [userDefaults valueForKey:name];
-				if (value) {
-					[values setObject:value forKey:name];
-				}
-			}];
-			if (values.count > 0) {
-				if (![_camera setCameraPropertyValues:values error:&error]) {
-					NSLog(@"To change the camera properties is failed: %@", error ? error : @"Unknown error");
-				}
-			}
+		// A refresh during an offload would queue the files in flight again.
+		if (self.downloadManager.downloading) {
+			dispatch_async(dispatch_get_main_queue(), ^{
+				handler(self.downloadManager.contentList, nil);
+			});
+			return;
 		}
-		self.connecting = NO;
-		
-		dispatch_async(dispatch_get_main_queue(), ^{
-			if (!_camera.connected) {
+		[self.downloadManager refreshContentList:^(NSArray *newContents, NSError *error) {
+			if (!newContents) {
+				NSLog(@"To download the content list is failed: %@", error ? error : @"Unknown error");
+				handler(nil, error);
 				return;
 			}
-			
-			[[NSNotificationCenter defaultCenter] postNotificationName:kAppDelegateCameraDidChangeConnectionStateNotification object:self userInfo:@{kConnectionStateKey: kConnectionStateConnected}];
-		});
+			handler(self.downloadManager.contentList, nil);
+		}];
 	});
 }
 
-- (void)disconnectWithPowerOff:(BOOL)powerOff
+- (void)stopBrowsingContents
 {
-	[[NSNotificationCenter defaultCenter] postNotificationName:kAppDelegateCameraDidChangeConnectionStateNotification object:self userInfo:@{kConnectionStateKey: kConnectionStateDisconnected}];
-	
-	dispatch_sync(self.connectionQueue, ^{
+	self.browsingContents = NO;
+	[self.downloadManager cancelThumbnails];
+	if (!self.downloadManager.downloading) {
+		[self returnToRecordingMode];
+	}
+}
+
+- (void)returnToRecordingMode
+{
+	dispatch_async(self.connectionQueue, ^{
 		NSError *error = nil;
-		
-		// Stores current settings.
-		if (_camera.connected) {
-			NSArray *names = @[ICSCameraPropertyTakemode,
-							   ICSCameraPropertyDrivemode,
-							   ICSCameraPropertyApertureValue,
-							   ICSCameraPropertyShutterSpeed,
-							   ICSCameraPropertyExposureCompensation,
-							   ICSCameraPropertyWhiteBalance,
-							   ICSCameraPropertyIsoSensitivity,
-							   ICSCameraPropertyRecview];
-			NSDictionary *values = [_camera cameraPropertyValues:[NSSet setWithArray:names] error:&error];
-			if (values) {
-				NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
-				[values enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
-					[userDefaults setObject:obj forKey:key];
-				}];
-			} else {
-				NSLog(@"To get the camera properties is failed: %@", error ? error : @"Unknown error");
-			}
-		}
-		
-		if (![_camera disconnectWithPowerOff:powerOff error:&error]) {
-			NSLog(@"To disconnect from the camera is failed: %@", error ? error : @"Unknown error");
+		if (_camera.connected && _camera.runMode != OLYCameraRunModeRecording && ![_camera changeRunMode:OLYCameraRunModeRecording error:&error]) {
+			NSLog(@"To change the run-mode is failed: %@", error ? error : @"Unknown error");
 		}
 	});
 }
 
+#pragma mark - ContentDownloadManagerDelegate
+
+- (void)downloadManager:(ContentDownloadManager *)manager didReceiveThumbnail:(UIImage *)image forContent:(NSDictionary *)content
+{
+	[[NSNotificationCenter defaultCenter] postNotificationName:kAppDelegateContentThumbnailDidLoadNotification object:self userInfo:@{kContentKey: content, kThumbnailKey: image}];
+}
+
+- (void)downloadManager:(ContentDownloadManager *)manager didDownloadContent:(NSDictionary *)content toURL:(NSURL *)url
+{
+	[[NSNotificationCenter defaultCenter] postNotificationName:kAppDelegateContentDownloadDidChangeNotification object:self];
+}
+
+- (void)downloadManager:(ContentDownloadManager *)manager didFailToDownloadContent:(NSDictionary *)content error:(NSError *)error
+{
+	NSLog(@"To download %@ is failed: %@", [ContentDownloadManager pathOfContent:content], error ? error : @"Unknown error");
+	[[NSNotificationCenter defaultCenter] postNotificationName:kAppDelegateContentDownloadDidChangeNotification object:self];
+}
+
+- (void)downloadManagerDidFinish:(ContentDownloadManager *)manager
+{
+	// An open browser still needs the playback mode; it returns to the recording mode when it closes.
+	if (!self.browsingContents) {
+		[self returnToRecordingMode];
+	}
+	[[NSNotificationCenter defaultCenter] postNotificationName:kAppDelegateContentDownloadDidChangeNotification object:self];
+}
+
 #pragma mark - Reachabiliry
 
 - (void)didChangeNetworkReachability:(Reachability *)noteObject
 {
+#if DEBUG
+	if ([self.camera isKindOfClass:[MockCamera class]]) {
+		return;
+	}
+#endif
 	NetworkStatus status = self.reachabilityForLocalWiFi.currentReachabilityStatus;
 	dispatch_async(dispatch_get_main_queue(), ^{
-		if (status == ReachableViaWiFi) {
-			[self startConnectingToCamera];
+		[self.connectionManager reachabilityDidChange:(status == ReachableViaWiFi)];
+	});
+}
+
+#pragma mark - ConnectionManagerDelegate
+
+- (void)connectionManagerDidConnect:(ConnectionManager *)manager
+{
+	[self resetLiveViewQuality];
+	[self.healthMonitor startMonitoring];
+	[[NSNotificationCenter defaultCenter] postNotificationName:kAppDelegateCameraDidChangeConnectionStateNotification object:self userInfo:@{kConnectionStateKey: kConnectionStateConnected}];
+}
+
+- (void)connectionManager:(ConnectionManager *)manager didFailWithError:(NSError *)error
+{
+	[self.healthMonitor stopMonitoring];
+	[[NSNotificationCenter defaultCenter] postNotificationName:kAppDelegateCameraDidChangeConnectionStateNotification object:self userInfo:@{kConnectionStateKey: kConnectionStateDisconnected}];
+
+	// Try again while the camera's network is still there; a network without the camera gives up after a few tries.
+	if (self.reachabilityForLocalWiFi.currentReachabilityStatus == ReachableViaWiFi && ![self.connectionManager retryAfterFailure]) {
+		NSLog(@"To connect to the camera is given up: %@", error ? error : @"Unknown error");
+	}
+}
+
+- (void)resetLiveViewQuality
+{
+	NSString *userLivePreviewQuality = [[NSUserDefaults standardUserDefaults] stringForKey:@"live_preview_quality"];
+	[self.healthMonitor resetWithMaximumLiveViewSize:CGSizeFromString(userLivePreviewQuality)];
+}
+
+#pragma mark - ConnectionHealthMonitorDelegate
+
+- (BOOL)healthMonitorShouldEvaluate:(ConnectionHealthMonitor *)monitor
+{
+	// The frames stop for the playback mode and while no screen shows the live view.
+	return (_camera.connected && _camera.runMode == OLYCameraRunModeRecording && _camera.liveViewDelegate != nil);
+}
+
+- (void)healthMonitor:(ConnectionHealthMonitor *)monitor changeLiveViewSize:(OLYCameraLiveViewSize)size
+{
+	NSLog(@"Live view size follows the connection: %@ (%.1f fps, %.0f KB/s, %.0f ms)", NSStringFromCGSize(size), monitor.lastSample.meanFrameInterval > 0 ? 1.0 / monitor.lastSample.meanFrameInterval : 0, monitor.lastSample.bytesPerSecond / 1024.0, monitor.lastSample.meanCommandLatency * 1000.0);
+	dispatch_async(self.connectionQueue, ^{
+		// The live view size can be changed only in the recording mode.
+		NSError *error = nil;
+		if (!_camera.connected || _camera.runMode != OLYCameraRunModeRecording) {
+			return;
+		}
+		if (![_camera changeLiveViewSize:size error:&error]) {
+			NSLog(@"To change the live view size is failed: %@", error ? error : @"Unknown error");
 		}
 	});
 }
@@ -205,7 +431,9 @@ NSString *ICSCameraPropertyRecview = @"RECVIEW";
 
 - (void)camera:(OLYCamera *)camera disconnectedByError:(NSError *)error
 {
+	[self.propertyCache invalidateAll];
 	dispatch_async(dispatch_get_main_queue(), ^{
+		[self.healthMonitor stopMonitoring];
 		[[NSNotificationCenter defaultCenter] postNotificationName:kAppDelegateCameraDidChangeConnectionStateNotification object:self userInfo:@{kConnectionStateKey: kConnectionStateDisconnected}];
 	});
 }
@@ -228,3 +456,71 @@ void AppDelegateCameraDisconnectWithPowerOff(BOOL powerOff)
 		[delegate disconnectWithPowerOff:powerOff];
 	});
 }
+
+CameraPropertyCache *AppDelegateCameraPropertyCache()
+{
+	AppDelegate *delegate = (AppDelegate *)[[UIApplication sharedApplication] delegate];
+	if (!delegate) {
+		return nil;
+	}
+	return delegate.propertyCache;
+}
+
+ConnectionManager *AppDelegateConnectionManager()
+{
+	AppDelegate *delegate = (AppDelegate *)[[UIApplication sharedApplication] delegate];
+	if (!delegate) {
+		return nil;
+	}
+	return delegate.connectionManager;
+}
+
+ConnectionHealthMonitor *AppDelegateConnectionHealthMonitor()
+{
+	AppDelegate *delegate = (AppDelegate *)[[UIApplication sharedApplication] delegate];
+	if (!delegate) {
+		return nil;
+	}
+	return delegate.healthMonitor;
+}
+
+ContentDownloadManager *AppDelegateContentDownloadManager()
+{
+	AppDelegate *delegate = (AppDelegate *)[[UIApplication sharedApplication] delegate];
+	if (!delegate) {
+		return nil;
+	}
+	return delegate.downloadManager;
+}
+
+void AppDelegateResetLiveViewQuality()
+{
+	dispatch_async(dispatch_get_main_queue(), ^{
+		AppDelegate *delegate = (AppDelegate *)[[UIApplication sharedApplication] delegate];
+		[delegate resetLiveViewQuality];
+	});
+}
+
+void AppDelegateStartDownloadingContents()
+{
+	dispatch_async(dispatch_get_main_queue(), ^{
+		AppDelegate *delegate = (AppDelegate *)[[UIApplication sharedApplication] delegate];
+		[delegate startDownloadingContents];
+	});
+}
+
+void AppDelegateStartBrowsingContents(void (^handler)(NSArray *contentList, NSError *error))
+{
+	dispatch_async(dispatch_get_main_queue(), ^{
+		AppDelegate *delegate = (AppDelegate *)[[UIApplication sharedApplication] delegate];
+		[delegate startBrowsingContents:handler];
+	});
+}
+
+void AppDelegateStopBrowsingContents()
+{
+	dispatch_async(dispatch_get_main_queue(), ^{
+		AppDelegate *delegate = (AppDelegate *)[[UIApplication sharedApplication] delegate];
+		[delegate stopBrowsingContents];
+	});
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+//
+//  AutoFocusTracker.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <OLYCameraKit/OLYCamera.h>
+
+@class AutoFocusTracker;
+
+@protocol AutoFocusTrackerDelegate <NSObject>
+@optional
+
+/**
+ * Called when the focus request for the latest point completes.
+ *
+ * @param result The focus result of the camera. ("ok", "ng" or "none"; nil on error)
+ * @param rect The focused rectangle on the viewfinder, or CGRectNull.
+ * @param latency The time from issuing the request to its result.
+ */
+- (void)autoFocusTracker:(AutoFocusTracker *)tracker didFocusWithResult:(NSString *)result rect:(CGRect)rect latency:(NSTimeInterval)latency;
+- (void)autoFocusTracker:(AutoFocusTracker *)tracker didFailWithError:(NSError *)error;
+
+@end
+
+/**
+ * Follows a dragged point with the auto focus.
+ *
+ * Points are coalesced: only the latest one waits while a request is in flight,
+ * and the ones it replaces are never sent. At most one request is outstanding, so
+ * the request rate follows what the camera sustains. The camera is driven from a
+ * background queue and the input is never blocked. The camera cannot take back a
+ * request once sent, so one superseded while in flight still runs to its end; only
+ * its result is dropped and not reported.
+ * All methods must be called on the main thread; delegate methods are called on it.
+ */
+@interface AutoFocusTracker : NSObject
+
+@property (weak, nonatomic) id<AutoFocusTrackerDelegate> delegate;
+/** The shortest time between two requests. (default: 0.1) */
+@property (assign, nonatomic) NSTimeInterval minimumInterval;
+@property (assign, nonatomic, readonly, getter = isTracking) BOOL tracking;
+@property (assign, nonatomic, readonly) NSUInteger issuedRequests;
+/** The number of points replaced by a later one before being sent. */
+@property (assign, nonatomic, readonly) NSUInteger coalescedPoints;
+@property (assign, nonatomic, readonly) NSTimeInterval lastLatency;
+@property (assign, nonatomic, readonly) NSTimeInterval averageLatency;
+
+- (id)initWithCamera:(OLYCamera *)camera;
+- (void)trackPoint:(CGPoint)point;
+- (void)stop;
+
+@end
@@ -0,0 +1,181 @@
+//
+//  AutoFocusTracker.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "AutoFocusTracker.h"
+#import "AutoFocusTrackerCore.h"
+#import "Trace.h"
+
+@interface AutoFocusTracker ()
+
+@property (weak, nonatomic) OLYCamera *camera;
+@property (strong, nonatomic) dispatch_queue_t queue;
+
+@end
+
+@implementation AutoFocusTracker
+{
+	AutoFocusTrackerState _state;
+}
+
+- (id)initWithCamera:(OLYCamera *)camera
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	_camera = camera;
+	_queue = dispatch_queue_create([NSString stringWithFormat:@"%@.autofocus", [NSBundle mainBundle].bundleIdentifier].UTF8String, DISPATCH_QUEUE_SERIAL);
+	AutoFocusTrackerInit(&_state);
+	return self;
+}
+
+- (NSTimeInterval)minimumInterval
+{
+	return _state.minimumInterval;
+}
+
+- (void)setMinimumInterval:(NSTimeInterval)minimumInterval
+{
+	_state.minimumInterval = minimumInterval;
+}
+
+- (BOOL)isTracking
+{
+	return _state.tracking;
+}
+
+- (NSUInteger)issuedRequests
+{
+	return _state.issuedRequests;
+}
+
+- (NSUInteger)coalescedPoints
+{
+	return _state.coalescedPoints;
+}
+
+- (NSTimeInterval)lastLatency
+{
+	return _state.lastLatency;
+}
+
+- (NSTimeInterval)averageLatency
+{
+	return _state.averageLatency;
+}
+
+#pragma mark -
+
+/**
+ * Moves the focus to a point.
+ *
+ * @param point A point on the viewfinder, in the range of 0 to 1.
+ */
+- (void)trackPoint:(CGPoint)point
+{
+	AutoFocusTrackerTrackPoint(&_state, point.x, point.y);
+	[self issuePendingPoint];
+}
+
+/**
+ * Drops the waiting point and releases the focus lock.
+ * A lock still in flight is released when it completes.
+ */
+- (void)stop
+{
+	if (!AutoFocusTrackerStop(&_state)) {
+		return;
+	}
+	OLYCamera *camera = self.camera;
+	dispatch_async(self.queue, ^{
+		[camera unlockAutoFocus:nil];
+	});
+}
+
+#pragma mark -
+
+- (void)issuePendingPoint
+{
+	CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+	double x, y, wait;
+	size_t generation;
+	AutoFocusTrackerAction action = AutoFocusTrackerNextAction(&_state, now, &x, &y, &generation, &wait);
+	if (action == AutoFocusTrackerActionNone) {
+		return;
+	}
+	if (action == AutoFocusTrackerActionWait) {
+		__weak AutoFocusTracker *weakSelf = self;
+		dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(wait * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+			AutoFocusTracker *strongSelf = weakSelf;
+			if (strongSelf) {
+				AutoFocusTrackerFinishWait(&strongSelf->_state);
+				[strongSelf issuePendingPoint];
+			}
+		});
+		return;
+	}
+
+	CGPoint point = CGPointMake(x, y);
+	TRACE_INSTANT("camera.autoFocus.issue", generation);
+
+	__weak AutoFocusTracker *weakSelf = self;
+	OLYCamera *camera = self.camera;
+	dispatch_async(self.queue, ^{
+		// The previous lock holds the focus until it is released.
+		[camera unlockAutoFocus:nil];
+		NSError *error = nil;
+		if (![camera setAutoFocusPoint:point error:&error]) {
+			dispatch_async(dispatch_get_main_queue(), ^{
+				[weakSelf finishRequest:generation issueTime:now info:nil error:error];
+			});
+			return;
+		}
+		[camera lockAutoFocus:^(NSDictionary *info) {
+			dispatch_async(dispatch_get_main_queue(), ^{
+				[weakSelf finishRequest:generation issueTime:now info:info error:nil];
+			});
+		} errorHandler:^(NSError *error) {
+			dispatch_async(dispatch_get_main_queue(), ^{
+				[weakSelf finishRequest:generation issueTime:now info:nil error:error];
+			});
+		}];
+	});
+}
+
+- (void)finishRequest:(size_t)generation issueTime:(CFAbsoluteTime)issueTime info:(NSDictionary *)info error:(NSError *)error
+{
+	NSTimeInterval latency = CFAbsoluteTimeGetCurrent() - issueTime;
+	TRACE_INSTANT("camera.autoFocus.complete", latency * 1000000.0);
+
+	bool unlock;
+	BOOL latest = AutoFocusTrackerFinishRequest(&_state, generation, latency, !error, &unlock);
+	if (unlock) {
+		// The lock completed after the unlock of stop had run; release it again.
+		OLYCamera *camera = self.camera;
+		dispatch_async(self.queue, ^{
+			[camera unlockAutoFocus:nil];
+		});
+	}
+	// A newer point waiting or a stop makes the result stale; it is dropped.
+	if (latest) {
+		if (error) {
+			if ([self.delegate respondsToSelector:@selector(autoFocusTracker:didFailWithError:)]) {
+				[self.delegate autoFocusTracker:self didFailWithError:error];
+			}
+		} else {
+			NSString *result = info[OLYCameraTakingPictureProgressInfoFocusResultKey];
+			NSValue *rectValue = info[OLYCameraTakingPictureProgressInfoFocusRectKey];
+			CGRect rect = rectValue ? [rectValue CGRectValue] : CGRectNull;
+			if ([self.delegate respondsToSelector:@selector(autoFocusTracker:didFocusWithResult:rect:latency:)]) {
+				[self.delegate autoFocusTracker:self didFocusWithResult:result rect:rect latency:latency];
+			}
+		}
+	}
+	[self issuePendingPoint];
+}
+
+@end
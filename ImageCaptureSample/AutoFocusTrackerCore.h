@@ -0,0 +1,139 @@
+//
+//  AutoFocusTrackerCore.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#ifndef ImageCaptureSample_AutoFocusTrackerCore_h
+#define ImageCaptureSample_AutoFocusTrackerCore_h
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * The request scheduling of AutoFocusTracker in plain C, so that it can also be
+ * built and checked against a simulated camera off the device. Times are in seconds.
+ */
+
+typedef enum {
+	AutoFocusTrackerActionNone,
+	/** Nothing may be sent before wait seconds have passed; decide again then. */
+	AutoFocusTrackerActionWait,
+	/** Send the point; the request is in flight until AutoFocusTrackerFinishRequest. */
+	AutoFocusTrackerActionIssue,
+} AutoFocusTrackerAction;
+
+typedef struct {
+	/** The shortest time between two requests. */
+	double minimumInterval;
+	bool tracking;
+	double pendingX;
+	double pendingY;
+	bool hasPendingPoint;
+	bool requestInFlight;
+	/** Whether a decision is already due after a wait. */
+	bool issueScheduled;
+	double lastIssueTime;
+	/** Counts requests and stops, so that a result can tell whether it is still the latest. */
+	size_t generation;
+	size_t issuedRequests;
+	/** The number of points replaced by a later one before being sent. */
+	size_t coalescedPoints;
+	double lastLatency;
+	double averageLatency;
+} AutoFocusTrackerState;
+
+static inline void AutoFocusTrackerInit(AutoFocusTrackerState *state)
+{
+	*state = (AutoFocusTrackerState){0};
+	state->minimumInterval = 0.1;
+}
+
+/**
+ * Takes a point to focus on; it replaces the one waiting, if any.
+ */
+static inline void AutoFocusTrackerTrackPoint(AutoFocusTrackerState *state, double x, double y)
+{
+	if (state->hasPendingPoint) {
+		state->coalescedPoints++;
+	}
+	state->tracking = true;
+	state->pendingX = x;
+	state->pendingY = y;
+	state->hasPendingPoint = true;
+}
+
+/**
+ * Drops the waiting point, so that the result of the request in flight goes unreported.
+ *
+ * @return true if the focus lock is to be released.
+ */
+static inline bool AutoFocusTrackerStop(AutoFocusTrackerState *state)
+{
+	if (!state->tracking) {
+		return false;
+	}
+	state->tracking = false;
+	state->hasPendingPoint = false;
+	state->generation++;
+	return true;
+}
+
+/**
+ * Decides whether the waiting point is sent now.
+ *
+ * At most one request is in flight, and requests are at least minimumInterval apart.
+ *
+ * @param x, y, generation The point to send and the generation its result comes back with, for an issue.
+ * @param wait The time to wait, for a wait. A wait is asked for once; the next decision is due after it.
+ */
+static inline AutoFocusTrackerAction AutoFocusTrackerNextAction(AutoFocusTrackerState *state, double now, double *x, double *y, size_t *generation, double *wait)
+{
+	if (!state->hasPendingPoint || state->requestInFlight || state->issueScheduled) {
+		return AutoFocusTrackerActionNone;
+	}
+	double remaining = state->lastIssueTime + state->minimumInterval - now;
+	if (state->issuedRequests > 0 && remaining > 0) {
+		state->issueScheduled = true;
+		*wait = remaining;
+		return AutoFocusTrackerActionWait;
+	}
+	*x = state->pendingX;
+	*y = state->pendingY;
+	state->hasPendingPoint = false;
+	state->requestInFlight = true;
+	state->lastIssueTime = now;
+	state->issuedRequests++;
+	*generation = ++state->generation;
+	return AutoFocusTrackerActionIssue;
+}
+
+/**
+ * Ends a wait asked for by AutoFocusTrackerNextAction.
+ */
+static inline void AutoFocusTrackerFinishWait(AutoFocusTrackerState *state)
+{
+	state->issueScheduled = false;
+}
+
+/**
+ * Takes the result of the request in flight.
+ *
+ * The camera cannot take back a request once sent, so a request superseded by a newer
+ * point, or by a stop, still runs to its end; only its result is dropped.
+ *
+ * @param succeeded Whether the camera locked the focus.
+ * @param unlock Set to whether the lock is to be released, since it completed after a stop.
+ * @return true if the result is for the latest point and is to be reported.
+ */
+static inline bool AutoFocusTrackerFinishRequest(AutoFocusTrackerState *state, size_t generation, double latency, bool succeeded, bool *unlock)
+{
+	state->requestInFlight = false;
+	state->lastLatency = latency;
+	state->averageLatency = (state->averageLatency > 0) ? state->averageLatency * 0.8 + latency * 0.2 : latency;
+	*unlock = (succeeded && !state->tracking);
+	return (generation == state->generation && !state->hasPendingPoint);
+}
+
+#endif
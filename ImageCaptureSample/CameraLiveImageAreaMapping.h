@@ -0,0 +1,174 @@
+//
+//  CameraLiveImageAreaMapping.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#ifndef ImageCaptureSample_CameraLiveImageAreaMapping_h
+#define ImageCaptureSample_CameraLiveImageAreaMapping_h
+
+#include <stdbool.h>
+#ifdef __OBJC__
+#import <UIKit/UIKit.h>
+#endif
+
+/*
+ * The conversion between the image area and the view area of CameraLiveImageView,
+ * in plain C so that it can also be built and checked off the device.
+ */
+
+/**
+ * The mapping of each axis between image area and view area, with the layout it was made for.
+ */
+struct CameraLiveImageAreaMapping
+{
+	CGSize imageSize;
+	CGSize viewSize;
+	UIViewContentMode contentMode;
+	CGFloat scaleX;
+	CGFloat scaleY;
+	CGFloat imageToViewOffsetX;
+	CGFloat imageToViewOffsetY;
+	CGFloat viewToImageOffsetX;
+	CGFloat viewToImageOffsetY;
+};
+
+typedef struct CameraLiveImageAreaMapping CameraLiveImageAreaMapping;
+
+/**
+ * Returns whether the mapping was made for the layout.
+ */
+static inline bool CameraLiveImageAreaMappingMatches(const CameraLiveImageAreaMapping *mapping, CGSize imageSize, CGSize viewSize, UIViewContentMode contentMode)
+{
+	return (mapping->contentMode == contentMode &&
+			mapping->imageSize.width == imageSize.width && mapping->imageSize.height == imageSize.height &&
+			mapping->viewSize.width == viewSize.width && mapping->viewSize.height == viewSize.height);
+}
+
+/**
+ * Makes the mapping of a layout.
+ *
+ * Every content mode maps the axes independently by a scale and an offset.
+ * The offsets of each direction are computed with the same expressions the
+ * conversions of each point used before the mapping was cached.
+ */
+static inline CameraLiveImageAreaMapping CameraLiveImageAreaMappingMake(CGSize imageSize, CGSize viewSize, UIViewContentMode contentMode)
+{
+	CameraLiveImageAreaMapping mapping;
+	mapping.imageSize = imageSize;
+	mapping.viewSize = viewSize;
+	mapping.contentMode = contentMode;
+	mapping.scaleX = 1.0;
+	mapping.scaleY = 1.0;
+	mapping.imageToViewOffsetX = 0.0;
+	mapping.imageToViewOffsetY = 0.0;
+	mapping.viewToImageOffsetX = 0.0;
+	mapping.viewToImageOffsetY = 0.0;
+	CGFloat ratioX = viewSize.width / imageSize.width;
+	CGFloat ratioY = viewSize.height / imageSize.height;
+	CGFloat scale = 0.0;
+
+	switch (contentMode) {
+		case UIViewContentModeScaleToFill:	// go to next label.
+		case UIViewContentModeRedraw:
+			mapping.scaleX = ratioX;
+			mapping.scaleY = ratioY;
+			break;
+		case UIViewContentModeScaleAspectFit:
+			scale = MIN(ratioX, ratioY);
+			mapping.scaleX = scale;
+			mapping.scaleY = scale;
+			mapping.imageToViewOffsetX = (viewSize.width  - imageSize.width  * scale) / 2.0f;
+			mapping.imageToViewOffsetY = (viewSize.height - imageSize.height * scale) / 2.0f;
+			mapping.viewToImageOffsetX = mapping.imageToViewOffsetX;
+			mapping.viewToImageOffsetY = mapping.imageToViewOffsetY;
+			break;
+		case UIViewContentModeScaleAspectFill:
+			scale = MAX(ratioX, ratioY);
+			mapping.scaleX = scale;
+			mapping.scaleY = scale;
+			mapping.imageToViewOffsetX = (viewSize.width  - imageSize.width  * scale) / 2.0f;
+			mapping.imageToViewOffsetY = (viewSize.height - imageSize.height * scale) / 2.0f;
+			mapping.viewToImageOffsetX = mapping.imageToViewOffsetX;
+			mapping.viewToImageOffsetY = mapping.imageToViewOffsetY;
+			break;
+		case UIViewContentModeCenter:
+			mapping.imageToViewOffsetX = viewSize.width / 2.0  - imageSize.width  / 2.0f;
+			mapping.imageToViewOffsetY = viewSize.height / 2.0 - imageSize.height / 2.0f;
+			mapping.viewToImageOffsetX = (viewSize.width - imageSize.width)  / 2.0f;
+			mapping.viewToImageOffsetY = (viewSize.height - imageSize.height) / 2.0f;
+			break;
+		case UIViewContentModeTop:
+			mapping.imageToViewOffsetX = viewSize.width / 2.0 - imageSize.width / 2.0f;
+			mapping.viewToImageOffsetX = (viewSize.width - imageSize.width)  / 2.0f;
+			break;
+		case UIViewContentModeBottom:
+			mapping.imageToViewOffsetX = viewSize.width / 2.0 - imageSize.width / 2.0f;
+			mapping.imageToViewOffsetY = viewSize.height - imageSize.height;
+			mapping.viewToImageOffsetX = (viewSize.width - imageSize.width)  / 2.0f;
+			mapping.viewToImageOffsetY = (viewSize.height - imageSize.height);
+			break;
+		case UIViewContentModeLeft:
+			mapping.imageToViewOffsetY = viewSize.height / 2.0 - imageSize.height / 2.0f;
+			mapping.viewToImageOffsetY = (viewSize.height - imageSize.height) / 2.0f;
+			break;
+		case UIViewContentModeRight:
+			mapping.imageToViewOffsetX = viewSize.width - imageSize.width;
+			mapping.imageToViewOffsetY = viewSize.height / 2.0 - imageSize.height / 2.0f;
+			mapping.viewToImageOffsetX = (viewSize.width - imageSize.width);
+			mapping.viewToImageOffsetY = (viewSize.height - imageSize.height) / 2.0f;
+			break;
+		case UIViewContentModeTopRight:
+			mapping.imageToViewOffsetX = viewSize.width - imageSize.width;
+			mapping.viewToImageOffsetX = (viewSize.width - imageSize.width);
+			break;
+		case UIViewContentModeBottomLeft:
+			mapping.imageToViewOffsetY = viewSize.height - imageSize.height;
+			mapping.viewToImageOffsetY = (viewSize.height - imageSize.height);
+			break;
+		case UIViewContentModeBottomRight:
+			mapping.imageToViewOffsetX = viewSize.width  - imageSize.width;
+			mapping.imageToViewOffsetY = viewSize.height - imageSize.height;
+			mapping.viewToImageOffsetX = (viewSize.width - imageSize.width);
+			mapping.viewToImageOffsetY = (viewSize.height - imageSize.height);
+			break;
+		case UIViewContentModeTopLeft:	// go to next label.
+		default:
+			break;
+	}
+	return mapping;
+}
+
+static inline CGPoint CameraLiveImageMapPointFromImageArea(const CameraLiveImageAreaMapping *mapping, CGPoint point)
+{
+	// Separate statements keep the compiler from fusing the multiply and add, which would round differently.
+	CGPoint viewPoint = point;
+	viewPoint.x *= mapping->scaleX;
+	viewPoint.y *= mapping->scaleY;
+	viewPoint.x += mapping->imageToViewOffsetX;
+	viewPoint.y += mapping->imageToViewOffsetY;
+	return viewPoint;
+}
+
+static inline CGPoint CameraLiveImageMapPointFromViewArea(const CameraLiveImageAreaMapping *mapping, CGPoint point)
+{
+	return CGPointMake((point.x - mapping->viewToImageOffsetX) / mapping->scaleX,
+					   (point.y - mapping->viewToImageOffsetY) / mapping->scaleY);
+}
+
+static inline CGRect CameraLiveImageMapRectFromImageArea(const CameraLiveImageAreaMapping *mapping, CGRect rect)
+{
+	CGPoint topLeft = CameraLiveImageMapPointFromImageArea(mapping, rect.origin);
+	CGPoint bottomRight = CameraLiveImageMapPointFromImageArea(mapping, CGPointMake(CGRectGetMaxX(rect), CGRectGetMaxY(rect)));
+	return CGRectMake(topLeft.x, topLeft.y, ABS(bottomRight.x - topLeft.x), ABS(bottomRight.y - topLeft.y));
+}
+
+static inline CGRect CameraLiveImageMapRectFromViewArea(const CameraLiveImageAreaMapping *mapping, CGRect rect)
+{
+	CGPoint topLeft = CameraLiveImageMapPointFromViewArea(mapping, rect.origin);
+	CGPoint bottomRight = CameraLiveImageMapPointFromViewArea(mapping, CGPointMake(CGRectGetMaxX(rect), CGRectGetMaxY(rect)));
+	return CGRectMake(topLeft.x, topLeft.y, ABS(bottomRight.x - topLeft.x), ABS(bottomRight.y - topLeft.y));
+}
+
+#endif
@@ -22,7 +22,16 @@ typedef enum CameraFocusFrameStatus CameraFocusFrameStatus;
 - (CGPoint)convertPointFromViewArea:(CGPoint)point;
 - (CGRect)convertRectFromImageArea:(CGRect)rect;
 - (CGRect)convertRectFromViewArea:(CGRect)rect;
+- (void)convertPoints:(CGPoint *)points count:(NSUInteger)count fromImageArea:(BOOL)fromImageArea;
+- (void)convertRects:(CGRect *)rects count:(NSUInteger)count fromImageArea:(BOOL)fromImageArea;
+- (CGAffineTransform)imageToViewTransform;
 - (void)hideFocusFrame;
 - (void)showFocusFrame:(CGRect)rect status:(CameraFocusFrameStatus)status animated:(BOOL)animated;
+- (void)hideFocusInfo;
+- (void)showFocusInfo:(NSString *)text;
+- (void)hideTrapRegion;
+- (void)showTrapRegion:(CGRect)rect armed:(BOOL)armed;
+- (void)hideHorizon;
+- (void)showHorizonWithRoll:(CGFloat)roll level:(BOOL)level;
 
 @end
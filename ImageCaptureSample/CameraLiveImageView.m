@@ -6,10 +6,16 @@
 //
 
 #import "CameraLiveImageView.h"
+#import "CameraLiveImageAreaMapping.h"
 
 @interface CameraLiveImageView()
 
 @property (strong, nonatomic) NSTimer *focusFrameHideTimer;
+@property (strong, nonatomic) CALayer *trapRegionLayer;
+@property (strong, nonatomic) CATextLayer *focusInfoLayer;
+@property (strong, nonatomic) CALayer *horizonLayer;
+@property (assign, nonatomic) CameraLiveImageAreaMapping areaMapping;
+@property (assign, nonatomic) BOOL areaMappingValid;
 
 @end
 
@@ -40,6 +46,27 @@
 	CALayer *focusFrameLayer = [CALayer layer];
 	focusFrameLayer.frame = self.bounds;
 	[self.layer addSublayer:focusFrameLayer];
+	
+	// The trap region is a plain bordered layer so that moving it costs no redrawing.
+	CALayer *trapRegionLayer = [CALayer layer];
+	trapRegionLayer.borderWidth = 2.0;
+	trapRegionLayer.hidden = YES;
+	[self.layer addSublayer:trapRegionLayer];
+	self.trapRegionLayer = trapRegionLayer;
+	
+	CATextLayer *focusInfoLayer = [CATextLayer layer];
+	focusInfoLayer.fontSize = 12.0;
+	focusInfoLayer.foregroundColor = [UIColor greenColor].CGColor;
+	focusInfoLayer.contentsScale = [UIScreen mainScreen].scale;
+	focusInfoLayer.hidden = YES;
+	[self.layer addSublayer:focusInfoLayer];
+	self.focusInfoLayer = focusInfoLayer;
+	
+	// The horizon is turned by its transform only, so following the gauge costs no redrawing.
+	CALayer *horizonLayer = [CALayer layer];
+	horizonLayer.hidden = YES;
+	[self.layer addSublayer:horizonLayer];
+	self.horizonLayer = horizonLayer;
 }
 
 - (void)dealloc
@@ -48,6 +75,42 @@
 	self.focusFrameHideTimer = nil;
 }
 
+#pragma mark - Coordinate conversion
+
+/**
+ * Returns the mapping between the image area and the view area, computing it only when the layout changed.
+ *
+ * The mapping is kept with the image size, view size and content mode it was made for,
+ * so clearing the image between frames or moving the view keeps it as long as the
+ * layout stays the same.
+ */
+- (CameraLiveImageAreaMapping)currentAreaMapping
+{
+	CGSize imageSize = self.image.size;
+	CGSize viewSize = self.bounds.size;
+	UIViewContentMode contentMode = self.contentMode;
+	CameraLiveImageAreaMapping mapping = self.areaMapping;
+	if (self.areaMappingValid && CameraLiveImageAreaMappingMatches(&mapping, imageSize, viewSize, contentMode)) {
+		return mapping;
+	}
+	mapping = CameraLiveImageAreaMappingMake(imageSize, viewSize, contentMode);
+	self.areaMapping = mapping;
+	self.areaMappingValid = YES;
+	return mapping;
+}
+
+/**
+ * Returns the transform from image area to view area, e.g. for a layer drawn in image coordinates.
+ */
+- (CGAffineTransform)imageToViewTransform
+{
+	if (!self.image) {
+		return CGAffineTransformIdentity;
+	}
+	CameraLiveImageAreaMapping mapping = [self currentAreaMapping];
+	return CGAffineTransformMake(mapping.scaleX, 0, 0, mapping.scaleY, mapping.imageToViewOffsetX, mapping.imageToViewOffsetY);
+}
+
 /**
  * Converts a point on image area to a point on view area.
  *
@@ -59,68 +122,8 @@
 	if (!self.image) {
 		return CGPointZero;
 	}
-
-	CGPoint viewPoint = point;
-	CGSize imageSize = self.image.size;
-	CGSize viewSize  = self.bounds.size;
-	CGFloat ratioX = viewSize.width / imageSize.width;
-	CGFloat ratioY = viewSize.height / imageSize.height;
-	CGFloat scale = 0.0;
-
-	switch (self.contentMode) {
-		case UIViewContentModeScaleToFill:	// go to next label.
-		case UIViewContentModeRedraw:
-			viewPoint.x *= ratioX;
-			viewPoint.y *= ratioY;
-			break;
-		case UIViewContentModeScaleAspectFit:
-			scale = MIN(ratioX, ratioY);
-			viewPoint.x *= scale;
-			viewPoint.y *= scale;
-			viewPoint.x += (viewSize.width  - imageSize.width  * scale) / 2.0f;
-			viewPoint.y += (viewSize.height - imageSize.height * scale) / 2.0f;
-			break;
-		case UIViewContentModeScaleAspectFill:
-			scale = MAX(ratioX, ratioY);
-			viewPoint.x *= scale;
-			viewPoint.y *= scale;
-			viewPoint.x += (viewSize.width  - imageSize.width  * scale) / 2.0f;
-			viewPoint.y += (viewSize.height - imageSize.height * scale) / 2.0f;
-			break;
-		case UIViewContentModeCenter:
-			viewPoint.x += viewSize.width / 2.0  - imageSize.width  / 2.0f;
-			viewPoint.y += viewSize.height / 2.0 - imageSize.height / 2.0f;
-			break;
-		case UIViewContentModeTop:
-			viewPoint.x += viewSize.width / 2.0 - imageSize.width / 2.0f;
-			break;
-		case UIViewContentModeBottom:
-			viewPoint.x += viewSize.width / 2.0 - imageSize.width / 2.0f;
-			viewPoint.y += viewSize.height - imageSize.height;
-			break;
-		case UIViewContentModeLeft:
-			viewPoint.y += viewSize.height / 2.0 - imageSize.height / 2.0f;
-			break;
-		case UIViewContentModeRight:
-			viewPoint.x += viewSize.width - imageSize.width;
-			viewPoint.y += viewSize.height / 2.0 - imageSize.height / 2.0f;
-			break;
-		case UIViewContentModeTopRight:
-			viewPoint.x += viewSize.width - imageSize.width;
-			break;
-		case UIViewContentModeBottomLeft:
-			viewPoint.y += viewSize.height - imageSize.height;
-			break;
-		case UIViewContentModeBottomRight:
-			viewPoint.x += viewSize.width  - imageSize.width;
-			viewPoint.y += viewSize.height - imageSize.height;
-			break;
-		case UIViewContentModeTopLeft:	// go to next label.
-		default:
-			break;
-	}
-	
-    return viewPoint;
+	CameraLiveImageAreaMapping mapping = [self currentAreaMapping];
+	return CameraLiveImageMapPointFromImageArea(&mapping, point);
 }
 
 /**
@@ -134,68 +137,8 @@
 	if (!self.image) {
 		return CGPointZero;
 	}
-	
-	CGPoint imagePoint = point;
-	CGSize imageSize = self.image.size;
-	CGSize viewSize  = self.bounds.size;
-	CGFloat ratioX = viewSize.width / imageSize.width;
-	CGFloat ratioY = viewSize.height / imageSize.height;
-	CGFloat scale = 0.0;
-    
-    switch (self.contentMode) {
-        case UIViewContentModeScaleToFill:	// go to next label.
-        case UIViewContentModeRedraw:
-            imagePoint.x /= ratioX;
-            imagePoint.y /= ratioY;
-            break;
-        case UIViewContentModeScaleAspectFit:
-			scale = MIN(ratioX, ratioY);
-            imagePoint.x -= (viewSize.width  - imageSize.width  * scale) / 2.0f;
-            imagePoint.y -= (viewSize.height - imageSize.height * scale) / 2.0f;
-            imagePoint.x /= scale;
-            imagePoint.y /= scale;
-            break;
-        case UIViewContentModeScaleAspectFill:
-			scale = MAX(ratioX, ratioY);
-            imagePoint.x -= (viewSize.width  - imageSize.width  * scale) / 2.0f;
-            imagePoint.y -= (viewSize.height - imageSize.height * scale) / 2.0f;
-            imagePoint.x /= scale;
-            imagePoint.y /= scale;
-            break;
-        case UIViewContentModeCenter:
-            imagePoint.x -= (viewSize.width - imageSize.width)  / 2.0f;
-            imagePoint.y -= (viewSize.height - imageSize.height) / 2.0f;
-            break;
-        case UIViewContentModeTop:
-            imagePoint.x -= (viewSize.width - imageSize.width)  / 2.0f;
-            break;
-        case UIViewContentModeBottom:
-            imagePoint.x -= (viewSize.width - imageSize.width)  / 2.0f;
-            imagePoint.y -= (viewSize.height - imageSize.height);
-            break;
-        case UIViewContentModeLeft:
-            imagePoint.y -= (viewSize.height - imageSize.height) / 2.0f;
-            break;
-        case UIViewContentModeRight:
-            imagePoint.x -= (viewSize.width - imageSize.width);
-            imagePoint.y -= (viewSize.height - imageSize.height) / 2.0f;
-            break;
-        case UIViewContentModeTopRight:
-            imagePoint.x -= (viewSize.width - imageSize.width);
-            break;
-        case UIViewContentModeBottomLeft:
-            imagePoint.y -= (viewSize.height - imageSize.height);
-            break;
-        case UIViewContentModeBottomRight:
-            imagePoint.x -= (viewSize.width - imageSize.width);
-            imagePoint.y -= (viewSize.height - imageSize.height);
-            break;
-        case UIViewContentModeTopLeft:		// go to next label.
-        default:
-            break;
-    }
-    
-    return imagePoint;
+	CameraLiveImageAreaMapping mapping = [self currentAreaMapping];
+	return CameraLiveImageMapPointFromViewArea(&mapping, point);
 }
 
 /**
@@ -209,18 +152,8 @@
 	if (!self.image) {
 		return CGRectZero;
 	}
-	
-	CGPoint imageTopLeft = rect.origin;
-	CGPoint imageBottomRight = CGPointMake(CGRectGetMaxX(rect), CGRectGetMaxY(rect));
-
-	CGPoint viewTopLeft = [self convertPointFromImageArea:imageTopLeft];
-	CGPoint viewBottomRight = [self convertPointFromImageArea:imageBottomRight];
-
-	CGFloat viewWidth = ABS(viewBottomRight.x - viewTopLeft.x);
-	CGFloat viewHeight = ABS(viewBottomRight.y - viewTopLeft.y);
-	CGRect viewRect = CGRectMake(viewTopLeft.x, viewTopLeft.y, viewWidth, viewHeight);
-    
-	return viewRect;
+	CameraLiveImageAreaMapping mapping = [self currentAreaMapping];
+	return CameraLiveImageMapRectFromImageArea(&mapping, rect);
 }
 
 /**
@@ -234,20 +167,50 @@
 	if (!self.image) {
 		return CGRectZero;
 	}
-	
-	CGPoint viewTopLeft = rect.origin;
-	CGPoint viewBottomRight = CGPointMake(CGRectGetMaxX(rect), CGRectGetMaxY(rect));
+	CameraLiveImageAreaMapping mapping = [self currentAreaMapping];
+	return CameraLiveImageMapRectFromViewArea(&mapping, rect);
+}
 
-	CGPoint imageTopLeft = [self convertPointFromViewArea:viewTopLeft];
-	CGPoint imageBottomRight = [self convertPointFromViewArea:viewBottomRight];
+/**
+ * Converts points between image area and view area in place.
+ *
+ * @param points Points to convert, which are replaced with the converted ones.
+ * @param count The number of points.
+ * @param fromImageArea If YES, converts from image area to view area; otherwise the other way.
+ */
+- (void)convertPoints:(CGPoint *)points count:(NSUInteger)count fromImageArea:(BOOL)fromImageArea
+{
+	if (!self.image) {
+		memset(points, 0, sizeof(CGPoint) * count);
+		return;
+	}
+	CameraLiveImageAreaMapping mapping = [self currentAreaMapping];
+	for (NSUInteger index = 0; index < count; index++) {
+		points[index] = fromImageArea ? CameraLiveImageMapPointFromImageArea(&mapping, points[index]) : CameraLiveImageMapPointFromViewArea(&mapping, points[index]);
+	}
+}
 
-	CGFloat imageWidth = ABS(imageBottomRight.x - imageTopLeft.x);
-	CGFloat imageHeight = ABS(imageBottomRight.y - imageTopLeft.y);
-	CGRect imageRect = CGRectMake(imageTopLeft.x, imageTopLeft.y, imageWidth, imageHeight);
-    
-    return imageRect;
+/**
+ * Converts rectangles between image area and view area in place.
+ *
+ * @param rects Rectangles to convert, which are replaced with the converted ones.
+ * @param count The number of rectangles.
+ * @param fromImageArea If YES, converts from image area to view area; otherwise the other way.
+ */
+- (void)convertRects:(CGRect *)rects count:(NSUInteger)count fromImageArea:(BOOL)fromImageArea
+{
+	if (!self.image) {
+		memset(rects, 0, sizeof(CGRect) * count);
+		return;
+	}
+	CameraLiveImageAreaMapping mapping = [self currentAreaMapping];
+	for (NSUInteger index = 0; index < count; index++) {
+		rects[index] = fromImageArea ? CameraLiveImageMapRectFromImageArea(&mapping, rects[index]) : CameraLiveImageMapRectFromViewArea(&mapping, rects[index]);
+	}
 }
 
+#pragma mark - Focus frame
+
 /**
  * Hides the forcus frame.
  */
@@ -317,6 +280,90 @@
 	}
 }
 
+/**
+ * Hides the focus information.
+ */
+- (void)hideFocusInfo
+{
+	[CATransaction begin];
+	[CATransaction setDisableActions:YES];
+	self.focusInfoLayer.hidden = YES;
+	[CATransaction commit];
+}
+
+/**
+ * Shows a line of focus information at the top left corner.
+ *
+ * @param text A text to show. (e.g. the latency of the auto focus)
+ */
+- (void)showFocusInfo:(NSString *)text
+{
+	[CATransaction begin];
+	[CATransaction setDisableActions:YES];
+	self.focusInfoLayer.frame = CGRectMake(8, 8, 160, 16);
+	self.focusInfoLayer.string = text;
+	self.focusInfoLayer.hidden = NO;
+	[CATransaction commit];
+}
+
+/**
+ * Hides the trap region.
+ */
+- (void)hideTrapRegion
+{
+	[CATransaction begin];
+	[CATransaction setDisableActions:YES];
+	self.trapRegionLayer.hidden = YES;
+	[CATransaction commit];
+}
+
+/**
+ * Shows the trap region.
+ *
+ * @param rect A rectangle of the trap region on view area.
+ * @param armed If YES, the region is drawn as watching for motion.
+ */
+- (void)showTrapRegion:(CGRect)rect armed:(BOOL)armed
+{
+	[CATransaction begin];
+	[CATransaction setDisableActions:YES];
+	self.trapRegionLayer.frame = rect;
+	self.trapRegionLayer.borderColor = armed ? [UIColor orangeColor].CGColor : [UIColor whiteColor].CGColor;
+	self.trapRegionLayer.hidden = NO;
+	[CATransaction commit];
+}
+
+/**
+ * Hides the horizon.
+ */
+- (void)hideHorizon
+{
+	[CATransaction begin];
+	[CATransaction setDisableActions:YES];
+	self.horizonLayer.hidden = YES;
+	[CATransaction commit];
+}
+
+/**
+ * Shows the horizon line across the center of the view.
+ *
+ * @param roll The rolling of the camera body in degrees.
+ * @param level If YES, the line is drawn as level.
+ */
+- (void)showHorizonWithRoll:(CGFloat)roll level:(BOOL)level
+{
+	CGRect bounds = self.bounds;
+	[CATransaction begin];
+	[CATransaction setDisableActions:YES];
+	self.horizonLayer.bounds = CGRectMake(0, 0, MIN(bounds.size.width, bounds.size.height) * 0.8, 1.5);
+	self.horizonLayer.position = CGPointMake(CGRectGetMidX(bounds), CGRectGetMidY(bounds));
+	// The picture turns against the camera body.
+	self.horizonLayer.transform = CATransform3DMakeRotation(-roll * M_PI / 180.0, 0, 0, 1);
+	self.horizonLayer.backgroundColor = level ? [UIColor greenColor].CGColor : [UIColor whiteColor].CGColor;
+	self.horizonLayer.hidden = NO;
+	[CATransaction commit];
+}
+
 - (void)focusFrameHideTimerDidFire:(NSTimer *)timer
 {
 	[self hideFocusFrame];
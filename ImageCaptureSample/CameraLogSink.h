@@ -0,0 +1,36 @@
+//
+//  CameraLogSink.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <OLYCameraKit/OLYCameraLog.h>
+
+/**
+ * Writes the log messages of the camera SDK to rotated files without blocking the SDK.
+ *
+ * Messages above the level are dropped before any work is done. The rest are copied
+ * into a fixed ring that any number of threads fill without a lock; a background
+ * queue formats them and appends them to camera.log. When the file grows beyond the
+ * size limit it is renamed to camera.log.1, the older ones shift up and the oldest is
+ * removed. If the writer falls behind and the ring is full, new messages are dropped
+ * and counted rather than waited for.
+ */
+@interface CameraLogSink : NSObject <OLYCameraLogDelegate>
+
+/** The least important level that is written. (default: OLYCameraLogLevelInfo) */
+@property (assign, atomic) OLYCameraLogLevel level;
+/** The size in bytes at which the file is rotated. (default: 1MB) */
+@property (assign, nonatomic) unsigned long long maximumFileSize;
+/** The number of rotated files kept besides the current one. (default: 3) */
+@property (assign, nonatomic) NSUInteger maximumFileCount;
+@property (strong, nonatomic, readonly) NSURL *directoryURL;
+@property (assign, nonatomic, readonly) NSUInteger droppedMessages;
+@property (assign, nonatomic, readonly) NSUInteger writtenMessages;
+
+- (id)initWithDirectoryURL:(NSURL *)directoryURL;
+- (void)flush;
+
+@end
@@ -0,0 +1,213 @@
+//
+//  CameraLogSink.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "CameraLogSink.h"
+#import "CameraLogSinkCore.h"
+#import <sys/stat.h>
+#import <fcntl.h>
+#import <time.h>
+
+static NSString *const CameraLogFileName = @"camera.log";
+
+@interface CameraLogSink ()
+
+@property (strong, nonatomic, readwrite) NSURL *directoryURL;
+@property (strong, nonatomic) dispatch_queue_t queue;
+@property (strong, nonatomic) dispatch_source_t source;
+@property (assign, nonatomic) unsigned long long fileSize;
+
+@end
+
+@implementation CameraLogSink
+{
+	CameraLogRing _ring;
+	int _fileDescriptor;
+}
+
+- (id)initWithDirectoryURL:(NSURL *)directoryURL
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	_directoryURL = directoryURL;
+	_level = OLYCameraLogLevelInfo;
+	_maximumFileSize = 1024 * 1024;
+	_maximumFileCount = 3;
+	_fileDescriptor = -1;
+	if (!CameraLogRingInit(&_ring)) {
+		return nil;
+	}
+
+	NSError *error = nil;
+	if (![[NSFileManager defaultManager] createDirectoryAtURL:directoryURL withIntermediateDirectories:YES attributes:nil error:&error]) {
+		NSLog(@"To create the log directory is failed: %@", error ? error : @"Unknown error");
+	}
+
+	// Producers only bump the pending count of the source; bursts wake the writer once.
+	_queue = dispatch_queue_create([NSString stringWithFormat:@"%@.log", [NSBundle mainBundle].bundleIdentifier].UTF8String, DISPATCH_QUEUE_SERIAL);
+	_source = dispatch_source_create(DISPATCH_SOURCE_TYPE_DATA_ADD, 0, 0, _queue);
+	__weak CameraLogSink *weakSelf = self;
+	dispatch_source_set_event_handler(_source, ^{
+		[weakSelf drain];
+	});
+	dispatch_resume(_source);
+	return self;
+}
+
+- (void)dealloc
+{
+	dispatch_source_cancel(_source);
+	if (_fileDescriptor >= 0) {
+		close(_fileDescriptor);
+	}
+	CameraLogRingDestroy(&_ring);
+}
+
+- (NSUInteger)droppedMessages
+{
+	return (NSUInteger)_ring.droppedCount;
+}
+
+- (NSUInteger)writtenMessages
+{
+	return (NSUInteger)_ring.writtenCount;
+}
+
+#pragma mark - OLYCameraLogDelegate
+
+/**
+ * Copies the message into the ring; called on whatever thread the SDK logs from.
+ */
+- (void)log:(OLYCameraLog *)log shouldOutputMessage:(NSString *)message level:(OLYCameraLogLevel)level
+{
+	if (level > self.level || !message) {
+		return;
+	}
+
+	int64_t position;
+	CameraLogSlot *slot = CameraLogRingClaim(&_ring, &position);
+	if (!slot) {
+		return;
+	}
+
+	NSUInteger length = 0;
+	[message getBytes:slot->text maxLength:kCameraLogMessageLength usedLength:&length encoding:NSUTF8StringEncoding options:NSStringEncodingConversionAllowLossy range:NSMakeRange(0, message.length) remainingRange:NULL];
+	slot->time = CFAbsoluteTimeGetCurrent();
+	slot->level = level;
+	slot->length = (uint32_t)length;
+	CameraLogRingPublish(slot, position);
+	dispatch_source_merge_data(self.source, 1);
+}
+
+#pragma mark -
+
+/**
+ * Writes out the messages in the ring and waits until they reach the file.
+ */
+- (void)flush
+{
+	dispatch_sync(self.queue, ^{
+		[self drain];
+		if (_fileDescriptor >= 0) {
+			fsync(_fileDescriptor);
+		}
+	});
+}
+
+- (void)drain
+{
+	NSMutableData *buffer = nil;
+	const CameraLogSlot *slot;
+	while ((slot = CameraLogRingPeek(&_ring))) {
+		if (!buffer) {
+			buffer = [[NSMutableData alloc] initWithCapacity:4096];
+		}
+		[self appendSlot:slot toBuffer:buffer];
+		CameraLogRingRelease(&_ring);
+	}
+	if (buffer.length > 0) {
+		[self writeData:buffer];
+	}
+}
+
+- (void)appendSlot:(const CameraLogSlot *)slot toBuffer:(NSMutableData *)buffer
+{
+	static const char levelMarks[] = { 'E', 'W', 'I', 'D' };
+	char mark = (slot->level >= 0 && (size_t)slot->level < sizeof(levelMarks)) ? levelMarks[slot->level] : '?';
+
+	CFAbsoluteTime time = slot->time + kCFAbsoluteTimeIntervalSince1970;
+	time_t seconds = (time_t)time;
+	struct tm components;
+	localtime_r(&seconds, &components);
+	char header[48];
+	size_t headerLength = strftime(header, sizeof(header), "%Y-%m-%d %H:%M:%S", &components);
+	headerLength += snprintf(header + headerLength, sizeof(header) - headerLength, ".%03d [%c] ", (int)((time - seconds) * 1000.0), mark);
+
+	[buffer appendBytes:header length:MIN(headerLength, sizeof(header) - 1)];
+	[buffer appendBytes:slot->text length:slot->length];
+	[buffer appendBytes:"\n" length:1];
+}
+
+- (void)writeData:(NSData *)data
+{
+	if (_fileDescriptor >= 0 && self.fileSize + data.length > self.maximumFileSize) {
+		[self rotateFiles];
+	}
+	if (_fileDescriptor < 0 && ![self openFile]) {
+		return;
+	}
+	const uint8_t *bytes = data.bytes;
+	size_t remaining = data.length;
+	while (remaining > 0) {
+		ssize_t written = write(_fileDescriptor, bytes, remaining);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+		bytes += written;
+		remaining -= (size_t)written;
+		self.fileSize += (unsigned long long)written;
+	}
+}
+
+- (BOOL)openFile
+{
+	NSString *path = [self.directoryURL URLByAppendingPathComponent:CameraLogFileName].path;
+	_fileDescriptor = open(path.fileSystemRepresentation, O_WRONLY | O_CREAT | O_APPEND, 0644);
+	if (_fileDescriptor < 0) {
+		return NO;
+	}
+	struct stat status;
+	self.fileSize = (fstat(_fileDescriptor, &status) == 0) ? (unsigned long long)status.st_size : 0;
+	return YES;
+}
+
+- (void)rotateFiles
+{
+	close(_fileDescriptor);
+	_fileDescriptor = -1;
+
+	NSString *path = [self.directoryURL URLByAppendingPathComponent:CameraLogFileName].path;
+	NSUInteger count = self.maximumFileCount;
+	if (count == 0) {
+		unlink(path.fileSystemRepresentation);
+		return;
+	}
+	NSString *oldest = [path stringByAppendingFormat:@".%lu", (unsigned long)count];
+	unlink(oldest.fileSystemRepresentation);
+	for (NSUInteger index = count - 1; index >= 1; index--) {
+		NSString *from = [path stringByAppendingFormat:@".%lu", (unsigned long)index];
+		NSString *to = [path stringByAppendingFormat:@".%lu", (unsigned long)(index + 1)];
+		rename(from.fileSystemRepresentation, to.fileSystemRepresentation);
+	}
+	rename(path.fileSystemRepresentation, [path stringByAppendingString:@".1"].fileSystemRepresentation);
+}
+
+@end
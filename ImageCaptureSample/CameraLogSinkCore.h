@@ -0,0 +1,145 @@
+//
+//  CameraLogSinkCore.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#ifndef ImageCaptureSample_CameraLogSinkCore_h
+#define ImageCaptureSample_CameraLogSinkCore_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * The message ring of CameraLogSink in plain C, so that it can also be built,
+ * checked and measured off the device. Any number of threads put messages in;
+ * one thread takes them out.
+ */
+
+enum
+{
+	kCameraLogRingCapacity = 512,	// Must be a power of two.
+	kCameraLogMessageLength = 232,
+};
+
+/**
+ * A message in the ring. The sequence tells whose turn the slot is:
+ * a producer may fill it when it equals the position, the writer may read it
+ * when it equals the position plus one.
+ */
+struct CameraLogSlot
+{
+	volatile int64_t sequence;
+	double time;
+	int level;
+	uint32_t length;
+	char text[kCameraLogMessageLength];
+};
+
+typedef struct CameraLogSlot CameraLogSlot;
+
+struct CameraLogRing
+{
+	CameraLogSlot *slots;
+	volatile int64_t enqueuePosition;
+	/** Only the writer touches this. */
+	int64_t dequeuePosition;
+	volatile int32_t droppedCount;
+	volatile int32_t writtenCount;
+};
+
+typedef struct CameraLogRing CameraLogRing;
+
+/**
+ * Sets up an empty ring.
+ *
+ * @return false if the slots could not be allocated.
+ */
+static inline bool CameraLogRingInit(CameraLogRing *ring)
+{
+	*ring = (CameraLogRing){0};
+	ring->slots = calloc(kCameraLogRingCapacity, sizeof(CameraLogSlot));
+	if (!ring->slots) {
+		return false;
+	}
+	for (int64_t index = 0; index < kCameraLogRingCapacity; index++) {
+		ring->slots[index].sequence = index;
+	}
+	return true;
+}
+
+static inline void CameraLogRingDestroy(CameraLogRing *ring)
+{
+	free(ring->slots);
+	ring->slots = NULL;
+}
+
+/**
+ * Claims the next free slot for a producer, without a lock.
+ *
+ * The producer fills the slot and hands it over with CameraLogRingPublish.
+ *
+ * @return The slot, or NULL if the writer has fallen behind and the ring is full;
+ * the message is counted as dropped then.
+ */
+static inline CameraLogSlot *CameraLogRingClaim(CameraLogRing *ring, int64_t *position)
+{
+	int64_t claimed = ring->enqueuePosition;
+	for (;;) {
+		CameraLogSlot *slot = &ring->slots[claimed & (kCameraLogRingCapacity - 1)];
+		int64_t difference = slot->sequence - claimed;
+		if (difference == 0) {
+			if (__sync_bool_compare_and_swap(&ring->enqueuePosition, claimed, claimed + 1)) {
+				*position = claimed;
+				return slot;
+			}
+		} else if (difference < 0) {
+			// The writer has not freed this slot yet; the ring is full.
+			__sync_fetch_and_add(&ring->droppedCount, 1);
+			return NULL;
+		}
+		claimed = ring->enqueuePosition;
+	}
+}
+
+/**
+ * Hands a filled slot over to the writer.
+ */
+static inline void CameraLogRingPublish(CameraLogSlot *slot, int64_t position)
+{
+	// The message must be complete before the writer can see the slot as its turn.
+	__sync_synchronize();
+	slot->sequence = position + 1;
+}
+
+/**
+ * Returns the oldest published message for the writer, or NULL if there is none.
+ *
+ * The slot stays the writer's until CameraLogRingRelease.
+ */
+static inline const CameraLogSlot *CameraLogRingPeek(CameraLogRing *ring)
+{
+	CameraLogSlot *slot = &ring->slots[ring->dequeuePosition & (kCameraLogRingCapacity - 1)];
+	if (slot->sequence != ring->dequeuePosition + 1) {
+		return NULL;
+	}
+	__sync_synchronize();
+	return slot;
+}
+
+/**
+ * Frees the slot returned by CameraLogRingPeek for the producers and counts its message as written.
+ */
+static inline void CameraLogRingRelease(CameraLogRing *ring)
+{
+	CameraLogSlot *slot = &ring->slots[ring->dequeuePosition & (kCameraLogRingCapacity - 1)];
+	__sync_synchronize();
+	slot->sequence = ring->dequeuePosition + kCameraLogRingCapacity;
+	ring->dequeuePosition++;
+	__sync_fetch_and_add(&ring->writtenCount, 1);
+}
+
+#endif
@@ -0,0 +1,39 @@
+//
+//  CameraPropertyCache.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <OLYCameraKit/OLYCamera.h>
+
+/**
+ * Keeps a snapshot of the camera property values so that the UI does not ask the camera every time.
+ *
+ * The snapshot is loaded in one batched request and a property is dropped from it
+ * when the camera reports that the property changed; the next read fetches it again.
+ * Value lists are kept per property and take mode, since the choices depend on the mode.
+ * Reads never take a lock: the snapshot is an immutable dictionary that is replaced
+ * as a whole on every update. Reads and writes may be called on any thread.
+ */
+@interface CameraPropertyCache : NSObject
+
+/** The number of reads answered from the snapshot without asking the camera. */
+@property (assign, nonatomic, readonly) NSUInteger avoidedRoundTrips;
+/** The number of reads that had to ask the camera. */
+@property (assign, nonatomic, readonly) NSUInteger roundTrips;
+/** Called with the duration of every request to the camera, on the thread that made it. */
+@property (copy, atomic) void (^roundTripHandler)(NSTimeInterval latency);
+
+- (id)initWithCamera:(OLYCamera *)camera;
+- (BOOL)loadValuesForProperties:(NSArray *)names error:(NSError **)error;
+- (NSString *)valueForProperty:(NSString *)name error:(NSError **)error;
+- (NSArray *)valueListForProperty:(NSString *)name error:(NSError **)error;
+- (NSDictionary *)valuesForProperties:(NSArray *)names error:(NSError **)error;
+- (BOOL)setValue:(NSString *)value forProperty:(NSString *)name error:(NSError **)error;
+- (void)assumeValues:(NSDictionary *)values;
+- (void)invalidateProperty:(NSString *)name;
+- (void)invalidateAll;
+
+@end
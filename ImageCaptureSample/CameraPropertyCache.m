@@ -0,0 +1,264 @@
+//
+//  CameraPropertyCache.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "CameraPropertyCache.h"
+#import <libkern/OSAtomic.h>
+#import "AppDelegate.h"
+#import "Trace.h"
+
+@interface CameraPropertyCache ()
+{
+	volatile int32_t _hitCount;
+	volatile int32_t _missCount;
+	volatile int32_t _invalidationCount;
+}
+
+@property (weak, nonatomic) OLYCamera *camera;
+// Immutable snapshots; replaced as a whole under the lock, read without it.
+@property (strong, atomic) NSDictionary *values;
+@property (strong, atomic) NSDictionary *valueLists;
+
+@end
+
+@implementation CameraPropertyCache
+
+- (id)initWithCamera:(OLYCamera *)camera
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	_camera = camera;
+	_values = @{};
+	_valueLists = @{};
+	return self;
+}
+
+- (NSUInteger)avoidedRoundTrips
+{
+	return (NSUInteger)_hitCount;
+}
+
+- (NSUInteger)roundTrips
+{
+	return (NSUInteger)_missCount;
+}
+
+#pragma mark -
+
+/**
+ * Replaces the snapshot of the given properties with their current values in one request.
+ */
+- (BOOL)loadValuesForProperties:(NSArray *)names error:(NSError **)error
+{
+	int32_t invalidationCount = _invalidationCount;
+	OSAtomicIncrement32(&_missCount);
+	TRACE_BEGIN("camera.cameraPropertyValues");
+	CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+	NSDictionary *values = [self.camera cameraPropertyValues:[NSSet setWithArray:names] error:error];
+	TRACE_END("camera.cameraPropertyValues");
+	[self reportRoundTripSince:startTime];
+	if (!values) {
+		return NO;
+	}
+	[self storeValues:values ifNotInvalidatedSince:invalidationCount];
+	return YES;
+}
+
+- (NSString *)valueForProperty:(NSString *)name error:(NSError **)error
+{
+	NSString *value = self.values[name];
+	if (value) {
+		OSAtomicIncrement32(&_hitCount);
+		return value;
+	}
+
+	int32_t invalidationCount = _invalidationCount;
+	OSAtomicIncrement32(&_missCount);
+	TRACE_BEGIN("camera.cameraPropertyValue");
+	CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+	value = [self.camera cameraPropertyValue:name error:error];
+	TRACE_END("camera.cameraPropertyValue");
+	[self reportRoundTripSince:startTime];
+	if (value) {
+		[self storeValues:@{name: value} ifNotInvalidatedSince:invalidationCount];
+	}
+	return value;
+}
+
+/**
+ * Returns the values that the property can take in the current take mode.
+ */
+- (NSArray *)valueListForProperty:(NSString *)name error:(NSError **)error
+{
+	NSString *takemode = [name isEqualToString:ICSCameraPropertyTakemode] ? @"" : [self valueForProperty:ICSCameraPropertyTakemode error:error];
+	if (!takemode) {
+		return nil;
+	}
+	NSString *key = [NSString stringWithFormat:@"%@|%@", name, takemode];
+	NSArray *valueList = self.valueLists[key];
+	if (valueList) {
+		OSAtomicIncrement32(&_hitCount);
+		return valueList;
+	}
+
+	int32_t invalidationCount = _invalidationCount;
+	OSAtomicIncrement32(&_missCount);
+	TRACE_BEGIN("camera.cameraPropertyValueList");
+	CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+	valueList = [self.camera cameraPropertyValueList:name error:error];
+	TRACE_END("camera.cameraPropertyValueList");
+	[self reportRoundTripSince:startTime];
+	if (valueList) {
+		@synchronized (self) {
+			// A change reported while the request was in flight may have changed the choices too.
+			if (invalidationCount == _invalidationCount) {
+				NSMutableDictionary *valueLists = [self.valueLists mutableCopy];
+				valueLists[key] = [valueList copy];
+				self.valueLists = valueLists;
+			}
+		}
+	}
+	return valueList;
+}
+
+/**
+ * Returns the values of the given properties, asking the camera only for the ones not in the snapshot.
+ */
+- (NSDictionary *)valuesForProperties:(NSArray *)names error:(NSError **)error
+{
+	NSDictionary *snapshot = self.values;
+	NSMutableDictionary *values = [[NSMutableDictionary alloc] initWithCapacity:names.count];
+	NSMutableSet *missingNames = [[NSMutableSet alloc] init];
+	for (NSString *name in names) {
+		if (snapshot[name]) {
+			values[name] = snapshot[name];
+		} else {
+			[missingNames addObject:name];
+		}
+	}
+	if (missingNames.count == 0) {
+		OSAtomicIncrement32(&_hitCount);
+		return values;
+	}
+
+	int32_t invalidationCount = _invalidationCount;
+	OSAtomicIncrement32(&_missCount);
+	TRACE_BEGIN("camera.cameraPropertyValues");
+	CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+	NSDictionary *fetchedValues = [self.camera cameraPropertyValues:missingNames error:error];
+	TRACE_END("camera.cameraPropertyValues");
+	[self reportRoundTripSince:startTime];
+	if (!fetchedValues) {
+		return nil;
+	}
+	[self storeValues:fetchedValues ifNotInvalidatedSince:invalidationCount];
+	[values addEntriesFromDictionary:fetchedValues];
+	return values;
+}
+
+/**
+ * Changes a property of the camera and the snapshot together.
+ */
+- (BOOL)setValue:(NSString *)value forProperty:(NSString *)name error:(NSError **)error
+{
+	// A change reported during the write must win over the value written.
+	int32_t invalidationCount = _invalidationCount;
+	TRACE_BEGIN("camera.setCameraPropertyValue");
+	CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+	BOOL result = [self.camera setCameraPropertyValue:name value:value error:error];
+	TRACE_END("camera.setCameraPropertyValue");
+	[self reportRoundTripSince:startTime];
+	if (!result) {
+		[self invalidateProperty:name];
+		return NO;
+	}
+	// The camera reports the change afterwards, which drops the entry again if the value was adjusted.
+	[self storeValues:@{name: value} ifNotInvalidatedSince:invalidationCount];
+	return YES;
+}
+
+/**
+ * Puts values into the snapshot ahead of a write that is still in flight.
+ * The writer must invalidate them once the write has finished.
+ */
+- (void)assumeValues:(NSDictionary *)values
+{
+	if (values.count == 0) {
+		return;
+	}
+	@synchronized (self) {
+		NSMutableDictionary *snapshot = [self.values mutableCopy];
+		[snapshot addEntriesFromDictionary:values];
+		self.values = snapshot;
+	}
+}
+
+/**
+ * Drops a property and its value lists from the snapshot. Called when the camera reports that the property changed.
+ */
+- (void)invalidateProperty:(NSString *)name
+{
+	@synchronized (self) {
+		OSAtomicIncrement32(&_invalidationCount);
+		if (self.values[name]) {
+			NSMutableDictionary *values = [self.values mutableCopy];
+			[values removeObjectForKey:name];
+			self.values = values;
+		}
+		NSString *prefix = [name stringByAppendingString:@"|"];
+		NSMutableDictionary *valueLists = nil;
+		for (NSString *key in self.valueLists) {
+			if ([key hasPrefix:prefix]) {
+				if (!valueLists) {
+					valueLists = [self.valueLists mutableCopy];
+				}
+				[valueLists removeObjectForKey:key];
+			}
+		}
+		if (valueLists) {
+			self.valueLists = valueLists;
+		}
+	}
+}
+
+/**
+ * Drops everything; used when the connection changes and the camera may have been changed meanwhile.
+ */
+- (void)invalidateAll
+{
+	@synchronized (self) {
+		OSAtomicIncrement32(&_invalidationCount);
+		self.values = @{};
+		self.valueLists = @{};
+	}
+}
+
+#pragma mark -
+
+- (void)reportRoundTripSince:(CFAbsoluteTime)startTime
+{
+	void (^handler)(NSTimeInterval) = self.roundTripHandler;
+	if (handler) {
+		handler(CFAbsoluteTimeGetCurrent() - startTime);
+	}
+}
+
+- (void)storeValues:(NSDictionary *)newValues ifNotInvalidatedSince:(int32_t)invalidationCount
+{
+	@synchronized (self) {
+		// A change reported while the request was in flight makes the fetched values stale.
+		if (invalidationCount != _invalidationCount) {
+			return;
+		}
+		NSMutableDictionary *values = [self.values mutableCopy];
+		[values addEntriesFromDictionary:newValues];
+		self.values = values;
+	}
+}
+
+@end
@@ -0,0 +1,64 @@
+//
+//  CaptureController.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <OLYCameraKit/OLYCamera.h>
+
+enum CaptureControllerState
+{
+	CaptureControllerStateIdle,
+	CaptureControllerStateTaking,
+	CaptureControllerStateWaitingForMedia,
+	CaptureControllerStateStarting,
+	CaptureControllerStateSequential,
+	CaptureControllerStateStopping,
+};
+
+typedef enum CaptureControllerState CaptureControllerState;
+
+@class CaptureController;
+
+@protocol CaptureControllerDelegate <NSObject>
+@optional
+
+- (void)captureController:(CaptureController *)controller didChangeProgress:(OLYCameraTakingProgress)progress info:(NSDictionary *)info;
+- (void)captureControllerDidFinishShot:(CaptureController *)controller;
+- (void)captureController:(CaptureController *)controller didFailWithError:(NSError *)error;
+
+@end
+
+/**
+ * Queues shutter requests and issues them to the camera one after another.
+ *
+ * The next shot starts focusing as soon as the camera finishes the previous one,
+ * while the camera is still writing it to the media. When too many shots are
+ * waiting to be written, the controller holds the queue until the media is free.
+ * All methods must be called on the main thread; the UI is never blocked.
+ */
+@interface CaptureController : NSObject
+
+@property (weak, nonatomic) id<CaptureControllerDelegate> delegate;
+@property (assign, nonatomic, readonly) CaptureControllerState state;
+/** The number of shots waiting to be issued. */
+@property (assign, nonatomic, readonly) NSUInteger queueDepth;
+/** The tag of the shot in progress, as given to requestShotWithTag:. Sequential shooting has tag 0. */
+@property (assign, nonatomic, readonly) NSInteger currentShotTag;
+/** The shooting rate over the most recent shots. */
+@property (assign, nonatomic, readonly) double shotsPerSecond;
+/** The maximum number of shots waiting to be issued. Further requests are dropped. (default: 8) */
+@property (assign, nonatomic) NSUInteger maximumQueueDepth;
+/** The number of shots the camera may buffer while the media is busy. (default: 2) */
+@property (assign, nonatomic) NSUInteger maximumUnwrittenShots;
+
+- (id)initWithCamera:(OLYCamera *)camera;
+- (BOOL)requestShot;
+- (BOOL)requestShotWithTag:(NSInteger)tag;
+- (void)beginSequentialShooting;
+- (void)endSequentialShooting;
+- (void)cancelPendingShots;
+
+@end
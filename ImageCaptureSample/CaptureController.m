@@ -0,0 +1,294 @@
+//
+//  CaptureController.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "CaptureController.h"
+#import "Trace.h"
+
+// The number of recent shots the shooting rate is measured over.
+static const NSUInteger kShotRateWindow = 8;
+
+static void *const CaptureControllerMediaBusyContext = (void *)&CaptureControllerMediaBusyContext;
+
+@interface CaptureController ()
+
+@property (weak, nonatomic) OLYCamera *camera;
+@property (assign, nonatomic, readwrite) CaptureControllerState state;
+@property (assign, nonatomic, readwrite) NSUInteger queueDepth;
+@property (assign, nonatomic, readwrite) NSInteger currentShotTag;
+@property (strong, nonatomic) NSMutableArray *queuedShotTags;
+@property (assign, nonatomic) NSUInteger unwrittenShots;
+@property (assign, nonatomic) BOOL sequentialRequested;
+@property (assign, nonatomic) BOOL stopRequested;
+@property (strong, nonatomic) NSMutableArray *shotTimes;
+
+@end
+
+@implementation CaptureController
+
+- (id)initWithCamera:(OLYCamera *)camera
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	_camera = camera;
+	_state = CaptureControllerStateIdle;
+	_maximumQueueDepth = 8;
+	_maximumUnwrittenShots = 2;
+	_shotTimes = [[NSMutableArray alloc] initWithCapacity:kShotRateWindow];
+	_queuedShotTags = [[NSMutableArray alloc] init];
+	[camera addObserver:self forKeyPath:@"mediaBusy" options:0 context:CaptureControllerMediaBusyContext];
+	return self;
+}
+
+- (void)dealloc
+{
+	@try {
+		[_camera removeObserver:self forKeyPath:@"mediaBusy" context:CaptureControllerMediaBusyContext];
+	}
+	@catch (NSException *exception) {
+		// Ignore all exceptions.
+	}
+}
+
+/**
+ * Queues a single shot with tag 0.
+ *
+ * @return NO if the queue is full and the request was dropped.
+ */
+- (BOOL)requestShot
+{
+	return [self requestShotWithTag:0];
+}
+
+/**
+ * Queues a single shot. The tag is the currentShotTag while the shot is in progress,
+ * so the delegate can tell whose shot the progress belongs to.
+ *
+ * @return NO if the queue is full and the request was dropped.
+ */
+- (BOOL)requestShotWithTag:(NSInteger)tag
+{
+	if (self.queueDepth >= self.maximumQueueDepth) {
+		return NO;
+	}
+	[self.queuedShotTags addObject:@(tag)];
+	self.queueDepth++;
+	[self issueNextShot];
+	return YES;
+}
+
+/**
+ * Starts sequential shooting as soon as the camera is free.
+ */
+- (void)beginSequentialShooting
+{
+	self.sequentialRequested = YES;
+	self.stopRequested = NO;
+	[self issueNextShot];
+}
+
+/**
+ * Ends sequential shooting, or drops it if it has not started yet.
+ */
+- (void)endSequentialShooting
+{
+	if (self.state == CaptureControllerStateSequential) {
+		[self stopSequentialShooting];
+	} else if (self.state == CaptureControllerStateStarting) {
+		// The start request is still in flight; the camera cannot stop before it has started.
+		self.stopRequested = YES;
+	} else if (self.sequentialRequested) {
+		// The start is still waiting for the camera; it is not issued at all.
+		self.sequentialRequested = NO;
+		[self issueNextShot];
+	}
+}
+
+/**
+ * Drops queued shots. The shot in progress is completed.
+ */
+- (void)cancelPendingShots
+{
+	[self.queuedShotTags removeAllObjects];
+	self.queueDepth = 0;
+	self.sequentialRequested = NO;
+	self.stopRequested = NO;
+}
+
+/**
+ * Returns the shooting rate over the most recent shots.
+ */
+- (double)shotsPerSecond
+{
+	if (self.shotTimes.count < 2) {
+		return 0;
+	}
+	CFAbsoluteTime first = [self.shotTimes.firstObject doubleValue];
+	CFAbsoluteTime last = [self.shotTimes.lastObject doubleValue];
+	if (last <= first) {
+		return 0;
+	}
+	return (double)(self.shotTimes.count - 1) / (last - first);
+}
+
+#pragma mark -
+
+- (void)issueNextShot
+{
+	if (self.state != CaptureControllerStateIdle && self.state != CaptureControllerStateWaitingForMedia) {
+		return;
+	}
+	if (self.queueDepth == 0 && !self.sequentialRequested) {
+		self.state = CaptureControllerStateIdle;
+		return;
+	}
+
+	// Backpressure: the camera buffers a few shots while writing, but not indefinitely.
+	OLYCamera *camera = self.camera;
+	if (camera.mediaBusy && self.unwrittenShots >= self.maximumUnwrittenShots) {
+		self.state = CaptureControllerStateWaitingForMedia;
+		return;
+	}
+
+	if (self.sequentialRequested) {
+		self.currentShotTag = 0;
+		[self startSequentialShooting];
+	} else {
+		self.currentShotTag = [self.queuedShotTags.firstObject integerValue];
+		[self.queuedShotTags removeObjectAtIndex:0];
+		self.queueDepth--;
+		[self takePicture];
+	}
+}
+
+- (void)takePicture
+{
+	self.state = CaptureControllerStateTaking;
+	TRACE_INSTANT("camera.takePicture.issue", self.queueDepth);
+
+	__weak CaptureController *weakSelf = self;
+	[self.camera takePicture:nil progressHandler:^(OLYCameraTakingProgress progress, NSDictionary *info) {
+		[weakSelf notifyProgress:progress info:info];
+
+	} completionHandler:^(NSDictionary *info) {
+		TRACE_INSTANT("camera.takePicture.complete", 0);
+		[weakSelf shotDidFinish];
+
+	} errorHandler:^(NSError *error) {
+		TRACE_INSTANT("camera.takePicture.error", error.code);
+		[weakSelf shotDidFailWithError:error];
+
+	}];
+}
+
+- (void)startSequentialShooting
+{
+	self.state = CaptureControllerStateStarting;
+	self.sequentialRequested = NO;
+
+	__weak CaptureController *weakSelf = self;
+	[self.camera startTakingPicture:nil progressHandler:^(OLYCameraTakingProgress progress, NSDictionary *info) {
+		[weakSelf notifyProgress:progress info:info];
+
+	} completionHandler:^{
+		[weakSelf sequentialShootingDidStart];
+
+	} errorHandler:^(NSError *error) {
+		[weakSelf shotDidFailWithError:error];
+
+	}];
+}
+
+- (void)sequentialShootingDidStart
+{
+	if (self.state != CaptureControllerStateStarting) {
+		return;
+	}
+	self.state = CaptureControllerStateSequential;
+	// The shooting was ended while the start was in flight.
+	if (self.stopRequested) {
+		[self stopSequentialShooting];
+	}
+}
+
+- (void)stopSequentialShooting
+{
+	self.state = CaptureControllerStateStopping;
+	self.stopRequested = NO;
+
+	__weak CaptureController *weakSelf = self;
+	[self.camera stopTakingPicture:^(OLYCameraTakingProgress progress, NSDictionary *info) {
+		[weakSelf notifyProgress:progress info:info];
+
+	} completionHandler:^(NSDictionary *info) {
+		[weakSelf shotDidFinish];
+
+	} errorHandler:^(NSError *error) {
+		[weakSelf shotDidFailWithError:error];
+
+	}];
+}
+
+- (void)notifyProgress:(OLYCameraTakingProgress)progress info:(NSDictionary *)info
+{
+	if ([self.delegate respondsToSelector:@selector(captureController:didChangeProgress:info:)]) {
+		[self.delegate captureController:self didChangeProgress:progress info:info];
+	}
+}
+
+- (void)shotDidFinish
+{
+	[self.shotTimes addObject:@(CFAbsoluteTimeGetCurrent())];
+	if (self.shotTimes.count > kShotRateWindow) {
+		[self.shotTimes removeObjectAtIndex:0];
+	}
+	if (self.camera.mediaBusy) {
+		self.unwrittenShots++;
+	}
+	self.state = CaptureControllerStateIdle;
+
+	if ([self.delegate respondsToSelector:@selector(captureControllerDidFinishShot:)]) {
+		[self.delegate captureControllerDidFinishShot:self];
+	}
+	[self issueNextShot];
+}
+
+- (void)shotDidFailWithError:(NSError *)error
+{
+	// Do not keep shooting into a failing camera.
+	[self cancelPendingShots];
+	self.state = CaptureControllerStateIdle;
+
+	if ([self.delegate respondsToSelector:@selector(captureController:didFailWithError:)]) {
+		[self.delegate captureController:self didFailWithError:error];
+	}
+}
+
+#pragma mark - Camera event handlings
+
+- (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context
+{
+	if (context != CaptureControllerMediaBusyContext) {
+		[super observeValueForKeyPath:keyPath ofObject:object change:change context:context];
+		return;
+	}
+	if (![NSThread isMainThread]) {
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[self observeValueForKeyPath:keyPath ofObject:object change:change context:context];
+		});
+		return;
+	}
+	if (!self.camera.mediaBusy) {
+		self.unwrittenShots = 0;
+		if (self.state == CaptureControllerStateWaitingForMedia) {
+			[self issueNextShot];
+		}
+	}
+}
+
+@end
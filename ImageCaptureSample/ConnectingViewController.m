@@ -38,6 +38,10 @@ static NSString *const kNextViewControllerIdentifier = @"ImageCapture";
 {
 	NSString *state = notification.userInfo[kConnectionStateKey];
 	if (state == kConnectionStateConnected) {
+		// A warm start after a short interruption finds the camera's screen still presented.
+		if (self.presentedViewController) {
+			return;
+		}
 		[self presentViewController:[self.storyboard instantiateViewControllerWithIdentifier:kNextViewControllerIdentifier] animated:NO completion:^{
 			if (!AppDelegateCamera().connected) {
 				[self.presentedViewController dismissViewControllerAnimated:NO completion:nil];
@@ -0,0 +1,92 @@
+//
+//  ConnectionHealthMonitor.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <OLYCameraKit/OLYCamera.h>
+#import "ConnectionHealthMonitorCore.h"
+
+/**
+ * Decides how the live view quality follows the health of the connection.
+ */
+@protocol LiveViewQualityPolicy <NSObject>
+
+/**
+ * @return -1 to step the quality down, +1 to step it up or 0 to keep it.
+ */
+- (NSInteger)stepChangeForSample:(ConnectionHealthSample)sample currentStep:(NSUInteger)step maximumStep:(NSUInteger)maximumStep;
+- (void)reset;
+
+@end
+
+/**
+ * Steps down after a few bad windows in a row and up after a longer run of good ones.
+ *
+ * A step up that turns out bad soon after doubles the number of good windows
+ * required before the next try, so a link at the edge of its capacity settles
+ * instead of oscillating between two sizes.
+ */
+@interface HysteresisQualityPolicy : NSObject <LiveViewQualityPolicy>
+
+/** A window whose mean frame interval exceeds this is bad. (default: 0.2) */
+@property (assign, nonatomic) NSTimeInterval degradedFrameInterval;
+/** A window whose mean frame interval is below this is good. (default: 0.1) */
+@property (assign, nonatomic) NSTimeInterval healthyFrameInterval;
+/** A window with a gap between frames longer than this is bad. (default: 1.0) */
+@property (assign, nonatomic) NSTimeInterval stallInterval;
+/** A window whose mean command latency exceeds this is bad. (default: 0.3) */
+@property (assign, nonatomic) NSTimeInterval degradedCommandLatency;
+/** The number of bad windows in a row before stepping down. (default: 2) */
+@property (assign, nonatomic) NSUInteger degradeWindows;
+/** The number of good windows in a row before stepping up. (default: 5) */
+@property (assign, nonatomic) NSUInteger recoverWindows;
+
+@end
+
+@class ConnectionHealthMonitor;
+
+@protocol ConnectionHealthMonitorDelegate <NSObject>
+
+- (void)healthMonitor:(ConnectionHealthMonitor *)monitor changeLiveViewSize:(OLYCameraLiveViewSize)size;
+
+@optional
+
+/**
+ * @return NO while the live view is not expected to stream, e.g. in the playback mode.
+ * The windows are not evaluated meanwhile. (default: YES)
+ */
+- (BOOL)healthMonitorShouldEvaluate:(ConnectionHealthMonitor *)monitor;
+
+@end
+
+/**
+ * Watches the live view frames and the command latency, and adapts the live view size to them.
+ *
+ * The size moves along QVGA, VGA, SVGA and XGA but never above the size the user chose.
+ * The monitor does not talk to the camera itself; samples can be fed with explicit
+ * times, so a recorded trace replays the same decisions as the live connection.
+ * Frames and evaluation must be reported on the main thread; latencies on any thread.
+ * Both are also traced as liveview.frame and camera.command.latency, so that a trace
+ * taken on the device can be replayed by the tests.
+ */
+@interface ConnectionHealthMonitor : NSObject
+
+@property (weak, nonatomic) id<ConnectionHealthMonitorDelegate> delegate;
+@property (strong, nonatomic) id<LiveViewQualityPolicy> policy;
+/** The length of an evaluation window. (default: 1.0) */
+@property (assign, nonatomic) NSTimeInterval evaluationInterval;
+@property (assign, nonatomic, readonly) OLYCameraLiveViewSize liveViewSize;
+@property (assign, nonatomic, readonly) ConnectionHealthSample lastSample;
+
+- (void)resetWithMaximumLiveViewSize:(OLYCameraLiveViewSize)size;
+- (void)startMonitoring;
+- (void)stopMonitoring;
+- (void)recordLiveFrameOfLength:(NSUInteger)length;
+- (void)recordLiveFrameOfLength:(NSUInteger)length atTime:(NSTimeInterval)time;
+- (void)recordCommandLatency:(NSTimeInterval)latency;
+- (void)evaluateAtTime:(NSTimeInterval)time;
+
+@end
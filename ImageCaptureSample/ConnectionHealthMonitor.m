@@ -0,0 +1,241 @@
+//
+//  ConnectionHealthMonitor.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "ConnectionHealthMonitor.h"
+#import "Trace.h"
+
+@implementation HysteresisQualityPolicy
+{
+	HysteresisQualityPolicyState _state;
+}
+
+- (id)init
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	HysteresisQualityPolicyInit(&_state);
+	return self;
+}
+
+- (NSTimeInterval)degradedFrameInterval
+{
+	return _state.degradedFrameInterval;
+}
+
+- (void)setDegradedFrameInterval:(NSTimeInterval)degradedFrameInterval
+{
+	_state.degradedFrameInterval = degradedFrameInterval;
+}
+
+- (NSTimeInterval)healthyFrameInterval
+{
+	return _state.healthyFrameInterval;
+}
+
+- (void)setHealthyFrameInterval:(NSTimeInterval)healthyFrameInterval
+{
+	_state.healthyFrameInterval = healthyFrameInterval;
+}
+
+- (NSTimeInterval)stallInterval
+{
+	return _state.stallInterval;
+}
+
+- (void)setStallInterval:(NSTimeInterval)stallInterval
+{
+	_state.stallInterval = stallInterval;
+}
+
+- (NSTimeInterval)degradedCommandLatency
+{
+	return _state.degradedCommandLatency;
+}
+
+- (void)setDegradedCommandLatency:(NSTimeInterval)degradedCommandLatency
+{
+	_state.degradedCommandLatency = degradedCommandLatency;
+}
+
+- (NSUInteger)degradeWindows
+{
+	return _state.degradeWindows;
+}
+
+- (void)setDegradeWindows:(NSUInteger)degradeWindows
+{
+	_state.degradeWindows = degradeWindows;
+}
+
+- (NSUInteger)recoverWindows
+{
+	return _state.recoverWindows;
+}
+
+- (void)setRecoverWindows:(NSUInteger)recoverWindows
+{
+	_state.recoverWindows = recoverWindows;
+}
+
+- (void)reset
+{
+	HysteresisQualityPolicyReset(&_state);
+}
+
+- (NSInteger)stepChangeForSample:(ConnectionHealthSample)sample currentStep:(NSUInteger)step maximumStep:(NSUInteger)maximumStep
+{
+	return HysteresisQualityPolicyStepChange(&_state, &sample, step, maximumStep);
+}
+
+@end
+
+#pragma mark -
+
+@interface ConnectionHealthMonitor ()
+
+@property (assign, nonatomic, readwrite) ConnectionHealthSample lastSample;
+@property (strong, nonatomic) NSArray *sizes;
+@property (assign, nonatomic) NSUInteger step;
+@property (assign, nonatomic) NSUInteger maximumStep;
+@property (strong, nonatomic) NSTimer *evaluationTimer;
+
+@end
+
+@implementation ConnectionHealthMonitor
+{
+	// The command statistics are guarded by self; the rest is touched on the main thread only.
+	ConnectionHealthWindow _window;
+}
+
+- (id)init
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	_policy = [[HysteresisQualityPolicy alloc] init];
+	_evaluationInterval = 1.0;
+	_sizes = @[NSStringFromCGSize(OLYCameraLiveViewSizeQVGA),
+			   NSStringFromCGSize(OLYCameraLiveViewSizeVGA),
+			   NSStringFromCGSize(OLYCameraLiveViewSizeSVGA),
+			   NSStringFromCGSize(OLYCameraLiveViewSizeXGA)];
+	_maximumStep = _sizes.count - 1;
+	_step = _maximumStep;
+	return self;
+}
+
+- (void)dealloc
+{
+	[_evaluationTimer invalidate];
+}
+
+- (OLYCameraLiveViewSize)liveViewSize
+{
+	return CGSizeFromString(self.sizes[self.step]);
+}
+
+#pragma mark -
+
+/**
+ * Starts over at the given size, which is also the largest size the monitor will choose.
+ */
+- (void)resetWithMaximumLiveViewSize:(OLYCameraLiveViewSize)size
+{
+	NSUInteger index = [self.sizes indexOfObject:NSStringFromCGSize(size)];
+	self.maximumStep = (index != NSNotFound) ? index : self.sizes.count - 1;
+	self.step = self.maximumStep;
+	[self restartWindow];
+	[self.policy reset];
+}
+
+- (void)startMonitoring
+{
+	[self.evaluationTimer invalidate];
+	// Frames drive the evaluation; the timer only notices when they stop coming.
+	self.evaluationTimer = [NSTimer scheduledTimerWithTimeInterval:self.evaluationInterval target:self selector:@selector(evaluationTimerDidFire:) userInfo:nil repeats:YES];
+}
+
+- (void)stopMonitoring
+{
+	[self.evaluationTimer invalidate];
+	self.evaluationTimer = nil;
+}
+
+- (void)recordLiveFrameOfLength:(NSUInteger)length
+{
+	[self recordLiveFrameOfLength:length atTime:CFAbsoluteTimeGetCurrent()];
+}
+
+- (void)recordLiveFrameOfLength:(NSUInteger)length atTime:(NSTimeInterval)time
+{
+	TRACE_INSTANT("liveview.frame", length);
+	if (ConnectionHealthWindowRecordFrame(&_window, length, time, self.evaluationInterval)) {
+		[self evaluateAtTime:time];
+	}
+}
+
+- (void)recordCommandLatency:(NSTimeInterval)latency
+{
+	TRACE_INSTANT("camera.command.latency", latency * 1000000.0);
+	@synchronized (self) {
+		ConnectionHealthWindowRecordCommandLatency(&_window, latency);
+	}
+}
+
+/**
+ * Closes the current window and lets the policy decide on the live view size.
+ */
+- (void)evaluateAtTime:(NSTimeInterval)time
+{
+	ConnectionHealthSample sample;
+	BOOL closed;
+	@synchronized (self) {
+		closed = ConnectionHealthWindowClose(&_window, time, &sample);
+	}
+	if (!closed) {
+		return;
+	}
+	self.lastSample = sample;
+
+	NSInteger change = [self.policy stepChangeForSample:sample currentStep:self.step maximumStep:self.maximumStep];
+	NSUInteger step = ConnectionHealthNextStep(self.step, (int)MAX(-1, MIN(change, 1)), self.maximumStep);
+	if (step == self.step) {
+		return;
+	}
+	self.step = step;
+	// The first frame at the new size is delayed by the change; do not count it against the link.
+	_window.lastFrameTime = 0;
+	[self.delegate healthMonitor:self changeLiveViewSize:self.liveViewSize];
+}
+
+#pragma mark -
+
+- (void)evaluationTimerDidFire:(NSTimer *)timer
+{
+	if ([self.delegate respondsToSelector:@selector(healthMonitorShouldEvaluate:)] && ![self.delegate healthMonitorShouldEvaluate:self]) {
+		// Start a fresh window when the live view comes back.
+		[self restartWindow];
+		return;
+	}
+	NSTimeInterval now = CFAbsoluteTimeGetCurrent();
+	if (now - _window.windowStartTime >= self.evaluationInterval) {
+		[self evaluateAtTime:now];
+	}
+}
+
+- (void)restartWindow
+{
+	@synchronized (self) {
+		_window.windowStartTime = 0;
+		_window.lastFrameTime = 0;
+		ConnectionHealthWindowReset(&_window);
+	}
+}
+
+@end
@@ -0,0 +1,236 @@
+//
+//  ConnectionHealthMonitorCore.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#ifndef ImageCaptureSample_ConnectionHealthMonitorCore_h
+#define ImageCaptureSample_ConnectionHealthMonitorCore_h
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * The evaluation windows of ConnectionHealthMonitor and the decisions of
+ * HysteresisQualityPolicy in plain C, so that they can also be built and
+ * replayed against network traces off the device. Times are in seconds.
+ */
+
+/**
+ * Statistics of the connection over one evaluation window.
+ */
+struct ConnectionHealthSample
+{
+	double duration;
+	size_t frameCount;
+	double meanFrameInterval;
+	double maximumFrameInterval;
+	double bytesPerSecond;
+	size_t commandCount;
+	double meanCommandLatency;
+};
+
+typedef struct ConnectionHealthSample ConnectionHealthSample;
+
+/**
+ * What is known of the current window. A start or frame time of zero means none yet.
+ */
+typedef struct {
+	double windowStartTime;
+	double lastFrameTime;
+	size_t frameCount;
+	unsigned long long frameBytes;
+	double maximumFrameInterval;
+	size_t commandCount;
+	double commandLatencySum;
+} ConnectionHealthWindow;
+
+/**
+ * Clears the statistics of the window but keeps its times.
+ */
+static inline void ConnectionHealthWindowReset(ConnectionHealthWindow *window)
+{
+	window->frameCount = 0;
+	window->frameBytes = 0;
+	window->maximumFrameInterval = 0;
+	window->commandCount = 0;
+	window->commandLatencySum = 0;
+}
+
+/**
+ * Counts a live view frame received at time.
+ *
+ * @return true if the window has lasted evaluationInterval and is due to be closed.
+ */
+static inline bool ConnectionHealthWindowRecordFrame(ConnectionHealthWindow *window, size_t length, double time, double evaluationInterval)
+{
+	if (window->windowStartTime <= 0) {
+		window->windowStartTime = time;
+	}
+	if (window->lastFrameTime > 0 && time - window->lastFrameTime > window->maximumFrameInterval) {
+		window->maximumFrameInterval = time - window->lastFrameTime;
+	}
+	window->lastFrameTime = time;
+	window->frameCount++;
+	window->frameBytes += length;
+	return time - window->windowStartTime >= evaluationInterval;
+}
+
+static inline void ConnectionHealthWindowRecordCommandLatency(ConnectionHealthWindow *window, double latency)
+{
+	window->commandCount++;
+	window->commandLatencySum += latency;
+}
+
+/**
+ * Closes the window at time and starts the next one.
+ *
+ * @return false if there was no window to close; the next one starts at time then.
+ */
+static inline bool ConnectionHealthWindowClose(ConnectionHealthWindow *window, double time, ConnectionHealthSample *sample)
+{
+	if (window->windowStartTime <= 0) {
+		window->windowStartTime = time;
+		return false;
+	}
+	double duration = time - window->windowStartTime;
+	if (duration <= 0) {
+		return false;
+	}
+	sample->duration = duration;
+	sample->frameCount = window->frameCount;
+	sample->meanFrameInterval = (window->frameCount > 0) ? duration / window->frameCount : duration;
+	// A gap that is still open counts as well, otherwise a full stall would look healthy.
+	double openGap = (window->lastFrameTime > 0) ? time - window->lastFrameTime : duration;
+	sample->maximumFrameInterval = (window->maximumFrameInterval > openGap) ? window->maximumFrameInterval : openGap;
+	sample->bytesPerSecond = (double)window->frameBytes / duration;
+	sample->commandCount = window->commandCount;
+	sample->meanCommandLatency = (window->commandCount > 0) ? window->commandLatencySum / window->commandCount : 0;
+	window->windowStartTime = time;
+	ConnectionHealthWindowReset(window);
+	return true;
+}
+
+/**
+ * Returns the step after a change asked for by a policy, kept within 0 and maximumStep.
+ */
+static inline size_t ConnectionHealthNextStep(size_t step, int change, size_t maximumStep)
+{
+	if (change < 0) {
+		return (step > 0) ? step - 1 : 0;
+	}
+	if (change > 0) {
+		return (step < maximumStep) ? step + 1 : maximumStep;
+	}
+	return step;
+}
+
+typedef struct {
+	/** A window whose mean frame interval exceeds this is bad. */
+	double degradedFrameInterval;
+	/** A window whose mean frame interval is below this is good. */
+	double healthyFrameInterval;
+	/** A window with a gap between frames longer than this is bad. */
+	double stallInterval;
+	/** A window whose mean command latency exceeds this is bad. */
+	double degradedCommandLatency;
+	/** The number of bad windows in a row before stepping down. */
+	size_t degradeWindows;
+	/** The number of good windows in a row before stepping up. */
+	size_t recoverWindows;
+	size_t badWindows;
+	size_t goodWindows;
+	size_t requiredGoodWindows;
+	bool probing;
+	size_t windowsSinceStepUp;
+} HysteresisQualityPolicyState;
+
+static inline void HysteresisQualityPolicyReset(HysteresisQualityPolicyState *state)
+{
+	state->badWindows = 0;
+	state->goodWindows = 0;
+	state->requiredGoodWindows = state->recoverWindows;
+	state->probing = false;
+	state->windowsSinceStepUp = 0;
+}
+
+/**
+ * Sets up a policy with the default thresholds.
+ */
+static inline void HysteresisQualityPolicyInit(HysteresisQualityPolicyState *state)
+{
+	*state = (HysteresisQualityPolicyState){0};
+	state->degradedFrameInterval = 0.2;
+	state->healthyFrameInterval = 0.1;
+	state->stallInterval = 1.0;
+	state->degradedCommandLatency = 0.3;
+	state->degradeWindows = 2;
+	state->recoverWindows = 5;
+	HysteresisQualityPolicyReset(state);
+}
+
+/**
+ * Decides on a window.
+ *
+ * Steps down after degradeWindows bad windows in a row and up after a run of good
+ * ones. A step up that turns out bad within recoverWindows doubles the good windows
+ * required before the next try, up to eight times recoverWindows.
+ *
+ * @return -1 to step the quality down, +1 to step it up or 0 to keep it.
+ */
+static inline int HysteresisQualityPolicyStepChange(HysteresisQualityPolicyState *state, const ConnectionHealthSample *sample, size_t step, size_t maximumStep)
+{
+	if (sample->frameCount == 0) {
+		// Nothing was streamed, which says nothing about the link; a stall is caught
+		// by the gap before the next frame.
+		return 0;
+	}
+	bool slowCommands = (sample->commandCount > 0 && sample->meanCommandLatency > state->degradedCommandLatency);
+	bool bad = (sample->meanFrameInterval > state->degradedFrameInterval ||
+				sample->maximumFrameInterval > state->stallInterval ||
+				slowCommands);
+	bool good = (!bad &&
+				 sample->meanFrameInterval < state->healthyFrameInterval &&
+				 (sample->commandCount == 0 || sample->meanCommandLatency < state->degradedCommandLatency / 2));
+	if (state->probing) {
+		state->windowsSinceStepUp++;
+	}
+
+	if (bad) {
+		state->goodWindows = 0;
+		state->badWindows++;
+		if (state->badWindows < state->degradeWindows || step == 0) {
+			return 0;
+		}
+		state->badWindows = 0;
+		if (state->probing && state->windowsSinceStepUp <= state->recoverWindows) {
+			// The step up did not hold; wait longer before trying again.
+			size_t required = state->requiredGoodWindows * 2;
+			state->requiredGoodWindows = (required < state->recoverWindows * 8) ? required : state->recoverWindows * 8;
+		}
+		state->probing = false;
+		return -1;
+	}
+	state->badWindows = 0;
+
+	if (state->probing && state->windowsSinceStepUp > state->recoverWindows) {
+		// The step up held.
+		state->probing = false;
+		state->requiredGoodWindows = state->recoverWindows;
+	}
+	if (!good) {
+		state->goodWindows = 0;
+		return 0;
+	}
+	state->goodWindows++;
+	if (state->goodWindows < state->requiredGoodWindows || step >= maximumStep) {
+		return 0;
+	}
+	state->goodWindows = 0;
+	state->probing = true;
+	state->windowsSinceStepUp = 0;
+	return +1;
+}
+
+#endif
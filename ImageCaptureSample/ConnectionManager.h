@@ -0,0 +1,65 @@
+//
+//  ConnectionManager.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <OLYCameraKit/OLYCamera.h>
+
+extern NSString *const ConnectionManagerPhaseConnect;
+extern NSString *const ConnectionManagerPhaseLiveViewSize;
+extern NSString *const ConnectionManagerPhaseRunMode;
+extern NSString *const ConnectionManagerPhaseRestore;
+
+@class CameraPropertyCache;
+@class ConnectionManager;
+
+@protocol ConnectionManagerDelegate <NSObject>
+@optional
+
+- (void)connectionManagerDidConnect:(ConnectionManager *)manager;
+- (void)connectionManager:(ConnectionManager *)manager didFailWithError:(NSError *)error;
+
+@end
+
+/**
+ * Runs the connection sequence to the camera and restores the user settings.
+ *
+ * Steps whose result is already in place are skipped, so reconnecting to a camera
+ * that kept its state costs little more than the connection itself; the property
+ * snapshot is only dropped when the connection itself had to be made again, and a
+ * connection that survived is not restored over. Otherwise the settings are compared
+ * with the camera in one request, and the differing ones are written while the
+ * delegate is told that the camera is ready; the snapshot answers reads with the
+ * restored values meanwhile. Reachability changes are debounced so that a flapping
+ * network does not cause a reconnection for every change, and retries after a failed
+ * connection back off exponentially up to a limit.
+ * Delegate methods are called on the main thread.
+ */
+@interface ConnectionManager : NSObject
+
+@property (weak, nonatomic) id<ConnectionManagerDelegate> delegate;
+/** The properties stored at disconnection and restored at connection. */
+@property (strong, nonatomic) NSArray *restoredPropertyNames;
+/** The time the network must stay reachable before connecting. (default: 1.0) */
+@property (assign, nonatomic) NSTimeInterval reachabilityDebounceInterval;
+/** The number of retries after failed connections before retryAfterFailure gives up. (default: 5) */
+@property (assign, nonatomic) NSUInteger maximumRetryCount;
+@property (assign, atomic, readonly, getter = isConnecting) BOOL connecting;
+/** The duration of each phase of the latest connection in seconds, keyed by phase. Skipped phases are absent. */
+@property (strong, atomic, readonly) NSDictionary *phaseDurations;
+/** The time from the start of the latest connection to the first live view frame. */
+@property (assign, atomic, readonly) NSTimeInterval timeToFirstLiveFrame;
+/** The number of properties written by the latest restore. */
+@property (assign, atomic, readonly) NSUInteger restoredPropertyCount;
+
+- (id)initWithCamera:(OLYCamera *)camera propertyCache:(CameraPropertyCache *)propertyCache queue:(dispatch_queue_t)queue;
+- (void)connect;
+- (void)disconnectWithPowerOff:(BOOL)powerOff;
+- (void)reachabilityDidChange:(BOOL)reachable;
+- (BOOL)retryAfterFailure;
+- (void)cameraDidUpdateLiveView;
+
+@end
@@ -0,0 +1,298 @@
+//
+//  ConnectionManager.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "ConnectionManager.h"
+#import "CameraPropertyCache.h"
+
+NSString *const ConnectionManagerPhaseConnect = @"connect";
+NSString *const ConnectionManagerPhaseLiveViewSize = @"liveViewSize";
+NSString *const ConnectionManagerPhaseRunMode = @"runMode";
+NSString *const ConnectionManagerPhaseRestore = @"restore";
+
+@interface ConnectionManager ()
+
+@property (weak, nonatomic) OLYCamera *camera;
+@property (strong, nonatomic) CameraPropertyCache *propertyCache;
+@property (strong, nonatomic) dispatch_queue_t queue;
+@property (assign, atomic, readwrite, getter = isConnecting) BOOL connecting;
+@property (strong, atomic, readwrite) NSDictionary *phaseDurations;
+@property (assign, atomic, readwrite) NSTimeInterval timeToFirstLiveFrame;
+@property (assign, atomic, readwrite) NSUInteger restoredPropertyCount;
+@property (assign, atomic) CFAbsoluteTime connectionStartTime;
+@property (assign, atomic) BOOL awaitingFirstLiveFrame;
+@property (assign, nonatomic) NSUInteger reachabilityGeneration;
+@property (assign, nonatomic) NSUInteger retryCount;
+
+@end
+
+@implementation ConnectionManager
+
+- (id)initWithCamera:(OLYCamera *)camera propertyCache:(CameraPropertyCache *)propertyCache queue:(dispatch_queue_t)queue
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	_camera = camera;
+	_propertyCache = propertyCache;
+	_queue = queue;
+	_reachabilityDebounceInterval = 1.0;
+	_maximumRetryCount = 5;
+	_restoredPropertyNames = @[];
+	_phaseDurations = @{};
+	return self;
+}
+
+#pragma mark -
+
+/**
+ * Starts connecting to the camera and starts counting the retries again. Must be called on the main thread.
+ */
+- (void)connect
+{
+	self.retryCount = 0;
+	[self startConnecting];
+}
+
+// Must be called on the main thread.
+- (void)startConnecting
+{
+	if (self.isConnecting) {
+		return;
+	}
+	self.connecting = YES;
+
+	dispatch_async(self.queue, ^{
+		OLYCamera *camera = self.camera;
+		// A connection that survived since the last one is a warm start; the camera kept its settings.
+		BOOL warm = camera.connected;
+		NSMutableDictionary *durations = [[NSMutableDictionary alloc] init];
+		CFAbsoluteTime phaseStartTime = CFAbsoluteTimeGetCurrent();
+		self.connectionStartTime = phaseStartTime;
+		self.timeToFirstLiveFrame = 0;
+		self.awaitingFirstLiveFrame = YES;
+
+		// This process will take some time...
+		NSError *error = nil;
+		if (!camera.connected) {
+			if (![camera connect:&error]) {
+				NSLog(@"To connect to the camera is failed: %@", error ? error : @"Unknown error");
+				[self failWithError:error];
+				return;
+			}
+			durations[ConnectionManagerPhaseConnect] = @(CFAbsoluteTimeGetCurrent() - phaseStartTime);
+			// The camera may have been changed while it was not connected.
+			[self.propertyCache invalidateAll];
+		}
+
+		// A camera that kept its state since the last connection needs neither of these.
+		NSString *userLivePreviewQuality = [[NSUserDefaults standardUserDefaults] stringForKey:@"live_preview_quality"];
+		if (userLivePreviewQuality && !CGSizeEqualToSize(camera.liveViewSize, CGSizeFromString(userLivePreviewQuality))) {
+			phaseStartTime = CFAbsoluteTimeGetCurrent();
+			if (![camera changeLiveViewSize:CGSizeFromString(userLivePreviewQuality) error:&error]) {
+				NSLog(@"To change the live view size is failed: %@", error ? error : @"Unknown error");
+			}
+			durations[ConnectionManagerPhaseLiveViewSize] = @(CFAbsoluteTimeGetCurrent() - phaseStartTime);
+		}
+		if (camera.runMode != OLYCameraRunModeRecording) {
+			phaseStartTime = CFAbsoluteTimeGetCurrent();
+			if (![camera changeRunMode:OLYCameraRunModeRecording error:&error]) {
+				NSLog(@"To change the run-mode is failed: %@", error ? error : @"Unknown error");
+				[self failWithError:error];
+				return;
+			}
+			durations[ConnectionManagerPhaseRunMode] = @(CFAbsoluteTimeGetCurrent() - phaseStartTime);
+		}
+		self.phaseDurations = durations;
+
+		// The settings changed on the camera since the last connection are newer than the stored ones.
+		NSDictionary *restoredValues = warm ? nil : [self valuesToRestore];
+		self.connecting = NO;
+		dispatch_async(dispatch_get_main_queue(), ^{
+			if (!camera.connected) {
+				return;
+			}
+			self.retryCount = 0;
+			if ([self.delegate respondsToSelector:@selector(connectionManagerDidConnect:)]) {
+				[self.delegate connectionManagerDidConnect:self];
+			}
+		});
+		// The UI starts meanwhile; the snapshot already holds the restored values for it to read.
+		if (restoredValues.count > 0) {
+			[self writeRestoredValues:restoredValues];
+		}
+	});
+}
+
+/**
+ * Stores the current settings and disconnects from the camera. Must be called on the main thread.
+ */
+- (void)disconnectWithPowerOff:(BOOL)powerOff
+{
+	self.reachabilityGeneration++;
+
+	dispatch_sync(self.queue, ^{
+		NSError *error = nil;
+		OLYCamera *camera = self.camera;
+
+		// Stores current settings.
+		// The snapshot misses changes made while no view listened to the camera, e.g. from the settings,
+		// so the values are read from the camera itself.
+		if (camera.connected) {
+			NSDictionary *values = nil;
+			if ([self.propertyCache loadValuesForProperties:self.restoredPropertyNames error:&error]) {
+				values = [self.propertyCache valuesForProperties:self.restoredPropertyNames error:&error];
+			}
+			if (values) {
+				NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+				[values enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
+					[userDefaults setObject:obj forKey:key];
+				}];
+			} else {
+				NSLog(@"To get the camera properties is failed: %@", error ? error : @"Unknown error");
+			}
+		}
+
+		// The snapshot is kept for a warm reconnection; a cold one drops it.
+		if (![camera disconnectWithPowerOff:powerOff error:&error]) {
+			NSLog(@"To disconnect from the camera is failed: %@", error ? error : @"Unknown error");
+		}
+	});
+}
+
+/**
+ * Connects once the network has stayed reachable for the debounce interval. Must be called on the main thread.
+ */
+- (void)reachabilityDidChange:(BOOL)reachable
+{
+	self.reachabilityGeneration++;
+	self.retryCount = 0;
+	if (!reachable) {
+		return;
+	}
+	[self connectAfterDelay:self.reachabilityDebounceInterval];
+}
+
+/**
+ * Connects again after a failed connection. The delay starts at the debounce interval and doubles
+ * with every retry. Must be called on the main thread.
+ *
+ * @return NO if maximumRetryCount retries have failed already; nothing is scheduled then.
+ */
+- (BOOL)retryAfterFailure
+{
+	if (self.retryCount >= self.maximumRetryCount) {
+		return NO;
+	}
+	NSTimeInterval delay = self.reachabilityDebounceInterval * (1 << self.retryCount);
+	self.retryCount++;
+	self.reachabilityGeneration++;
+	[self connectAfterDelay:delay];
+	return YES;
+}
+
+// Must be called on the main thread. A reachability change or a disconnection meanwhile cancels the connection.
+- (void)connectAfterDelay:(NSTimeInterval)delay
+{
+	NSUInteger generation = self.reachabilityGeneration;
+	__weak ConnectionManager *weakSelf = self;
+	dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+		ConnectionManager *strongSelf = weakSelf;
+		if (!strongSelf || strongSelf.reachabilityGeneration != generation) {
+			return;
+		}
+		// The connection may have survived the flap.
+		if (strongSelf.camera.connected) {
+			return;
+		}
+		[strongSelf startConnecting];
+	});
+}
+
+/**
+ * Records the time to the first frame of the latest connection. Later calls are ignored.
+ */
+- (void)cameraDidUpdateLiveView
+{
+	if (!self.awaitingFirstLiveFrame) {
+		return;
+	}
+	self.awaitingFirstLiveFrame = NO;
+	self.timeToFirstLiveFrame = CFAbsoluteTimeGetCurrent() - self.connectionStartTime;
+	NSLog(@"Connected in %.0f ms to the first live view frame: %@", self.timeToFirstLiveFrame * 1000.0, self.phaseDurations);
+}
+
+#pragma mark -
+
+/**
+ * Returns my settings that differ from the camera and puts them into the property snapshot,
+ * so that they are read back before they have been written. Must be called on the queue.
+ */
+- (NSDictionary *)valuesToRestore
+{
+	OLYCamera *camera = self.camera;
+	if (!camera.connected || self.restoredPropertyNames.count == 0) {
+		self.restoredPropertyCount = 0;
+		return nil;
+	}
+	CFAbsoluteTime phaseStartTime = CFAbsoluteTimeGetCurrent();
+
+	// Reads the current values in one request; it also seeds the property snapshot.
+	NSError *error = nil;
+	if (![self.propertyCache loadValuesForProperties:self.restoredPropertyNames error:&error]) {
+		NSLog(@"To get the camera properties is failed: %@", error ? error : @"Unknown error");
+	}
+	NSDictionary *currentValues = [self.propertyCache valuesForProperties:self.restoredPropertyNames error:nil];
+
+	NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+	NSMutableDictionary *values = [[NSMutableDictionary alloc] initWithCapacity:self.restoredPropertyNames.count];
+	for (NSString *name in self.restoredPropertyNames) {
+		id value = [userDefaults valueForKey:name];
+		if (value && ![value isEqual:currentValues[name]]) {
+			values[name] = value;
+		}
+	}
+	[self.propertyCache assumeValues:values];
+	self.restoredPropertyCount = values.count;
+
+	NSMutableDictionary *durations = [self.phaseDurations mutableCopy];
+	durations[ConnectionManagerPhaseRestore] = @(CFAbsoluteTimeGetCurrent() - phaseStartTime);
+	self.phaseDurations = durations;
+	return values;
+}
+
+// Must be called on the queue.
+- (void)writeRestoredValues:(NSDictionary *)values
+{
+	CFAbsoluteTime phaseStartTime = CFAbsoluteTimeGetCurrent();
+	NSError *error = nil;
+	if (![self.camera setCameraPropertyValues:values error:&error]) {
+		NSLog(@"To change the camera properties is failed: %@", error ? error : @"Unknown error");
+	}
+	// The camera may have refused or adjusted a value; the next read asks it.
+	for (NSString *name in values) {
+		[self.propertyCache invalidateProperty:name];
+	}
+
+	NSMutableDictionary *durations = [self.phaseDurations mutableCopy];
+	durations[ConnectionManagerPhaseRestore] = @([durations[ConnectionManagerPhaseRestore] doubleValue] + CFAbsoluteTimeGetCurrent() - phaseStartTime);
+	self.phaseDurations = durations;
+}
+
+// Must be called on the queue.
+- (void)failWithError:(NSError *)error
+{
+	self.connecting = NO;
+	self.awaitingFirstLiveFrame = NO;
+	dispatch_async(dispatch_get_main_queue(), ^{
+		if ([self.delegate respondsToSelector:@selector(connectionManager:didFailWithError:)]) {
+			[self.delegate connectionManager:self didFailWithError:error];
+		}
+	});
+}
+
+@end
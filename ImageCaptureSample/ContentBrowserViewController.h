@@ -0,0 +1,20 @@
+//
+//  ContentBrowserViewController.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+
+/**
+ * Shows the thumbnails of the contents on the camera media, and the screennail of a tapped one.
+ *
+ * The camera is in the playback mode while the browser is on screen. Thumbnails come from
+ * the content cache when it has them and are fetched a screenful ahead of scrolling otherwise.
+ */
+@interface ContentBrowserViewController : UICollectionViewController
+
+- (id)init;
+
+@end
@@ -0,0 +1,202 @@
+//
+//  ContentBrowserViewController.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "ContentBrowserViewController.h"
+#import "AppDelegate.h"
+#import "ContentDownloadManager.h"
+
+static NSString *const kContentCellIdentifier = @"ContentCell";
+
+@interface ContentBrowserCell : UICollectionViewCell
+
+@property (strong, nonatomic) UIImageView *imageView;
+
+@end
+
+@implementation ContentBrowserCell
+
+- (id)initWithFrame:(CGRect)frame
+{
+	self = [super initWithFrame:frame];
+	if (!self) {
+		return nil;
+	}
+	_imageView = [[UIImageView alloc] initWithFrame:self.contentView.bounds];
+	_imageView.autoresizingMask = UIViewAutoresizingFlexibleWidth | UIViewAutoresizingFlexibleHeight;
+	_imageView.contentMode = UIViewContentModeScaleAspectFill;
+	_imageView.clipsToBounds = YES;
+	self.contentView.backgroundColor = [UIColor lightGrayColor];
+	[self.contentView addSubview:_imageView];
+	return self;
+}
+
+- (void)prepareForReuse
+{
+	[super prepareForReuse];
+	self.imageView.image = nil;
+}
+
+@end
+
+@interface ContentBrowserViewController ()
+
+@property (strong, nonatomic) NSArray *contentList;
+/** The position of every content in the list, keyed by its path on the camera. */
+@property (strong, nonatomic) NSDictionary *contentIndexes;
+@property (assign, nonatomic) NSUInteger prefetchedIndex;
+
+@end
+
+@implementation ContentBrowserViewController
+
+- (id)init
+{
+	UICollectionViewFlowLayout *layout = [[UICollectionViewFlowLayout alloc] init];
+	layout.itemSize = CGSizeMake(96, 72);
+	layout.minimumInteritemSpacing = 2;
+	layout.minimumLineSpacing = 2;
+	self = [super initWithCollectionViewLayout:layout];
+	if (!self) {
+		return nil;
+	}
+	_contentList = @[];
+	_contentIndexes = @{};
+	_prefetchedIndex = NSNotFound;
+	self.title = NSLocalizedString(@"Contents", nil);
+	return self;
+}
+
+- (void)viewDidLoad
+{
+	[super viewDidLoad];
+	
+	self.collectionView.backgroundColor = [UIColor whiteColor];
+	[self.collectionView registerClass:[ContentBrowserCell class] forCellWithReuseIdentifier:kContentCellIdentifier];
+	[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(contentThumbnailDidLoad:) name:kAppDelegateContentThumbnailDidLoadNotification object:nil];
+
+	__weak ContentBrowserViewController *weakSelf = self;
+	AppDelegateStartBrowsingContents(^(NSArray *contentList, NSError *error) {
+		[weakSelf showContentList:contentList];
+	});
+}
+
+- (void)dealloc
+{
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (BOOL)prefersStatusBarHidden
+{
+	return YES;
+}
+
+- (void)viewWillDisappear:(BOOL)animated
+{
+	if ([self.navigationController.viewControllers indexOfObject:self] == NSNotFound) {
+		// Going back to the previous scene.
+		AppDelegateStopBrowsingContents();
+	}
+	[super viewWillDisappear:animated];
+}
+
+#pragma mark -
+
+- (void)showContentList:(NSArray *)contentList
+{
+	// In the order of the manager's list, so that item positions are its prefetch positions.
+	NSArray *list = contentList ?: @[];
+	NSMutableDictionary *indexes = [[NSMutableDictionary alloc] initWithCapacity:list.count];
+	[list enumerateObjectsUsingBlock:^(NSDictionary *content, NSUInteger index, BOOL *stop) {
+		indexes[[ContentDownloadManager pathOfContent:content]] = @(index);
+	}];
+	self.contentList = list;
+	self.contentIndexes = indexes;
+	self.prefetchedIndex = NSNotFound;
+	[self.collectionView reloadData];
+	[self prefetchThumbnails];
+}
+
+/**
+ * Asks for the thumbnails from the first visible one on, when scrolling has moved it.
+ */
+- (void)prefetchThumbnails
+{
+	if (self.contentList.count == 0) {
+		return;
+	}
+	NSUInteger firstIndex = self.contentList.count;
+	for (NSIndexPath *indexPath in self.collectionView.indexPathsForVisibleItems) {
+		firstIndex = MIN(firstIndex, (NSUInteger)indexPath.item);
+	}
+	if (firstIndex == self.contentList.count) {
+		firstIndex = 0;
+	}
+	if (firstIndex == self.prefetchedIndex) {
+		return;
+	}
+	self.prefetchedIndex = firstIndex;
+	[AppDelegateContentDownloadManager() prefetchThumbnailsFromIndex:firstIndex];
+}
+
+- (void)contentThumbnailDidLoad:(NSNotification *)notification
+{
+	NSDictionary *content = notification.userInfo[kContentKey];
+	NSNumber *index = self.contentIndexes[[ContentDownloadManager pathOfContent:content]];
+	if (!index) {
+		return;
+	}
+	NSIndexPath *indexPath = [NSIndexPath indexPathForItem:[index integerValue] inSection:0];
+	ContentBrowserCell *cell = (ContentBrowserCell *)[self.collectionView cellForItemAtIndexPath:indexPath];
+	cell.imageView.image = notification.userInfo[kThumbnailKey];
+}
+
+- (void)showScreennail:(UIImage *)image
+{
+	UIViewController *viewController = [[UIViewController alloc] init];
+	UIImageView *imageView = [[UIImageView alloc] initWithImage:image];
+	imageView.contentMode = UIViewContentModeScaleAspectFit;
+	imageView.backgroundColor = [UIColor blackColor];
+	viewController.view = imageView;
+	[self.navigationController pushViewController:viewController animated:YES];
+}
+
+#pragma mark - UICollectionViewDataSource
+
+- (NSInteger)collectionView:(UICollectionView *)collectionView numberOfItemsInSection:(NSInteger)section
+{
+	return self.contentList.count;
+}
+
+- (UICollectionViewCell *)collectionView:(UICollectionView *)collectionView cellForItemAtIndexPath:(NSIndexPath *)indexPath
+{
+	ContentBrowserCell *cell = [collectionView dequeueReusableCellWithReuseIdentifier:kContentCellIdentifier forIndexPath:indexPath];
+	// A thumbnail not in the cache yet arrives with the prefetch.
+	cell.imageView.image = [AppDelegateContentDownloadManager() thumbnailForContent:self.contentList[indexPath.item]];
+	return cell;
+}
+
+#pragma mark - UICollectionViewDelegate
+
+- (void)collectionView:(UICollectionView *)collectionView didSelectItemAtIndexPath:(NSIndexPath *)indexPath
+{
+	[collectionView deselectItemAtIndexPath:indexPath animated:YES];
+	__weak ContentBrowserViewController *weakSelf = self;
+	[AppDelegateContentDownloadManager() loadScreennailOfContent:self.contentList[indexPath.item] completionHandler:^(UIImage *image, NSError *error) {
+		if (!image) {
+			NSLog(@"To download the screennail is failed: %@", error ? error : @"Unknown error");
+			return;
+		}
+		[weakSelf showScreennail:image];
+	}];
+}
+
+- (void)scrollViewDidScroll:(UIScrollView *)scrollView
+{
+	[self prefetchThumbnails];
+}
+
+@end
@@ -0,0 +1,43 @@
+//
+//  ContentCache.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+
+enum ContentCacheKind
+{
+	ContentCacheKindThumbnail,
+	ContentCacheKindScreennail,
+};
+
+typedef enum ContentCacheKind ContentCacheKind;
+
+/**
+ * Caches thumbnails and screennails of camera contents across launches.
+ *
+ * Entries are keyed by the camera path, modified date and file size of the content,
+ * so a file that was replaced on the media never hits a stale entry.
+ * Decoded images are held in memory within a byte budget. The encoded data is
+ * appended to a single pack file that is memory-mapped for reads; the least
+ * recently used entries are evicted when the pack exceeds its byte budget, and the
+ * pack is compacted in the background once enough of it is dead.
+ * All methods are thread safe.
+ */
+@interface ContentCache : NSObject
+
+@property (assign, nonatomic, readonly) NSUInteger memoryHits;
+@property (assign, nonatomic, readonly) NSUInteger diskHits;
+@property (assign, nonatomic, readonly) NSUInteger misses;
+@property (assign, nonatomic, readonly) double hitRate;
+@property (assign, nonatomic, readonly) unsigned long long diskUsage;
+
+- (id)initWithDirectory:(NSURL *)directory memoryByteLimit:(NSUInteger)memoryByteLimit diskByteLimit:(unsigned long long)diskByteLimit;
+- (UIImage *)imageForContent:(NSDictionary *)content kind:(ContentCacheKind)kind;
+- (void)storeData:(NSData *)data image:(UIImage *)image forContent:(NSDictionary *)content kind:(ContentCacheKind)kind;
+- (void)synchronize;
+- (void)removeAllEntries;
+
+@end
@@ -0,0 +1,449 @@
+//
+//  ContentCache.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "ContentCache.h"
+#import "ContentCacheCore.h"
+#import <OLYCameraKit/OLYCamera.h>
+#include <fcntl.h>
+
+static NSString *const kPackFilenamePrefix = @"ContentCache-";
+static NSString *const kPackFilenameExtension = @"pack";
+static NSString *const kIndexFilename = @"ContentCache.index";
+// The index names the generation of the pack its offsets point into.
+static NSString *const kIndexGenerationKey = @"generation";
+static NSString *const kIndexEntriesKey = @"entries";
+
+// Index entries are arrays of offset, length and last access time.
+enum {
+	kIndexEntryOffset,
+	kIndexEntryLength,
+	kIndexEntryAccessTime,
+};
+
+@interface ContentCache ()
+
+@property (assign, nonatomic, readwrite) NSUInteger memoryHits;
+@property (assign, nonatomic, readwrite) NSUInteger diskHits;
+@property (assign, nonatomic, readwrite) NSUInteger misses;
+@property (assign, nonatomic, readwrite) unsigned long long diskUsage;
+@property (strong, nonatomic) NSURL *directory;
+@property (strong, nonatomic) NSURL *indexURL;
+@property (assign, nonatomic) NSUInteger generation;
+@property (assign, nonatomic) unsigned long long diskByteLimit;
+@property (strong, nonatomic) NSCache *memoryCache;
+@property (strong, nonatomic) dispatch_queue_t queue;
+@property (strong, nonatomic) dispatch_queue_t compactionQueue;
+@property (strong, nonatomic) NSMutableDictionary *index;
+@property (strong, nonatomic) NSData *mappedPack;
+@property (assign, nonatomic) unsigned long long packLength;
+@property (assign, nonatomic) BOOL indexSaveScheduled;
+@property (assign, nonatomic) BOOL packNeedsSync;
+@property (assign, nonatomic) BOOL compacting;
+@property (assign, nonatomic) NSUInteger resetCount;
+
+@end
+
+@implementation ContentCache
+
+- (id)initWithDirectory:(NSURL *)directory memoryByteLimit:(NSUInteger)memoryByteLimit diskByteLimit:(unsigned long long)diskByteLimit
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	[[NSFileManager defaultManager] createDirectoryAtURL:directory withIntermediateDirectories:YES attributes:nil error:nil];
+	_directory = directory;
+	_indexURL = [directory URLByAppendingPathComponent:kIndexFilename];
+	_diskByteLimit = diskByteLimit;
+	_memoryCache = [[NSCache alloc] init];
+	_memoryCache.totalCostLimit = memoryByteLimit;
+	_queue = dispatch_queue_create([NSString stringWithFormat:@"%@.cache", [NSBundle mainBundle].bundleIdentifier].UTF8String, DISPATCH_QUEUE_SERIAL);
+	_compactionQueue = dispatch_queue_create([NSString stringWithFormat:@"%@.cache.compaction", [NSBundle mainBundle].bundleIdentifier].UTF8String, DISPATCH_QUEUE_SERIAL);
+
+	NSDictionary *savedIndex = [NSDictionary dictionaryWithContentsOfURL:_indexURL];
+	NSDictionary *entries = savedIndex[kIndexEntriesKey];
+	_generation = [savedIndex[kIndexGenerationKey] unsignedIntegerValue];
+	_index = entries ? [entries mutableCopy] : [[NSMutableDictionary alloc] init];
+	NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:self.packURL.path error:nil];
+	_packLength = attributes ? [attributes fileSize] : 0;
+	if (_packLength == 0) {
+		[_index removeAllObjects];
+		[[NSData data] writeToURL:self.packURL atomically:YES];
+	}
+	[self removeStalePacks];
+	for (NSArray *entry in _index.allValues) {
+		_diskUsage += [entry[kIndexEntryLength] unsignedLongLongValue];
+	}
+	return self;
+}
+
+- (NSURL *)packURL
+{
+	return [self packURLForGeneration:self.generation];
+}
+
+- (NSURL *)packURLForGeneration:(NSUInteger)generation
+{
+	NSString *filename = [NSString stringWithFormat:@"%@%lu", kPackFilenamePrefix, (unsigned long)generation];
+	return [self.directory URLByAppendingPathComponent:[filename stringByAppendingPathExtension:kPackFilenameExtension]];
+}
+
+- (double)hitRate
+{
+	NSUInteger hits = self.memoryHits + self.diskHits;
+	NSUInteger lookups = hits + self.misses;
+	return lookups > 0 ? (double)hits / (double)lookups : 0;
+}
+
++ (NSString *)keyForContent:(NSDictionary *)content kind:(ContentCacheKind)kind
+{
+	NSString *directory = content[OLYCameraContentListDirectoryKey];
+	NSString *filename = content[OLYCameraContentListFilenameKey];
+	NSDate *datetime = content[OLYCameraContentListDatetimeKey];
+	NSNumber *filesize = content[OLYCameraContentListFilesizeKey];
+	return [NSString stringWithFormat:@"%d|%@/%@|%.0f|%@", kind, directory, filename, [datetime timeIntervalSince1970], filesize];
+}
+
++ (NSUInteger)costOfImage:(UIImage *)image
+{
+	return (NSUInteger)(image.size.width * image.scale * image.size.height * image.scale * 4);
+}
+
+#pragma mark -
+
+/**
+ * Returns the cached image of a content, decoding it from the disk if needed.
+ *
+ * @return nil if the content is not cached.
+ */
+- (UIImage *)imageForContent:(NSDictionary *)content kind:(ContentCacheKind)kind
+{
+	NSString *key = [[self class] keyForContent:content kind:kind];
+	UIImage *image = [self.memoryCache objectForKey:key];
+	if (image) {
+		dispatch_async(self.queue, ^{
+			self.memoryHits++;
+		});
+		return image;
+	}
+
+	__block NSData *data = nil;
+	dispatch_sync(self.queue, ^{
+		data = [self readDataForKey:key];
+		if (data) {
+			self.diskHits++;
+		} else {
+			self.misses++;
+		}
+	});
+	if (!data) {
+		return nil;
+	}
+	// Decode outside the queue so that other lookups are not held up.
+	image = [UIImage imageWithData:data];
+	if (image) {
+		[self.memoryCache setObject:image forKey:key cost:[[self class] costOfImage:image]];
+	}
+	return image;
+}
+
+/**
+ * Stores the encoded data of a content and, optionally, its decoded image.
+ */
+- (void)storeData:(NSData *)data image:(UIImage *)image forContent:(NSDictionary *)content kind:(ContentCacheKind)kind
+{
+	NSString *key = [[self class] keyForContent:content kind:kind];
+	if (image) {
+		[self.memoryCache setObject:image forKey:key cost:[[self class] costOfImage:image]];
+	}
+	if (data.length == 0) {
+		return;
+	}
+	dispatch_async(self.queue, ^{
+		if (self.index[key]) {
+			return;
+		}
+		[self appendData:data forKey:key];
+		[self evictIfNeeded];
+		[self scheduleIndexSave];
+	});
+}
+
+/**
+ * Writes the index to the disk now.
+ */
+- (void)synchronize
+{
+	dispatch_sync(self.queue, ^{
+		[self writeIndex];
+	});
+}
+
+- (void)removeAllEntries
+{
+	[self.memoryCache removeAllObjects];
+	dispatch_async(self.queue, ^{
+		// The empty index goes first; it points into no pack.
+		[self.index removeAllObjects];
+		[self writeIndex];
+		self.mappedPack = nil;
+		self.packLength = 0;
+		self.diskUsage = 0;
+		self.packNeedsSync = NO;
+		// A compaction in flight copies from the pack being dropped.
+		self.resetCount++;
+		[[NSData data] writeToURL:self.packURL atomically:YES];
+	});
+}
+
+#pragma mark - Pack file (must be called on the queue)
+
+- (NSData *)readDataForKey:(NSString *)key
+{
+	NSArray *entry = self.index[key];
+	if (!entry) {
+		return nil;
+	}
+	unsigned long long offset = [entry[kIndexEntryOffset] unsignedLongLongValue];
+	unsigned long long length = [entry[kIndexEntryLength] unsignedLongLongValue];
+
+	// The mapping covers the pack as it was when mapped; map again after appends.
+	if (!self.mappedPack || offset + length > self.mappedPack.length) {
+		self.mappedPack = [NSData dataWithContentsOfURL:self.packURL options:NSDataReadingMappedAlways error:nil];
+	}
+	if (offset + length > self.mappedPack.length) {
+		[self.index removeObjectForKey:key];
+		return nil;
+	}
+
+	NSMutableArray *touchedEntry = [entry mutableCopy];
+	touchedEntry[kIndexEntryAccessTime] = @(CFAbsoluteTimeGetCurrent());
+	self.index[key] = touchedEntry;
+	[self scheduleIndexSave];
+	return [self.mappedPack subdataWithRange:NSMakeRange((NSUInteger)offset, (NSUInteger)length)];
+}
+
+- (void)appendData:(NSData *)data forKey:(NSString *)key
+{
+	int fd = open(self.packURL.fileSystemRepresentation, O_WRONLY);
+	if (fd < 0) {
+		return;
+	}
+	uint64_t offset;
+	BOOL appended = ContentCacheAppend(fd, data.bytes, data.length, &offset);
+	close(fd);
+	if (!appended) {
+		return;
+	}
+
+	self.packLength = offset + data.length;
+	self.diskUsage += data.length;
+	self.packNeedsSync = YES;
+	self.index[key] = @[@(offset), @(data.length), @(CFAbsoluteTimeGetCurrent())];
+}
+
+- (void)evictIfNeeded
+{
+	if (self.diskUsage > self.diskByteLimit) {
+		// Drop the least recently used entries down to 90% of the budget.
+		unsigned long long target = self.diskByteLimit / 10 * 9;
+		NSArray *keys = self.index.allKeys;
+		NSMutableData *entries = [self entriesForKeys:keys];
+		NSMutableData *order = [NSMutableData dataWithLength:keys.count * sizeof(size_t)];
+		size_t evictedCount = ContentCacheSelectEvictions(entries.bytes, keys.count, self.diskUsage, target, order.mutableBytes);
+		const size_t *evicted = order.bytes;
+		for (size_t index = 0; index < evictedCount; index++) {
+			NSString *key = keys[evicted[index]];
+			self.diskUsage -= [self.index[key][kIndexEntryLength] unsignedLongLongValue];
+			[self.index removeObjectForKey:key];
+		}
+	}
+
+	// Evicted entries stay in the pack until it is compacted.
+	if (ContentCacheShouldCompact(self.packLength, self.diskUsage)) {
+		[self compact];
+	}
+}
+
+- (NSMutableData *)entriesForKeys:(NSArray *)keys
+{
+	NSMutableData *entries = [NSMutableData dataWithLength:keys.count * sizeof(ContentCacheEntry)];
+	ContentCacheEntry *entry = entries.mutableBytes;
+	for (NSString *key in keys) {
+		NSArray *indexEntry = self.index[key];
+		entry->offset = [indexEntry[kIndexEntryOffset] unsignedLongLongValue];
+		entry->length = [indexEntry[kIndexEntryLength] unsignedLongLongValue];
+		entry->accessTime = [indexEntry[kIndexEntryAccessTime] doubleValue];
+		entry++;
+	}
+	return entries;
+}
+
+/**
+ * Copies the live entries into the pack of the next generation.
+ *
+ * The copy runs on the compaction queue against the old pack, which is only ever appended
+ * to, so lookups and stores go on meanwhile. The new index is swapped in on the queue:
+ * entries evicted during the copy are left out, and entries stored during it are copied
+ * over then. The new pack is synced before the index that points into it is written, and
+ * the old pack is only removed after that, so a crash at any point leaves an index with
+ * the pack it was written for. The pack of the other generation is removed on launch.
+ */
+- (void)compact
+{
+	if (self.compacting) {
+		return;
+	}
+	self.compacting = YES;
+	NSArray *keys = self.index.allKeys;
+	NSData *entries = [self entriesForKeys:keys];
+	NSURL *packURL = self.packURL;
+	NSUInteger compactedGeneration = self.generation + 1;
+	NSURL *compactedURL = [self packURLForGeneration:compactedGeneration];
+	NSUInteger resetCount = self.resetCount;
+
+	dispatch_async(self.compactionQueue, ^{
+		NSMutableData *compactedOffsets = [NSMutableData dataWithLength:keys.count * sizeof(uint64_t)];
+		uint64_t compactedLength = 0;
+		BOOL copied = NO;
+		NSData *pack = [NSData dataWithContentsOfURL:packURL options:NSDataReadingMappedAlways error:nil];
+		int fd = open(compactedURL.fileSystemRepresentation, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (pack && fd >= 0) {
+			copied = ContentCacheCopyEntries(pack.bytes, pack.length, entries.bytes, keys.count, fd, compactedOffsets.mutableBytes, &compactedLength) && fsync(fd) == 0;
+		}
+		if (fd >= 0) {
+			close(fd);
+		}
+
+		dispatch_async(self.queue, ^{
+			self.compacting = NO;
+			if (!copied || resetCount != self.resetCount || ![self swapInPackAtURL:compactedURL generation:compactedGeneration length:compactedLength keys:keys entries:entries compactedOffsets:compactedOffsets]) {
+				[[NSFileManager defaultManager] removeItemAtURL:compactedURL error:nil];
+			}
+		});
+	});
+}
+
+/**
+ * Points the index at a compacted pack.
+ *
+ * @return NO if the index could not be written; the old pack is then kept.
+ */
+- (BOOL)swapInPackAtURL:(NSURL *)compactedURL generation:(NSUInteger)compactedGeneration length:(uint64_t)compactedLength keys:(NSArray *)keys entries:(NSData *)entries compactedOffsets:(NSData *)compactedOffsets
+{
+	const ContentCacheEntry *copiedEntries = entries.bytes;
+	const uint64_t *offsets = compactedOffsets.bytes;
+	NSMutableDictionary *compactedIndex = [[NSMutableDictionary alloc] initWithCapacity:self.index.count];
+	for (NSUInteger index = 0; index < keys.count; index++) {
+		NSString *key = keys[index];
+		NSArray *entry = self.index[key];
+		// Entries evicted, or evicted and stored again, since the copy started are not the ones copied.
+		if (!entry || offsets[index] == kContentCacheNoOffset || [entry[kIndexEntryOffset] unsignedLongLongValue] != copiedEntries[index].offset) {
+			continue;
+		}
+		compactedIndex[key] = @[@(offsets[index]), entry[kIndexEntryLength], entry[kIndexEntryAccessTime]];
+	}
+
+	NSMutableArray *storedKeys = [[NSMutableArray alloc] init];
+	for (NSString *key in self.index) {
+		if (!compactedIndex[key]) {
+			[storedKeys addObject:key];
+		}
+	}
+	if (storedKeys.count > 0) {
+		int fd = open(compactedURL.fileSystemRepresentation, O_WRONLY);
+		if (fd < 0) {
+			return NO;
+		}
+		NSData *pack = [NSData dataWithContentsOfURL:self.packURL options:NSDataReadingMappedAlways error:nil];
+		for (NSString *key in storedKeys) {
+			NSArray *entry = self.index[key];
+			unsigned long long offset = [entry[kIndexEntryOffset] unsignedLongLongValue];
+			unsigned long long length = [entry[kIndexEntryLength] unsignedLongLongValue];
+			uint64_t compactedOffset;
+			if (offset + length > pack.length || !ContentCacheAppend(fd, (const uint8_t *)pack.bytes + offset, (size_t)length, &compactedOffset)) {
+				continue;
+			}
+			compactedIndex[key] = @[@(compactedOffset), entry[kIndexEntryLength], entry[kIndexEntryAccessTime]];
+			compactedLength = compactedOffset + length;
+		}
+		BOOL synced = fsync(fd) == 0;
+		close(fd);
+		if (!synced) {
+			return NO;
+		}
+	}
+
+	NSURL *oldPackURL = self.packURL;
+	NSMutableDictionary *oldIndex = self.index;
+	self.generation = compactedGeneration;
+	self.index = compactedIndex;
+	self.packNeedsSync = NO;
+	if (![self writeIndex]) {
+		self.generation = compactedGeneration - 1;
+		self.index = oldIndex;
+		self.packNeedsSync = YES;
+		return NO;
+	}
+	self.mappedPack = nil;
+	self.packLength = compactedLength;
+	self.diskUsage = 0;
+	for (NSArray *entry in compactedIndex.allValues) {
+		self.diskUsage += [entry[kIndexEntryLength] unsignedLongLongValue];
+	}
+	[[NSFileManager defaultManager] removeItemAtURL:oldPackURL error:nil];
+	return YES;
+}
+
+/**
+ * Removes the packs of other generations, left behind by a compaction that was interrupted.
+ */
+- (void)removeStalePacks
+{
+	NSString *currentFilename = self.packURL.lastPathComponent;
+	NSArray *filenames = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:self.directory.path error:nil];
+	for (NSString *filename in filenames) {
+		if ([filename hasPrefix:kPackFilenamePrefix] && [filename.pathExtension isEqualToString:kPackFilenameExtension] && ![filename isEqualToString:currentFilename]) {
+			[[NSFileManager defaultManager] removeItemAtURL:[self.directory URLByAppendingPathComponent:filename] error:nil];
+		}
+	}
+}
+
+- (BOOL)writeIndex
+{
+	// The entries the index points to must be on the disk before it is.
+	if (self.packNeedsSync) {
+		int fd = open(self.packURL.fileSystemRepresentation, O_WRONLY);
+		if (fd < 0 || fsync(fd) != 0) {
+			if (fd >= 0) {
+				close(fd);
+			}
+			return NO;
+		}
+		close(fd);
+		self.packNeedsSync = NO;
+	}
+	NSDictionary *savedIndex = @{
+		kIndexGenerationKey: @(self.generation),
+		kIndexEntriesKey: self.index,
+	};
+	return [savedIndex writeToURL:self.indexURL atomically:YES];
+}
+
+- (void)scheduleIndexSave
+{
+	if (self.indexSaveScheduled) {
+		return;
+	}
+	self.indexSaveScheduled = YES;
+	dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(2 * NSEC_PER_SEC)), self.queue, ^{
+		self.indexSaveScheduled = NO;
+		[self writeIndex];
+	});
+}
+
+@end
@@ -0,0 +1,170 @@
+//
+//  ContentCacheCore.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#ifndef ImageCaptureSample_ContentCacheCore_h
+#define ImageCaptureSample_ContentCacheCore_h
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+
+/*
+ * The pack file and eviction work of ContentCache in plain C, so that it can
+ * also be built and measured off the device.
+ */
+
+typedef struct {
+	uint64_t offset;
+	uint64_t length;
+	double accessTime;
+} ContentCacheEntry;
+
+/** The offset of an entry that did not make it into a compacted pack. */
+#define kContentCacheNoOffset UINT64_MAX
+
+/**
+ * Writes all of the bytes, retrying short writes.
+ *
+ * @return false if writing failed.
+ */
+static inline bool ContentCacheWrite(int fd, const void *bytes, size_t length)
+{
+	const uint8_t *cursor = bytes;
+	while (length > 0) {
+		ssize_t written = write(fd, cursor, length);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		cursor += written;
+		length -= (size_t)written;
+	}
+	return true;
+}
+
+/**
+ * Appends bytes to the end of a pack.
+ *
+ * @return false if writing failed; the pack may then have a partial entry at its end, which no index points to.
+ */
+static inline bool ContentCacheAppend(int fd, const void *bytes, size_t length, uint64_t *offset)
+{
+	off_t end = lseek(fd, 0, SEEK_END);
+	if (end < 0) {
+		return false;
+	}
+	*offset = (uint64_t)end;
+	return ContentCacheWrite(fd, bytes, length);
+}
+
+/**
+ * Returns whether enough of a pack is dead, i.e. evicted, to be worth compacting.
+ */
+static inline bool ContentCacheShouldCompact(uint64_t packLength, uint64_t liveBytes)
+{
+	uint64_t deadBytes = packLength > liveBytes ? packLength - liveBytes : 0;
+	return deadBytes > 1024 * 1024 && deadBytes > packLength / 2;
+}
+
+static inline bool ContentCacheIsOlder(const ContentCacheEntry *entries, size_t a, size_t b)
+{
+	return entries[a].accessTime < entries[b].accessTime;
+}
+
+static inline void ContentCacheSiftDown(const ContentCacheEntry *entries, size_t *heap, size_t count, size_t index)
+{
+	for (;;) {
+		size_t oldest = index;
+		size_t left = index * 2 + 1;
+		size_t right = left + 1;
+		if (left < count && ContentCacheIsOlder(entries, heap[left], heap[oldest])) {
+			oldest = left;
+		}
+		if (right < count && ContentCacheIsOlder(entries, heap[right], heap[oldest])) {
+			oldest = right;
+		}
+		if (oldest == index) {
+			return;
+		}
+		size_t swap = heap[index];
+		heap[index] = heap[oldest];
+		heap[oldest] = swap;
+		index = oldest;
+	}
+}
+
+/**
+ * Picks the least recently used entries to evict until usage is at most targetUsage.
+ *
+ * Only the evicted entries are ordered, on a heap of the access times, so that a small
+ * eviction from a large index does not sort all of it.
+ *
+ * @param order Receives the indexes of the entries to evict, oldest first; it needs room for count indexes.
+ * @return The number of entries to evict.
+ */
+static inline size_t ContentCacheSelectEvictions(const ContentCacheEntry *entries, size_t count, uint64_t usage, uint64_t targetUsage, size_t *order)
+{
+	if (usage <= targetUsage || count == 0) {
+		return 0;
+	}
+	// The heap fills order from the front and shrinks as the evicted entries are moved behind it.
+	for (size_t index = 0; index < count; index++) {
+		order[index] = index;
+	}
+	for (size_t index = count / 2; index-- > 0;) {
+		ContentCacheSiftDown(entries, order, count, index);
+	}
+	size_t heapCount = count;
+	while (heapCount > 0 && usage > targetUsage) {
+		size_t oldest = order[0];
+		heapCount--;
+		order[0] = order[heapCount];
+		order[heapCount] = oldest;
+		ContentCacheSiftDown(entries, order, heapCount, 0);
+		usage -= entries[oldest].length < usage ? entries[oldest].length : usage;
+	}
+	// The evicted entries are at the back, the oldest last; reversing puts them at the front in order.
+	for (size_t front = 0, back = count - 1; front < back; front++, back--) {
+		size_t swap = order[front];
+		order[front] = order[back];
+		order[back] = swap;
+	}
+	return count - heapCount;
+}
+
+/**
+ * Copies entries from a pack into another, back to back in the order given.
+ *
+ * @param pack The bytes of the source pack, typically mapped.
+ * @param compactedOffsets Receives the offset of each entry in the new pack, or kContentCacheNoOffset for the
+ * entries that lie beyond the end of the source.
+ * @return false if writing failed.
+ */
+static inline bool ContentCacheCopyEntries(const uint8_t *pack, uint64_t packLength, const ContentCacheEntry *entries, size_t count, int fd, uint64_t *compactedOffsets, uint64_t *compactedLength)
+{
+	uint64_t length = 0;
+	for (size_t index = 0; index < count; index++) {
+		const ContentCacheEntry *entry = &entries[index];
+		if (entry->offset > packLength || entry->length > packLength - entry->offset) {
+			compactedOffsets[index] = kContentCacheNoOffset;
+			continue;
+		}
+		if (!ContentCacheWrite(fd, pack + entry->offset, (size_t)entry->length)) {
+			return false;
+		}
+		compactedOffsets[index] = length;
+		length += entry->length;
+	}
+	*compactedLength = length;
+	return true;
+}
+
+#endif
@@ -0,0 +1,70 @@
+//
+//  ContentDownloadManager.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <OLYCameraKit/OLYCamera.h>
+
+@class ContentDownloadManager;
+@class ContentCache;
+
+@protocol ContentDownloadManagerDelegate <NSObject>
+@optional
+
+- (void)downloadManager:(ContentDownloadManager *)manager didReceiveThumbnail:(UIImage *)image forContent:(NSDictionary *)content;
+- (void)downloadManager:(ContentDownloadManager *)manager didDownloadContent:(NSDictionary *)content toURL:(NSURL *)url;
+- (void)downloadManager:(ContentDownloadManager *)manager didFailToDownloadContent:(NSDictionary *)content error:(NSError *)error;
+- (void)downloadManagerDidFinish:(ContentDownloadManager *)manager;
+
+@end
+
+/**
+ * Offloads the contents of the camera media to a local directory.
+ *
+ * The content list is fetched once per refresh and compared with a local index,
+ * so files that were already offloaded are never transferred again.
+ * Thumbnails and files share a bounded number of concurrent requests; thumbnails
+ * go first so that browsing stays responsive during an offload. The camera hands
+ * over every file as a whole in memory, so a large file such as a movie is only
+ * requested while no other file is in flight.
+ * The camera must be in the playback run mode while the manager is working.
+ * Delegate methods are called on the main thread.
+ */
+@interface ContentDownloadManager : NSObject
+
+@property (weak, nonatomic) id<ContentDownloadManagerDelegate> delegate;
+/** The number of requests issued to the camera at once. (default: 2) */
+@property (assign, nonatomic) NSUInteger maximumConcurrentRequests;
+/** The number of times a failed file is tried again. (default: 3) */
+@property (assign, nonatomic) NSUInteger maximumRetries;
+/** The file size above which a file is transferred alone. (default: 32 MB) */
+@property (assign, nonatomic) unsigned long long largeContentSize;
+/** The number of thumbnails fetched ahead of the requested position. (default: 20) */
+@property (assign, nonatomic) NSUInteger thumbnailPrefetchDistance;
+@property (strong, nonatomic, readonly) NSURL *directory;
+@property (strong, atomic, readonly) NSArray *contentList;
+@property (assign, atomic, readonly, getter = isDownloading) BOOL downloading;
+@property (assign, atomic, readonly) NSUInteger pendingCount;
+@property (assign, atomic, readonly) NSUInteger downloadedCount;
+@property (assign, atomic, readonly) NSUInteger failedCount;
+@property (assign, atomic, readonly) unsigned long long downloadedBytes;
+/** The transfer rate of the current or latest session in bytes per second. */
+@property (assign, nonatomic, readonly) double throughput;
+/** The persistent cache of thumbnails and screennails. */
+@property (strong, nonatomic, readonly) ContentCache *cache;
+
++ (NSString *)pathOfContent:(NSDictionary *)content;
+
+- (id)initWithCamera:(OLYCamera *)camera directory:(NSURL *)directory;
+- (void)refreshContentList:(void (^)(NSArray *newContents, NSError *error))handler;
+- (void)startDownloading;
+- (void)cancel;
+- (UIImage *)thumbnailForContent:(NSDictionary *)content;
+- (void)prefetchThumbnailsFromIndex:(NSUInteger)index;
+- (void)cancelThumbnails;
+- (void)loadScreennailOfContent:(NSDictionary *)content completionHandler:(void (^)(UIImage *image, NSError *error))handler;
+
+@end
@@ -0,0 +1,457 @@
+//
+//  ContentDownloadManager.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "ContentDownloadManager.h"
+#import "ContentCache.h"
+
+static NSString *const kContentIndexFilename = @"ContentIndex.plist";
+static NSString *const kCacheDirectoryName = @"Cache";
+
+@interface ContentDownloadManager ()
+
+@property (weak, nonatomic) OLYCamera *camera;
+@property (strong, nonatomic, readwrite) NSURL *directory;
+@property (strong, atomic, readwrite) NSArray *contentList;
+@property (assign, atomic, readwrite, getter = isDownloading) BOOL downloading;
+@property (assign, atomic, readwrite) NSUInteger pendingCount;
+@property (assign, atomic, readwrite) NSUInteger downloadedCount;
+@property (assign, atomic, readwrite) NSUInteger failedCount;
+@property (assign, atomic, readwrite) unsigned long long downloadedBytes;
+@property (strong, nonatomic) dispatch_queue_t queue;
+@property (strong, nonatomic) NSMutableDictionary *index;
+@property (strong, nonatomic) NSMutableArray *pendingContents;
+@property (strong, nonatomic) NSMutableArray *pendingThumbnails;
+@property (strong, nonatomic) NSMutableSet *requestedThumbnails;
+@property (strong, nonatomic) NSMutableDictionary *retryCounts;
+@property (strong, nonatomic, readwrite) ContentCache *cache;
+@property (assign, nonatomic) NSUInteger activeRequests;
+@property (assign, nonatomic) NSUInteger activeContentRequests;
+@property (assign, nonatomic) BOOL largeContentInFlight;
+@property (assign, nonatomic) NSUInteger generation;
+@property (assign, atomic) CFAbsoluteTime sessionStartTime;
+@property (assign, atomic) CFAbsoluteTime sessionEndTime;
+
+@end
+
+@implementation ContentDownloadManager
+
+/**
+ * Returns the path of a content on the camera, which identifies it in the local index.
+ */
++ (NSString *)pathOfContent:(NSDictionary *)content
+{
+	NSString *directory = content[OLYCameraContentListDirectoryKey];
+	NSString *filename = content[OLYCameraContentListFilenameKey];
+	return [directory stringByAppendingPathComponent:filename];
+}
+
+- (id)initWithCamera:(OLYCamera *)camera directory:(NSURL *)directory
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	_camera = camera;
+	_directory = directory;
+	_maximumConcurrentRequests = 2;
+	_maximumRetries = 3;
+	_largeContentSize = 32 * 1024 * 1024;
+	_thumbnailPrefetchDistance = 20;
+	_queue = dispatch_queue_create([NSString stringWithFormat:@"%@.download", [NSBundle mainBundle].bundleIdentifier].UTF8String, DISPATCH_QUEUE_SERIAL);
+	_pendingContents = [[NSMutableArray alloc] init];
+	_pendingThumbnails = [[NSMutableArray alloc] init];
+	_requestedThumbnails = [[NSMutableSet alloc] init];
+	_retryCounts = [[NSMutableDictionary alloc] init];
+	_cache = [[ContentCache alloc] initWithDirectory:[directory URLByAppendingPathComponent:kCacheDirectoryName isDirectory:YES] memoryByteLimit:16 * 1024 * 1024 diskByteLimit:128 * 1024 * 1024];
+
+	[[NSFileManager defaultManager] createDirectoryAtURL:directory withIntermediateDirectories:YES attributes:nil error:nil];
+	NSDictionary *index = [NSDictionary dictionaryWithContentsOfURL:[directory URLByAppendingPathComponent:kContentIndexFilename]];
+	_index = index ? [index mutableCopy] : [[NSMutableDictionary alloc] init];
+	return self;
+}
+
+- (double)throughput
+{
+	CFAbsoluteTime start = self.sessionStartTime;
+	CFAbsoluteTime end = self.downloading ? CFAbsoluteTimeGetCurrent() : self.sessionEndTime;
+	if (start <= 0 || end <= start) {
+		return 0;
+	}
+	return (double)self.downloadedBytes / (end - start);
+}
+
+#pragma mark -
+
+/**
+ * Downloads the content list and compares it with the local index.
+ *
+ * @param handler Called on the main thread with the contents that are not offloaded yet.
+ */
+- (void)refreshContentList:(void (^)(NSArray *newContents, NSError *error))handler
+{
+	__weak ContentDownloadManager *weakSelf = self;
+	[self.camera downloadContentList:^(NSMutableArray *list, NSError *error) {
+		ContentDownloadManager *strongSelf = weakSelf;
+		if (!strongSelf) {
+			return;
+		}
+		dispatch_async(strongSelf.queue, ^{
+			NSArray *newContents = nil;
+			if (list) {
+				strongSelf.contentList = [list copy];
+				newContents = [strongSelf contentsMissingFromIndex:list];
+				[strongSelf.pendingContents removeAllObjects];
+				[strongSelf.pendingContents addObjectsFromArray:newContents];
+				strongSelf.pendingCount = strongSelf.pendingContents.count;
+			}
+			if (handler) {
+				dispatch_async(dispatch_get_main_queue(), ^{
+					handler(newContents, error);
+				});
+			}
+		});
+	}];
+}
+
+/**
+ * Starts downloading the contents found by the latest refresh.
+ */
+- (void)startDownloading
+{
+	dispatch_async(self.queue, ^{
+		if (self.downloading) {
+			return;
+		}
+		self.downloading = YES;
+		self.downloadedCount = 0;
+		self.failedCount = 0;
+		self.downloadedBytes = 0;
+		self.sessionStartTime = CFAbsoluteTimeGetCurrent();
+		[self.retryCounts removeAllObjects];
+		[self pumpQueue];
+	});
+}
+
+/**
+ * Stops issuing requests. Requests in flight still hold their slots until they
+ * complete, but their results are dropped.
+ */
+- (void)cancel
+{
+	dispatch_async(self.queue, ^{
+		self.generation++;
+		[self.pendingThumbnails removeAllObjects];
+		[self.requestedThumbnails removeAllObjects];
+		if (self.downloading) {
+			[self finishSession];
+		}
+	});
+}
+
+- (UIImage *)thumbnailForContent:(NSDictionary *)content
+{
+	return [self.cache imageForContent:content kind:ContentCacheKindThumbnail];
+}
+
+/**
+ * Loads the screennail of a content from the cache, or from the camera if it is not cached.
+ *
+ * @param handler Called on the main thread; the image is nil if the download failed.
+ */
+- (void)loadScreennailOfContent:(NSDictionary *)content completionHandler:(void (^)(UIImage *image, NSError *error))handler
+{
+	dispatch_async(self.queue, ^{
+		UIImage *cachedImage = [self.cache imageForContent:content kind:ContentCacheKindScreennail];
+		if (cachedImage) {
+			dispatch_async(dispatch_get_main_queue(), ^{
+				handler(cachedImage, nil);
+			});
+			return;
+		}
+		ContentCache *cache = self.cache;
+		NSString *path = [[self class] pathOfContent:content];
+		[self.camera downloadContentScreennail:path progressHandler:nil completionHandler:^(NSData *data) {
+			// Screennails are plain JPEG; unlike thumbnails they come without metadata.
+			UIImage *image = [UIImage imageWithData:data];
+			if (image) {
+				[cache storeData:data image:image forContent:content kind:ContentCacheKindScreennail];
+			}
+			dispatch_async(dispatch_get_main_queue(), ^{
+				handler(image, nil);
+			});
+		} errorHandler:^(NSError *error) {
+			dispatch_async(dispatch_get_main_queue(), ^{
+				handler(nil, error);
+			});
+		}];
+	});
+}
+
+/**
+ * Requests the thumbnails of the contents following a position in the content list.
+ */
+- (void)prefetchThumbnailsFromIndex:(NSUInteger)index
+{
+	dispatch_async(self.queue, ^{
+		NSArray *list = self.contentList;
+		NSUInteger end = MIN(index + self.thumbnailPrefetchDistance, list.count);
+		// Newer requests are more likely to be on screen; drop the ones scrolled past.
+		[self.pendingThumbnails removeAllObjects];
+		for (NSUInteger position = index; position < end; position++) {
+			NSDictionary *content = list[position];
+			NSString *path = [[self class] pathOfContent:content];
+			if ([self.requestedThumbnails containsObject:path]) {
+				continue;
+			}
+			UIImage *cachedImage = [self.cache imageForContent:content kind:ContentCacheKindThumbnail];
+			if (cachedImage) {
+				// Thumbnails of earlier sessions come from the disk without asking the camera.
+				dispatch_async(dispatch_get_main_queue(), ^{
+					if ([self.delegate respondsToSelector:@selector(downloadManager:didReceiveThumbnail:forContent:)]) {
+						[self.delegate downloadManager:self didReceiveThumbnail:cachedImage forContent:content];
+					}
+				});
+				continue;
+			}
+			[self.pendingThumbnails addObject:content];
+		}
+		[self pumpQueue];
+	});
+}
+
+/**
+ * Drops the thumbnails not requested yet, when nothing shows them anymore.
+ */
+- (void)cancelThumbnails
+{
+	dispatch_async(self.queue, ^{
+		[self.pendingThumbnails removeAllObjects];
+	});
+}
+
+#pragma mark - Queue
+
+- (NSArray *)contentsMissingFromIndex:(NSArray *)list
+{
+	NSMutableArray *missing = [[NSMutableArray alloc] init];
+	for (NSDictionary *content in list) {
+		NSDictionary *entry = self.index[[[self class] pathOfContent:content]];
+		if (!entry ||
+			![entry[OLYCameraContentListFilesizeKey] isEqual:content[OLYCameraContentListFilesizeKey]] ||
+			![entry[OLYCameraContentListDatetimeKey] isEqual:content[OLYCameraContentListDatetimeKey]]) {
+			[missing addObject:content];
+		}
+	}
+	return missing;
+}
+
+// Must be called on the queue.
+- (void)pumpQueue
+{
+	while (self.activeRequests < self.maximumConcurrentRequests) {
+		if (self.pendingThumbnails.count > 0) {
+			NSDictionary *content = self.pendingThumbnails[0];
+			[self.pendingThumbnails removeObjectAtIndex:0];
+			[self requestThumbnailOfContent:content];
+		} else if (self.downloading && self.pendingContents.count > 0 && !self.largeContentInFlight) {
+			NSDictionary *content = self.pendingContents[0];
+			// A large file waits until the files in flight are written and released.
+			BOOL large = ([content[OLYCameraContentListFilesizeKey] unsignedLongLongValue] > self.largeContentSize);
+			if (large && self.activeContentRequests > 0) {
+				break;
+			}
+			self.largeContentInFlight = large;
+			[self.pendingContents removeObjectAtIndex:0];
+			self.pendingCount = self.pendingContents.count;
+			[self requestContent:content];
+		} else {
+			break;
+		}
+	}
+	if (self.downloading && self.activeRequests == 0 && self.pendingContents.count == 0) {
+		[self finishSession];
+	}
+}
+
+// Must be called on the queue.
+- (void)finishSession
+{
+	self.downloading = NO;
+	self.sessionEndTime = CFAbsoluteTimeGetCurrent();
+	[self.cache synchronize];
+	[self.index writeToURL:[self.directory URLByAppendingPathComponent:kContentIndexFilename] atomically:YES];
+	dispatch_async(dispatch_get_main_queue(), ^{
+		if ([self.delegate respondsToSelector:@selector(downloadManagerDidFinish:)]) {
+			[self.delegate downloadManagerDidFinish:self];
+		}
+	});
+}
+
+// Must be called on the queue.
+- (void)requestThumbnailOfContent:(NSDictionary *)content
+{
+	NSString *path = [[self class] pathOfContent:content];
+	NSUInteger generation = self.generation;
+	self.activeRequests++;
+	[self.requestedThumbnails addObject:path];
+
+	__weak ContentDownloadManager *weakSelf = self;
+	void (^finish)(NSData *, UIImage *) = ^(NSData *data, UIImage *image) {
+		ContentDownloadManager *strongSelf = weakSelf;
+		if (!strongSelf) {
+			return;
+		}
+		dispatch_async(strongSelf.queue, ^{
+			strongSelf.activeRequests--;
+			if (generation != strongSelf.generation) {
+				[strongSelf pumpQueue];
+				return;
+			}
+			[strongSelf.requestedThumbnails removeObject:path];
+			if (image) {
+				[strongSelf.cache storeData:data image:image forContent:content kind:ContentCacheKindThumbnail];
+				dispatch_async(dispatch_get_main_queue(), ^{
+					if ([strongSelf.delegate respondsToSelector:@selector(downloadManager:didReceiveThumbnail:forContent:)]) {
+						[strongSelf.delegate downloadManager:strongSelf didReceiveThumbnail:image forContent:content];
+					}
+				});
+			}
+			[strongSelf pumpQueue];
+		});
+	};
+	[self.camera downloadContentThumbnail:path progressHandler:nil completionHandler:^(NSData *data, NSMutableDictionary *metadata) {
+		finish(data, OLYCameraConvertDataToImage(data, metadata));
+	} errorHandler:^(NSError *error) {
+		finish(nil, nil);
+	}];
+}
+
+// Must be called on the queue.
+- (void)requestContent:(NSDictionary *)content
+{
+	NSString *path = [[self class] pathOfContent:content];
+	NSUInteger generation = self.generation;
+	self.activeRequests++;
+	self.activeContentRequests++;
+
+	__weak ContentDownloadManager *weakSelf = self;
+	[self.camera downloadContent:path progressHandler:^(float progress, BOOL *stop) {
+		// Abandon the transfer if the session was cancelled.
+		if (generation != weakSelf.generation) {
+			*stop = YES;
+		}
+	} completionHandler:^(NSData *data) {
+		ContentDownloadManager *strongSelf = weakSelf;
+		if (!strongSelf) {
+			return;
+		}
+		dispatch_async(strongSelf.queue, ^{
+			[strongSelf contentRequestDidFinish];
+			if (generation != strongSelf.generation) {
+				[strongSelf pumpQueue];
+				return;
+			}
+			[strongSelf storeContent:content data:data];
+			[strongSelf pumpQueue];
+		});
+	} errorHandler:^(NSError *error) {
+		ContentDownloadManager *strongSelf = weakSelf;
+		if (!strongSelf) {
+			return;
+		}
+		dispatch_async(strongSelf.queue, ^{
+			[strongSelf contentRequestDidFinish];
+			if (generation != strongSelf.generation) {
+				[strongSelf pumpQueue];
+				return;
+			}
+			[strongSelf retryContent:content error:error];
+			[strongSelf pumpQueue];
+		});
+	}];
+}
+
+// Must be called on the queue.
+- (void)contentRequestDidFinish
+{
+	self.activeRequests--;
+	self.activeContentRequests--;
+	if (self.activeContentRequests == 0) {
+		self.largeContentInFlight = NO;
+	}
+}
+
+// Must be called on the queue.
+- (void)storeContent:(NSDictionary *)content data:(NSData *)data
+{
+	NSString *path = [[self class] pathOfContent:content];
+	NSString *directoryName = [content[OLYCameraContentListDirectoryKey] lastPathComponent];
+	NSURL *directory = [self.directory URLByAppendingPathComponent:directoryName isDirectory:YES];
+	NSURL *url = [directory URLByAppendingPathComponent:content[OLYCameraContentListFilenameKey]];
+
+	NSError *error = nil;
+	[[NSFileManager defaultManager] createDirectoryAtURL:directory withIntermediateDirectories:YES attributes:nil error:nil];
+	if (![data writeToURL:url options:NSDataWritingAtomic error:&error]) {
+		[self retryContent:content error:error];
+		return;
+	}
+
+	NSMutableDictionary *entry = [[NSMutableDictionary alloc] init];
+	if (content[OLYCameraContentListFilesizeKey]) {
+		entry[OLYCameraContentListFilesizeKey] = content[OLYCameraContentListFilesizeKey];
+	}
+	if (content[OLYCameraContentListDatetimeKey]) {
+		entry[OLYCameraContentListDatetimeKey] = content[OLYCameraContentListDatetimeKey];
+	}
+	self.index[path] = entry;
+	self.downloadedCount++;
+	self.downloadedBytes += data.length;
+	// Persist the index every few files so an interrupted session resumes where it stopped.
+	if (self.downloadedCount % 10 == 0) {
+		[self.index writeToURL:[self.directory URLByAppendingPathComponent:kContentIndexFilename] atomically:YES];
+	}
+
+	dispatch_async(dispatch_get_main_queue(), ^{
+		if ([self.delegate respondsToSelector:@selector(downloadManager:didDownloadContent:toURL:)]) {
+			[self.delegate downloadManager:self didDownloadContent:content toURL:url];
+		}
+	});
+}
+
+// Must be called on the queue.
+- (void)retryContent:(NSDictionary *)content error:(NSError *)error
+{
+	NSString *path = [[self class] pathOfContent:content];
+	NSUInteger retries = [self.retryCounts[path] unsignedIntegerValue];
+	if (retries >= self.maximumRetries) {
+		self.failedCount++;
+		dispatch_async(dispatch_get_main_queue(), ^{
+			if ([self.delegate respondsToSelector:@selector(downloadManager:didFailToDownloadContent:error:)]) {
+				[self.delegate downloadManager:self didFailToDownloadContent:content error:error];
+			}
+		});
+		return;
+	}
+	self.retryCounts[path] = @(retries + 1);
+
+	// Back off exponentially; the slot is held so the session does not finish meanwhile.
+	NSUInteger generation = self.generation;
+	self.activeRequests++;
+	int64_t delay = (int64_t)((1 << retries) * NSEC_PER_SEC);
+	dispatch_after(dispatch_time(DISPATCH_TIME_NOW, delay), self.queue, ^{
+		self.activeRequests--;
+		if (generation != self.generation) {
+			[self pumpQueue];
+			return;
+		}
+		[self.pendingContents addObject:content];
+		self.pendingCount = self.pendingContents.count;
+		[self pumpQueue];
+	});
+}
+
+@end
@@ -0,0 +1,53 @@
+//
+//  Intervalometer.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class Intervalometer;
+
+@protocol IntervalometerDelegate <NSObject>
+
+/** Returns NO if the camera is still busy; the shot is then skipped, not postponed. */
+- (BOOL)intervalometerCanTakeShot:(Intervalometer *)intervalometer;
+- (void)intervalometer:(Intervalometer *)intervalometer takeShotAtIndex:(NSUInteger)index;
+
+@optional
+
+- (void)intervalometer:(Intervalometer *)intervalometer changeExposureCompensation:(float)value;
+- (void)intervalometerDidFinish:(Intervalometer *)intervalometer;
+
+@end
+
+/**
+ * Schedules shots at a fixed interval against the monotonic clock.
+ *
+ * Each shot is scheduled relative to the start time rather than to the previous
+ * shot, so late timer callbacks do not accumulate into drift.
+ * All methods must be called on the main thread.
+ */
+@interface Intervalometer : NSObject
+
+@property (weak, nonatomic) id<IntervalometerDelegate> delegate;
+@property (assign, nonatomic) NSTimeInterval interval;
+/** The number of slots to schedule. Zero runs until stopped. */
+@property (assign, nonatomic) NSUInteger numberOfShots;
+/** If YES, the exposure compensation is ramped linearly from the start value to the end value. */
+@property (assign, nonatomic) BOOL rampsExposureCompensation;
+@property (assign, nonatomic) float startExposureCompensation;
+@property (assign, nonatomic) float endExposureCompensation;
+@property (assign, nonatomic, readonly, getter = isRunning) BOOL running;
+@property (assign, nonatomic, readonly) NSUInteger takenShots;
+@property (assign, nonatomic, readonly) NSUInteger skippedShots;
+/** The delay of the latest shot from its scheduled time, in seconds. */
+@property (assign, nonatomic, readonly) NSTimeInterval lastTimingError;
+@property (assign, nonatomic, readonly) NSTimeInterval maximumTimingError;
+@property (assign, nonatomic, readonly) NSTimeInterval averageTimingError;
+
+- (void)start;
+- (void)stop;
+
+@end
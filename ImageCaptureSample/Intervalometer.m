@@ -0,0 +1,145 @@
+//
+//  Intervalometer.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "Intervalometer.h"
+#import "IntervalometerCore.h"
+#import <mach/mach_time.h>
+
+/**
+ * Returns the monotonic clock in seconds.
+ */
+static NSTimeInterval IntervalometerCurrentTime(void)
+{
+	static mach_timebase_info_data_t timebase;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		mach_timebase_info(&timebase);
+	});
+	return (NSTimeInterval)mach_absolute_time() * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+@interface Intervalometer ()
+
+@property (assign, nonatomic, readwrite, getter = isRunning) BOOL running;
+@property (assign, nonatomic) NSUInteger generation;
+
+@end
+
+@implementation Intervalometer
+{
+	IntervalometerState _state;
+}
+
+- (id)init
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	_interval = 5.0;
+	return self;
+}
+
+/**
+ * Starts scheduling. The first shot is taken immediately.
+ */
+- (void)start
+{
+	if (self.running || self.interval <= 0) {
+		return;
+	}
+	self.running = YES;
+	_state.interval = self.interval;
+	_state.numberOfShots = self.numberOfShots;
+	IntervalometerStart(&_state, IntervalometerCurrentTime());
+	[self scheduleNextShot];
+}
+
+/**
+ * Stops scheduling. The pending timer is ignored when it fires.
+ */
+- (void)stop
+{
+	if (!self.running) {
+		return;
+	}
+	self.running = NO;
+	self.generation++;
+	if ([self.delegate respondsToSelector:@selector(intervalometerDidFinish:)]) {
+		[self.delegate intervalometerDidFinish:self];
+	}
+}
+
+- (NSUInteger)takenShots
+{
+	return _state.takenShots;
+}
+
+- (NSUInteger)skippedShots
+{
+	return _state.skippedShots;
+}
+
+- (NSTimeInterval)lastTimingError
+{
+	return _state.lastTimingError;
+}
+
+- (NSTimeInterval)maximumTimingError
+{
+	return _state.maximumTimingError;
+}
+
+- (NSTimeInterval)averageTimingError
+{
+	if (_state.takenShots == 0) {
+		return 0;
+	}
+	return _state.totalTimingError / _state.takenShots;
+}
+
+#pragma mark -
+
+- (void)scheduleNextShot
+{
+	unsigned long index;
+	NSTimeInterval scheduledTime;
+	if (!IntervalometerNextSlot(&_state, &index, &scheduledTime)) {
+		[self stop];
+		return;
+	}
+	NSTimeInterval delay = MAX(scheduledTime - IntervalometerCurrentTime(), 0);
+	NSUInteger generation = self.generation;
+
+	__weak Intervalometer *weakSelf = self;
+	dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+		// Ignore the timers of a stopped run.
+		if (weakSelf.generation != generation || !weakSelf.running) {
+			return;
+		}
+		[weakSelf fireShotAtIndex:index];
+	});
+}
+
+- (void)fireShotAtIndex:(unsigned long)index
+{
+	BOOL canTakeShot = [self.delegate intervalometerCanTakeShot:self];
+	if (IntervalometerFire(&_state, &index, IntervalometerCurrentTime(), canTakeShot)) {
+		if (self.rampsExposureCompensation && [self.delegate respondsToSelector:@selector(intervalometer:changeExposureCompensation:)]) {
+			float progress = IntervalometerRampProgress(&_state, index);
+			float value = self.startExposureCompensation + (self.endExposureCompensation - self.startExposureCompensation) * progress;
+			[self.delegate intervalometer:self changeExposureCompensation:value];
+		}
+		[self.delegate intervalometer:self takeShotAtIndex:index];
+	}
+
+	if (self.running) {
+		[self scheduleNextShot];
+	}
+}
+
+@end
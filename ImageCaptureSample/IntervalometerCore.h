@@ -0,0 +1,114 @@
+//
+//  IntervalometerCore.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#ifndef ImageCaptureSample_IntervalometerCore_h
+#define ImageCaptureSample_IntervalometerCore_h
+
+#include <math.h>
+#include <stdbool.h>
+
+/*
+ * The slot arithmetic of Intervalometer in plain C, so that it can also be
+ * built and checked off the device against a simulated clock. Times are in seconds.
+ */
+
+struct IntervalometerState
+{
+	double interval;
+	/** The number of slots to schedule. Zero runs until stopped. */
+	unsigned long numberOfShots;
+	double startTime;
+	/** The slot to schedule next. */
+	unsigned long nextIndex;
+	unsigned long takenShots;
+	unsigned long skippedShots;
+	double lastTimingError;
+	double maximumTimingError;
+	double totalTimingError;
+};
+
+typedef struct IntervalometerState IntervalometerState;
+
+/**
+ * Starts a run with the first slot at now.
+ */
+static inline void IntervalometerStart(IntervalometerState *state, double now)
+{
+	state->startTime = now;
+	state->nextIndex = 0;
+	state->takenShots = 0;
+	state->skippedShots = 0;
+	state->lastTimingError = 0;
+	state->maximumTimingError = 0;
+	state->totalTimingError = 0;
+}
+
+/**
+ * Returns the time the next slot is due. Each slot is placed relative to the start
+ * rather than to the previous shot, so late timers do not accumulate into drift.
+ *
+ * @return false if all the slots of the run have been used.
+ */
+static inline bool IntervalometerNextSlot(const IntervalometerState *state, unsigned long *index, double *scheduledTime)
+{
+	if (state->numberOfShots > 0 && state->nextIndex >= state->numberOfShots) {
+		return false;
+	}
+	*index = state->nextIndex;
+	*scheduledTime = state->startTime + state->nextIndex * state->interval;
+	return true;
+}
+
+/**
+ * Handles the timer of a slot firing at now.
+ *
+ * If the timer is more than a whole interval late, the missed slots are counted as
+ * skipped and the shot goes to the current slot. A shot that cannot be taken skips
+ * its slot rather than postponing it.
+ *
+ * @param index The slot the timer was scheduled for; receives the slot the shot belongs to.
+ * @return true if the shot should be taken.
+ */
+static inline bool IntervalometerFire(IntervalometerState *state, unsigned long *index, double now, bool canTakeShot)
+{
+	unsigned long shotIndex = *index;
+	double elapsed = now - state->startTime;
+	unsigned long currentIndex = elapsed > 0 ? (unsigned long)floor(elapsed / state->interval) : 0;
+	if (currentIndex > shotIndex) {
+		if (state->numberOfShots > 0 && currentIndex > state->numberOfShots - 1) {
+			currentIndex = state->numberOfShots - 1;
+		}
+		state->skippedShots += currentIndex - shotIndex;
+		shotIndex = currentIndex;
+	}
+	*index = shotIndex;
+	state->nextIndex = shotIndex + 1;
+
+	if (!canTakeShot) {
+		state->skippedShots++;
+		return false;
+	}
+	double error = now - (state->startTime + shotIndex * state->interval);
+	state->lastTimingError = error;
+	state->maximumTimingError = fmax(state->maximumTimingError, error);
+	state->totalTimingError += error;
+	state->takenShots++;
+	return true;
+}
+
+/**
+ * Returns how far through the run a slot is, from 0 at the first to 1 at the last.
+ */
+static inline float IntervalometerRampProgress(const IntervalometerState *state, unsigned long index)
+{
+	if (state->numberOfShots <= 1) {
+		return 0;
+	}
+	return fminf((float)index / (float)(state->numberOfShots - 1), 1.0f);
+}
+
+#endif
@@ -0,0 +1,74 @@
+//
+//  LevelGauge.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <OLYCameraKit/OLYCamera.h>
+
+/**
+ * A low pass filter whose cutoff rises with the speed of the signal. (the "1€ filter")
+ *
+ * A still signal is smoothed hard, so the jitter disappears; a moving one is
+ * followed with little lag.
+ */
+@interface OneEuroFilter : NSObject
+
+/** The cutoff frequency in Hz for a still signal. (default: 1.0) */
+@property (assign, nonatomic) double minimumCutoff;
+/** How fast the cutoff rises with the speed of the signal. (default: 0.05) */
+@property (assign, nonatomic) double beta;
+/** The cutoff frequency in Hz of the speed estimate. (default: 1.0) */
+@property (assign, nonatomic) double derivativeCutoff;
+
+- (double)filterValue:(double)value atTime:(NSTimeInterval)time;
+- (void)reset;
+
+@end
+
+@class LevelGauge;
+
+@protocol LevelGaugeDelegate <NSObject>
+
+/**
+ * Called when the filtered attitude moved enough to be seen, or when the level state changed.
+ *
+ * @param roll The rolling in degrees, or NaN if the camera cannot tell it.
+ * @param pitch The pitching in degrees, or NaN if the camera cannot tell it.
+ */
+- (void)levelGauge:(LevelGauge *)gauge didUpdateRoll:(double)roll pitch:(double)pitch level:(BOOL)level;
+
+@end
+
+/**
+ * Filters the level gauge of the camera and tells when the horizon is level.
+ *
+ * The gauge is sampled at a fixed rate, well below the live view frame rate.
+ * Each sample costs a dictionary lookup and two filter steps; the delegate is
+ * called only when the displayed line would move, so an overlay is redrawn a few
+ * times a second at most while the camera is held still. The roll counts as level near any multiple of
+ * 90 degrees, so portrait framing works as well.
+ * All methods must be called on the main thread.
+ */
+@interface LevelGauge : NSObject
+
+@property (weak, nonatomic) id<LevelGaugeDelegate> delegate;
+/** The largest roll in degrees that counts as level. (default: 1.0) */
+@property (assign, nonatomic) double tolerance;
+/** The smallest change in degrees that is reported. (default: 0.2) */
+@property (assign, nonatomic) double displayResolution;
+/** The interval in seconds between samples taken by sampleLevelGauge:. (default: 0.1) */
+@property (assign, nonatomic) NSTimeInterval sampleInterval;
+@property (assign, nonatomic, readonly) double roll;
+@property (assign, nonatomic, readonly) double pitch;
+@property (assign, nonatomic, readonly, getter = isValid) BOOL valid;
+@property (assign, nonatomic, readonly, getter = isLevel) BOOL level;
+
+- (void)sampleLevelGauge:(OLYCamera *)camera;
+- (void)processLevelGauge:(NSDictionary *)levelGauge;
+- (void)processLevelGauge:(NSDictionary *)levelGauge atTime:(NSTimeInterval)time;
+- (void)reset;
+
+@end
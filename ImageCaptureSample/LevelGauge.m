@@ -0,0 +1,171 @@
+//
+//  LevelGauge.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "LevelGauge.h"
+#import "LevelGaugeCore.h"
+
+@implementation OneEuroFilter
+{
+	OneEuroFilterState _state;
+}
+
+- (id)init
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	_minimumCutoff = 1.0;
+	_beta = 0.05;
+	_derivativeCutoff = 1.0;
+	return self;
+}
+
+- (double)filterValue:(double)value atTime:(NSTimeInterval)time
+{
+	return OneEuroFilterStep(&_state, self.minimumCutoff, self.beta, self.derivativeCutoff, value, time);
+}
+
+- (void)reset
+{
+	OneEuroFilterReset(&_state);
+}
+
+@end
+
+#pragma mark -
+
+@interface LevelGauge ()
+
+@property (strong, nonatomic) OneEuroFilter *rollFilter;
+@property (strong, nonatomic) OneEuroFilter *pitchFilter;
+@property (assign, nonatomic, readwrite) double roll;
+@property (assign, nonatomic, readwrite) double pitch;
+@property (assign, nonatomic, readwrite, getter = isValid) BOOL valid;
+@property (assign, nonatomic, readwrite, getter = isLevel) BOOL level;
+/** The latest roll sample, unwrapped against the ones before it. */
+@property (assign, nonatomic) double unwrappedRoll;
+@property (assign, nonatomic) double reportedRoll;
+@property (assign, nonatomic) double reportedPitch;
+@property (assign, nonatomic) BOOL reported;
+@property (assign, nonatomic) NSTimeInterval sampleTime;
+
+@end
+
+@implementation LevelGauge
+
+- (id)init
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	_rollFilter = [[OneEuroFilter alloc] init];
+	_pitchFilter = [[OneEuroFilter alloc] init];
+	_tolerance = 1.0;
+	_displayResolution = 0.2;
+	_sampleInterval = 0.1;
+	_roll = NAN;
+	_pitch = NAN;
+	_unwrappedRoll = NAN;
+	return self;
+}
+
+#pragma mark -
+
+/**
+ * Takes a sample of the level gauge of the camera unless one was taken within the sample interval.
+ *
+ * This is meant to be called for every live view frame; most calls return without touching the camera.
+ */
+- (void)sampleLevelGauge:(OLYCamera *)camera
+{
+	NSTimeInterval time = CFAbsoluteTimeGetCurrent();
+	if (time - self.sampleTime < self.sampleInterval) {
+		return;
+	}
+	self.sampleTime = time;
+	[self processLevelGauge:camera.levelGauge atTime:time];
+}
+
+- (void)processLevelGauge:(NSDictionary *)levelGauge
+{
+	[self processLevelGauge:levelGauge atTime:CFAbsoluteTimeGetCurrent()];
+}
+
+/**
+ * Takes a sample of the level gauge.
+ *
+ * @param levelGauge The level gauge information of the camera.
+ * @param time The time of the sample, so a recorded trace gives the same results.
+ */
+- (void)processLevelGauge:(NSDictionary *)levelGauge atTime:(NSTimeInterval)time
+{
+	NSString *orientation = levelGauge[OLYCameraLevelGaugeOrientationKey];
+	double roll = [levelGauge[OLYCameraLevelGaugeRollingKey] doubleValue];
+	double pitch = [levelGauge[OLYCameraLevelGaugePitchingKey] doubleValue];
+	if (!levelGauge[OLYCameraLevelGaugeRollingKey]) {
+		roll = NAN;
+	}
+	if (!levelGauge[OLYCameraLevelGaugePitchingKey]) {
+		pitch = NAN;
+	}
+	// Facing up or down there is no horizon to show.
+	if ([orientation isEqualToString:@"faceup"] || [orientation isEqualToString:@"facedown"]) {
+		roll = NAN;
+	}
+
+	if (isnan(roll)) {
+		[self.rollFilter reset];
+		self.unwrappedRoll = NAN;
+		self.roll = NAN;
+	} else {
+		// The filter runs on the unwrapped angle so that crossing 180 degrees is not a jump of 360; only the result is wrapped.
+		self.unwrappedRoll = isnan(self.unwrappedRoll) ? roll : LevelGaugeUnwrapAngle(self.unwrappedRoll, roll);
+		self.roll = LevelGaugeWrapAngle([self.rollFilter filterValue:self.unwrappedRoll atTime:time]);
+	}
+	if (isnan(pitch)) {
+		[self.pitchFilter reset];
+		self.pitch = NAN;
+	} else {
+		self.pitch = [self.pitchFilter filterValue:pitch atTime:time];
+	}
+
+	BOOL valid = !isnan(self.roll);
+	BOOL level = valid && fabs(remainder(self.roll, 90.0)) <= self.tolerance;
+	BOOL changed = (!self.reported || valid != self.valid || level != self.level);
+	if (!changed && valid) {
+		changed = (fabs(remainder(self.roll - self.reportedRoll, 360.0)) >= self.displayResolution);
+	}
+	if (!changed && !isnan(self.pitch)) {
+		changed = (isnan(self.reportedPitch) || fabs(self.pitch - self.reportedPitch) >= self.displayResolution);
+	}
+	self.valid = valid;
+	self.level = level;
+	if (!changed) {
+		return;
+	}
+	self.reported = YES;
+	self.reportedRoll = self.roll;
+	self.reportedPitch = self.pitch;
+	[self.delegate levelGauge:self didUpdateRoll:self.roll pitch:self.pitch level:level];
+}
+
+- (void)reset
+{
+	[self.rollFilter reset];
+	[self.pitchFilter reset];
+	self.unwrappedRoll = NAN;
+	self.roll = NAN;
+	self.pitch = NAN;
+	self.valid = NO;
+	self.level = NO;
+	self.reported = NO;
+	self.sampleTime = 0;
+}
+
+@end
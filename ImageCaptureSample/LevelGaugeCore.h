@@ -0,0 +1,97 @@
+//
+//  LevelGaugeCore.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#ifndef ImageCaptureSample_LevelGaugeCore_h
+#define ImageCaptureSample_LevelGaugeCore_h
+
+#include <math.h>
+#include <stdbool.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/*
+ * The filtering of LevelGauge in plain C, so that it can also be built and
+ * checked off the device. Angles are in degrees and times in seconds.
+ */
+
+/**
+ * The state of a 1€ filter.
+ */
+struct OneEuroFilterState
+{
+	bool hasValue;
+	double value;
+	double derivative;
+	double time;
+};
+
+typedef struct OneEuroFilterState OneEuroFilterState;
+
+static inline double OneEuroSmoothingFactor(double cutoff, double interval)
+{
+	double tau = 1.0 / (2.0 * M_PI * cutoff);
+	return 1.0 / (1.0 + tau / interval);
+}
+
+static inline void OneEuroFilterReset(OneEuroFilterState *state)
+{
+	state->hasValue = false;
+	state->value = 0;
+	state->derivative = 0;
+	state->time = 0;
+}
+
+/**
+ * Filters a sample taken at time and returns the filtered value.
+ */
+static inline double OneEuroFilterStep(OneEuroFilterState *state, double minimumCutoff, double beta, double derivativeCutoff, double value, double time)
+{
+	if (!state->hasValue) {
+		state->hasValue = true;
+		state->value = value;
+		state->derivative = 0;
+		state->time = time;
+		return value;
+	}
+	double interval = time - state->time;
+	if (interval <= 0) {
+		// A repeated sample carries nothing new.
+		return state->value;
+	}
+	state->time = time;
+
+	double derivative = (value - state->value) / interval;
+	state->derivative += OneEuroSmoothingFactor(derivativeCutoff, interval) * (derivative - state->derivative);
+
+	double cutoff = minimumCutoff + beta * fabs(state->derivative);
+	state->value += OneEuroSmoothingFactor(cutoff, interval) * (value - state->value);
+	return state->value;
+}
+
+/**
+ * Returns the angle, moved by whole turns to within half a turn of reference.
+ *
+ * Unwrapping each sample against the previous unwrapped one keeps the sequence
+ * continuous however many times it crosses 180 degrees, so a filter never sees
+ * a jump of a whole turn.
+ */
+static inline double LevelGaugeUnwrapAngle(double reference, double angle)
+{
+	return reference + remainder(angle - reference, 360.0);
+}
+
+/**
+ * Returns the angle in [-180, 180].
+ */
+static inline double LevelGaugeWrapAngle(double angle)
+{
+	return remainder(angle, 360.0);
+}
+
+#endif
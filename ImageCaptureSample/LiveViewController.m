@@ -7,13 +7,44 @@
 
 #import <AudioToolbox/AudioToolbox.h>
 #import "AppDelegate.h"
+#import "CameraPropertyCache.h"
+#import "AutoFocusTracker.h"
 #import "CameraLiveImageView.h"
+#import "CaptureController.h"
+#import "ConnectionHealthMonitor.h"
+#import "ConnectionManager.h"
+#import "Intervalometer.h"
+#import "LevelGauge.h"
 #import "LiveViewController.h"
+#import "MIDIClockSequencer.h"
+#import "MIDIActionMapper.h"
+#import "MIDIFeedbackController.h"
+#import "MIDISourceMerger.h"
+#import "MotionDetector.h"
+#import "ObjectTracker.h"
 #import "ParameterViewController.h"
 #import "RecViewController.h"
+#import "ShutterLatencyBenchmark.h"
+#import "Trace.h"
+#import "ZoomController.h"
 #import "MIKMIDI.h"
 
-@interface LiveViewController () <OLYCameraLiveViewDelegate, OLYCameraPropertyDelegate, OLYCameraRecordingSupportsDelegate>
+/**
+ * Who asked for a shot. The source is the tag of the capture request, so the progress of a shot can be
+ * told apart from that of the others.
+ */
+enum LiveViewShotSource
+{
+	LiveViewShotSourceUser,
+	LiveViewShotSourceMIDI,
+	LiveViewShotSourceIntervalometer,
+	LiveViewShotSourceClock,
+	LiveViewShotSourceTrap,
+};
+
+typedef enum LiveViewShotSource LiveViewShotSource;
+
+@interface LiveViewController () <OLYCameraLiveViewDelegate, OLYCameraPropertyDelegate, OLYCameraRecordingSupportsDelegate, AutoFocusTrackerDelegate, CaptureControllerDelegate, IntervalometerDelegate, LevelGaugeDelegate, MIDIClockSequencerDelegate, MIDIActionMapperDelegate, MIDISourceMergerDelegate>
 
 @property (weak, nonatomic) IBOutlet UIView *imageContainerView;
 @property (weak, nonatomic) IBOutlet CameraLiveImageView *imageView;
@@ -34,9 +65,38 @@
 @property (strong, nonatomic) NSDictionary *drivemodeIconList;
 @property (strong, nonatomic) NSDictionary *whiteBalanceIconList;
 @property (strong, nonatomic) NSDictionary *batteryIconList;
+@property (strong, nonatomic) NSDictionary *batteryFeedbackList;
 @property (assign, nonatomic) SystemSoundID focusedSound;
 @property (assign, nonatomic) SystemSoundID shutterSound;
 @property (strong, nonatomic) UIImage *capturedImage;
+@property (strong, nonatomic) CameraPropertyCache *propertyCache;
+@property (strong, nonatomic) CaptureController *captureController;
+@property (strong, nonatomic) AutoFocusTracker *autoFocusTracker;
+@property (assign, nonatomic) BOOL focusTracking;
+@property (strong, nonatomic) ObjectTracker *objectTracker;
+@property (strong, nonatomic) dispatch_queue_t objectTrackingQueue;
+@property (assign, atomic) BOOL objectTrackingBusy;
+@property (assign, nonatomic) BOOL followingSubject;
+@property (assign, nonatomic) NSUInteger followingSubjectGeneration;
+@property (assign, nonatomic) CGPoint lastSubjectFocusPoint;
+@property (strong, nonatomic) Intervalometer *intervalometer;
+@property (strong, nonatomic) MIDIClockSequencer *clockSequencer;
+@property (strong, nonatomic) MIDIActionMapper *actionMapper;
+@property (strong, nonatomic) id midiDeviceHandlerToken;
+@property (strong, nonatomic) MIDISourceMerger *sourceMerger;
+@property (strong, nonatomic) MIDIFeedbackController *feedbackController;
+@property (strong, nonatomic) ZoomController *zoomController;
+@property (strong, nonatomic) LevelGauge *levelGauge;
+@property (strong, nonatomic) ShutterLatencyBenchmark *latencyBenchmark;
+@property (assign, nonatomic) BOOL levelCapturePending;
+@property (assign, nonatomic) LiveViewShotSource levelCaptureSource;
+@property (assign, nonatomic) NSUInteger levelCaptureGeneration;
+@property (strong, nonatomic) MotionDetector *motionDetector;
+@property (strong, nonatomic) dispatch_queue_t motionDetectionQueue;
+@property (assign, atomic) BOOL motionDetecting;
+@property (assign, nonatomic) BOOL trapArmed;
+@property (assign, nonatomic) CGPoint trapRegionAnchor;
+@property (assign, nonatomic) CFAbsoluteTime trapHoldOffTime;
 
 @end
 
@@ -76,6 +136,17 @@
 		@"<BATTERY_LEVEL/SUPPLY_LOW>": @"TT_icn_battery_supply_middle",
 		@"<BATTERY_LEVEL/SUPPLY_FULL>": @"TT_icn_battery_supply_full",
 	};
+	self.batteryFeedbackList = @{
+		@"<BATTERY_LEVEL/CHARGE>": @127,
+		@"<BATTERY_LEVEL/FULL>": @127,
+		@"<BATTERY_LEVEL/SUPPLY_FULL>": @127,
+		@"<BATTERY_LEVEL/LOW>": @85,
+		@"<BATTERY_LEVEL/SUPPLY_LOW>": @85,
+		@"<BATTERY_LEVEL/WARNING>": @42,
+		@"<BATTERY_LEVEL/SUPPLY_WARNING>": @42,
+		@"<BATTERY_LEVEL/EMPTY>": @0,
+		@"<BATTERY_LEVEL/EMPTY_AC>": @0,
+	};
 
 	NSURL *focusedSoundURL = [[NSBundle mainBundle] URLForResource:@"FocusedSound" withExtension:@"caf"];
 	SystemSoundID focusedSoundID;
@@ -86,11 +157,52 @@
 	SystemSoundID shutterSoundID;
 	AudioServicesCreateSystemSoundID((__bridge CFURLRef)shutterSoundURL, &shutterSoundID);
 	self.shutterSound = shutterSoundID;
+	
+	// Trap mode: long press and drag on the live view to draw the region to watch for motion.
+	self.motionDetector = [[MotionDetector alloc] initWithWidth:128 height:96 blockSize:8];
+	self.motionDetectionQueue = dispatch_queue_create([NSString stringWithFormat:@"%@.motion", [NSBundle mainBundle].bundleIdentifier].UTF8String, DISPATCH_QUEUE_SERIAL);
+	UILongPressGestureRecognizer *trapGesture = [[UILongPressGestureRecognizer alloc] initWithTarget:self action:@selector(imageViewDidLongPress:)];
+	[self.imageView addGestureRecognizer:trapGesture];
+	
+	// Drag-to-track AF: tap with two fingers to switch between moving the view and tracking the focus.
+	UITapGestureRecognizer *focusTrackingGesture = [[UITapGestureRecognizer alloc] initWithTarget:self action:@selector(imageViewDidTwoFingerTap:)];
+	focusTrackingGesture.numberOfTouchesRequired = 2;
+	[self.imageView addGestureRecognizer:focusTrackingGesture];
+	self.objectTracker = [[ObjectTracker alloc] initWithWidth:160 height:120 templateSize:16];
+	self.objectTrackingQueue = dispatch_queue_create([NSString stringWithFormat:@"%@.tracking", [NSBundle mainBundle].bundleIdentifier].UTF8String, DISPATCH_QUEUE_SERIAL);
     
     OLYCamera *camera = AppDelegateCamera();
+	self.propertyCache = AppDelegateCameraPropertyCache();
+	self.captureController = [[CaptureController alloc] initWithCamera:camera];
+	self.captureController.delegate = self;
+	self.autoFocusTracker = [[AutoFocusTracker alloc] initWithCamera:camera];
+	self.autoFocusTracker.delegate = self;
+	self.intervalometer = [[Intervalometer alloc] init];
+	self.intervalometer.delegate = self;
+	self.clockSequencer = [[MIDIClockSequencer alloc] init];
+	self.clockSequencer.delegate = self;
+	self.clockSequencer.ticksPerTrigger = (NSUInteger)[[NSUserDefaults standardUserDefaults] integerForKey:@"clock_sync_ticks"];
+	if ([[[NSUserDefaults standardUserDefaults] stringForKey:@"clock_sync_action"] isEqualToString:@"movie"]) {
+		self.clockSequencer.action = MIDIClockSequencerActionToggleVideo;
+	}
+	self.actionMapper = [[MIDIActionMapper alloc] init];
+	self.actionMapper.delegate = self;
+	[self loadMidiActions];
+	self.feedbackController = [[MIDIFeedbackController alloc] init];
+	self.feedbackController.elementMap = [[NSUserDefaults standardUserDefaults] dictionaryForKey:@"midi_feedback"];
+	[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(applicationDidBecomeActive:) name:UIApplicationDidBecomeActiveNotification object:nil];
+	self.zoomController = [[ZoomController alloc] initWithCamera:camera];
+	if ([[NSUserDefaults standardUserDefaults] boolForKey:@"zoom_cc_relative"]) {
+		self.zoomController.inputMode = ZoomControllerInputModeRelative;
+	}
+	self.latencyBenchmark = [[ShutterLatencyBenchmark alloc] init];
+	self.levelGauge = [[LevelGauge alloc] init];
+	self.levelGauge.delegate = self;
+	self.levelGauge.tolerance = [[NSUserDefaults standardUserDefaults] doubleForKey:@"level_tolerance"];
+	
     __block NSError *error = nil;
     NSString *value = @"<TAKEMODE/P>";
-    if (![camera setCameraPropertyValue:ICSCameraPropertyTakemode value:value error:&error]) {
+    if (![self.propertyCache setValue:value forProperty:ICSCameraPropertyTakemode error:&error]) {
         NSLog(@"ERROR SETTING TAKEMODE TO P");
         return;
     }
@@ -108,11 +220,16 @@
 	self.drivemodeIconList = nil;
 	self.whiteBalanceIconList = nil;
 	self.batteryIconList = nil;
+	self.batteryFeedbackList = nil;
 	
 	AudioServicesDisposeSystemSoundID(self.focusedSound);
 	AudioServicesDisposeSystemSoundID(self.shutterSound);
 	
 	[[NSNotificationCenter defaultCenter] removeObserver:self];
+	if (self.midiDeviceHandlerToken) {
+		[[MIKMIDIDeviceManager sharedDeviceManager] removeDeviceHandlerForToken:self.midiDeviceHandlerToken];
+	}
+	[self.feedbackController invalidate];
 }
 
 - (BOOL)prefersStatusBarHidden
@@ -127,6 +244,20 @@
     
 	_imageView.image = nil;
 	[_imageView hideFocusFrame];
+	[_imageView hideHorizon];
+	[self.levelGauge reset];
+	
+	// Changes are not reported while the view is hidden; refresh the snapshot in one request.
+	NSError *error = nil;
+	NSArray *names = @[ICSCameraPropertyTakemode,
+					   ICSCameraPropertyDrivemode,
+					   ICSCameraPropertyWhiteBalance,
+					   ICSCameraPropertyIsoSensitivity,
+					   ICSCameraPropertyExposureCompensation,
+					   ICSCameraPropertyBatteryLevel];
+	if (![self.propertyCache loadValuesForProperties:names error:&error]) {
+		NSLog(@"To get the camera properties is failed: %@", error ? error : @"Unknown error");
+	}
 	
 	[self updateDrivemodeButton];
 	[self updateTakemodeButton];
@@ -137,6 +268,7 @@
 	[self updateWhiteBalanceButton];
 	[self updateBatteryLevelLabel];
 	[self updateRemainingRecordableImagesLabel];
+	[self updateMidiFeedback];
 	
 	OLYCamera *camera = AppDelegateCamera();
     camera.liveViewDelegate = self;
@@ -160,6 +292,11 @@
 {
 	[super viewWillDisappear:animated];
 	[UIApplication sharedApplication].idleTimerDisabled = NO;
+	[self.intervalometer stop];
+	[self stopFollowingSubject];
+	[self.autoFocusTracker stop];
+	[self.zoomController stop];
+	self.levelCapturePending = NO;
 	
 	OLYCamera *camera = AppDelegateCamera();
 	camera.liveViewDelegate = nil;
@@ -233,6 +370,15 @@
         return;
     }
     
+	if (self.focusTracking) {
+		[self stopFollowingSubject];
+		// The frame follows the finger at once; the camera catches up with the latest point.
+		CGRect preFocusFrameRect = CGRectMake(viewPoint.x - 22, viewPoint.y - 22, 44, 44);
+		[_imageView showFocusFrame:preFocusFrameRect status:CameraFocusFrameStatusRunning animated:NO];
+		[self.autoFocusTracker trackPoint:focusPoint];
+		return;
+	}
+    
     CGPoint translation = [recognizer translationInView:self.view];
     recognizer.view.center = CGPointMake(recognizer.view.center.x + translation.x,
                                          recognizer.view.center.y + translation.y);
@@ -259,6 +405,14 @@
 		return;
 	}
 	
+	if (self.focusTracking) {
+		// In the tracking mode a tap picks the subject to follow.
+		CGSize imageSize = _imageView.image.size;
+		[self startFollowingSubjectAtPoint:CGPointMake(imagePoint.x / imageSize.width, imagePoint.y / imageSize.height)];
+		[self.autoFocusTracker trackPoint:focusPoint];
+		return;
+	}
+	
     // Display a provisional focus frame at the touched point.
 	CGRect preFocusFrameRect = CGRectMake(viewPoint.x - 22, viewPoint.y - 22, 44, 44);
 	[_imageView showFocusFrame:preFocusFrameRect status:CameraFocusFrameStatusRunning animated:NO];
@@ -308,6 +462,155 @@
 	
 }
 
+- (void)imageViewDidTwoFingerTap:(UITapGestureRecognizer *)recognizer
+{
+	OLYCamera *camera = AppDelegateCamera();
+	if (!self.focusTracking && camera.actionType == OLYCameraActionTypeMovie) {
+		return;
+	}
+	self.focusTracking = !self.focusTracking;
+	if (self.focusTracking) {
+		[_imageView showFocusInfo:NSLocalizedString(@"AF tracking", nil)];
+	} else {
+		[self stopFollowingSubject];
+		[self.autoFocusTracker stop];
+		[_imageView hideFocusFrame];
+		[_imageView hideFocusInfo];
+	}
+}
+
+- (void)startFollowingSubjectAtPoint:(CGPoint)point
+{
+	UIImage *image = _imageView.image;
+	ObjectTracker *tracker = self.objectTracker;
+	__weak LiveViewController *weakSelf = self;
+	self.followingSubject = YES;
+	self.followingSubjectGeneration++;
+	NSUInteger generation = self.followingSubjectGeneration;
+	self.lastSubjectFocusPoint = CGPointMake(-1, -1);
+	dispatch_async(self.objectTrackingQueue, ^{
+		if ([tracker startTrackingAtPoint:point inImage:image]) {
+			return;
+		}
+		dispatch_async(dispatch_get_main_queue(), ^{
+			if (weakSelf.followingSubjectGeneration != generation) {
+				return;
+			}
+			[weakSelf stopFollowingSubject];
+		});
+	});
+}
+
+- (void)stopFollowingSubject
+{
+	self.followingSubject = NO;
+	self.followingSubjectGeneration++;
+	ObjectTracker *tracker = self.objectTracker;
+	dispatch_async(self.objectTrackingQueue, ^{
+		[tracker stopTracking];
+	});
+}
+
+/**
+ * Moves the focus to the subject found in a frame.
+ *
+ * @param generation The following the frame was searched for. Results of an
+ * earlier subject, which arrive after it was stopped or replaced, are ignored.
+ */
+- (void)objectTrackerDidMoveToPosition:(CGPoint)position size:(CGSize)size generation:(NSUInteger)generation
+{
+	if (!self.followingSubject || generation != self.followingSubjectGeneration) {
+		return;
+	}
+	UIImage *image = _imageView.image;
+	CGSize imageSize = image.size;
+	CGRect imageRect = CGRectMake((position.x - size.width / 2) * imageSize.width, (position.y - size.height / 2) * imageSize.height, size.width * imageSize.width, size.height * imageSize.height);
+	[_imageView showFocusFrame:[_imageView convertRectFromImageArea:imageRect] status:CameraFocusFrameStatusRunning animated:NO];
+
+	// Small movements are within the focus area already; do not bother the camera with them.
+	CGPoint imagePoint = CGPointMake(position.x * imageSize.width, position.y * imageSize.height);
+	CGPoint focusPoint = OLYCameraConvertPointOnLiveImageIntoViewfinder(imagePoint, image);
+	CGPoint lastPoint = self.lastSubjectFocusPoint;
+	if (!CGRectContainsPoint(CGRectMake(0, 0, 1, 1), focusPoint) || hypot(focusPoint.x - lastPoint.x, focusPoint.y - lastPoint.y) < 0.03) {
+		return;
+	}
+	self.lastSubjectFocusPoint = focusPoint;
+	[self.autoFocusTracker trackPoint:focusPoint];
+}
+
+- (void)objectTrackerDidLoseSubjectOfGeneration:(NSUInteger)generation
+{
+	if (!self.followingSubject || generation != self.followingSubjectGeneration) {
+		return;
+	}
+	self.followingSubject = NO;
+	self.followingSubjectGeneration++;
+	[_imageView showFocusInfo:NSLocalizedString(@"Subject lost", nil)];
+	[_imageView hideFocusFrame];
+}
+
+- (void)imageViewDidLongPress:(UILongPressGestureRecognizer *)recognizer
+{
+	CGPoint viewPoint = [recognizer locationInView:_imageView];
+	
+	if (recognizer.state == UIGestureRecognizerStateBegan) {
+		self.trapArmed = NO;
+		self.trapRegionAnchor = viewPoint;
+		[_imageView showTrapRegion:CGRectMake(viewPoint.x, viewPoint.y, 0, 0) armed:NO];
+		
+	} else if (recognizer.state == UIGestureRecognizerStateChanged) {
+		CGRect viewRect = CGRectStandardize(CGRectMake(self.trapRegionAnchor.x, self.trapRegionAnchor.y, viewPoint.x - self.trapRegionAnchor.x, viewPoint.y - self.trapRegionAnchor.y));
+		[_imageView showTrapRegion:viewRect armed:NO];
+		
+	} else if (recognizer.state == UIGestureRecognizerStateEnded) {
+		CGRect viewRect = CGRectStandardize(CGRectMake(self.trapRegionAnchor.x, self.trapRegionAnchor.y, viewPoint.x - self.trapRegionAnchor.x, viewPoint.y - self.trapRegionAnchor.y));
+		// A press without dragging disarms the trap.
+		if (viewRect.size.width < 22 || viewRect.size.height < 22 || !_imageView.image) {
+			[_imageView hideTrapRegion];
+			return;
+		}
+		[self armTrapWithViewRect:viewRect];
+		
+	} else if (recognizer.state == UIGestureRecognizerStateCancelled) {
+		self.trapArmed = NO;
+		[_imageView hideTrapRegion];
+	}
+}
+
+- (void)armTrapWithViewRect:(CGRect)viewRect
+{
+	CGSize imageSize = _imageView.image.size;
+	CGRect imageRect = [_imageView convertRectFromViewArea:viewRect];
+	CGRect region = CGRectMake(imageRect.origin.x / imageSize.width, imageRect.origin.y / imageSize.height,
+							   imageRect.size.width / imageSize.width, imageRect.size.height / imageSize.height);
+	
+	MotionDetector *detector = self.motionDetector;
+	dispatch_async(self.motionDetectionQueue, ^{
+		detector.region = region;
+		[detector reset];
+	});
+	self.trapArmed = YES;
+	[_imageView showTrapRegion:viewRect armed:YES];
+}
+
+- (void)motionDetectorDidDetectMotion
+{
+	if (!self.trapArmed) {
+		return;
+	}
+	// Give the camera time to finish the shot before watching again.
+	CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+	if (now < self.trapHoldOffTime) {
+		return;
+	}
+	OLYCamera *camera = AppDelegateCamera();
+	if (camera.takingPicture || camera.recordingVideo) {
+		return;
+	}
+	self.trapHoldOffTime = now + 2.0;
+	[self releaseShutterFromSource:LiveViewShotSourceTrap];
+}
+
 - (IBAction)imageViewDidPinch:(UIPinchGestureRecognizer *)recognizer
 {
     recognizer.view.transform = CGAffineTransformScale(recognizer.view.transform, recognizer.scale, recognizer.scale);
@@ -322,6 +625,24 @@
 
 - (IBAction)shutterButtonDidTap:(UITapGestureRecognizer *)sender
 {
+	[self releaseShutterFromSource:LiveViewShotSourceUser];
+}
+
+/**
+ * Requests a shot, or defers it while level capture waits for the horizon.
+ *
+ * @return NO if no shot was requested now; it was refused, or deferred until the horizon is level
+ * or level_capture_timeout elapses, whichever comes first.
+ */
+- (BOOL)releaseShutterFromSource:(LiveViewShotSource)source
+{
+	// Clock shots must land on their beat, so they never wait for the horizon.
+	return [self releaseShutterFromSource:source waitForLevel:(source != LiveViewShotSourceClock)];
+}
+
+- (BOOL)releaseShutterFromSource:(LiveViewShotSource)source waitForLevel:(BOOL)waitForLevel
+{
+	[self.latencyBenchmark markStage:ShutterLatencyStageDispatched];
 	OLYCamera *camera = AppDelegateCamera();
 	OLYCameraActionType actionType = [camera actionType];
     
@@ -329,34 +650,78 @@
         
         __block NSError *error = nil;
         NSString *value = @"<TAKEMODE/P>";
-        if (![camera setCameraPropertyValue:ICSCameraPropertyTakemode value:value error:&error]) {
+        if (![self.propertyCache setValue:value forProperty:ICSCameraPropertyTakemode error:&error]) {
             NSLog(@"ERROR SETTING TAKEMODE TO P");
-            return;
+            return NO;
         }
+        [self.latencyBenchmark markStage:ShutterLatencyStageTakemodeChanged];
         
     }
     
-	if (camera.takingPicture || camera.recordingVideo) {
-        NSLog(@"STILL TAKING PICTURE/FILMING");
-		return;
-    } else {
-        [self takePicture];
+	// No still shots while a movie is recorded.
+	if (camera.recordingVideo) {
+        NSLog(@"STILL FILMING");
+		return NO;
     }
-    
+	
+	// With level capture, the shot waits until the horizon is level.
+	if (waitForLevel && [self shotWaitsForLevel]) {
+		if (!self.levelCapturePending) {
+			[self deferShotFromSource:source];
+		}
+		return NO;
+	}
+	self.levelCapturePending = NO;
+	[self.latencyBenchmark markStage:ShutterLatencyStageRequested];
+	[self takePictureFromSource:source];
+	return YES;
+}
+
+- (BOOL)shotWaitsForLevel
+{
+	return [[NSUserDefaults standardUserDefaults] boolForKey:@"level_capture"] && self.levelGauge.valid && !self.levelGauge.level;
+}
+
+/**
+ * Holds a shot until the horizon is level. One shot is held at a time; it is taken anyway
+ * when level_capture_timeout elapses, so that a camera that is never level does not lose it.
+ */
+- (void)deferShotFromSource:(LiveViewShotSource)source
+{
+	self.levelCapturePending = YES;
+	self.levelCaptureSource = source;
+	NSUInteger generation = ++self.levelCaptureGeneration;
+	TRACE_INSTANT("level.deferred", source);
+	[self updateMidiFeedback];
+
+	NSTimeInterval timeout = [[NSUserDefaults standardUserDefaults] doubleForKey:@"level_capture_timeout"];
+	__weak LiveViewController *weakSelf = self;
+	dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(timeout * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+		LiveViewController *strongSelf = weakSelf;
+		if (!strongSelf.levelCapturePending || strongSelf.levelCaptureGeneration != generation) {
+			return;
+		}
+		TRACE_INSTANT("level.timeout", strongSelf.levelCaptureSource);
+		[strongSelf releaseDeferredShot];
+	});
+}
+
+- (void)releaseDeferredShot
+{
+	self.levelCapturePending = NO;
+	if (![self releaseShutterFromSource:self.levelCaptureSource waitForLevel:NO]) {
+		[self updateMidiFeedback];
+	}
 }
 
 - (IBAction)shutterButtonDidLongPress:(UILongPressGestureRecognizer *)sender
 {
-    /*
     OLYCamera *camera = AppDelegateCamera();
     OLYCameraActionType actionType = [camera actionType];
     
     if (sender.state == UIGestureRecognizerStateBegan) {
-		if (camera.takingPicture) {
-			return;
-		}
 		if (actionType == OLYCameraActionTypeSingle) {
-			[self takePicture];
+			[self takePictureFromSource:LiveViewShotSourceUser];
 		} else if (actionType == OLYCameraActionTypeSequential) {
 			[self beginTakingPicture];
         } else if (actionType == OLYCameraActionTypeMovie) {
@@ -371,8 +736,6 @@
             [self endRecordingVideo];
 		}
 	}
-    */
-    
 }
 
 - (IBAction)secondaryButtonDidTap:(UITapGestureRecognizer *)sender
@@ -384,7 +747,7 @@
         
         __block NSError *error = nil;
         NSString *value = @"<TAKEMODE/movie>";
-        if (![camera setCameraPropertyValue:ICSCameraPropertyTakemode value:value error:&error]) {
+        if (![self.propertyCache setValue:value forProperty:ICSCameraPropertyTakemode error:&error]) {
             NSLog(@"ERROR SETTING TAKEMODE TO MOVIE");
             return;
         }
@@ -396,7 +759,7 @@
         
         __block NSError *error = nil;
         NSString *value = @"<TAKEMODE/P>";
-        if (![camera setCameraPropertyValue:ICSCameraPropertyTakemode value:value error:&error]) {
+        if (![self.propertyCache setValue:value forProperty:ICSCameraPropertyTakemode error:&error]) {
             NSLog(@"ERROR SETTING TAKEMODE TO P");
             return;
         }
@@ -425,130 +788,22 @@
     */
 }
 
-- (void)takePicture
+- (void)takePictureFromSource:(LiveViewShotSource)source
 {
-	[[UIApplication sharedApplication] beginIgnoringInteractionEvents];
-    
-	__weak LiveViewController *weakSelf = self;
-	OLYCamera *camera = AppDelegateCamera();
-	[camera takePicture:nil progressHandler:^(OLYCameraTakingProgress progress, NSDictionary *info) {
-		
-		if (progress == OLYCameraTakingProgressEndFocusing) {
-			NSString *focusResult   = info[OLYCameraTakingPictureProgressInfoFocusResultKey];
-			NSValue *focusRectValue = info[OLYCameraTakingPictureProgressInfoFocusRectKey];
-            
-			if ([focusResult isEqualToString:@"ok"] && focusRectValue) {
-				CGRect focusRect = [focusRectValue CGRectValue];
-				CGRect imageRect = OLYCameraConvertRectOnViewfinderIntoLiveImage(focusRect, weakSelf.imageView.image);
-				CGRect postFocusFrameRect = [weakSelf.imageView convertRectFromImageArea:imageRect];
-				[weakSelf.imageView showFocusFrame:postFocusFrameRect status:CameraFocusFrameStatusFocused animated:YES];
-				
-			} else if ([focusResult isEqualToString:@"none"]) {
-				[weakSelf.imageView hideFocusFrame];
-			} else {
-				[weakSelf.imageView hideFocusFrame];
-			}
-			
-		} else if (progress == OLYCameraTakingProgressBeginCapturing) {
-			AudioServicesPlaySystemSound(weakSelf.shutterSound);
-		}
-		
-	} completionHandler:^(NSDictionary *info) {
-		[[UIApplication sharedApplication] endIgnoringInteractionEvents];
-        
-		[weakSelf.imageView hideFocusFrame];
-		
-	} errorHandler:^(NSError *error) {
-		[[UIApplication sharedApplication] endIgnoringInteractionEvents];
-		
-		[weakSelf.imageView hideFocusFrame];
-		
-		if (error.domain != OLYCameraErrorDomain || error.code != OLYCameraErrorFocusFailed) {
-			NSString *title = NSLocalizedString(@"Take failed", nil);
-			NSString *message = error.localizedDescription;
-			NSString *ok = NSLocalizedString(@"OK", nil);
-			UIAlertView *alertView = [[UIAlertView alloc] initWithTitle:title message:message delegate:nil cancelButtonTitle:ok otherButtonTitles:nil];
-			[alertView show];
-		}
-		
-	}];
+	// Shots requested while the camera is taking a picture are queued.
+	if (![self.captureController requestShotWithTag:source]) {
+		TRACE_INSTANT("capture.queueFull", self.captureController.queueDepth);
+	}
 }
 
 - (void)beginTakingPicture
 {
-	[[UIApplication sharedApplication] beginIgnoringInteractionEvents];
-    
-	__weak LiveViewController *weakSelf = self;
-	OLYCamera *camera = AppDelegateCamera();
-	[camera startTakingPicture:nil progressHandler:^(OLYCameraTakingProgress progress, NSDictionary *info) {
-        
-		if (progress == OLYCameraTakingProgressEndFocusing) {
-			NSString *focusResult = info[OLYCameraTakingPictureProgressInfoFocusResultKey];
-			NSValue *focusRectValue = info[OLYCameraTakingPictureProgressInfoFocusRectKey];
-			if ([focusResult isEqualToString:@"ok"] && focusRectValue) {
-				CGRect focusRect = [focusRectValue CGRectValue];
-				CGRect imageRect = OLYCameraConvertRectOnViewfinderIntoLiveImage(focusRect, weakSelf.imageView.image);
-				CGRect postFocusFrameRect = [weakSelf.imageView convertRectFromImageArea:imageRect];
-				[weakSelf.imageView showFocusFrame:postFocusFrameRect status:CameraFocusFrameStatusFocused animated:YES];
-				
-			} else if ([focusResult isEqualToString:@"none"]) {
-				[weakSelf.imageView hideFocusFrame];
-				
-			} else {
-				[weakSelf.imageView hideFocusFrame];
-				
-			}
-            
-		} else if (progress == OLYCameraTakingProgressBeginCapturing) {
-			AudioServicesPlaySystemSound(weakSelf.shutterSound);
-		}
-		
-	} completionHandler:^{
-		[[UIApplication sharedApplication] endIgnoringInteractionEvents];
-        
-	} errorHandler:^(NSError *error) {
-		[[UIApplication sharedApplication] endIgnoringInteractionEvents];
-		
-		[weakSelf.imageView hideFocusFrame];
-		
-		if (error.domain != OLYCameraErrorDomain || error.code != OLYCameraErrorFocusFailed) {
-			NSString *title = NSLocalizedString(@"Take failed", nil);
-			NSString *message = error.localizedDescription;
-			NSString *ok = NSLocalizedString(@"OK", nil);
-			UIAlertView *alertView = [[UIAlertView alloc] initWithTitle:title message:message delegate:nil cancelButtonTitle:ok otherButtonTitles:nil];
-			[alertView show];
-		}
-		
-	}];
+	[self.captureController beginSequentialShooting];
 }
 
 - (void)endTakingPicture
 {
-	[[UIApplication sharedApplication] beginIgnoringInteractionEvents];
-    
-	__weak LiveViewController *weakSelf = self;
-    OLYCamera *camera = AppDelegateCamera();
-	[camera stopTakingPicture:^(OLYCameraTakingProgress progress, NSDictionary *info) {
-		// No operation.
-	} completionHandler:^(NSDictionary *info) {
-		[[UIApplication sharedApplication] endIgnoringInteractionEvents];
-		
-		[weakSelf.imageView hideFocusFrame];
-
-	} errorHandler:^(NSError *error) {
-		[[UIApplication sharedApplication] endIgnoringInteractionEvents];
-		
-		[weakSelf.imageView hideFocusFrame];
-		
-		if (error.domain != OLYCameraErrorDomain || error.code != OLYCameraErrorFocusFailed) {
-			NSString *title = NSLocalizedString(@"Take failed", nil);
-			NSString *message = error.localizedDescription;
-			NSString *ok = NSLocalizedString(@"OK", nil);
-			UIAlertView *alertView = [[UIAlertView alloc] initWithTitle:title message:message delegate:nil cancelButtonTitle:ok otherButtonTitles:nil];
-			[alertView show];
-		}
-		
-	}];
+	[self.captureController endSequentialShooting];
 }
 
 - (void)beginRecordingVideo
@@ -559,8 +814,10 @@
     self.secondaryButton.selected = YES;
     [camera startRecordingVideo:nil completionHandler:^{
 		[[UIApplication sharedApplication] endIgnoringInteractionEvents];
+		[self updateMidiFeedback];
     } errorHandler:^(NSError *error) {
 		[[UIApplication sharedApplication] endIgnoringInteractionEvents];
+		[self updateMidiFeedback];
         
 		NSString *title = NSLocalizedString(@"Record failed", nil);
 		NSString *message = error.localizedDescription;
@@ -578,8 +835,10 @@
     self.secondaryButton.selected = NO;
 	[camera stopRecordingVideo:^(NSDictionary *info) {
 		[[UIApplication sharedApplication] endIgnoringInteractionEvents];
+		[self updateMidiFeedback];
 	} errorHandler:^(NSError *error) {
 		[[UIApplication sharedApplication] endIgnoringInteractionEvents];
+		[self updateMidiFeedback];
         
 		NSString *title = NSLocalizedString(@"Record failed", nil);
 		NSString *message = error.localizedDescription;
@@ -589,6 +848,174 @@
     }];
 }
 
+#pragma mark - AutoFocusTrackerDelegate -
+
+- (void)autoFocusTracker:(AutoFocusTracker *)tracker didFocusWithResult:(NSString *)result rect:(CGRect)rect latency:(NSTimeInterval)latency
+{
+	if (!self.focusTracking) {
+		return;
+	}
+	[_imageView showFocusInfo:[NSString stringWithFormat:@"AF %.0f ms (avg %.0f ms)", latency * 1000.0, tracker.averageLatency * 1000.0]];
+	if ([result isEqualToString:@"ok"] && !CGRectIsNull(rect)) {
+		CGRect imageRect = OLYCameraConvertRectOnViewfinderIntoLiveImage(rect, _imageView.image);
+		CGRect postFocusFrameRect = [_imageView convertRectFromImageArea:imageRect];
+		[_imageView showFocusFrame:postFocusFrameRect status:CameraFocusFrameStatusFocused animated:NO];
+	} else if ([result isEqualToString:@"none"]) {
+		[_imageView hideFocusFrame];
+	}
+}
+
+- (void)autoFocusTracker:(AutoFocusTracker *)tracker didFailWithError:(NSError *)error
+{
+	// Keep tracking; the next point is sent regardless.
+	NSLog(@"To track the auto focus is failed: %@", error ? error : @"Unknown error");
+}
+
+#pragma mark - LevelGaugeDelegate -
+
+- (void)levelGauge:(LevelGauge *)gauge didUpdateRoll:(double)roll pitch:(double)pitch level:(BOOL)level
+{
+	if (isnan(roll)) {
+		[_imageView hideHorizon];
+	} else {
+		[_imageView showHorizonWithRoll:roll level:level];
+	}
+	if (self.levelCapturePending && (level || isnan(roll))) {
+		[self releaseDeferredShot];
+	}
+}
+
+#pragma mark - CaptureControllerDelegate -
+
+- (void)captureController:(CaptureController *)controller didChangeProgress:(OLYCameraTakingProgress)progress info:(NSDictionary *)info
+{
+	if (progress == OLYCameraTakingProgressEndFocusing) {
+		NSString *focusResult   = info[OLYCameraTakingPictureProgressInfoFocusResultKey];
+		NSValue *focusRectValue = info[OLYCameraTakingPictureProgressInfoFocusRectKey];
+		
+		if ([focusResult isEqualToString:@"ok"] && focusRectValue) {
+			CGRect focusRect = [focusRectValue CGRectValue];
+			CGRect imageRect = OLYCameraConvertRectOnViewfinderIntoLiveImage(focusRect, self.imageView.image);
+			CGRect postFocusFrameRect = [self.imageView convertRectFromImageArea:imageRect];
+			[self.imageView showFocusFrame:postFocusFrameRect status:CameraFocusFrameStatusFocused animated:YES];
+			
+		} else {
+			[self.imageView hideFocusFrame];
+		}
+		
+	} else if (progress == OLYCameraTakingProgressBeginCapturing) {
+		[self.latencyBenchmark markStage:ShutterLatencyStageBeginCapturing];
+		AudioServicesPlaySystemSound(self.shutterSound);
+		// Only the shots the sequencer triggered measure its lag and phase.
+		if (controller.currentShotTag == LiveViewShotSourceClock) {
+			[self.clockSequencer cameraDidBeginCapturing];
+		}
+	}
+	[self updateMidiFeedback];
+}
+
+- (void)captureControllerDidFinishShot:(CaptureController *)controller
+{
+	[self.imageView hideFocusFrame];
+	[self updateMidiFeedback];
+	TRACE_COUNTER("capture.shotsPerMinute", controller.shotsPerSecond * 60.0);
+	TRACE_COUNTER("capture.queueDepth", controller.queueDepth);
+}
+
+- (void)captureController:(CaptureController *)controller didFailWithError:(NSError *)error
+{
+	[self.imageView hideFocusFrame];
+	[self updateMidiFeedback];
+	
+	if (error.domain != OLYCameraErrorDomain || error.code != OLYCameraErrorFocusFailed) {
+		NSString *title = NSLocalizedString(@"Take failed", nil);
+		NSString *message = error.localizedDescription;
+		NSString *ok = NSLocalizedString(@"OK", nil);
+		UIAlertView *alertView = [[UIAlertView alloc] initWithTitle:title message:message delegate:nil cancelButtonTitle:ok otherButtonTitles:nil];
+		[alertView show];
+	}
+}
+
+#pragma mark - Interval shooting -
+
+- (void)toggleIntervalShooting
+{
+	if (self.intervalometer.running) {
+		[self.intervalometer stop];
+		return;
+	}
+	NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+	self.intervalometer.interval = [userDefaults doubleForKey:@"interval_seconds"];
+	self.intervalometer.numberOfShots = (NSUInteger)[userDefaults integerForKey:@"interval_shots"];
+	self.intervalometer.rampsExposureCompensation = [userDefaults boolForKey:@"interval_exposure_ramp"];
+	self.intervalometer.startExposureCompensation = [userDefaults floatForKey:@"interval_exposure_start"];
+	self.intervalometer.endExposureCompensation = [userDefaults floatForKey:@"interval_exposure_end"];
+	[self.intervalometer start];
+}
+
+- (BOOL)intervalometerCanTakeShot:(Intervalometer *)intervalometer
+{
+	OLYCamera *camera = AppDelegateCamera();
+	if (!camera.connected || camera.takingPicture || camera.recordingVideo) {
+		return NO;
+	}
+	// A slot that would wait for the horizon is skipped like one of a busy camera, so the run stays on its grid.
+	if ([self shotWaitsForLevel]) {
+		return NO;
+	}
+	return (self.captureController.state == CaptureControllerStateIdle);
+}
+
+- (void)intervalometer:(Intervalometer *)intervalometer takeShotAtIndex:(NSUInteger)index
+{
+	[self releaseShutterFromSource:LiveViewShotSourceIntervalometer];
+	TRACE_INSTANT("interval.lateMicroseconds", intervalometer.lastTimingError * 1e6);
+	TRACE_COUNTER("interval.skippedShots", intervalometer.skippedShots);
+}
+
+- (void)intervalometer:(Intervalometer *)intervalometer changeExposureCompensation:(float)value
+{
+	// Pick the nearest step the camera offers. The values look like "<EXPREV/+0.3>".
+	NSError *error = nil;
+	OLYCamera *camera = AppDelegateCamera();
+	NSArray *valueList = [self.propertyCache valueListForProperty:ICSCameraPropertyExposureCompensation error:&error];
+	NSString *nearestValue = nil;
+	float nearestDistance = FLT_MAX;
+	for (NSString *candidate in valueList) {
+		NSRange separator = [candidate rangeOfString:@"/"];
+		if (separator.location == NSNotFound) {
+			continue;
+		}
+		float distance = fabsf([[candidate substringFromIndex:separator.location + 1] floatValue] - value);
+		if (distance < nearestDistance) {
+			nearestDistance = distance;
+			nearestValue = candidate;
+		}
+	}
+	if (!nearestValue) {
+		return;
+	}
+	if (![self.propertyCache setValue:nearestValue forProperty:ICSCameraPropertyExposureCompensation error:&error]) {
+		NSLog(@"ERROR SETTING EX RAMP TO: %@", nearestValue);
+	}
+}
+
+- (void)intervalometerDidFinish:(Intervalometer *)intervalometer
+{
+	NSLog(@"Interval shooting finished: %lu taken, %lu skipped, average late %.1f ms", (unsigned long)intervalometer.takenShots, (unsigned long)intervalometer.skippedShots, intervalometer.averageTimingError * 1000.0);
+}
+
+#pragma mark - MIDIClockSequencerDelegate -
+
+- (void)clockSequencer:(MIDIClockSequencer *)sequencer performAction:(MIDIClockSequencerAction)action
+{
+	if (action == MIDIClockSequencerActionToggleVideo) {
+		[self secondaryButtonDidTap:nil];
+	} else {
+		[self releaseShutterFromSource:LiveViewShotSourceClock];
+	}
+}
+
 #pragma mark - Camera property control -
 
 #pragma mark drive mode
@@ -597,7 +1024,7 @@
 {
 	__block NSError *error = nil;
     OLYCamera *camera = AppDelegateCamera();
-	NSArray *valueList = [camera cameraPropertyValueList:ICSCameraPropertyDrivemode error:&error];
+	NSArray *valueList = [self.propertyCache valueListForProperty:ICSCameraPropertyDrivemode error:&error];
 	if (!valueList) {
 		return;
 	}
@@ -606,7 +1033,7 @@
 		NSString *title = NSLocalizedString([camera cameraPropertyValueTitle:value], nil);
         [parameterList addObject:@{ICSParameterListTitleKey:title, ICSParameterListValueKey:value}];
     }
-	NSString *currentValue = [camera cameraPropertyValue:ICSCameraPropertyDrivemode error:&error];
+	NSString *currentValue = [self.propertyCache valueForProperty:ICSCameraPropertyDrivemode error:&error];
 	if (!currentValue) {
 		return;
 	}
@@ -616,7 +1043,7 @@
 	[self presentParameterList:parameterList initialValue:currentValue handler:^(NSString *value) {
 		[weakSelf dismissParameterList];
         self.drivemodeButton.selected = NO;
-		if (![camera setCameraPropertyValue:ICSCameraPropertyDrivemode value:value error:&error]) {
+		if (![self.propertyCache setValue:value forProperty:ICSCameraPropertyDrivemode error:&error]) {
 			return;
 		}
         [self updateDrivemodeButton];
@@ -627,7 +1054,7 @@
 {
 	NSError *error = nil;
     OLYCamera *camera = AppDelegateCamera();
-	NSString *value = [camera cameraPropertyValue:ICSCameraPropertyDrivemode error:&error];
+	NSString *value = [self.propertyCache valueForProperty:ICSCameraPropertyDrivemode error:&error];
 	UIImage *iconImageNormal = nil;
 	UIImage *iconImageSelected = nil;
 	if (value) {
@@ -646,7 +1073,7 @@
 {
 	__block NSError *error = nil;
     OLYCamera *camera = AppDelegateCamera();
-	NSArray *valueList = [camera cameraPropertyValueList:ICSCameraPropertyTakemode error:&error];
+	NSArray *valueList = [self.propertyCache valueListForProperty:ICSCameraPropertyTakemode error:&error];
 	if (!valueList) {
 		return;
 	}
@@ -655,7 +1082,7 @@
 		NSString *title = NSLocalizedString([camera cameraPropertyValueTitle:value], nil);
         [parameterList addObject:@{ICSParameterListTitleKey:title, ICSParameterListValueKey:value}];
     }
-	NSString *currentValue = [camera cameraPropertyValue:ICSCameraPropertyTakemode error:&error];
+	NSString *currentValue = [self.propertyCache valueForProperty:ICSCameraPropertyTakemode error:&error];
 	if (!currentValue) {
 		return;
 	}
@@ -665,7 +1092,7 @@
 	[self presentParameterList:parameterList initialValue:currentValue handler:^(NSString *value) {
 		[weakSelf dismissParameterList];
         self.takemodeButton.selected = NO;
-		if (![camera setCameraPropertyValue:ICSCameraPropertyTakemode value:value error:&error]) {
+		if (![self.propertyCache setValue:value forProperty:ICSCameraPropertyTakemode error:&error]) {
 			return;
 		}
         [self updateTakemodeButton];
@@ -676,7 +1103,7 @@
 {
 	NSError *error = nil;
 	OLYCamera *camera = AppDelegateCamera();
-	NSString *value = [camera cameraPropertyValue:ICSCameraPropertyTakemode error:&error];
+	NSString *value = [self.propertyCache valueForProperty:ICSCameraPropertyTakemode error:&error];
 	NSString *title = @"";
 	if (value) {
 		title = NSLocalizedString([camera cameraPropertyValueTitle:value], nil);
@@ -696,7 +1123,7 @@
 {
 	__block NSError *error = nil;
     OLYCamera *camera = AppDelegateCamera();
-	NSArray *valueList = [camera cameraPropertyValueList:ICSCameraPropertyShutterSpeed error:&error];
+	NSArray *valueList = [self.propertyCache valueListForProperty:ICSCameraPropertyShutterSpeed error:&error];
 	if (!valueList) {
 		return;
 	}
@@ -705,7 +1132,7 @@
 		NSString *title = NSLocalizedString([camera cameraPropertyValueTitle:value], nil);
         [parameterList addObject:@{ICSParameterListTitleKey:title, ICSParameterListValueKey:value}];
     }
-	NSString *currentValue = [camera cameraPropertyValue:ICSCameraPropertyShutterSpeed error:&error];
+	NSString *currentValue = [self.propertyCache valueForProperty:ICSCameraPropertyShutterSpeed error:&error];
 	if (!currentValue) {
 		return;
 	}
@@ -715,7 +1142,7 @@
 	[self presentParameterList:parameterList initialValue:currentValue handler:^(NSString *value) {
 		[weakSelf dismissParameterList];
         self.shutterSpeedButton.selected = NO;
-		if (![camera setCameraPropertyValue:ICSCameraPropertyShutterSpeed value:value error:&error]) {
+		if (![self.propertyCache setValue:value forProperty:ICSCameraPropertyShutterSpeed error:&error]) {
 			return;
 		}
     }];
@@ -744,7 +1171,7 @@
 {
 	__block NSError *error = nil;
     OLYCamera *camera = AppDelegateCamera();
-	NSArray *valueList = [camera cameraPropertyValueList:ICSCameraPropertyApertureValue error:&error];
+	NSArray *valueList = [self.propertyCache valueListForProperty:ICSCameraPropertyApertureValue error:&error];
 	if (!valueList) {
 		return;
 	}
@@ -753,7 +1180,7 @@
 		NSString *title = NSLocalizedString([camera cameraPropertyValueTitle:value], nil);
         [parameterList addObject:@{ICSParameterListTitleKey:title, ICSParameterListValueKey:value}];
     }
-	NSString *currentValue = [camera cameraPropertyValue:ICSCameraPropertyApertureValue error:&error];
+	NSString *currentValue = [self.propertyCache valueForProperty:ICSCameraPropertyApertureValue error:&error];
 	if (!currentValue) {
 		return;
 	}
@@ -763,7 +1190,7 @@
 	[self presentParameterList:parameterList initialValue:currentValue handler:^(NSString *value) {
 		[weakSelf dismissParameterList];
         self.apertureValueButton.selected = NO;
-		if (![camera setCameraPropertyValue:ICSCameraPropertyApertureValue value:value error:&error]) {
+		if (![self.propertyCache setValue:value forProperty:ICSCameraPropertyApertureValue error:&error]) {
 			return;
 		}
     }];
@@ -792,7 +1219,7 @@
 {
 	__block NSError *error = nil;
     OLYCamera *camera = AppDelegateCamera();
-	NSArray *valueList = [camera cameraPropertyValueList:ICSCameraPropertyExposureCompensation error:&error];
+	NSArray *valueList = [self.propertyCache valueListForProperty:ICSCameraPropertyExposureCompensation error:&error];
 	if (!valueList) {
 		return;
 	}
@@ -801,7 +1228,7 @@
 		NSString *title = NSLocalizedString([camera cameraPropertyValueTitle:value], nil);
         [parameterList addObject:@{ICSParameterListTitleKey:title, ICSParameterListValueKey:value}];
     }
-	NSString *currentValue = [camera cameraPropertyValue:ICSCameraPropertyExposureCompensation error:&error];
+	NSString *currentValue = [self.propertyCache valueForProperty:ICSCameraPropertyExposureCompensation error:&error];
 	if (!currentValue) {
 		return;
 	}
@@ -811,7 +1238,7 @@
 	[self presentParameterList:parameterList initialValue:currentValue handler:^(NSString *value) {
 		[weakSelf dismissParameterList];
         self.exposureCompensationButton.selected = NO;
-		if (![camera setCameraPropertyValue:ICSCameraPropertyExposureCompensation value:value error:&error]) {
+		if (![self.propertyCache setValue:value forProperty:ICSCameraPropertyExposureCompensation error:&error]) {
 			return;
 		}
     }];
@@ -821,7 +1248,7 @@
 {
     __block NSError *error = nil;
     OLYCamera *camera = AppDelegateCamera();
-    NSArray *valueList = [camera cameraPropertyValueList:ICSCameraPropertyExposureCompensation error:&error];
+    NSArray *valueList = [self.propertyCache valueListForProperty:ICSCameraPropertyExposureCompensation error:&error];
     if (!valueList) {
         return;
     }
@@ -830,7 +1257,7 @@
         NSString *title = NSLocalizedString([camera cameraPropertyValueTitle:value], nil);
         [parameterList addObject:@{ICSParameterListTitleKey:title, ICSParameterListValueKey:value}];
     }
-    NSString *currentValue = [camera cameraPropertyValue:ICSCameraPropertyExposureCompensation error:&error];
+    NSString *currentValue = [self.propertyCache valueForProperty:ICSCameraPropertyExposureCompensation error:&error];
     if (!currentValue) {
         return;
     }
@@ -839,7 +1266,7 @@
     int newIndex = (int)indexOfCurrentValue;
     if (valueList.count > newIndex+1) {
         NSString *value = [valueList objectAtIndex:newIndex+1];
-        if (![camera setCameraPropertyValue:ICSCameraPropertyExposureCompensation value:value error:&error]) {
+        if (![self.propertyCache setValue:value forProperty:ICSCameraPropertyExposureCompensation error:&error]) {
             NSLog(@"ERROR SETTING EX HIGHER TO: %d", newIndex);
             return;
         }
@@ -850,7 +1277,7 @@
 {
     __block NSError *error = nil;
     OLYCamera *camera = AppDelegateCamera();
-    NSArray *valueList = [camera cameraPropertyValueList:ICSCameraPropertyExposureCompensation error:&error];
+    NSArray *valueList = [self.propertyCache valueListForProperty:ICSCameraPropertyExposureCompensation error:&error];
     if (!valueList) {
         return;
     }
@@ -859,7 +1286,7 @@
         NSString *title = NSLocalizedString([camera cameraPropertyValueTitle:value], nil);
         [parameterList addObject:@{ICSParameterListTitleKey:title, ICSParameterListValueKey:value}];
     }
-    NSString *currentValue = [camera cameraPropertyValue:ICSCameraPropertyExposureCompensation error:&error];
+    NSString *currentValue = [self.propertyCache valueForProperty:ICSCameraPropertyExposureCompensation error:&error];
     if (!currentValue) {
         return;
     }
@@ -869,7 +1296,7 @@
     
     if (newIndex-1 > 0) {
         NSString *value = [valueList objectAtIndex:newIndex-1];
-        if (![camera setCameraPropertyValue:ICSCameraPropertyExposureCompensation value:value error:&error]) {
+        if (![self.propertyCache setValue:value forProperty:ICSCameraPropertyExposureCompensation error:&error]) {
             NSLog(@"ERROR SETTING EX LOWER TO: %d", newIndex);
             return;
         }
@@ -879,6 +1306,7 @@
 - (void)exposureCompensationValueDidChange:(NSDictionary *)change
 {
 	[self updateExposureCompensationButton];
+	[self updateMidiFeedback];
 }
 
 - (void)updateExposureCompensationButton
@@ -899,7 +1327,7 @@
 {
 	__block NSError *error = nil;
     OLYCamera *camera = AppDelegateCamera();
-	NSArray *valueList = [camera cameraPropertyValueList:ICSCameraPropertyIsoSensitivity error:&error];
+	NSArray *valueList = [self.propertyCache valueListForProperty:ICSCameraPropertyIsoSensitivity error:&error];
 	if (!valueList) {
 		return;
 	}
@@ -908,7 +1336,7 @@
 		NSString *title = NSLocalizedString([camera cameraPropertyValueTitle:value], nil);
         [parameterList addObject:@{ICSParameterListTitleKey:title, ICSParameterListValueKey:value}];
     }
-	NSString *currentValue = [camera cameraPropertyValue:ICSCameraPropertyIsoSensitivity error:&error];
+	NSString *currentValue = [self.propertyCache valueForProperty:ICSCameraPropertyIsoSensitivity error:&error];
 	if (!currentValue) {
 		return;
 	}
@@ -918,7 +1346,7 @@
 	[self presentParameterList:parameterList initialValue:currentValue handler:^(NSString *value) {
 		[weakSelf dismissParameterList];
         self.isoSensitivityButton.selected = NO;
-		if (![camera setCameraPropertyValue:ICSCameraPropertyIsoSensitivity value:value error:&error]) {
+		if (![self.propertyCache setValue:value forProperty:ICSCameraPropertyIsoSensitivity error:&error]) {
 			return;
 		}
     }];
@@ -934,7 +1362,7 @@
 	NSError *error = nil;
 	OLYCamera *camera = AppDelegateCamera();
 	NSString *title = @"";
-	NSString *preferred = [camera cameraPropertyValue:ICSCameraPropertyIsoSensitivity error:&error];
+	NSString *preferred = [self.propertyCache valueForProperty:ICSCameraPropertyIsoSensitivity error:&error];
 	if (preferred) {
 		NSString *value = camera.actualIsoSensitivity;
 		if ([preferred isEqualToString:@"<ISO/Auto>"]) {
@@ -953,7 +1381,7 @@
 {
 	__block NSError *error = nil;
     OLYCamera *camera = AppDelegateCamera();
-	NSArray *valueList = [camera cameraPropertyValueList:ICSCameraPropertyWhiteBalance error:&error];
+	NSArray *valueList = [self.propertyCache valueListForProperty:ICSCameraPropertyWhiteBalance error:&error];
 	if (!valueList) {
 		return;
 	}
@@ -962,7 +1390,7 @@
 		NSString *title = NSLocalizedString([camera cameraPropertyValueTitle:value], nil);
         [parameterList addObject:@{ICSParameterListTitleKey:title, ICSParameterListValueKey:value}];
     }
-	NSString *currentValue = [camera cameraPropertyValue:ICSCameraPropertyWhiteBalance error:&error];
+	NSString *currentValue = [self.propertyCache valueForProperty:ICSCameraPropertyWhiteBalance error:&error];
 	if (!currentValue) {
 		return;
 	}
@@ -972,7 +1400,7 @@
 	[self presentParameterList:parameterList initialValue:currentValue handler:^(NSString *value) {
 		[weakSelf dismissParameterList];
         self.whiteBalanceButton.selected = NO;
-		if (![camera setCameraPropertyValue:ICSCameraPropertyWhiteBalance value:value error:&error]) {
+		if (![self.propertyCache setValue:value forProperty:ICSCameraPropertyWhiteBalance error:&error]) {
 			return;
 		}
 		[self updateWhiteBalanceButton];
@@ -988,7 +1416,7 @@
 {
 	NSError *error = nil;
     OLYCamera *camera = AppDelegateCamera();
-	NSString *value = [camera cameraPropertyValue:ICSCameraPropertyWhiteBalance error:&error];
+	NSString *value = [self.propertyCache valueForProperty:ICSCameraPropertyWhiteBalance error:&error];
 	UIImage *iconImageNormal = nil;
 	UIImage *iconImageSelected = nil;
 	if (value) {
@@ -1012,13 +1440,19 @@
 {
     NSError *error = nil;
 	OLYCamera *camera = AppDelegateCamera();
-    NSString *value = [camera cameraPropertyValue:ICSCameraPropertyBatteryLevel error:&error];
+    NSString *value = [self.propertyCache valueForProperty:ICSCameraPropertyBatteryLevel error:&error];
 	UIImage *iconImage = nil;
 	if (value) {
 		NSString *iconImageName = self.batteryIconList[value];
 		iconImage = [UIImage imageNamed:iconImageName];
 	}
 	self.batteryLevelImageView.image = iconImage;
+	
+	// The LED shows the charge in four steps; an unknown level leaves it as it is.
+	NSNumber *feedbackValue = value ? self.batteryFeedbackList[value] : nil;
+	if (feedbackValue) {
+		[self.feedbackController setValue:feedbackValue.unsignedCharValue forElement:MIDIFeedbackElementBatteryLevel];
+	}
 }
 
 #pragma mark remaining recordable images
@@ -1047,6 +1481,7 @@
 - (void)mediaBusyValueDidChange:(NSDictionary *)change
 {
 	[self updateRemainingRecordableImagesLabel];
+	[self updateMidiFeedback];
 }
 
 #pragma mark Helpers
@@ -1115,13 +1550,61 @@
 
 - (void)camera:(OLYCamera *)camera didUpdateLiveView:(NSData *)data metadata:(NSDictionary *)metadata
 {
+	[AppDelegateConnectionManager() cameraDidUpdateLiveView];
+	[AppDelegateConnectionHealthMonitor() recordLiveFrameOfLength:data.length];
+	[self.levelGauge sampleLevelGauge:camera];
+	TRACE_BEGIN("liveview.decode");
 	UIImage *image = OLYCameraConvertDataToImage(data, metadata);
+	TRACE_END("liveview.decode");
     _imageView.image = nil; // HACK: Force to refresh UIImageView contents.
 	_imageView.image = image;
+	
+	// Follow the subject unless the previous frame is still being searched.
+	if (self.followingSubject && image && !self.objectTrackingBusy) {
+		self.objectTrackingBusy = YES;
+		__weak LiveViewController *weakSelf = self;
+		ObjectTracker *tracker = self.objectTracker;
+		NSUInteger generation = self.followingSubjectGeneration;
+		dispatch_async(self.objectTrackingQueue, ^{
+			if (!tracker.tracking) {
+				weakSelf.objectTrackingBusy = NO;
+				return;
+			}
+			BOOL found = [tracker processImage:image];
+			CGPoint position = tracker.position;
+			CGSize size = tracker.size;
+			weakSelf.objectTrackingBusy = NO;
+			dispatch_async(dispatch_get_main_queue(), ^{
+				if (found) {
+					[weakSelf objectTrackerDidMoveToPosition:position size:size generation:generation];
+				} else {
+					[weakSelf objectTrackerDidLoseSubjectOfGeneration:generation];
+				}
+			});
+		});
+	}
+	
+	// Examine the frame for motion unless the previous one is still being examined.
+	if (self.trapArmed && image && !self.motionDetecting) {
+		self.motionDetecting = YES;
+		__weak LiveViewController *weakSelf = self;
+		MotionDetector *detector = self.motionDetector;
+		dispatch_async(self.motionDetectionQueue, ^{
+			BOOL motion = [detector processImage:image];
+			weakSelf.motionDetecting = NO;
+			if (motion) {
+				dispatch_async(dispatch_get_main_queue(), ^{
+					[weakSelf motionDetectorDidDetectMotion];
+				});
+			}
+		});
+	}
 }
 
 - (void)camera:(OLYCamera *)camera didChangeCameraProperty:(NSString *)name
 {
+	// Drop the stale value before anyone on the main thread can read it.
+	[self.propertyCache invalidateProperty:name];
 	if (![NSThread isMainThread]) {
 		dispatch_async(dispatch_get_main_queue(), ^{
 			[self camera:camera didChangeCameraProperty:name];
@@ -1168,65 +1651,126 @@
 
 - (void)connectMidi
 {
-    MIKMIDIDeviceManager *deviceManager = [MIKMIDIDeviceManager sharedDeviceManager];
+    // The sources of all the controllers are merged into one stream in time stamp order.
+    self.sourceMerger = [[MIDISourceMerger alloc] init];
+    self.sourceMerger.delegate = self;
     
-    NSArray *availableDevices = [deviceManager availableDevices];
+    // Ototo strangely responds with name following 3 space characters, which the device manager ignores.
+    // The handler is called for the device that is already plugged in and again whenever it comes back.
+    __weak LiveViewController *weakSelf = self;
+    self.midiDeviceHandlerToken = [[MIKMIDIDeviceManager sharedDeviceManager] addHandlerForDevicesWithName:@"Dentaku Ototo" handler:^(MIKMIDIDevice *device) {
+        NSLog(@"Device name: %@", device.name);
+        for (MIKMIDISourceEndpoint *source in [device.entities valueForKeyPath:@"@unionOfArrays.sources"]) {
+            [weakSelf.sourceMerger addSource:source];
+        }
+        // The LEDs and faders are driven through the first destination; a device that comes back is sent everything again.
+        weakSelf.feedbackController.destination = [[device.entities valueForKeyPath:@"@unionOfArrays.destinations"] firstObject];
+    }];
     
-    MIKMIDIDevice *device;
+    // Launch with "-benchmark_shots N" to replay shutter notes and log the latency of each stage.
+    NSUInteger benchmarkShots = (NSUInteger)[[NSUserDefaults standardUserDefaults] integerForKey:@"benchmark_shots"];
+    if (benchmarkShots > 0) {
+        [self.sourceMerger addSource:self.latencyBenchmark.replaySource];
+        NSTimeInterval interval = [[NSUserDefaults standardUserDefaults] doubleForKey:@"benchmark_interval"];
+        [self.latencyBenchmark replayNote:60 count:benchmarkShots interval:interval completionHandler:^{
+            NSLog(@"MIDI to shutter latency:\n%@", [weakSelf.latencyBenchmark percentileTable]);
+        }];
+    }
+}
+
+/**
+ * Sets the camera state the controller shows. The feedback controller sends only what changed, once per frame.
+ * The battery level is set where it is read, as reading it may ask the camera.
+ */
+- (void)updateMidiFeedback
+{
+    OLYCamera *camera = AppDelegateCamera();
+    MIDIFeedbackController *feedback = self.feedbackController;
     
-    BOOL found = NO;
+    [feedback setValue:(camera.recordingVideo ? 127 : 0) forElement:MIDIFeedbackElementRecording];
+    BOOL busy = (self.captureController.state != CaptureControllerStateIdle || camera.takingPicture || camera.mediaBusy || self.levelCapturePending);
+    [feedback setValue:(busy ? 127 : 0) forElement:MIDIFeedbackElementShutterBusy];
     
-    int i = 0;
-    for (id object in availableDevices) {
-        // Ototo strangely responds with name following 3 space characters:
-        if ([[object name] isEqual: @"Dentaku Ototo   "]) {
-            device = availableDevices[i];
-            NSLog(@"FOUND OTOTO");
-            NSLog(@"Device name: %@", device.name);
-            found = YES;
-        }
-        i++;
+    // The values look like "<EXPREV/+0.3>"; -5.0 to +5.0 is spread over the range of a fader.
+    NSString *exposureCompensation = camera.actualExposureCompensation;
+    NSRange separator = [exposureCompensation rangeOfString:@"/"];
+    if (separator.location != NSNotFound) {
+        float value = [[exposureCompensation substringFromIndex:separator.location + 1] floatValue];
+        value = MAX(-5.0f, MIN(value, 5.0f));
+        [feedback setValue:(uint8_t)lroundf((value + 5.0f) * 12.7f) forElement:MIDIFeedbackElementExposureCompensation];
     }
-    
-    if (found == YES) {
-        
-        NSArray *sources = [device.entities valueForKeyPath:@"@unionOfArrays.sources"];
-        if (![sources count]) return;
-        MIKMIDISourceEndpoint *source = [sources objectAtIndex:0];
-        NSError *error = nil;
+}
+
+#pragma mark - MIDISourceMergerDelegate -
+
+- (void)sourceMerger:(MIDISourceMerger *)merger didReceiveCommand:(MIKMIDICommand *)command sourceID:(NSUInteger)sourceID
+{
+    [self handleMidiCommands:@[command]];
+}
+
+- (void)handleMidiCommands:(NSArray *)commands
+{
+    TRACE_BEGIN("midi.dispatch");
+    TRACE_COUNTER("midi.commands", commands.count);
+    for (MIKMIDICommand *command in commands) {
         
-        id connectionToken = [deviceManager connectInput:source error:&error eventHandler:^(MIKMIDISourceEndpoint *source, NSArray *commands) {
-            
-            for (MIKMIDIChannelVoiceCommand *command in commands) {
-                
-                if (command.commandType == MIKMIDICommandTypeNoteOn) {
-                    
-                    MIKMIDINoteOnCommand *note = command;
-                    
-                    [[UIApplication sharedApplication] handleMIDICommand:command];
-                    
-                    NSLog(@"Received from ototo: %@", command);
-                    
-                    if (note.note == 60) {
-                        // shutter
-                        [self shutterButtonDidTap:nil];
-                    } else if (note.note == 62) {
-                        // movie
-                        [self secondaryButtonDidTap:nil];
-                    } else if (note.note == 64) {
-                        // EX-
-                        [self exposureCompensationLower];
-                    } else if (note.note == 65) {
-                        // EX+
-                        [self exposureCompensationHigher];
-                    }
-                    
-                }
-            }
-            
-        }];
+        // Clock, start/stop and song position drive the beat-synced sequencer.
+        [self.clockSequencer handleCommand:command];
         
-        if (!connectionToken) NSLog(@"Unable to connect to input: %@", error);
+        // Notes, controllers and program changes are mapped to the camera actions by the rules.
+        [self.actionMapper handleCommand:command];
+    }
+    TRACE_END("midi.dispatch");
+}
+
+/**
+ * Loads the rules from MIDIActions.plist in the documents, or from the settings if there is none.
+ */
+- (void)loadMidiActions
+{
+    NSURL *documentsURL = [[[NSFileManager defaultManager] URLsForDirectory:NSDocumentDirectory inDomains:NSUserDomainMask] lastObject];
+    NSArray *rules = [NSArray arrayWithContentsOfURL:[documentsURL URLByAppendingPathComponent:@"MIDIActions.plist"]];
+    if (!rules) {
+        rules = [[NSUserDefaults standardUserDefaults] arrayForKey:@"midi_actions"];
+    }
+    if (![rules isEqualToArray:self.actionMapper.rules]) {
+        self.actionMapper.rules = rules;
+    }
+}
+
+- (void)applicationDidBecomeActive:(NSNotification *)notification
+{
+    // The mapping file may have been replaced while the app was in the background.
+    [self loadMidiActions];
+}
+
+#pragma mark - MIDIActionMapperDelegate -
+
+- (void)actionMapper:(MIDIActionMapper *)mapper performAction:(MIDIAction)action value:(uint8_t)value command:(MIKMIDICommand *)command
+{
+    TRACE_INSTANT("midi.action", action);
+    
+    switch (action) {
+        case MIDIActionShutter:
+            [self.latencyBenchmark beginSampleWithMIDITimestamp:command.midiTimestamp];
+            [self releaseShutterFromSource:LiveViewShotSourceMIDI];
+            break;
+        case MIDIActionToggleVideo:
+            [self secondaryButtonDidTap:nil];
+            break;
+        case MIDIActionExposureDown:
+            [self exposureCompensationLower];
+            break;
+        case MIDIActionExposureUp:
+            [self exposureCompensationHigher];
+            break;
+        case MIDIActionToggleIntervalShooting:
+            [self toggleIntervalShooting];
+            break;
+        case MIDIActionZoom:
+            // A knob or a fader drives the zoom lens.
+            [self.zoomController handleControllerValue:value];
+            break;
     }
 }
 
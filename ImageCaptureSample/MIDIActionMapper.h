@@ -0,0 +1,61 @@
+//
+//  MIDIActionMapper.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class MIKMIDICommand;
+@class MIDIActionMapper;
+
+enum MIDIAction
+{
+	MIDIActionShutter,
+	MIDIActionToggleVideo,
+	MIDIActionExposureDown,
+	MIDIActionExposureUp,
+	MIDIActionToggleIntervalShooting,
+	MIDIActionZoom,
+};
+
+typedef enum MIDIAction MIDIAction;
+
+@protocol MIDIActionMapperDelegate <NSObject>
+
+/**
+ * Performs the action of a rule that matched.
+ *
+ * @param value The velocity, controller value or program number of the message.
+ */
+- (void)actionMapper:(MIDIActionMapper *)mapper performAction:(MIDIAction)action value:(uint8_t)value command:(MIKMIDICommand *)command;
+
+@end
+
+/**
+ * Maps MIDI messages to camera actions by rules.
+ *
+ * A rule is a dictionary with the following keys:
+ *   message  "note", "cc" or "program".
+ *   number   The note or controller number. (not used for "program")
+ *   channel  1 to 16, or 0 for any channel. (default: 0)
+ *   min, max The range of the velocity, controller value or program number. (default: 1-127 for notes, 0-127 for others)
+ *   trigger  "level" fires on every message in the range, "edge" only when the value enters the range. (default: "level")
+ *   action   "shutter", "movie", "exposure_down", "exposure_up", "interval" or "zoom".
+ *
+ * Rules are compiled into a table indexed by the status and the first data byte,
+ * so a message is matched without comparing strings. A note off is matched as a
+ * note on of velocity zero. Replacing the rules swaps the table between two
+ * messages, and an edge trigger starts out of its range again.
+ * All methods must be called on the main thread.
+ */
+@interface MIDIActionMapper : NSObject
+
+@property (weak, nonatomic) id<MIDIActionMapperDelegate> delegate;
+/** The rules the table was compiled from. Invalid rules are logged and skipped. */
+@property (copy, nonatomic) NSArray *rules;
+
+- (void)handleCommand:(MIKMIDICommand *)command;
+
+@end
@@ -0,0 +1,146 @@
+//
+//  MIDIActionMapper.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "MIDIActionMapper.h"
+#import "MIKMIDI.h"
+#import "MIDIActionMapperCore.h"
+
+/**
+ * The message being matched, for the actions it performs.
+ */
+struct MIDIActionMapperMatch
+{
+	__unsafe_unretained MIDIActionMapper *mapper;
+	__unsafe_unretained MIKMIDICommand *command;
+};
+
+typedef struct MIDIActionMapperMatch MIDIActionMapperMatch;
+
+static void MIDIActionMapperPerform(void *context, uint8_t action, uint8_t value);
+
+@interface MIDIActionMapper ()
+
+@property (strong, nonatomic) NSMutableData *entries;
+@property (strong, nonatomic) NSMutableData *slots;
+
+@end
+
+@implementation MIDIActionMapper
+
+- (id)init
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	_entries = [[NSMutableData alloc] initWithLength:sizeof(MIDIActionEntry) * kMIDIActionTableCount];
+	_slots = [[NSMutableData alloc] init];
+	return self;
+}
+
+#pragma mark -
+
+- (void)setRules:(NSArray *)rules
+{
+	_rules = [rules copy];
+
+	NSMutableData *keyedSlots = [[NSMutableData alloc] init];
+	for (NSDictionary *rule in _rules) {
+		if (![self compileRule:rule intoKeyedSlots:keyedSlots]) {
+			NSLog(@"To compile the MIDI action rule is failed: %@", rule);
+		}
+	}
+
+	NSUInteger slotCount = keyedSlots.length / sizeof(MIDIActionKeyedSlot);
+	NSMutableData *entries = [[NSMutableData alloc] initWithLength:sizeof(MIDIActionEntry) * kMIDIActionTableCount];
+	NSMutableData *slots = [[NSMutableData alloc] initWithLength:sizeof(MIDIActionSlot) * slotCount];
+	MIDIActionBuildTable(keyedSlots.bytes, slotCount, entries.mutableBytes, slots.mutableBytes);
+
+	// Messages are handled on the main thread too, so none of them sees a half-built table.
+	self.entries = entries;
+	self.slots = slots;
+}
+
+- (BOOL)compileRule:(NSDictionary *)rule intoKeyedSlots:(NSMutableData *)keyedSlots
+{
+	static NSDictionary *actions;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		actions = @{@"shutter": @(MIDIActionShutter),
+					@"movie": @(MIDIActionToggleVideo),
+					@"exposure_down": @(MIDIActionExposureDown),
+					@"exposure_up": @(MIDIActionExposureUp),
+					@"interval": @(MIDIActionToggleIntervalShooting),
+					@"zoom": @(MIDIActionZoom)};
+	});
+	if (![rule isKindOfClass:[NSDictionary class]]) {
+		return NO;
+	}
+	NSNumber *action = actions[rule[@"action"]];
+	if (!action) {
+		return NO;
+	}
+
+	NSString *message = rule[@"message"];
+	uint8_t status;
+	NSInteger minimum = 0;
+	if ([message isEqualToString:@"note"]) {
+		status = 0x90;
+		minimum = 1;
+	} else if ([message isEqualToString:@"cc"]) {
+		status = 0xB0;
+	} else if ([message isEqualToString:@"program"]) {
+		status = 0xC0;
+	} else {
+		return NO;
+	}
+	if (rule[@"min"]) {
+		minimum = [rule[@"min"] integerValue];
+	}
+	MIDIActionRule compiledRule;
+	compiledRule.status = status;
+	compiledRule.number = (int)[rule[@"number"] integerValue];
+	compiledRule.channel = (int)[rule[@"channel"] integerValue];
+	compiledRule.minimum = (int)minimum;
+	compiledRule.maximum = rule[@"max"] ? (int)[rule[@"max"] integerValue] : 127;
+	compiledRule.action = (uint8_t)[action unsignedIntegerValue];
+	compiledRule.edge = [rule[@"trigger"] isEqualToString:@"edge"];
+
+	NSUInteger slotCount = keyedSlots.length / sizeof(MIDIActionKeyedSlot);
+	NSUInteger ruleSlotCount = MIDIActionRuleSlotCount(&compiledRule);
+	if (ruleSlotCount == 0) {
+		return NO;
+	}
+	keyedSlots.length = sizeof(MIDIActionKeyedSlot) * (slotCount + ruleSlotCount);
+	NSUInteger compiledSlotCount = MIDIActionCompileRule(&compiledRule, keyedSlots.mutableBytes, slotCount);
+	keyedSlots.length = sizeof(MIDIActionKeyedSlot) * compiledSlotCount;
+	return (compiledSlotCount > slotCount);
+}
+
+#pragma mark -
+
+- (void)handleCommand:(MIKMIDICommand *)command
+{
+	// The accessors read the bytes in place; the data property would copy them for every message.
+	// The table is held locally, so a delegate that replaces the rules does not free it under the match.
+	NSMutableData *entries = self.entries;
+	NSMutableData *slots = self.slots;
+	uint8_t status = command.commandType;
+	uint8_t type = status & 0xF0;
+	// Only the messages of three bytes have a second data byte; reading it from others would grow them.
+	uint8_t dataByte2 = (type == 0xC0 || type == 0xD0 || type == 0xF0) ? 0 : command.dataByte2;
+	MIDIActionMapperMatch match = {self, command};
+	MIDIActionMatch(entries.bytes, slots.mutableBytes, status, command.dataByte1, dataByte2, MIDIActionMapperPerform, &match);
+}
+
+static void MIDIActionMapperPerform(void *context, uint8_t action, uint8_t value)
+{
+	MIDIActionMapperMatch *match = context;
+	[match->mapper.delegate actionMapper:match->mapper performAction:(MIDIAction)action value:value command:match->command];
+}
+
+@end
@@ -0,0 +1,192 @@
+//
+//  MIDIActionMapperCore.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#ifndef ImageCaptureSample_MIDIActionMapperCore_h
+#define ImageCaptureSample_MIDIActionMapperCore_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * The rule table of MIDIActionMapper in plain C, so that it can also be built,
+ * checked and measured off the device.
+ */
+
+enum
+{
+	kMIDIActionTableStatusCount = 0x70,	// The channel voice statuses, 0x80 to 0xEF.
+	kMIDIActionTableDataCount = 0x80,
+	kMIDIActionTableCount = kMIDIActionTableStatusCount * kMIDIActionTableDataCount,
+	/** The most slots a table holds; a rule that would go beyond it is not compiled. */
+	kMIDIActionTableMaximumSlotCount = UINT16_MAX,
+};
+
+/**
+ * A rule as read from the settings, before it is checked.
+ */
+typedef struct {
+	/** 0x90 for notes, 0xB0 for controllers or 0xC0 for program changes. */
+	uint8_t status;
+	/** The note or controller number; not used for program changes. */
+	int number;
+	/** 1 to 16, or 0 for any channel. */
+	int channel;
+	int minimum;
+	int maximum;
+	uint8_t action;
+	bool edge;
+} MIDIActionRule;
+
+/**
+ * The rules of a status and data byte are the count slots from the first.
+ */
+typedef struct {
+	uint16_t first;
+	uint16_t count;
+} MIDIActionEntry;
+
+typedef struct {
+	uint8_t minimum;
+	uint8_t maximum;
+	uint8_t action;
+	bool edge;
+	/** Whether the latest value was in the range; edge triggers fire only when this turns on. */
+	bool inRange;
+} MIDIActionSlot;
+
+/**
+ * A compiled rule before it is placed in the table.
+ */
+typedef struct {
+	uint16_t key;
+	MIDIActionSlot slot;
+} MIDIActionKeyedSlot;
+
+typedef void (*MIDIActionPerformFunction)(void *context, uint8_t action, uint8_t value);
+
+static inline uint16_t MIDIActionTableKey(uint8_t status, uint8_t number)
+{
+	return (uint16_t)(((status - 0x80) << 7) | number);
+}
+
+/**
+ * Returns the number of slots a rule compiles to, or 0 if it is invalid.
+ */
+static inline size_t MIDIActionRuleSlotCount(const MIDIActionRule *rule)
+{
+	if (rule->status != 0x90 && rule->status != 0xB0 && rule->status != 0xC0) {
+		return 0;
+	}
+	if (rule->minimum < 0 || rule->maximum > 127 || rule->minimum > rule->maximum || rule->number < 0 || rule->number > 127 || rule->channel < 0 || rule->channel > 16) {
+		return 0;
+	}
+	// A program change has no value of its own, so its rule covers the programs in the range.
+	size_t numbers = (rule->status == 0xC0) ? (size_t)(rule->maximum - rule->minimum + 1) : 1;
+	size_t channels = (rule->channel == 0) ? 16 : 1;
+	return numbers * channels;
+}
+
+/**
+ * Compiles a rule into keyed slots, after the slotCount ones already in keyedSlots.
+ *
+ * @param keyedSlots It needs room for MIDIActionRuleSlotCount more slots.
+ * @return The new number of keyed slots, or slotCount if the rule is invalid or the table would overflow.
+ */
+static inline size_t MIDIActionCompileRule(const MIDIActionRule *rule, MIDIActionKeyedSlot *keyedSlots, size_t slotCount)
+{
+	size_t ruleSlotCount = MIDIActionRuleSlotCount(rule);
+	if (ruleSlotCount == 0 || slotCount + ruleSlotCount > kMIDIActionTableMaximumSlotCount) {
+		return slotCount;
+	}
+	MIDIActionKeyedSlot keyedSlot;
+	keyedSlot.slot.minimum = (uint8_t)rule->minimum;
+	keyedSlot.slot.maximum = (uint8_t)rule->maximum;
+	keyedSlot.slot.action = rule->action;
+	keyedSlot.slot.edge = rule->edge;
+	keyedSlot.slot.inRange = false;
+
+	int firstNumber = (rule->status == 0xC0) ? rule->minimum : rule->number;
+	int lastNumber = (rule->status == 0xC0) ? rule->maximum : rule->number;
+	int firstChannel = (rule->channel == 0) ? 0 : rule->channel - 1;
+	int lastChannel = (rule->channel == 0) ? 15 : rule->channel - 1;
+	for (int channel = firstChannel; channel <= lastChannel; channel++) {
+		for (int number = firstNumber; number <= lastNumber; number++) {
+			keyedSlot.key = MIDIActionTableKey((uint8_t)(rule->status | channel), (uint8_t)number);
+			keyedSlots[slotCount++] = keyedSlot;
+		}
+	}
+	return slotCount;
+}
+
+/**
+ * Places keyed slots in a table.
+ *
+ * A counting sort by key, so the slots of each entry are contiguous and keep the order of the rules.
+ *
+ * @param entries kMIDIActionTableCount entries, which are overwritten.
+ * @param slots Room for slotCount slots.
+ */
+static inline void MIDIActionBuildTable(const MIDIActionKeyedSlot *keyedSlots, size_t slotCount, MIDIActionEntry *entries, MIDIActionSlot *slots)
+{
+	for (size_t key = 0; key < kMIDIActionTableCount; key++) {
+		entries[key].count = 0;
+	}
+	for (size_t index = 0; index < slotCount; index++) {
+		entries[keyedSlots[index].key].count++;
+	}
+	uint16_t first = 0;
+	for (size_t key = 0; key < kMIDIActionTableCount; key++) {
+		entries[key].first = first;
+		first += entries[key].count;
+		entries[key].count = 0;
+	}
+	for (size_t index = 0; index < slotCount; index++) {
+		MIDIActionEntry *entry = &entries[keyedSlots[index].key];
+		slots[entry->first + entry->count++] = keyedSlots[index].slot;
+	}
+}
+
+/**
+ * Performs the actions of the slots a message matches, in the order of the rules.
+ *
+ * A note off is matched as a note on of velocity zero. Messages other than channel voice ones match nothing.
+ */
+static inline void MIDIActionMatch(const MIDIActionEntry *entries, MIDIActionSlot *slots, uint8_t status, uint8_t dataByte1, uint8_t dataByte2, MIDIActionPerformFunction perform, void *context)
+{
+	uint8_t value;
+	switch (status & 0xF0) {
+		case 0x80:
+			status = 0x90 | (status & 0x0F);
+			value = 0;
+			break;
+		case 0x90:
+		case 0xA0:
+		case 0xB0:
+		case 0xE0:
+			value = dataByte2;
+			break;
+		case 0xC0:
+		case 0xD0:
+			value = dataByte1;
+			break;
+		default:
+			return;
+	}
+	MIDIActionEntry entry = entries[MIDIActionTableKey(status, dataByte1 & 0x7F)];
+	for (uint16_t index = entry.first; index < entry.first + entry.count; index++) {
+		MIDIActionSlot *slot = &slots[index];
+		bool inRange = (value >= slot->minimum && value <= slot->maximum);
+		bool fire = inRange && !(slot->edge && slot->inRange);
+		slot->inRange = inRange;
+		if (fire) {
+			perform(context, slot->action, value);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,64 @@
+//
+//  MIDIClockSequencer.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreMIDI/CoreMIDI.h>
+
+@class MIKMIDICommand;
+@class MIDIClockSequencer;
+
+enum MIDIClockSequencerAction
+{
+	MIDIClockSequencerActionShutter,
+	MIDIClockSequencerActionToggleVideo,
+};
+
+typedef enum MIDIClockSequencerAction MIDIClockSequencerAction;
+
+@protocol MIDIClockSequencerDelegate <NSObject>
+
+- (void)clockSequencer:(MIDIClockSequencer *)sequencer performAction:(MIDIClockSequencerAction)action;
+
+@end
+
+/**
+ * Follows an external MIDI clock and performs camera actions on beat divisions.
+ *
+ * The tempo and phase of the clock are tracked by a second-order phase-locked loop
+ * over the CoreMIDI timestamps, so main-queue delivery jitter does not reach the
+ * trigger times. Actions are issued early by the measured shutter lag so that the
+ * exposure, not the command, lands on the beat.
+ * All methods must be called on the main thread.
+ */
+@interface MIDIClockSequencer : NSObject
+
+@property (weak, nonatomic) id<MIDIClockSequencerDelegate> delegate;
+@property (assign, nonatomic) MIDIClockSequencerAction action;
+/** The trigger division in clock ticks. (24 ticks per quarter note, e.g. 96 for a 4/4 bar) */
+@property (assign, nonatomic) NSUInteger ticksPerTrigger;
+/** The offset of the triggers in clock ticks from the song position zero. */
+@property (assign, nonatomic) NSUInteger tickOffset;
+/** The phase gain of the loop filter. */
+@property (assign, nonatomic) double phaseGain;
+/** The frequency gain of the loop filter. */
+@property (assign, nonatomic) double frequencyGain;
+@property (assign, nonatomic, readonly, getter = isPlaying) BOOL playing;
+@property (assign, nonatomic, readonly) double tempo;
+/** The smoothed delay from issuing the action to the start of the exposure, in seconds. */
+@property (assign, nonatomic, readonly) NSTimeInterval shutterLag;
+/** The distance of the latest exposure from its beat, in seconds. Positive is late. */
+@property (assign, nonatomic, readonly) NSTimeInterval lastPhaseError;
+
+- (void)handleCommand:(MIKMIDICommand *)command;
+- (void)handleClockAtTimeStamp:(MIDITimeStamp)timeStamp;
+- (void)handleStartAtTimeStamp:(MIDITimeStamp)timeStamp;
+- (void)handleContinueAtTimeStamp:(MIDITimeStamp)timeStamp;
+- (void)handleStop;
+- (void)handleSongPosition:(NSUInteger)sixteenths;
+- (void)cameraDidBeginCapturing;
+
+@end
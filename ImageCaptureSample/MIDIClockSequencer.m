@@ -0,0 +1,229 @@
+//
+//  MIDIClockSequencer.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "MIDIClockSequencer.h"
+#import <mach/mach_time.h>
+#import "MIKMIDICommand.h"
+#import "MIDIClockSequencerCore.h"
+
+static const NSUInteger kTicksPerQuarterNote = 24;
+static const NSUInteger kTicksPerSixteenthNote = 6;
+// An action the camera has not begun capturing for this long was refused.
+static const NSTimeInterval kCaptureTimeout = 2.0;
+
+/**
+ * Converts a host time into seconds.
+ */
+static NSTimeInterval MIDIClockSequencerSecondsFromHostTime(uint64_t hostTime)
+{
+	static mach_timebase_info_data_t timebase;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		mach_timebase_info(&timebase);
+	});
+	return (NSTimeInterval)hostTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+static NSTimeInterval MIDIClockSequencerCurrentTime(void)
+{
+	return MIDIClockSequencerSecondsFromHostTime(mach_absolute_time());
+}
+
+@interface MIDIClockSequencer ()
+
+@property (assign, nonatomic, readwrite, getter = isPlaying) BOOL playing;
+@property (assign, nonatomic, readwrite) NSTimeInterval shutterLag;
+@property (assign, nonatomic, readwrite) NSTimeInterval lastPhaseError;
+// Transport state.
+@property (assign, nonatomic) NSUInteger nextTick;
+@property (assign, nonatomic) NSInteger lastScheduledTick;
+@property (assign, nonatomic) NSUInteger generation;
+
+@end
+
+@implementation MIDIClockSequencer
+{
+	MIDIClockLoop _loop;
+	/** The issued shutter actions, measured in order as the camera begins capturing. */
+	MIDIClockCaptureQueue _pendingCaptures;
+}
+
+- (id)init
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	_action = MIDIClockSequencerActionShutter;
+	_ticksPerTrigger = kTicksPerQuarterNote;
+	_phaseGain = 0.1;
+	_frequencyGain = 0.01;
+	MIDIClockLoopInit(&_loop, 60.0 / 120.0 / kTicksPerQuarterNote);
+	_lastScheduledTick = -1;
+	return self;
+}
+
+- (double)tempo
+{
+	if (_loop.receivedTicks < 2 || _loop.period <= 0) {
+		return 0;
+	}
+	return 60.0 / (_loop.period * kTicksPerQuarterNote);
+}
+
+#pragma mark - MIDI messages
+
+/**
+ * Dispatches a system real-time or song position message. Other commands are ignored.
+ */
+- (void)handleCommand:(MIKMIDICommand *)command
+{
+	MIDITimeStamp timeStamp = command.midiTimestamp;
+	switch (command.commandType) {
+		case MIKMIDICommandTypeSystemTimingClock:
+			[self handleClockAtTimeStamp:timeStamp];
+			break;
+		case MIKMIDICommandTypeSystemStartSequence:
+			[self handleStartAtTimeStamp:timeStamp];
+			break;
+		case MIKMIDICommandTypeSystemContinueSequence:
+			[self handleContinueAtTimeStamp:timeStamp];
+			break;
+		case MIKMIDICommandTypeSystemStopSequence:
+			[self handleStop];
+			break;
+		case MIKMIDICommandTypeSystemSongPositionPointer:
+			[self handleSongPosition:(command.dataByte2 << 7) | command.dataByte1];
+			break;
+		default:
+			break;
+	}
+}
+
+- (void)handleClockAtTimeStamp:(MIDITimeStamp)timeStamp
+{
+	// A zero timestamp means "now" in CoreMIDI.
+	NSTimeInterval time = timeStamp ? MIDIClockSequencerSecondsFromHostTime(timeStamp) : MIDIClockSequencerCurrentTime();
+	MIDIClockLoopUpdate(&_loop, time, self.phaseGain, self.frequencyGain);
+
+	if (!self.playing) {
+		return;
+	}
+	NSUInteger tick = self.nextTick;
+	self.nextTick++;
+	[self scheduleTriggersFromTick:tick];
+}
+
+- (void)handleStartAtTimeStamp:(MIDITimeStamp)timeStamp
+{
+	self.nextTick = 0;
+	[self startPlaying];
+}
+
+- (void)handleContinueAtTimeStamp:(MIDITimeStamp)timeStamp
+{
+	[self startPlaying];
+}
+
+- (void)handleStop
+{
+	self.playing = NO;
+	self.generation++;
+}
+
+- (void)handleSongPosition:(NSUInteger)sixteenths
+{
+	self.nextTick = sixteenths * kTicksPerSixteenthNote;
+	self.lastScheduledTick = (NSInteger)self.nextTick - 1;
+	self.generation++;
+}
+
+#pragma mark - Camera events
+
+/**
+ * Measures the shutter lag and the phase error of the oldest pending action.
+ */
+- (void)cameraDidBeginCapturing
+{
+	NSTimeInterval now = MIDIClockSequencerCurrentTime();
+	MIDIClockCapture capture;
+	if (!MIDIClockCaptureQueuePop(&_pendingCaptures, now, kCaptureTimeout, &capture)) {
+		return;
+	}
+
+	NSTimeInterval lag = now - capture.actionTime;
+	if (self.shutterLag <= 0) {
+		self.shutterLag = lag;
+	} else {
+		self.shutterLag = self.shutterLag * 0.8 + lag * 0.2;
+	}
+	self.lastPhaseError = now - capture.targetTime;
+}
+
+#pragma mark -
+
+- (void)startPlaying
+{
+	self.playing = YES;
+	self.lastScheduledTick = (NSInteger)self.nextTick - 1;
+	self.generation++;
+}
+
+/**
+ * Schedules the triggers whose issue time falls before the next tick is expected.
+ *
+ * @param tick The tick that was just received.
+ */
+- (void)scheduleTriggersFromTick:(NSUInteger)tick
+{
+	NSUInteger division = MAX(self.ticksPerTrigger, 1);
+	NSTimeInterval now = MIDIClockSequencerCurrentTime();
+	NSTimeInterval period = _loop.period;
+	NSTimeInterval horizon = now + period;
+
+	while (YES) {
+		// The next trigger after the last one scheduled.
+		NSInteger candidate = MIDIClockNextTriggerTick(MAX(self.lastScheduledTick + 1, (NSInteger)tick), (NSInteger)self.tickOffset, (NSInteger)division);
+		NSTimeInterval targetTime = _loop.filteredTime + (candidate - (NSInteger)tick) * period;
+		NSTimeInterval actionTime = targetTime - self.shutterLag;
+		if (actionTime > horizon) {
+			// A later tick will refine the estimate before this trigger is due.
+			return;
+		}
+		self.lastScheduledTick = candidate;
+		if (actionTime < now - period) {
+			// Too late to land on this beat; try the next one.
+			continue;
+		}
+		[self scheduleActionAtTime:actionTime targetTime:targetTime now:now];
+	}
+}
+
+- (void)scheduleActionAtTime:(NSTimeInterval)actionTime targetTime:(NSTimeInterval)targetTime now:(NSTimeInterval)now
+{
+	NSUInteger generation = self.generation;
+	NSTimeInterval delay = MAX(actionTime - now, 0);
+
+	__weak MIDIClockSequencer *weakSelf = self;
+	dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+		MIDIClockSequencer *strongSelf = weakSelf;
+		if (!strongSelf || strongSelf.generation != generation || !strongSelf.playing) {
+			return;
+		}
+		if (strongSelf.action == MIDIClockSequencerActionShutter) {
+			[strongSelf addPendingCaptureWithTargetTime:targetTime];
+		}
+		[strongSelf.delegate clockSequencer:strongSelf performAction:strongSelf.action];
+	});
+}
+
+- (void)addPendingCaptureWithTargetTime:(NSTimeInterval)targetTime
+{
+	MIDIClockCaptureQueuePush(&_pendingCaptures, MIDIClockSequencerCurrentTime(), targetTime);
+}
+
+@end
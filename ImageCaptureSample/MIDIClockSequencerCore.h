@@ -0,0 +1,157 @@
+//
+//  MIDIClockSequencerCore.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#ifndef ImageCaptureSample_MIDIClockSequencerCore_h
+#define ImageCaptureSample_MIDIClockSequencerCore_h
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * The timing arithmetic of MIDIClockSequencer in plain C, so that it can also
+ * be built and checked off the device. Times are in seconds.
+ */
+
+/**
+ * The state of the second-order phase-locked loop that follows the clock ticks.
+ */
+struct MIDIClockLoop
+{
+	unsigned long receivedTicks;
+	/** The estimated interval of the ticks. */
+	double period;
+	/** When the next tick is expected. */
+	double predictedTime;
+	/** The smoothed time of the latest tick. */
+	double filteredTime;
+};
+
+typedef struct MIDIClockLoop MIDIClockLoop;
+
+static inline void MIDIClockLoopInit(MIDIClockLoop *loop, double period)
+{
+	loop->receivedTicks = 0;
+	loop->period = period;
+	loop->predictedTime = 0;
+	loop->filteredTime = 0;
+}
+
+/**
+ * Runs one step of the loop for a tick received at time.
+ */
+static inline void MIDIClockLoopUpdate(MIDIClockLoop *loop, double time, double phaseGain, double frequencyGain)
+{
+	if (loop->receivedTicks == 0) {
+		loop->filteredTime = time;
+		loop->predictedTime = time + loop->period;
+		loop->receivedTicks = 1;
+		return;
+	}
+	if (loop->receivedTicks == 1) {
+		// The first interval seeds the period directly.
+		if (time > loop->filteredTime) {
+			loop->period = time - loop->filteredTime;
+		}
+		loop->filteredTime = time;
+		loop->predictedTime = time + loop->period;
+		loop->receivedTicks = 2;
+		return;
+	}
+
+	double error = time - loop->predictedTime;
+	if (fabs(error) > loop->period * 4) {
+		// The clock jumped or restarted at another tempo; lock again from scratch.
+		loop->receivedTicks = 1;
+		loop->filteredTime = time;
+		loop->predictedTime = time + loop->period;
+		return;
+	}
+	loop->filteredTime = loop->predictedTime + phaseGain * error;
+	loop->period += frequencyGain * error;
+	loop->predictedTime = loop->filteredTime + loop->period;
+	loop->receivedTicks++;
+}
+
+/**
+ * Returns the first tick at or after candidate that lies on the division.
+ */
+static inline long MIDIClockNextTriggerTick(long candidate, long offset, long division)
+{
+	long remainder = (candidate - offset) % division;
+	if (remainder < 0) {
+		remainder += division;
+	}
+	if (remainder != 0) {
+		candidate += division - remainder;
+	}
+	return candidate;
+}
+
+enum { MIDIClockCaptureQueueCapacity = 8 };
+
+/**
+ * One issued action that waits for the camera to begin capturing.
+ */
+struct MIDIClockCapture
+{
+	double actionTime;
+	double targetTime;
+};
+
+typedef struct MIDIClockCapture MIDIClockCapture;
+
+/**
+ * The actions in flight, oldest first. The camera reports captures in the order
+ * they were requested, so each report is measured against its own request.
+ */
+struct MIDIClockCaptureQueue
+{
+	MIDIClockCapture entries[MIDIClockCaptureQueueCapacity];
+	size_t first;
+	size_t count;
+};
+
+typedef struct MIDIClockCaptureQueue MIDIClockCaptureQueue;
+
+/**
+ * Appends an action. When the queue is full the oldest one is dropped; it
+ * would have been given up as lost by then.
+ */
+static inline void MIDIClockCaptureQueuePush(MIDIClockCaptureQueue *queue, double actionTime, double targetTime)
+{
+	if (queue->count == MIDIClockCaptureQueueCapacity) {
+		queue->first = (queue->first + 1) % MIDIClockCaptureQueueCapacity;
+		queue->count--;
+	}
+	MIDIClockCapture *capture = &queue->entries[(queue->first + queue->count) % MIDIClockCaptureQueueCapacity];
+	capture->actionTime = actionTime;
+	capture->targetTime = targetTime;
+	queue->count++;
+}
+
+/**
+ * Removes the oldest action issued no earlier than now - timeout.
+ * Older ones were refused by the camera and are discarded.
+ *
+ * @return false if no action is pending.
+ */
+static inline bool MIDIClockCaptureQueuePop(MIDIClockCaptureQueue *queue, double now, double timeout, MIDIClockCapture *capture)
+{
+	while (queue->count > 0) {
+		MIDIClockCapture oldest = queue->entries[queue->first];
+		queue->first = (queue->first + 1) % MIDIClockCaptureQueueCapacity;
+		queue->count--;
+		if (oldest.actionTime >= now - timeout) {
+			*capture = oldest;
+			return true;
+		}
+	}
+	return false;
+}
+
+#endif
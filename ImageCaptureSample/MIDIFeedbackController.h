@@ -0,0 +1,53 @@
+//
+//  MIDIFeedbackController.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class MIKMIDIDestinationEndpoint;
+
+enum MIDIFeedbackElement
+{
+	MIDIFeedbackElementRecording,
+	MIDIFeedbackElementExposureCompensation,
+	MIDIFeedbackElementShutterBusy,
+	MIDIFeedbackElementBatteryLevel,
+	MIDIFeedbackElementCount,
+};
+
+typedef enum MIDIFeedbackElement MIDIFeedbackElement;
+
+/**
+ * Mirrors the camera state on the LEDs and motorized faders of a controller.
+ *
+ * Each element is shown by a note, whose velocity lights an LED, or by a
+ * controller, whose value moves a fader. The element map is a dictionary from
+ * "recording", "exposure", "busy" and "battery" to dictionaries with the keys
+ * "message" ("note" or "cc"), "number" and "channel" (1 to 16, default 1).
+ *
+ * A shadow copy of what the controller shows is kept, and only the elements that
+ * differ from it are sent, once per display frame. However often the camera state
+ * changes, the controller receives at most one message per element and frame.
+ * Setting the destination sends every element again; the destination is cleared
+ * when its device is unplugged.
+ * All methods must be called on the main thread.
+ */
+@interface MIDIFeedbackController : NSObject
+
+@property (strong, nonatomic) MIKMIDIDestinationEndpoint *destination;
+@property (copy, nonatomic) NSDictionary *elementMap;
+/** The number of messages sent to the controller. */
+@property (assign, nonatomic, readonly) NSUInteger sentMessages;
+/** The number of value changes that were replaced by a later one in the same frame. */
+@property (assign, nonatomic, readonly) NSUInteger coalescedChanges;
+
+/**
+ * Sets the value an element should show, from 0 to 127.
+ */
+- (void)setValue:(uint8_t)value forElement:(MIDIFeedbackElement)element;
+- (void)invalidate;
+
+@end
@@ -0,0 +1,234 @@
+//
+//  MIDIFeedbackController.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "MIDIFeedbackController.h"
+#import <QuartzCore/QuartzCore.h>
+#import "MIKMIDI.h"
+
+/**
+ * The message an element is shown by.
+ */
+struct MIDIFeedbackOutput
+{
+	bool enabled;
+	bool controlChange;
+	uint8_t channel;
+	uint8_t number;
+};
+
+typedef struct MIDIFeedbackOutput MIDIFeedbackOutput;
+
+/** How long to wait before sending values again that could not be sent. */
+static const NSTimeInterval MIDIFeedbackRetryInterval = 0.5;
+/** How many times in a row to try sending before waiting for a change or a new destination. */
+static const NSUInteger MIDIFeedbackMaximumRetryCount = 10;
+
+static NSString *const MIDIFeedbackElementNames[MIDIFeedbackElementCount] = {
+	@"recording",
+	@"exposure",
+	@"busy",
+	@"battery",
+};
+
+@interface MIDIFeedbackController ()
+
+@property (assign, nonatomic, readwrite) NSUInteger sentMessages;
+@property (assign, nonatomic, readwrite) NSUInteger coalescedChanges;
+@property (strong, nonatomic) CADisplayLink *displayLink;
+@property (assign, nonatomic) NSUInteger retryCount;
+
+@end
+
+@implementation MIDIFeedbackController
+{
+	MIDIFeedbackOutput _outputs[MIDIFeedbackElementCount];
+	uint8_t _values[MIDIFeedbackElementCount];
+	/** What the controller shows; -1 when it is not known. */
+	int16_t _shownValues[MIDIFeedbackElementCount];
+	/** Whether the value was changed since the last frame. */
+	bool _changed[MIDIFeedbackElementCount];
+}
+
+- (id)init
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	for (NSUInteger element = 0; element < MIDIFeedbackElementCount; element++) {
+		_shownValues[element] = -1;
+	}
+	NSNotificationCenter *notificationCenter = [NSNotificationCenter defaultCenter];
+	[notificationCenter addObserver:self selector:@selector(deviceWasRemoved:) name:MIKMIDIDeviceWasRemovedNotification object:nil];
+	[notificationCenter addObserver:self selector:@selector(virtualEndpointWasRemoved:) name:MIKMIDIVirtualEndpointWasRemovedNotification object:nil];
+	return self;
+}
+
+- (void)dealloc
+{
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+	[_displayLink invalidate];
+}
+
+#pragma mark -
+
+- (void)setDestination:(MIKMIDIDestinationEndpoint *)destination
+{
+	_destination = destination;
+	self.retryCount = 0;
+	[self forgetShownValues];
+}
+
+- (void)setElementMap:(NSDictionary *)elementMap
+{
+	_elementMap = [elementMap copy];
+	for (NSUInteger element = 0; element < MIDIFeedbackElementCount; element++) {
+		NSDictionary *output = _elementMap[MIDIFeedbackElementNames[element]];
+		NSString *message = output[@"message"];
+		NSInteger number = [output[@"number"] integerValue];
+		NSInteger channel = output[@"channel"] ? [output[@"channel"] integerValue] : 1;
+		BOOL controlChange = [message isEqualToString:@"cc"];
+		BOOL valid = (controlChange || [message isEqualToString:@"note"]) && number >= 0 && number <= 127 && channel >= 1 && channel <= 16;
+		if (output && !valid) {
+			NSLog(@"To map the MIDI feedback element is failed: %@", output);
+		}
+		_outputs[element].enabled = valid;
+		_outputs[element].controlChange = controlChange;
+		_outputs[element].channel = (uint8_t)(channel - 1);
+		_outputs[element].number = (uint8_t)number;
+	}
+	[self forgetShownValues];
+}
+
+- (void)setValue:(uint8_t)value forElement:(MIDIFeedbackElement)element
+{
+	if (element >= MIDIFeedbackElementCount) {
+		return;
+	}
+	value = MIN(value, (uint8_t)127);
+	if (_values[element] == value) {
+		return;
+	}
+	if (_changed[element]) {
+		self.coalescedChanges++;
+	}
+	_values[element] = value;
+	_changed[element] = true;
+	[self scheduleFrame];
+}
+
+- (void)invalidate
+{
+	[self.displayLink invalidate];
+	self.displayLink = nil;
+}
+
+#pragma mark -
+
+- (void)deviceWasRemoved:(NSNotification *)notification
+{
+	if (![NSThread isMainThread]) {
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[self deviceWasRemoved:notification];
+		});
+		return;
+	}
+	MIKMIDIDevice *device = notification.userInfo[MIKMIDIDeviceKey];
+	if (self.destination && [[device.entities valueForKeyPath:@"@unionOfArrays.destinations"] containsObject:self.destination]) {
+		// Nothing is sent until the device comes back and is set again.
+		self.destination = nil;
+	}
+}
+
+- (void)virtualEndpointWasRemoved:(NSNotification *)notification
+{
+	if (![NSThread isMainThread]) {
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[self virtualEndpointWasRemoved:notification];
+		});
+		return;
+	}
+	if (self.destination && [notification.userInfo[MIKMIDIEndpointKey] isEqual:self.destination]) {
+		self.destination = nil;
+	}
+}
+
+- (void)forgetShownValues
+{
+	for (NSUInteger element = 0; element < MIDIFeedbackElementCount; element++) {
+		_shownValues[element] = -1;
+	}
+	[self scheduleFrame];
+}
+
+- (void)scheduleFrame
+{
+	if (self.displayLink || !self.destination) {
+		return;
+	}
+	// The link holds the controller only until the frame is sent.
+	self.displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(displayLinkDidFire:)];
+	[self.displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+}
+
+- (void)displayLinkDidFire:(CADisplayLink *)displayLink
+{
+	[self invalidate];
+
+	NSMutableArray *commands = [[NSMutableArray alloc] init];
+	for (NSUInteger element = 0; element < MIDIFeedbackElementCount; element++) {
+		const MIDIFeedbackOutput *output = &_outputs[element];
+		if (!output->enabled || _shownValues[element] == _values[element]) {
+			continue;
+		}
+		if (output->controlChange) {
+			MIKMutableMIDIControlChangeCommand *command = [[MIKMutableMIDIControlChangeCommand alloc] init];
+			command.channel = output->channel;
+			command.controllerNumber = output->number;
+			command.controllerValue = _values[element];
+			[commands addObject:command];
+		} else {
+			MIKMutableMIDINoteOnCommand *command = [[MIKMutableMIDINoteOnCommand alloc] init];
+			command.channel = output->channel;
+			command.note = output->number;
+			command.velocity = _values[element];
+			[commands addObject:command];
+		}
+	}
+	if (commands.count == 0 || !self.destination) {
+		memset(_changed, 0, sizeof(_changed));
+		return;
+	}
+
+	NSError *error = nil;
+	if (![[MIKMIDIDeviceManager sharedDeviceManager] sendCommands:commands toEndpoint:self.destination error:&error]) {
+		// The values stay pending and are sent again a little later, even if nothing changes meanwhile,
+		// until the retries run out; after that only a change or a new destination sends them.
+		if (self.retryCount == 0) {
+			NSLog(@"To send the MIDI feedback is failed: %@", error ? error : @"Unknown error");
+		}
+		if (self.retryCount >= MIDIFeedbackMaximumRetryCount) {
+			return;
+		}
+		self.retryCount++;
+		__weak MIDIFeedbackController *weakSelf = self;
+		dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(MIDIFeedbackRetryInterval * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+			[weakSelf scheduleFrame];
+		});
+		return;
+	}
+	self.retryCount = 0;
+	for (NSUInteger element = 0; element < MIDIFeedbackElementCount; element++) {
+		_changed[element] = false;
+		if (_outputs[element].enabled) {
+			_shownValues[element] = _values[element];
+		}
+	}
+	self.sentMessages += commands.count;
+}
+
+@end
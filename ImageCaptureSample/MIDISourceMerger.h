@@ -0,0 +1,55 @@
+//
+//  MIDISourceMerger.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class MIKMIDICommand;
+@class MIKMIDISourceEndpoint;
+@class MIDISourceMerger;
+
+@protocol MIDISourceMergerDelegate <NSObject>
+
+- (void)sourceMerger:(MIDISourceMerger *)merger didReceiveCommand:(MIKMIDICommand *)command sourceID:(NSUInteger)sourceID;
+
+@end
+
+/**
+ * Merges the commands of any number of MIDI sources into one stream in time stamp order.
+ *
+ * Each source delivers its commands to the main queue on its own, so commands of
+ * different controllers may arrive out of order. The merger holds each command
+ * for the reorder window after its time stamp and hands them out sorted, tagged
+ * with the ID of their source. A command that arrives after a later one has been
+ * handed out is handed out at once and counted as late. Commands without a time
+ * stamp are stamped with their arrival.
+ * All methods must be called on the main thread.
+ */
+@interface MIDISourceMerger : NSObject
+
+@property (weak, nonatomic) id<MIDISourceMergerDelegate> delegate;
+/** The time commands are held for, in seconds. Zero hands out each batch as it arrives. (default: 0.003) */
+@property (assign, nonatomic) NSTimeInterval reorderWindow;
+/** The number of commands that were put before commands that arrived earlier. */
+@property (assign, nonatomic, readonly) NSUInteger reorderedCommands;
+/** The number of commands that arrived too late to be put in order. */
+@property (assign, nonatomic, readonly) NSUInteger lateCommands;
+/** The longest time from the time stamp of a command to handing it out, in seconds. */
+@property (assign, nonatomic, readonly) NSTimeInterval maximumDelay;
+
+/**
+ * Connects a source; a source added again is reconnected under the same ID.
+ *
+ * A source whose device is unplugged is disconnected and its ID is given to the next new source.
+ *
+ * @return The ID the commands of the source are tagged with, or NSNotFound if it could not be connected.
+ */
+- (NSUInteger)addSource:(MIKMIDISourceEndpoint *)source;
+- (MIKMIDISourceEndpoint *)sourceForID:(NSUInteger)sourceID;
+- (void)removeAllSources;
+- (void)resetStatistics;
+
+@end
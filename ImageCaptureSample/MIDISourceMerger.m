@@ -0,0 +1,292 @@
+//
+//  MIDISourceMerger.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "MIDISourceMerger.h"
+#import <mach/mach_time.h>
+#import "MIKMIDI.h"
+#import "MIDISourceMergerCore.h"
+
+static mach_timebase_info_data_t MIDISourceMergerTimebase(void)
+{
+	static mach_timebase_info_data_t timebase;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		mach_timebase_info(&timebase);
+	});
+	return timebase;
+}
+
+static NSTimeInterval MIDISourceMergerSecondsFromHostTime(uint64_t hostTime)
+{
+	mach_timebase_info_data_t timebase = MIDISourceMergerTimebase();
+	return (NSTimeInterval)hostTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+static uint64_t MIDISourceMergerHostTimeFromSeconds(NSTimeInterval seconds)
+{
+	mach_timebase_info_data_t timebase = MIDISourceMergerTimebase();
+	return (uint64_t)(seconds * NSEC_PER_SEC * timebase.denom / timebase.numer);
+}
+
+@interface MIDISourceMerger ()
+
+@property (strong, nonatomic) NSMutableArray *sources;
+@property (strong, nonatomic) NSMutableArray *connectionTokens;
+// The held commands, in step with the entries of the queue.
+@property (strong, nonatomic) NSMutableArray *heldCommands;
+// The pending release; releases of older generations are ignored when they fire.
+@property (assign, nonatomic) NSUInteger generation;
+@property (assign, nonatomic) BOOL releaseScheduled;
+@property (assign, nonatomic) NSTimeInterval scheduledReleaseTime;
+
+@end
+
+@implementation MIDISourceMerger
+{
+	MIDISourceMergerQueue _queue;
+}
+
+- (id)init
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	_reorderWindow = 0.003;
+	_sources = [[NSMutableArray alloc] init];
+	_connectionTokens = [[NSMutableArray alloc] init];
+	_heldCommands = [[NSMutableArray alloc] init];
+	MIDISourceMergerInit(&_queue);
+	NSNotificationCenter *notificationCenter = [NSNotificationCenter defaultCenter];
+	[notificationCenter addObserver:self selector:@selector(deviceWasRemoved:) name:MIKMIDIDeviceWasRemovedNotification object:nil];
+	[notificationCenter addObserver:self selector:@selector(virtualEndpointWasRemoved:) name:MIKMIDIVirtualEndpointWasRemovedNotification object:nil];
+	return self;
+}
+
+- (void)dealloc
+{
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+	[self disconnectSources];
+	MIDISourceMergerDestroy(&_queue);
+}
+
+#pragma mark -
+
+- (NSUInteger)addSource:(MIKMIDISourceEndpoint *)source
+{
+	if (!source) {
+		return NSNotFound;
+	}
+	MIKMIDIDeviceManager *deviceManager = [MIKMIDIDeviceManager sharedDeviceManager];
+	NSUInteger sourceID = [self.sources indexOfObject:source];
+	if (sourceID != NSNotFound) {
+		// A source that comes back after a cable pull is connected again from scratch.
+		id connectionToken = self.connectionTokens[sourceID];
+		if (connectionToken != [NSNull null]) {
+			[deviceManager disconnectInput:self.sources[sourceID] forConnectionToken:connectionToken];
+		}
+		self.sources[sourceID] = source;
+	} else {
+		// A device plugged in again comes with new sources; they take the IDs its old ones left free.
+		sourceID = [self.sources indexOfObject:[NSNull null]];
+		if (sourceID != NSNotFound) {
+			self.sources[sourceID] = source;
+		} else {
+			sourceID = self.sources.count;
+			[self.sources addObject:source];
+			[self.connectionTokens addObject:[NSNull null]];
+		}
+	}
+
+	NSError *error = nil;
+	__weak MIDISourceMerger *weakSelf = self;
+	id connectionToken = [deviceManager connectInput:source error:&error eventHandler:^(MIKMIDISourceEndpoint *source, NSArray *commands) {
+		[weakSelf receiveCommands:commands sourceID:sourceID];
+	}];
+	if (!connectionToken) {
+		NSLog(@"To connect the MIDI source is failed: %@", error ? error : @"Unknown error");
+		self.connectionTokens[sourceID] = [NSNull null];
+		return NSNotFound;
+	}
+	self.connectionTokens[sourceID] = connectionToken;
+	return sourceID;
+}
+
+- (MIKMIDISourceEndpoint *)sourceForID:(NSUInteger)sourceID
+{
+	id source = (sourceID < self.sources.count) ? self.sources[sourceID] : nil;
+	return (source != [NSNull null]) ? source : nil;
+}
+
+/**
+ * Disconnects a source that went away and frees its ID.
+ */
+- (void)removeSource:(MIKMIDISourceEndpoint *)source
+{
+	NSUInteger sourceID = [self.sources indexOfObject:source];
+	if (sourceID == NSNotFound) {
+		return;
+	}
+	id connectionToken = self.connectionTokens[sourceID];
+	if (connectionToken != [NSNull null]) {
+		[[MIKMIDIDeviceManager sharedDeviceManager] disconnectInput:self.sources[sourceID] forConnectionToken:connectionToken];
+	}
+	self.sources[sourceID] = [NSNull null];
+	self.connectionTokens[sourceID] = [NSNull null];
+}
+
+- (void)removeAllSources
+{
+	[self disconnectSources];
+	[self.sources removeAllObjects];
+	[self.connectionTokens removeAllObjects];
+	[self releaseCommandsUntil:UINT64_MAX];
+}
+
+- (void)disconnectSources
+{
+	MIKMIDIDeviceManager *deviceManager = [MIKMIDIDeviceManager sharedDeviceManager];
+	for (NSUInteger index = 0; index < _sources.count; index++) {
+		id connectionToken = _connectionTokens[index];
+		if (connectionToken != [NSNull null]) {
+			[deviceManager disconnectInput:_sources[index] forConnectionToken:connectionToken];
+		}
+	}
+}
+
+- (void)deviceWasRemoved:(NSNotification *)notification
+{
+	if (![NSThread isMainThread]) {
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[self deviceWasRemoved:notification];
+		});
+		return;
+	}
+	MIKMIDIDevice *device = notification.userInfo[MIKMIDIDeviceKey];
+	for (MIKMIDISourceEndpoint *source in [device.entities valueForKeyPath:@"@unionOfArrays.sources"]) {
+		[self removeSource:source];
+	}
+}
+
+- (void)virtualEndpointWasRemoved:(NSNotification *)notification
+{
+	if (![NSThread isMainThread]) {
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[self virtualEndpointWasRemoved:notification];
+		});
+		return;
+	}
+	id endpoint = notification.userInfo[MIKMIDIEndpointKey];
+	if ([endpoint isKindOfClass:[MIKMIDISourceEndpoint class]]) {
+		[self removeSource:endpoint];
+	}
+}
+
+- (NSUInteger)reorderedCommands
+{
+	return _queue.reorderedCommands;
+}
+
+- (NSUInteger)lateCommands
+{
+	return _queue.lateCommands;
+}
+
+- (NSTimeInterval)maximumDelay
+{
+	return MIDISourceMergerSecondsFromHostTime(_queue.maximumDelay);
+}
+
+- (void)resetStatistics
+{
+	MIDISourceMergerResetStatistics(&_queue);
+}
+
+#pragma mark -
+
+- (void)receiveCommands:(NSArray *)commands sourceID:(NSUInteger)sourceID
+{
+	uint64_t now = mach_absolute_time();
+	for (MIKMIDICommand *command in commands) {
+		MIDISourceMergerEntry entry;
+		entry.timestamp = MIDISourceMergerStamp(command.midiTimestamp, now);
+		entry.sourceID = sourceID;
+		size_t index = MIDISourceMergerInsert(&_queue, entry);
+		if (index == kMIDISourceMergerLate) {
+			[self handOutCommand:command entry:entry now:now];
+			continue;
+		}
+		[self.heldCommands insertObject:command atIndex:index];
+	}
+
+	if (self.reorderWindow <= 0) {
+		[self releaseCommandsUntil:UINT64_MAX];
+		return;
+	}
+	uint64_t window = MIDISourceMergerHostTimeFromSeconds(self.reorderWindow);
+	[self releaseCommandsUntil:(now > window ? now - window : 0)];
+	[self scheduleRelease];
+}
+
+/**
+ * Hands out the held commands stamped at or before the host time.
+ */
+- (void)releaseCommandsUntil:(uint64_t)hostTime
+{
+	uint64_t now = mach_absolute_time();
+	size_t count = MIDISourceMergerReleasableCount(&_queue, hostTime);
+	if (count == 0) {
+		return;
+	}
+
+	// Taken out before handing out, as the delegate may add or remove sources.
+	NSArray *commands = [self.heldCommands subarrayWithRange:NSMakeRange(0, count)];
+	NSMutableData *released = [[NSMutableData alloc] initWithLength:count * sizeof(MIDISourceMergerEntry)];
+	MIDISourceMergerEntry *releasedEntries = released.mutableBytes;
+	MIDISourceMergerRelease(&_queue, count, releasedEntries);
+	[self.heldCommands removeObjectsInRange:NSMakeRange(0, count)];
+
+	for (NSUInteger index = 0; index < count; index++) {
+		[self handOutCommand:commands[index] entry:releasedEntries[index] now:now];
+	}
+}
+
+- (void)handOutCommand:(MIKMIDICommand *)command entry:(MIDISourceMergerEntry)entry now:(uint64_t)now
+{
+	MIDISourceMergerNoteHandOut(&_queue, entry, now);
+	[self.delegate sourceMerger:self didReceiveCommand:command sourceID:entry.sourceID];
+}
+
+- (void)scheduleRelease
+{
+	if (_queue.count == 0) {
+		return;
+	}
+	NSTimeInterval releaseTime = MIDISourceMergerSecondsFromHostTime(_queue.entries[0].timestamp) + self.reorderWindow;
+	if (self.releaseScheduled && self.scheduledReleaseTime <= releaseTime) {
+		return;
+	}
+
+	NSUInteger generation = ++self.generation;
+	self.releaseScheduled = YES;
+	self.scheduledReleaseTime = releaseTime;
+	NSTimeInterval delay = MAX(releaseTime - MIDISourceMergerSecondsFromHostTime(mach_absolute_time()), 0);
+	__weak MIDISourceMerger *weakSelf = self;
+	dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+		MIDISourceMerger *strongSelf = weakSelf;
+		if (!strongSelf || strongSelf.generation != generation) {
+			return;
+		}
+		strongSelf.releaseScheduled = NO;
+		uint64_t now = mach_absolute_time();
+		uint64_t window = MIDISourceMergerHostTimeFromSeconds(strongSelf.reorderWindow);
+		[strongSelf releaseCommandsUntil:(now > window ? now - window : 0)];
+		[strongSelf scheduleRelease];
+	});
+}
+
+@end
@@ -0,0 +1,152 @@
+//
+//  MIDISourceMergerCore.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#ifndef ImageCaptureSample_MIDISourceMergerCore_h
+#define ImageCaptureSample_MIDISourceMergerCore_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The ordering of MIDISourceMerger in plain C, so that it can also be built
+ * and checked off the device. Time stamps are in host time units.
+ */
+
+/** Returned by MIDISourceMergerInsert for a command too late to be held. */
+#define kMIDISourceMergerLate SIZE_MAX
+
+/**
+ * The time stamp and the source of a held command.
+ */
+typedef struct {
+	uint64_t timestamp;
+	size_t sourceID;
+} MIDISourceMergerEntry;
+
+/**
+ * The held entries in time stamp order, and the statistics of the ordering.
+ */
+typedef struct {
+	MIDISourceMergerEntry *entries;
+	size_t count;
+	size_t capacity;
+	/** The time stamp of the latest entry handed out. */
+	uint64_t lastReleasedTimestamp;
+	/** The number of entries that were put before entries that arrived earlier. */
+	size_t reorderedCommands;
+	/** The number of entries that arrived too late to be put in order. */
+	size_t lateCommands;
+	/** The longest time from the time stamp of an entry to handing it out. */
+	uint64_t maximumDelay;
+} MIDISourceMergerQueue;
+
+static inline void MIDISourceMergerInit(MIDISourceMergerQueue *queue)
+{
+	*queue = (MIDISourceMergerQueue){0};
+}
+
+static inline void MIDISourceMergerDestroy(MIDISourceMergerQueue *queue)
+{
+	free(queue->entries);
+	queue->entries = NULL;
+	queue->count = 0;
+	queue->capacity = 0;
+}
+
+static inline void MIDISourceMergerResetStatistics(MIDISourceMergerQueue *queue)
+{
+	queue->reorderedCommands = 0;
+	queue->lateCommands = 0;
+	queue->maximumDelay = 0;
+}
+
+/**
+ * Returns the time stamp to order a command by; one without a time stamp, or with one in the future, is stamped now.
+ */
+static inline uint64_t MIDISourceMergerStamp(uint64_t timestamp, uint64_t now)
+{
+	return (timestamp != 0 && timestamp <= now) ? timestamp : now;
+}
+
+/**
+ * Holds an entry in time stamp order, after the entries of the same time stamp.
+ *
+ * @return The index the entry was put at, for the caller to keep its command in step, or
+ * kMIDISourceMergerLate if a later entry has been handed out already; holding it would not
+ * put it in order, so it is to be handed out at once. kMIDISourceMergerLate is also returned,
+ * without counting, if the queue could not grow.
+ */
+static inline size_t MIDISourceMergerInsert(MIDISourceMergerQueue *queue, MIDISourceMergerEntry entry)
+{
+	if (queue->lastReleasedTimestamp > entry.timestamp) {
+		queue->lateCommands++;
+		return kMIDISourceMergerLate;
+	}
+	if (queue->count == queue->capacity) {
+		size_t capacity = queue->capacity ? queue->capacity * 2 : 16;
+		MIDISourceMergerEntry *entries = realloc(queue->entries, capacity * sizeof(MIDISourceMergerEntry));
+		if (!entries) {
+			return kMIDISourceMergerLate;
+		}
+		queue->entries = entries;
+		queue->capacity = capacity;
+	}
+
+	// Usually the entry belongs at the end, so the search starts there.
+	size_t index = queue->count;
+	while (index > 0 && queue->entries[index - 1].timestamp > entry.timestamp) {
+		index--;
+	}
+	if (index < queue->count) {
+		queue->reorderedCommands++;
+		memmove(&queue->entries[index + 1], &queue->entries[index], (queue->count - index) * sizeof(MIDISourceMergerEntry));
+	}
+	queue->entries[index] = entry;
+	queue->count++;
+	return index;
+}
+
+/**
+ * Returns the number of held entries stamped at or before a time.
+ */
+static inline size_t MIDISourceMergerReleasableCount(const MIDISourceMergerQueue *queue, uint64_t time)
+{
+	size_t count = 0;
+	while (count < queue->count && queue->entries[count].timestamp <= time) {
+		count++;
+	}
+	return count;
+}
+
+/**
+ * Takes the first count held entries out, into released, to be handed out in order.
+ */
+static inline void MIDISourceMergerRelease(MIDISourceMergerQueue *queue, size_t count, MIDISourceMergerEntry *released)
+{
+	if (count == 0 || count > queue->count) {
+		return;
+	}
+	memcpy(released, queue->entries, count * sizeof(MIDISourceMergerEntry));
+	memmove(queue->entries, &queue->entries[count], (queue->count - count) * sizeof(MIDISourceMergerEntry));
+	queue->count -= count;
+	queue->lastReleasedTimestamp = released[count - 1].timestamp;
+}
+
+/**
+ * Records the delay of an entry handed out at now.
+ */
+static inline void MIDISourceMergerNoteHandOut(MIDISourceMergerQueue *queue, MIDISourceMergerEntry entry, uint64_t now)
+{
+	if (now > entry.timestamp && now - entry.timestamp > queue->maximumDelay) {
+		queue->maximumDelay = now - entry.timestamp;
+	}
+}
+
+#endif
@@ -26,6 +26,7 @@
 #import "MIKMIDIResponder.h"
 #import "MIKMIDISourceEndpoint.h"
 #import "MIKMIDISystemExclusiveCommand.h"
+#import "MIKMIDISystemExclusiveAssembler.h"
 #import "MIKMIDISystemMessageCommand.h"
 #import "MIKMIDIMapping.h"
 #import "MIKMIDIMappingManager.h"
@@ -35,6 +36,7 @@
 #import "MIKMIDIErrors.h"
 #import "MIKMIDICommandThrottler.h"
 #import "MIKMIDIEndpointSynthesizer.h"
+#import "MIKMIDIOfflineRenderer.h"
 #import "MIKMIDIEvent.h"
 #import "MIKMIDIMetaCopyrightEvent.h"
 #import "MIKMIDIMetaCuePointEvent.h"
@@ -73,17 +73,12 @@ static NSMutableSet *registeredMIKMIDICommandSubclasses;
 			return command ? @[command] : @[];
 		}
 		
-		// This is gross, but it's the only way I can find to reliably create a
-		// single-message MIDIPacket.
-		MIDIPacketList packetList;
-		MIDIPacket *midiPacket = MIDIPacketListInit(&packetList);
-		midiPacket = MIDIPacketListAdd(&packetList,
-										  sizeof(MIDIPacketList),
-										  midiPacket,
-										  inputPacket->timeStamp,
-										  standardLength,
-										  packetData);
-		MIKMIDICommand *command = [MIKMIDICommand commandWithMIDIPacket:midiPacket];
+		// A single message of a standard length always fits the data of a MIDIPacket.
+		MIDIPacket midiPacket;
+		midiPacket.timeStamp = inputPacket->timeStamp;
+		midiPacket.length = (UInt16)standardLength;
+		memcpy(midiPacket.data, packetData, standardLength);
+		MIKMIDICommand *command = [MIKMIDICommand commandWithMIDIPacket:&midiPacket];
 		if (command) [result addObject:command];
 		packetCount++;
 	}
@@ -91,6 +86,25 @@ static NSMutableSet *registeredMIKMIDICommandSubclasses;
 	return result;
 }
 
++ (NSArray *)commandsWithBytes:(const Byte *)bytes length:(NSUInteger)length timestamp:(MIDITimeStamp)timestamp
+{
+	if (length == 0 || length > UINT16_MAX) return @[];
+	
+	// MIDIPacket declares room for 256 bytes; a longer message needs a packet allocated to its length.
+	MIDIPacket stackPacket;
+	MIDIPacket *packet = &stackPacket;
+	if (length > sizeof(stackPacket.data)) {
+		packet = malloc(offsetof(MIDIPacket, data) + length);
+		if (!packet) return @[];
+	}
+	packet->timeStamp = timestamp;
+	packet->length = (UInt16)length;
+	memcpy(packet->data, bytes, length);
+	NSArray *result = [self commandsWithMIDIPacket:packet];
+	if (packet != &stackPacket) free(packet);
+	return result;
+}
+
 + (instancetype)commandForCommandType:(MIKMIDICommandType)commandType; // Most useful for mutable commands
 {
 	Class subclass = [[self class] subclassForCommandType:commandType];
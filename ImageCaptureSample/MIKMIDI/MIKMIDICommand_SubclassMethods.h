@@ -29,6 +29,18 @@
  */
 + (void)registerSubclass:(Class)subclass;
 
+/**
+ *  Parses raw bytes into commands the way +commandsWithMIDIPacket: parses a packet,
+ *  for bytes that are not held in a MIDIPacket of their own, however many there are.
+ *
+ *  @param bytes     The bytes of one or more MIDI messages.
+ *  @param length    The number of bytes. At most 65535, the most a MIDIPacket can carry.
+ *  @param timestamp The timestamp of the commands.
+ *
+ *  @return An array of MIKMIDICommand instances.
+ */
++ (NSArray *)commandsWithBytes:(const Byte *)bytes length:(NSUInteger)length timestamp:(MIDITimeStamp)timestamp;
+
 /**
  *  This method has been replaced by +supportedMIDICommandTypes
  *  and by default simply calls through to that method. Subclasses
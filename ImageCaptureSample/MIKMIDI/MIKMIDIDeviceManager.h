@@ -13,6 +13,9 @@
 @class MIKMIDIClientSourceEndpoint;
 @class MIKMIDIDestinationEndpoint;
 @class MIKMIDICommand;
+@class MIKMIDIDevice;
+
+typedef void(^MIKMIDIDeviceHandlerBlock)(MIKMIDIDevice *device);
 
 // Notifications
 /**
@@ -93,6 +96,68 @@ extern NSString * const MIKMIDIEndpointKey;
  */
 - (void)disconnectInput:(MIKMIDISourceEndpoint *)endpoint forConnectionToken:(id)connectionToken;
 
+/**
+ *  Looks up a device that is available on the system by its unique ID.
+ *
+ *  @param uniqueID The kMIDIPropertyUniqueID of the device.
+ *
+ *  @return The MIKMIDIDevice with the unique ID, or nil if there is none.
+ */
+- (MIKMIDIDevice *)deviceWithUniqueID:(MIDIUniqueID)uniqueID;
+
+/**
+ *  Looks up the devices available on the system by name. Names are compared ignoring case and
+ *  leading or trailing whitespace, which some devices pad their names with.
+ *
+ *  @param name The name of the devices.
+ *
+ *  @return An NSArray of MIKMIDIDevice instances. Empty if there are none.
+ */
+- (NSArray *)devicesWithName:(NSString *)name;
+
+/**
+ *  Looks up the devices available on the system by manufacturer and model, compared
+ *  the same way as names.
+ *
+ *  @param manufacturer The manufacturer of the devices.
+ *  @param model        The model of the devices.
+ *
+ *  @return An NSArray of MIKMIDIDevice instances. Empty if there are none.
+ */
+- (NSArray *)devicesWithManufacturer:(NSString *)manufacturer model:(NSString *)model;
+
+/**
+ *  Registers a block to be called for each device with a name, as with -devicesWithName:,
+ *  every time one becomes available. That includes devices that come back online after being
+ *  unplugged. The block is called right away for the matching devices already available.
+ *
+ *  @param name    The name of the devices.
+ *  @param handler A block called on the main thread with the device that became available.
+ *
+ *  @return A token to be passed to -removeDeviceHandlerForToken:. The token is opaque.
+ */
+- (id)addHandlerForDevicesWithName:(NSString *)name handler:(MIKMIDIDeviceHandlerBlock)handler;
+
+/**
+ *  Registers a block to be called for each device with a manufacturer and model every time one
+ *  becomes available. Otherwise the same as -addHandlerForDevicesWithName:handler:.
+ *
+ *  @param manufacturer The manufacturer of the devices.
+ *  @param model        The model of the devices.
+ *  @param handler      A block called on the main thread with the device that became available.
+ *
+ *  @return A token to be passed to -removeDeviceHandlerForToken:. The token is opaque.
+ */
+- (id)addHandlerForDevicesWithManufacturer:(NSString *)manufacturer model:(NSString *)model handler:(MIKMIDIDeviceHandlerBlock)handler;
+
+/**
+ *  Unregisters a block registered with -addHandlerForDevicesWithName:handler: or
+ *  -addHandlerForDevicesWithManufacturer:model:handler:.
+ *
+ *  @param token The token returned when the block was registered.
+ */
+- (void)removeDeviceHandlerForToken:(id)token;
+
 /**
  *  Used to send MIDI messages/commands from your application to a MIDI output endpoint. 
  *  Use this to send messages to a connected device, or another app connected via virtual MIDI port.
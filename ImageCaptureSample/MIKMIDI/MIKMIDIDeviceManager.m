@@ -32,6 +32,22 @@ NSString * const MIKMIDIEndpointKey = @"MIKMIDIEndpointKey";
 
 static MIKMIDIDeviceManager *sharedDeviceManager;
 
+// Some devices pad their names with spaces, e.g. "Dentaku Ototo   ".
+static NSString *MIKMIDIDeviceIndexKey(NSString *string)
+{
+	return [[string stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]] lowercaseString];
+}
+
+static NSString *MIKMIDIDeviceNameIndexKey(NSString *name)
+{
+	return [@"name:" stringByAppendingString:MIKMIDIDeviceIndexKey(name ? name : @"")];
+}
+
+static NSString *MIKMIDIDeviceModelIndexKey(NSString *manufacturer, NSString *model)
+{
+	return [NSString stringWithFormat:@"model:%@\n%@", MIKMIDIDeviceIndexKey(manufacturer ? manufacturer : @""), MIKMIDIDeviceIndexKey(model ? model : @"")];
+}
+
 @interface MIKMIDIDeviceManager ()
 
 @property (nonatomic) MIDIClientRef client;
@@ -39,6 +55,15 @@ static MIKMIDIDeviceManager *sharedDeviceManager;
 - (void)addInternalDevicesObject:(MIKMIDIDevice *)device;
 - (void)removeInternalDevicesObject:(MIKMIDIDevice *)device;
 
+// Indexes of internalDevices, kept up to date as devices come and go
+@property (nonatomic, strong) NSMutableDictionary *devicesByObjectRef;
+@property (nonatomic, strong) NSMutableDictionary *devicesByUniqueID;
+@property (nonatomic, strong) NSMutableDictionary *devicesByIndexKey; // Arrays of devices, keyed by name and by manufacturer and model
+@property (nonatomic, strong) NSMutableDictionary *indexKeysByObjectRef; // The keys a device was indexed under, as its name may be gone when it is removed
+
+@property (nonatomic, strong) NSMutableDictionary *deviceHandlersByIndexKey; // Dictionaries of handlers by token
+@property (nonatomic, strong) NSMutableDictionary *indexKeysByDeviceHandlerToken;
+
 @property (nonatomic, strong) NSMutableArray *internalVirtualSources;
 - (void)addInternalVirtualSourcesObject:(MIKMIDISourceEndpoint *)source;
 - (void)removeInternalVirtualSourcesObject:(MIKMIDISourceEndpoint *)source;
@@ -69,6 +94,12 @@ static MIKMIDIDeviceManager *sharedDeviceManager;
 	
     self = [super init];
     if (self) {
+		_devicesByObjectRef = [[NSMutableDictionary alloc] init];
+		_devicesByUniqueID = [[NSMutableDictionary alloc] init];
+		_devicesByIndexKey = [[NSMutableDictionary alloc] init];
+		_indexKeysByObjectRef = [[NSMutableDictionary alloc] init];
+		_deviceHandlersByIndexKey = [[NSMutableDictionary alloc] init];
+		_indexKeysByDeviceHandlerToken = [[NSMutableDictionary alloc] init];
 		[self createClient];
         [self retrieveAvailableDevices];
 		[self retrieveVirtualEndpoints];
@@ -113,6 +144,43 @@ static MIKMIDIDeviceManager *sharedDeviceManager;
 	}
 }
 
+- (MIKMIDIDevice *)deviceWithUniqueID:(MIDIUniqueID)uniqueID
+{
+	return self.devicesByUniqueID[@(uniqueID)];
+}
+
+- (NSArray *)devicesWithName:(NSString *)name
+{
+	NSArray *devices = self.devicesByIndexKey[MIKMIDIDeviceNameIndexKey(name)];
+	return devices ? [devices copy] : @[];
+}
+
+- (NSArray *)devicesWithManufacturer:(NSString *)manufacturer model:(NSString *)model
+{
+	NSArray *devices = self.devicesByIndexKey[MIKMIDIDeviceModelIndexKey(manufacturer, model)];
+	return devices ? [devices copy] : @[];
+}
+
+- (id)addHandlerForDevicesWithName:(NSString *)name handler:(MIKMIDIDeviceHandlerBlock)handler
+{
+	return [self addDeviceHandler:handler forIndexKey:MIKMIDIDeviceNameIndexKey(name)];
+}
+
+- (id)addHandlerForDevicesWithManufacturer:(NSString *)manufacturer model:(NSString *)model handler:(MIKMIDIDeviceHandlerBlock)handler
+{
+	return [self addDeviceHandler:handler forIndexKey:MIKMIDIDeviceModelIndexKey(manufacturer, model)];
+}
+
+- (void)removeDeviceHandlerForToken:(id)token
+{
+	NSString *indexKey = self.indexKeysByDeviceHandlerToken[token];
+	if (!indexKey) return;
+	[self.indexKeysByDeviceHandlerToken removeObjectForKey:token];
+	NSMutableDictionary *handlers = self.deviceHandlersByIndexKey[indexKey];
+	[handlers removeObjectForKey:token];
+	if (![handlers count]) [self.deviceHandlersByIndexKey removeObjectForKey:indexKey];
+}
+
 - (BOOL)sendCommands:(NSArray *)commands toEndpoint:(MIKMIDIDestinationEndpoint *)endpoint error:(NSError **)error;
 {
 	return [self.outputPort sendCommands:commands toDestination:endpoint error:error];
@@ -148,6 +216,7 @@ static MIKMIDIDeviceManager *sharedDeviceManager;
 	}
 	
 	self.internalDevices = devices;
+	for (MIKMIDIDevice *device in devices) [self indexDevice:device];
 }
 
 - (void)retrieveVirtualEndpoints
@@ -173,6 +242,62 @@ static MIKMIDIDeviceManager *sharedDeviceManager;
 	self.internalVirtualDestinations = destinations;
 }
 
+- (void)indexDevice:(MIKMIDIDevice *)device
+{
+	NSArray *indexKeys = @[MIKMIDIDeviceNameIndexKey(device.name), MIKMIDIDeviceModelIndexKey(device.manufacturer, device.model)];
+	self.devicesByObjectRef[@(device.objectRef)] = device;
+	self.devicesByUniqueID[@(device.uniqueID)] = device;
+	self.indexKeysByObjectRef[@(device.objectRef)] = indexKeys;
+	for (NSString *indexKey in indexKeys) {
+		NSMutableArray *devices = self.devicesByIndexKey[indexKey];
+		if (!devices) {
+			devices = [NSMutableArray array];
+			self.devicesByIndexKey[indexKey] = devices;
+		}
+		[devices addObject:device];
+	}
+}
+
+- (void)unindexDevice:(MIKMIDIDevice *)device
+{
+	for (NSString *indexKey in self.indexKeysByObjectRef[@(device.objectRef)]) {
+		NSMutableArray *devices = self.devicesByIndexKey[indexKey];
+		[devices removeObjectIdenticalTo:device];
+		if (![devices count]) [self.devicesByIndexKey removeObjectForKey:indexKey];
+	}
+	[self.indexKeysByObjectRef removeObjectForKey:@(device.objectRef)];
+	[self.devicesByObjectRef removeObjectForKey:@(device.objectRef)];
+	if (self.devicesByUniqueID[@(device.uniqueID)] == device) [self.devicesByUniqueID removeObjectForKey:@(device.uniqueID)];
+}
+
+- (id)addDeviceHandler:(MIKMIDIDeviceHandlerBlock)handler forIndexKey:(NSString *)indexKey
+{
+	CFUUIDRef uuid = CFUUIDCreate(kCFAllocatorDefault);
+	NSString *token = CFBridgingRelease(CFUUIDCreateString(kCFAllocatorDefault, uuid));
+	CFRelease(uuid);
+	
+	NSMutableDictionary *handlers = self.deviceHandlersByIndexKey[indexKey];
+	if (!handlers) {
+		handlers = [NSMutableDictionary dictionary];
+		self.deviceHandlersByIndexKey[indexKey] = handlers;
+	}
+	handlers[token] = [handler copy];
+	self.indexKeysByDeviceHandlerToken[token] = indexKey;
+	
+	for (MIKMIDIDevice *device in [self.devicesByIndexKey[indexKey] copy]) handler(device);
+	return token;
+}
+
+// Calls the handlers registered for any of the keys the device is indexed under.
+- (void)notifyDeviceHandlersOfDevice:(MIKMIDIDevice *)device
+{
+	for (NSString *indexKey in self.indexKeysByObjectRef[@(device.objectRef)]) {
+		for (MIKMIDIDeviceHandlerBlock handler in [self.deviceHandlersByIndexKey[indexKey] allValues]) {
+			handler(device);
+		}
+	}
+}
+
 - (MIKMIDIInputPort *)inputPortConnectedToEndpoint:(MIKMIDIEndpoint *)endpoint
 {
 	for (MIKMIDIInputPort *port in self.internalConnectedInputPorts) {
@@ -193,18 +318,33 @@ static MIKMIDIDeviceManager *sharedDeviceManager;
 	switch (notification->objectType) {
 		case kMIDIObjectType_Device: {
 			
-			if (![changedProperty isEqualToString:(__bridge NSString *)kMIDIPropertyOffline]) break;
+			BOOL offlineChanged = [changedProperty isEqualToString:(__bridge NSString *)kMIDIPropertyOffline];
+			BOOL indexedPropertyChanged = ([changedProperty isEqualToString:(__bridge NSString *)kMIDIPropertyName] ||
+										   [changedProperty isEqualToString:(__bridge NSString *)kMIDIPropertyManufacturer] ||
+										   [changedProperty isEqualToString:(__bridge NSString *)kMIDIPropertyModel]);
+			if (!offlineChanged && !indexedPropertyChanged) break;
 			
 			MIKMIDIDevice *changedObject = [MIKMIDIDevice MIDIObjectWithObjectRef:notification->object];
 			if (!changedObject) break;
+			MIKMIDIDevice *existingDevice = self.devicesByObjectRef[@(notification->object)];
+			
+			if (indexedPropertyChanged) {
+				// Devices cache their manufacturer and model, so the fresh instance takes the place of the old one.
+				if (!existingDevice) break;
+				[self removeInternalDevicesObject:existingDevice];
+				[self addInternalDevicesObject:changedObject];
+				[self notifyDeviceHandlersOfDevice:changedObject];
+				break;
+			}
 			
-			if (changedObject.isOnline && ![self.internalDevices containsObject:changedObject]) {
+			if (changedObject.isOnline && !existingDevice) {
 				[self addInternalDevicesObject:changedObject];
 				[nc postNotificationName:MIKMIDIDeviceWasAddedNotification object:self userInfo:@{MIKMIDIDeviceKey : changedObject}];
+				[self notifyDeviceHandlersOfDevice:changedObject];
 			}
-			if (!changedObject.isOnline) {
-				[self removeInternalDevicesObject:changedObject];
-				[nc postNotificationName:MIKMIDIDeviceWasRemovedNotification object:self userInfo:@{MIKMIDIDeviceKey : changedObject}];
+			if (!changedObject.isOnline && existingDevice) {
+				[self removeInternalDevicesObject:existingDevice];
+				[nc postNotificationName:MIKMIDIDeviceWasRemovedNotification object:self userInfo:@{MIKMIDIDeviceKey : existingDevice}];
 			}
 		}
 			break;
@@ -253,9 +393,11 @@ static MIKMIDIDeviceManager *sharedDeviceManager;
 	
 	switch (notification->childType) {
 		case kMIDIObjectType_Device: {
-			MIKMIDIDevice *removedDevice = [MIKMIDIDevice MIDIObjectWithObjectRef:notification->child];
+			// The device may not be readable anymore, so it is looked up by its object ref.
+			MIKMIDIDevice *removedDevice = self.devicesByObjectRef[@(notification->child)];
 			if (!removedDevice) break;
 			[self removeInternalDevicesObject:removedDevice];
+			[nc postNotificationName:MIKMIDIDeviceWasRemovedNotification object:self userInfo:@{MIKMIDIDeviceKey : removedDevice}];
 		}
 			break;
 		case kMIDIObjectType_Source: {
@@ -304,9 +446,10 @@ static MIKMIDIDeviceManager *sharedDeviceManager;
 	switch (notification->childType) {
 		case kMIDIObjectType_Device: {
 			MIKMIDIDevice *addedDevice = [MIKMIDIDevice MIDIObjectWithObjectRef:notification->child];
-			if (addedDevice && ![self.internalDevices containsObject:addedDevice]) {
+			if (addedDevice && addedDevice.isOnline && !self.devicesByObjectRef[@(notification->child)]) {
 				[self addInternalDevicesObject:addedDevice];
 				[nc postNotificationName:MIKMIDIDeviceWasAddedNotification object:self userInfo:@{MIKMIDIDeviceKey : addedDevice}];
+				[self notifyDeviceHandlersOfDevice:addedDevice];
 			}
 		}
 			break;
@@ -380,11 +523,13 @@ void MIKMIDIDeviceManagerNotifyCallback(const MIDINotification *message, void *r
 - (void)addInternalDevicesObject:(MIKMIDIDevice *)device;
 {
 	[self.internalDevices addObject:device];
+	[self indexDevice:device];
 }
 
 - (void)removeInternalDevicesObject:(MIKMIDIDevice *)device;
 {
-	[self.internalDevices removeObject:device];
+	[self unindexDevice:device];
+	[self.internalDevices removeObjectIdenticalTo:device];
 }
 
 - (NSArray *)virtualSources { return [self.internalVirtualSources copy]; }
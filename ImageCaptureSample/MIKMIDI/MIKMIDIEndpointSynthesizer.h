@@ -129,6 +129,11 @@
  *  useful for MIKMIDIEndpointSynthesizers that are not connected to a MIDI
  *  endpoint.
  *
+ *  Messages are handed to the render thread, which plays each one at the frame its
+ *  midiTimestamp falls on, so notes scheduled ahead by a sequencer keep their timing
+ *  within a render buffer. Messages without a time stamp, or whose time has passed,
+ *  are played at the start of the next buffer.
+ *
  *  @param messages An NSArray of MIKMIDICommand (subclass) instances.
  */
 - (void)handleMIDIMessages:(NSArray *)messages;
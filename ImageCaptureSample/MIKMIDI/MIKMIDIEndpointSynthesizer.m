@@ -10,11 +10,34 @@
 #import <AudioToolbox/AudioToolbox.h>
 #import "MIKMIDI.h"
 #import "MIKMIDIClientDestinationEndpoint.h"
+#import "MIKMIDIEndpointSynthesizerCore.h"
+#import <mach/mach_time.h>
+#import <unistd.h>
 
 #if !__has_feature(objc_arc)
 #error MIKMIDIEndpointSynthesizer.m must be compiled with ARC. Either turn on ARC for the project or set the -fobjc-arc flag for MIKMIDIMappingManager.m in the Build Phases for this target
 #endif
 
+typedef struct {
+	MIKMIDIEndpointSynthesizerSchedule schedule;
+	AudioUnit instrument;
+} MIKMIDIEndpointSynthesizerRenderContext;
+
+static void MIKMIDIEndpointSynthesizerPlayEvent(void *context, const MIKMIDIEndpointSynthesizerEvent *event, uint32_t sampleOffset)
+{
+	MusicDeviceMIDIEvent((AudioUnit)context, event->status, event->data1, event->data2, sampleOffset);
+}
+
+static OSStatus MIKMIDIEndpointSynthesizerRenderNotify(void *inRefCon, AudioUnitRenderActionFlags *ioActionFlags, const AudioTimeStamp *inTimeStamp, UInt32 inBusNumber, UInt32 inNumberFrames, AudioBufferList *ioData)
+{
+	if (!(*ioActionFlags & kAudioUnitRenderAction_PreRender) || inBusNumber != 0) return noErr;
+	
+	MIKMIDIEndpointSynthesizerRenderContext *renderContext = inRefCon;
+	MIDITimeStamp bufferTime = (inTimeStamp->mFlags & kAudioTimeStampHostTimeValid) ? inTimeStamp->mHostTime : mach_absolute_time();
+	MIKMIDIEndpointSynthesizerPlayDueEvents(&renderContext->schedule, bufferTime, inNumberFrames, MIKMIDIEndpointSynthesizerPlayEvent, renderContext->instrument);
+	return noErr;
+}
+
 @interface MIKMIDIEndpointSynthesizer ()
 
 @property (nonatomic, strong, readwrite) MIKMIDIEndpoint *endpoint;
@@ -25,6 +48,10 @@
 @end
 
 @implementation MIKMIDIEndpointSynthesizer
+{
+	MIKMIDIEndpointSynthesizerRenderContext *_renderContext;
+	BOOL _renderNotifyAdded;
+}
 
 - (instancetype)init
 {
@@ -50,6 +77,7 @@
 {
 	self = [super init];
 	if (self) {
+		if (![self createSchedule]) return nil;
 		if (source) {
 			NSError *error = nil;
 			if (![self connectToMIDISource:source error:&error]) {
@@ -89,6 +117,7 @@
 	
 	self = [super init];
 	if (self) {
+		if (![self createSchedule]) return nil;
 		
 		__weak MIKMIDIEndpointSynthesizer *weakSelf = self;
 		destination.receivedMessagesHandler = ^(MIKMIDIClientDestinationEndpoint *destination, NSArray *commands){
@@ -112,7 +141,18 @@
 		// Don't need to do anything for a destination endpoint. __weak reference in the messages handler will automatically nil out.
 	}
 	
+	// The render thread reads the schedule until the graph has stopped and the notification is removed.
+	if (_graph) {
+		AUGraphStop(_graph);
+		Boolean running = false;
+		for (int attempt = 0; attempt < 100 && AUGraphIsRunning(_graph, &running) == noErr && running; attempt++) {
+			usleep(1000);
+		}
+	}
+	// The graph disposes of the instrument, so the notification is removed first.
+	self.instrument = NULL;
 	self.graph = NULL;
+	free(_renderContext);
 }
 
 #pragma mark - Private
@@ -136,11 +176,30 @@
 	return YES;
 }
 
+- (BOOL)createSchedule
+{
+	_renderContext = calloc(1, sizeof(MIKMIDIEndpointSynthesizerRenderContext));
+	if (!_renderContext) return NO;
+	
+	mach_timebase_info_data_t timebase;
+	mach_timebase_info(&timebase);
+	_renderContext->schedule.hostTicksPerSecond = (Float64)NSEC_PER_SEC * timebase.denom / timebase.numer;
+	_renderContext->schedule.sampleRate = 44100.0;
+	return YES;
+}
+
 - (void)handleMIDIMessages:(NSArray *)commands
 {
-	for (MIKMIDICommand *command in commands) {
-		OSStatus err = MusicDeviceMIDIEvent(self.instrument, command.commandType, command.dataByte1, command.dataByte2, 0);
-		if (err) NSLog(@"Unable to send MIDI command to synthesizer %@: %i", command, (int)err);
+	// The render notification plays the events at the frame their time stamps fall on.
+	@synchronized(self) {
+		for (MIKMIDICommand *command in commands) {
+			MIKMIDIEndpointSynthesizerEvent event = {command.midiTimestamp, command.commandType, command.dataByte1, command.dataByte2};
+			if (!_renderNotifyAdded || !MIKMIDIEndpointSynthesizerPushEvent(&_renderContext->schedule, event)) {
+				// Nothing would pick the event up, or the render thread has fallen behind; play it at once.
+				OSStatus err = MusicDeviceMIDIEvent(self.instrument, event.status, event.data1, event.data2, 0);
+				if (err) NSLog(@"Unable to send MIDI command to synthesizer %@: %i", command, (int)err);
+			}
+		}
 	}
 }
 
@@ -276,6 +335,36 @@
 
 #pragma mark - Properties
 
+- (void)setInstrument:(AudioUnit)instrument
+{
+	// handleMIDIMessages: checks whether the notification is added under the same lock.
+	@synchronized(self) {
+		if (instrument == _instrument) return;
+		
+		OSStatus err = 0;
+		if (_renderNotifyAdded) {
+			if ((err = AudioUnitRemoveRenderNotify(_instrument, MIKMIDIEndpointSynthesizerRenderNotify, _renderContext))) {
+				NSLog(@"Unable to remove render notification from instrument: %i", (int)err);
+			}
+			_renderNotifyAdded = NO;
+		}
+		_instrument = instrument;
+		_renderContext->instrument = instrument;
+		if (!instrument) return;
+		
+		Float64 sampleRate = 0;
+		UInt32 size = sizeof(sampleRate);
+		if (!AudioUnitGetProperty(instrument, kAudioUnitProperty_SampleRate, kAudioUnitScope_Output, 0, &sampleRate, &size) && sampleRate > 0) {
+			_renderContext->schedule.sampleRate = sampleRate;
+		}
+		if ((err = AudioUnitAddRenderNotify(instrument, MIKMIDIEndpointSynthesizerRenderNotify, _renderContext))) {
+			NSLog(@"Unable to add render notification to instrument: %i", (int)err);
+			return;
+		}
+		_renderNotifyAdded = YES;
+	}
+}
+
 - (void)setGraph:(AUGraph)graph
 {
 	if (graph != _graph) {
@@ -0,0 +1,152 @@
+//
+//  MIKMIDIEndpointSynthesizerCore.h
+//  MIKMIDI
+//
+
+#ifndef MIKMIDI_MIKMIDIEndpointSynthesizerCore_h
+#define MIKMIDI_MIKMIDIEndpointSynthesizerCore_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ *  The scheduling of MIKMIDIEndpointSynthesizer's render notification in plain C,
+ *  so that it can also be built and checked off the device. Time stamps are in host ticks.
+ */
+
+// Returned by MIKMIDIEndpointSynthesizerSampleOffset() for an event due in a later buffer.
+#define MIKMIDIEndpointSynthesizerNotDue UINT32_MAX
+
+#define MIKMIDIEndpointSynthesizerQueueCapacity 512 // Must be a power of two.
+#define MIKMIDIEndpointSynthesizerPendingCapacity 512
+
+typedef struct {
+	uint64_t timeStamp;
+	uint8_t status;
+	uint8_t data1;
+	uint8_t data2;
+} MIKMIDIEndpointSynthesizerEvent;
+
+/**
+ *  Returns the frame in a buffer of frameCount frames starting at bufferTime at which
+ *  an event stamped eventTime should sound. Events without a time stamp or that are
+ *  already due sound at the start of the buffer.
+ */
+static inline uint32_t MIKMIDIEndpointSynthesizerSampleOffset(uint64_t eventTime, uint64_t bufferTime, uint32_t frameCount, double sampleRate, double hostTicksPerSecond)
+{
+	if (eventTime <= bufferTime) return 0;
+	double offset = (double)(eventTime - bufferTime) * sampleRate / hostTicksPerSecond;
+	if (offset >= frameCount) return MIKMIDIEndpointSynthesizerNotDue;
+	return (uint32_t)offset;
+}
+
+/**
+ *  Inserts an event into a list kept in time stamp order, after the events of the same time.
+ *  The list must have room for one more event.
+ */
+static inline void MIKMIDIEndpointSynthesizerInsertEvent(MIKMIDIEndpointSynthesizerEvent *events, uint32_t *count, MIKMIDIEndpointSynthesizerEvent event)
+{
+	// Events mostly arrive in order, so the search starts at the end.
+	uint32_t index = *count;
+	while (index > 0 && events[index - 1].timeStamp > event.timeStamp) index--;
+	memmove(&events[index + 1], &events[index], (*count - index) * sizeof(event));
+	events[index] = event;
+	(*count)++;
+}
+
+/**
+ *  Events on their way from handleMIDIMessages: to the render thread.
+ *
+ *  The queue is a single producer, single consumer ring; producers are serialized
+ *  by the synthesizer, and only the render notification consumes, so the render
+ *  thread never waits on a lock. Events that are due in a later buffer are moved
+ *  to the pending list, which only the render thread touches.
+ */
+typedef struct {
+	MIKMIDIEndpointSynthesizerEvent queue[MIKMIDIEndpointSynthesizerQueueCapacity];
+	volatile int64_t writePosition;
+	volatile int64_t readPosition;
+	
+	MIKMIDIEndpointSynthesizerEvent pending[MIKMIDIEndpointSynthesizerPendingCapacity];
+	uint32_t pendingCount;
+	
+	double sampleRate;
+	double hostTicksPerSecond;
+} MIKMIDIEndpointSynthesizerSchedule;
+
+/**
+ *  Plays an event sampleOffset frames into the buffer being rendered.
+ */
+typedef void (*MIKMIDIEndpointSynthesizerPlayFunction)(void *context, const MIKMIDIEndpointSynthesizerEvent *event, uint32_t sampleOffset);
+
+/**
+ *  Queues an event for the render thread. Only one thread may push at a time.
+ *
+ *  @return false if the queue is full because the render thread has fallen behind.
+ */
+static inline bool MIKMIDIEndpointSynthesizerPushEvent(MIKMIDIEndpointSynthesizerSchedule *schedule, MIKMIDIEndpointSynthesizerEvent event)
+{
+	int64_t writePosition = schedule->writePosition;
+	if (writePosition - schedule->readPosition >= MIKMIDIEndpointSynthesizerQueueCapacity) return false;
+	schedule->queue[writePosition & (MIKMIDIEndpointSynthesizerQueueCapacity - 1)] = event;
+	// The event must be in place before the render thread can see the new position.
+	__sync_synchronize();
+	schedule->writePosition = writePosition + 1;
+	return true;
+}
+
+/**
+ *  Takes the oldest queued event. Only the render thread pops.
+ *
+ *  @return false if the queue is empty.
+ */
+static inline bool MIKMIDIEndpointSynthesizerPopEvent(MIKMIDIEndpointSynthesizerSchedule *schedule, MIKMIDIEndpointSynthesizerEvent *event)
+{
+	int64_t readPosition = schedule->readPosition;
+	if (readPosition == schedule->writePosition) return false;
+	__sync_synchronize();
+	*event = schedule->queue[readPosition & (MIKMIDIEndpointSynthesizerQueueCapacity - 1)];
+	// The slot must be read before the producer can see it free.
+	__sync_synchronize();
+	schedule->readPosition = readPosition + 1;
+	return true;
+}
+
+/**
+ *  Moves the queued events to the pending list and plays those due in a buffer of frameCount
+ *  frames starting at bufferTime, at the frame they fall on. Events that do not fit in the
+ *  pending list are played at the start of the buffer rather than lost.
+ *
+ *  @return The number of events played.
+ */
+static inline uint32_t MIKMIDIEndpointSynthesizerPlayDueEvents(MIKMIDIEndpointSynthesizerSchedule *schedule, uint64_t bufferTime, uint32_t frameCount, MIKMIDIEndpointSynthesizerPlayFunction play, void *context)
+{
+	uint32_t playedCount = 0;
+	MIKMIDIEndpointSynthesizerEvent event;
+	while (MIKMIDIEndpointSynthesizerPopEvent(schedule, &event)) {
+		if (schedule->pendingCount < MIKMIDIEndpointSynthesizerPendingCapacity) {
+			MIKMIDIEndpointSynthesizerInsertEvent(schedule->pending, &schedule->pendingCount, event);
+		} else {
+			// Too far ahead to hold; play it now rather than lose it.
+			play(context, &event, 0);
+			playedCount++;
+		}
+	}
+	
+	uint32_t dueCount = 0;
+	while (dueCount < schedule->pendingCount) {
+		const MIKMIDIEndpointSynthesizerEvent *pendingEvent = &schedule->pending[dueCount];
+		uint32_t offset = MIKMIDIEndpointSynthesizerSampleOffset(pendingEvent->timeStamp, bufferTime, frameCount, schedule->sampleRate, schedule->hostTicksPerSecond);
+		if (offset == MIKMIDIEndpointSynthesizerNotDue) break;
+		play(context, pendingEvent, offset);
+		dueCount++;
+	}
+	if (dueCount > 0) {
+		schedule->pendingCount -= dueCount;
+		memmove(&schedule->pending[0], &schedule->pending[dueCount], schedule->pendingCount * sizeof(MIKMIDIEndpointSynthesizerEvent));
+	}
+	return playedCount + dueCount;
+}
+
+#endif
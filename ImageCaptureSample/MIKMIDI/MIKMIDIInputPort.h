@@ -12,6 +12,7 @@
 @class MIKMIDISourceEndpoint;
 
 typedef void(^MIKMIDIEventHandlerBlock)(MIKMIDISourceEndpoint *source, NSArray *commands); // commands in an array of MIKMIDICommands
+typedef void(^MIKMIDISystemExclusiveChunkHandlerBlock)(MIKMIDISourceEndpoint *source, NSData *chunk, BOOL isLast); // See MIKMIDISystemExclusiveChunkHandler
 
 /**
  *  MIKMIDIInputPort is an Objective-C wrapper for CoreMIDI's MIDIPort class, and is only for source ports.
@@ -32,4 +33,16 @@ typedef void(^MIKMIDIEventHandlerBlock)(MIKMIDISourceEndpoint *source, NSArray *
 
 @property (nonatomic) BOOL coalesces14BitControlChangeCommands; // Default is YES
 
+/**
+ *  The largest system exclusive message, including its delimiters, that is put back together
+ *  from the packets of a source. Longer messages are dropped. Default is 1 MB.
+ */
+@property (nonatomic) NSUInteger maximumSystemExclusiveLength;
+
+/**
+ *  If set, system exclusive messages are handed to this block chunk by chunk as they arrive,
+ *  instead of to the event handlers as complete commands. Called on the main thread.
+ */
+@property (nonatomic, copy) MIKMIDISystemExclusiveChunkHandlerBlock systemExclusiveChunkHandler;
+
 @end
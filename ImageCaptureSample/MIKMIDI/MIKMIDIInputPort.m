@@ -14,6 +14,8 @@
 #import "MIKMIDICommand.h"
 #import "MIKMIDIControlChangeCommand.h"
 #import "MIKMIDIUtilities.h"
+#import "MIKMIDISystemExclusiveAssembler.h"
+#import "Trace.h"
 
 #if !__has_feature(objc_arc)
 #error MIKMIDIInputPort.m must be compiled with ARC. Either turn on ARC for the project or set the -fobjc-arc flag for MIKMIDIInputPort.m in the Build Phases for this target
@@ -27,6 +29,8 @@
 @property (nonatomic, strong) NSMutableArray *bufferedMSBCommands;
 @property (nonatomic) dispatch_queue_t bufferedCommandQueue;
 
+@property (nonatomic, strong) NSMutableDictionary *systemExclusiveAssemblersBySource; // Keyed by MIDIObjectRef
+
 @end
 
 @implementation MIKMIDIInputPort
@@ -50,6 +54,8 @@
 		_eventHandlersByToken = [[NSMutableDictionary alloc] init];
 		_internalSources = [[NSMutableArray alloc] init];
 		_coalesces14BitControlChangeCommands = YES;
+		_maximumSystemExclusiveLength = 1024 * 1024;
+		_systemExclusiveAssemblersBySource = [[NSMutableDictionary alloc] init];
 		
 		_bufferedCommandQueue = dispatch_queue_create("com.mixedinkey.MIKMIDI.MIKMIDIInputPort.bufferedCommandQueue", DISPATCH_QUEUE_SERIAL);
 		dispatch_async(self.bufferedCommandQueue, ^{ self.bufferedMSBCommands = [[NSMutableArray alloc] init]; });
@@ -86,6 +92,9 @@
 	OSStatus err = MIDIPortDisconnectSource(self.portRef, source.objectRef);
 	if (err != noErr) NSLog(@"Error disconnecting MIDI source %@ from port %@", source, self);
 	[self removeInternalSourcesObject:source];
+	@synchronized(self.systemExclusiveAssemblersBySource) {
+		[self.systemExclusiveAssemblersBySource removeObjectForKey:@(source.objectRef)];
+	}
 }
 
 - (id)addEventHandler:(MIKMIDIEventHandlerBlock)eventHandler; // Returns a token
@@ -173,6 +182,34 @@
 	});
 }
 
+// Called on the CoreMIDI read thread. Assemblers are created lazily, when a source first sends something.
+- (MIKMIDISystemExclusiveAssembler *)systemExclusiveAssemblerForSource:(MIKMIDISourceEndpoint *)source
+{
+	@synchronized(self.systemExclusiveAssemblersBySource) {
+		MIKMIDISystemExclusiveAssembler *assembler = self.systemExclusiveAssemblersBySource[@(source.objectRef)];
+		if (!assembler) {
+			assembler = [[MIKMIDISystemExclusiveAssembler alloc] init];
+			[self configureSystemExclusiveAssembler:assembler forSource:source];
+			self.systemExclusiveAssemblersBySource[@(source.objectRef)] = assembler;
+		}
+		return assembler;
+	}
+}
+
+// Called with the assemblers locked, which also guards the settings against the setters.
+- (void)configureSystemExclusiveAssembler:(MIKMIDISystemExclusiveAssembler *)assembler forSource:(MIKMIDISourceEndpoint *)source
+{
+	assembler.maximumLength = self.maximumSystemExclusiveLength;
+	MIKMIDISystemExclusiveChunkHandlerBlock chunkHandler = self.systemExclusiveChunkHandler;
+	if (!chunkHandler) {
+		assembler.chunkHandler = nil;
+		return;
+	}
+	assembler.chunkHandler = ^(NSData *chunk, BOOL isLast) {
+		dispatch_async(dispatch_get_main_queue(), ^{ chunkHandler(source, chunk, isLast); });
+	};
+}
+
 #pragma mark - Callbacks
 
 // May be called on a background thread!
@@ -182,14 +219,20 @@ void MIKMIDIPortReadCallback(const MIDIPacketList *pktList, void *readProcRefCon
 		MIKMIDIInputPort *self = (__bridge MIKMIDIInputPort *)readProcRefCon;
 		MIKMIDISourceEndpoint *source = (__bridge MIKMIDISourceEndpoint *)srcConnRefCon;
 		
+		TRACE_BEGIN("midi.read");
+		TRACE_COUNTER("midi.read.packets", pktList->numPackets);
+		MIKMIDISystemExclusiveAssembler *assembler = [self systemExclusiveAssemblerForSource:source];
 		NSMutableArray *receivedCommands = [NSMutableArray array];
 		MIDIPacket *packet = (MIDIPacket *)pktList->packet;
 		for (int i=0; i<pktList->numPackets; i++) {
 			if (packet->length == 0) continue;
-			NSArray *commands = [MIKMIDICommand commandsWithMIDIPacket:packet];
+			// System exclusive messages may span several packets, so they go through the source's assembler.
+			NSArray *commands = [assembler commandsByAppendingMIDIPacket:packet];
+			if (!commands) commands = [MIKMIDICommand commandsWithMIDIPacket:packet];
 			if (commands) [receivedCommands addObjectsFromArray:commands];
 			packet = MIDIPacketNext(packet);
 		}
+		TRACE_END("midi.read");
 		
 		if (![receivedCommands count]) return;
 		
@@ -204,6 +247,7 @@ void MIKMIDIPortReadCallback(const MIDIPacketList *pktList, void *readProcRefCon
 			MIKMIDICommand *finalCommand = [receivedCommands lastObject];
 			if ([self commandIsPossibleMSBOf14BitCommand:finalCommand]) {
 				// Hold back and wait for a possible LSB command to come in.
+				TRACE_INSTANT("midi.read.holdMSB", 0);
 				dispatch_sync(self.bufferedCommandQueue, ^{ [self.bufferedMSBCommands addObject:finalCommand]; });
 				[receivedCommands removeLastObject];
 				
@@ -238,6 +282,24 @@ void MIKMIDIPortReadCallback(const MIDIPacketList *pktList, void *readProcRefCon
 
 - (NSArray *)connectedSources { return [self.internalSources copy]; }
 
+// Existing assemblers are replaced rather than changed, as the read thread may be using them.
+// A message in progress is dropped.
+- (void)setMaximumSystemExclusiveLength:(NSUInteger)maximumSystemExclusiveLength
+{
+	@synchronized(self.systemExclusiveAssemblersBySource) {
+		_maximumSystemExclusiveLength = maximumSystemExclusiveLength;
+		[self.systemExclusiveAssemblersBySource removeAllObjects];
+	}
+}
+
+- (void)setSystemExclusiveChunkHandler:(MIKMIDISystemExclusiveChunkHandlerBlock)systemExclusiveChunkHandler
+{
+	@synchronized(self.systemExclusiveAssemblersBySource) {
+		_systemExclusiveChunkHandler = [systemExclusiveChunkHandler copy];
+		[self.systemExclusiveAssemblersBySource removeAllObjects];
+	}
+}
+
 - (void)addInternalSourcesObject:(MIKMIDISourceEndpoint *)source
 {
 	[self.internalSources addObject:source];
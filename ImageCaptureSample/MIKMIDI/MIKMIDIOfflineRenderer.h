@@ -0,0 +1,93 @@
+//
+//  MIKMIDIOfflineRenderer.h
+//  MIKMIDI
+//
+
+#import <Foundation/Foundation.h>
+#import <AudioToolbox/AudioToolbox.h>
+
+@class MIKMIDISequence;
+
+/**
+ *  MIKMIDIOfflineRenderer bounces an MIKMIDISequence to a WAV file as fast as the
+ *  instrument can render, without playing it through the audio hardware.
+ *
+ *  Each track that would be heard (not muted, and soloed if any track is soloed) gets
+ *  its own instance of the instrument. The note and channel events of the tracks are
+ *  converted to sample times through the sequence's tempo map, and the instruments
+ *  are pulled block by block, on parallel threads, with every event scheduled at its
+ *  sample offset within the block. The blocks of the tracks are then mixed and written out.
+ *
+ *  Track loops are not expanded; each track's events are rendered once.
+ */
+@interface MIKMIDIOfflineRenderer : NSObject
+
+/**
+ *  Creates and initializes an MIKMIDIOfflineRenderer instance using Apple's sampler
+ *  (DLS synth on OS X) as the instrument.
+ *
+ *  @param sequence The sequence to render.
+ *
+ *  @return An initialized MIKMIDIOfflineRenderer.
+ */
++ (instancetype)rendererWithSequence:(MIKMIDISequence *)sequence;
+
+/**
+ *  Initializes an MIKMIDIOfflineRenderer instance using Apple's sampler
+ *  (DLS synth on OS X) as the instrument.
+ *
+ *  @param sequence The sequence to render.
+ *
+ *  @return An initialized MIKMIDIOfflineRenderer.
+ */
+- (instancetype)initWithSequence:(MIKMIDISequence *)sequence;
+
+/**
+ *  Renders the whole sequence, followed by tailDuration seconds for notes to ring out,
+ *  into a 16-bit stereo WAV file.
+ *
+ *  @param fileURL The URL of the file to write. An existing file is overwritten.
+ *  @param error   If an error occurs, upon return contains an NSError object that describes the problem.
+ *  If you are not interested in possible errors, you may pass in NULL.
+ *
+ *  @return YES if the file was written, NO if an error occurred.
+ */
+- (BOOL)renderToURL:(NSURL *)fileURL error:(NSError **)error;
+
+/**
+ *  The sequence rendered by the receiver.
+ */
+@property (nonatomic, strong, readonly) MIKMIDISequence *sequence;
+
+/**
+ *  The component description of the Audio Unit instrument each track is rendered with.
+ */
+@property (nonatomic) AudioComponentDescription componentDescription;
+
+/**
+ *  The sample rate of the file. Default is 44100.
+ */
+@property (nonatomic) Float64 sampleRate;
+
+/**
+ *  The number of frames rendered at a time. Default is 1024.
+ */
+@property (nonatomic) UInt32 framesPerBlock;
+
+/**
+ *  The time rendered after the end of the sequence, in seconds. Default is 1.
+ */
+@property (nonatomic) NSTimeInterval tailDuration;
+
+/**
+ *  The length of audio written by the last render, in seconds.
+ */
+@property (nonatomic, readonly) NSTimeInterval renderedDuration;
+
+/**
+ *  How many times faster than real time the last render ran: the rendered duration
+ *  divided by the time it took.
+ */
+@property (nonatomic, readonly) double realtimeFactor;
+
+@end
@@ -0,0 +1,390 @@
+//
+//  MIKMIDIOfflineRenderer.m
+//  MIKMIDI
+//
+
+#import "MIKMIDIOfflineRenderer.h"
+#import "MIKMIDISequence.h"
+#import "MIKMIDITrack.h"
+#import "MIKMIDIEvent.h"
+#import "MIKMIDINoteEvent.h"
+#import "MIKMIDIErrors.h"
+
+#if !__has_feature(objc_arc)
+#error MIKMIDIOfflineRenderer.m must be compiled with ARC. Either turn on ARC for the project or set the -fobjc-arc flag for MIKMIDIOfflineRenderer.m in the Build Phases for this target
+#endif
+
+#define MIKMIDIOfflineRendererChannelCount 2
+
+typedef struct {
+	Float64 sampleTime;
+	UInt8 status;
+	UInt8 data1;
+	UInt8 data2;
+} MIKMIDIOfflineRendererEvent;
+
+/**
+ *  One track and the instrument it is rendered with. Only the thread rendering
+ *  the part touches it during a block.
+ */
+typedef struct {
+	AudioUnit instrument;
+	MIKMIDIOfflineRendererEvent *events;
+	NSUInteger eventCount;
+	NSUInteger nextEvent;
+	AudioBufferList *bufferList;
+	float *samples[MIKMIDIOfflineRendererChannelCount];
+	OSStatus status;
+} MIKMIDIOfflineRendererPart;
+
+static BOOL MIKMIDIOfflineRendererIsNoteOff(const MIKMIDIOfflineRendererEvent *event)
+{
+	UInt8 type = event->status & 0xF0;
+	return type == 0x80 || (type == 0x90 && event->data2 == 0);
+}
+
+static int MIKMIDIOfflineRendererCompareEvents(const void *a, const void *b)
+{
+	const MIKMIDIOfflineRendererEvent *event1 = a;
+	const MIKMIDIOfflineRendererEvent *event2 = b;
+	if (event1->sampleTime < event2->sampleTime) return -1;
+	if (event1->sampleTime > event2->sampleTime) return 1;
+	// A note that ends where the next one starts is released first, so the next one sounds.
+	return (int)!MIKMIDIOfflineRendererIsNoteOff(event1) - (int)!MIKMIDIOfflineRendererIsNoteOff(event2);
+}
+
+static AudioStreamBasicDescription MIKMIDIOfflineRendererFloatFormat(Float64 sampleRate)
+{
+	AudioStreamBasicDescription format = {0};
+	format.mSampleRate = sampleRate;
+	format.mFormatID = kAudioFormatLinearPCM;
+	format.mFormatFlags = kAudioFormatFlagsNativeFloatPacked | kAudioFormatFlagIsNonInterleaved;
+	format.mBytesPerPacket = sizeof(float);
+	format.mFramesPerPacket = 1;
+	format.mBytesPerFrame = sizeof(float);
+	format.mChannelsPerFrame = MIKMIDIOfflineRendererChannelCount;
+	format.mBitsPerChannel = 8 * sizeof(float);
+	return format;
+}
+
+static AudioBufferList *MIKMIDIOfflineRendererCreateBufferList(float **samples, UInt32 frameCount)
+{
+	AudioBufferList *bufferList = calloc(1, offsetof(AudioBufferList, mBuffers) + MIKMIDIOfflineRendererChannelCount * sizeof(AudioBuffer));
+	if (!bufferList) return NULL;
+	bufferList->mNumberBuffers = MIKMIDIOfflineRendererChannelCount;
+	for (UInt32 channel = 0; channel < MIKMIDIOfflineRendererChannelCount; channel++) {
+		samples[channel] = calloc(frameCount, sizeof(float));
+		bufferList->mBuffers[channel].mNumberChannels = 1;
+		bufferList->mBuffers[channel].mData = samples[channel];
+		bufferList->mBuffers[channel].mDataByteSize = frameCount * sizeof(float);
+	}
+	return bufferList;
+}
+
+static void MIKMIDIOfflineRendererDisposeBufferList(AudioBufferList *bufferList, float **samples)
+{
+	for (UInt32 channel = 0; channel < MIKMIDIOfflineRendererChannelCount; channel++) {
+		free(samples[channel]);
+		samples[channel] = NULL;
+	}
+	free(bufferList);
+}
+
+/**
+ *  Renders the next frameCount frames of a part, starting at sampleTime.
+ */
+static void MIKMIDIOfflineRendererRenderPart(MIKMIDIOfflineRendererPart *part, Float64 sampleTime, UInt32 frameCount)
+{
+	while (part->nextEvent < part->eventCount) {
+		const MIKMIDIOfflineRendererEvent *event = &part->events[part->nextEvent];
+		if (event->sampleTime >= sampleTime + frameCount) break;
+		UInt32 offset = (event->sampleTime > sampleTime) ? (UInt32)(event->sampleTime - sampleTime) : 0;
+		MusicDeviceMIDIEvent(part->instrument, event->status, event->data1, event->data2, offset);
+		part->nextEvent++;
+	}
+
+	for (UInt32 channel = 0; channel < MIKMIDIOfflineRendererChannelCount; channel++) {
+		part->bufferList->mBuffers[channel].mData = part->samples[channel];
+		part->bufferList->mBuffers[channel].mDataByteSize = frameCount * sizeof(float);
+	}
+	AudioUnitRenderActionFlags flags = 0;
+	AudioTimeStamp timeStamp = {0};
+	timeStamp.mSampleTime = sampleTime;
+	timeStamp.mFlags = kAudioTimeStampSampleTimeValid;
+	part->status = AudioUnitRender(part->instrument, &flags, &timeStamp, 0, frameCount, part->bufferList);
+}
+
+@interface MIKMIDIOfflineRenderer ()
+
+@property (nonatomic, strong, readwrite) MIKMIDISequence *sequence;
+@property (nonatomic, readwrite) NSTimeInterval renderedDuration;
+@property (nonatomic, readwrite) double realtimeFactor;
+
+@end
+
+@implementation MIKMIDIOfflineRenderer
+
++ (instancetype)rendererWithSequence:(MIKMIDISequence *)sequence
+{
+	return [[self alloc] initWithSequence:sequence];
+}
+
+- (instancetype)initWithSequence:(MIKMIDISequence *)sequence
+{
+	if (!sequence) {
+		[NSException raise:NSInvalidArgumentException format:@"%s requires a non-nil sequence argument.", __PRETTY_FUNCTION__];
+		return nil;
+	}
+
+	self = [super init];
+	if (self) {
+		_sequence = sequence;
+		_componentDescription = [[self class] appleSynthComponentDescription];
+		_sampleRate = 44100.0;
+		_framesPerBlock = 1024;
+		_tailDuration = 1.0;
+	}
+	return self;
+}
+
+#pragma mark - Rendering
+
+- (BOOL)renderToURL:(NSURL *)fileURL error:(NSError **)error
+{
+	error = error ? error : &(NSError *__autoreleasing){ nil };
+	CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+
+	NSArray *tracks = [self audibleTracks];
+	NSUInteger partCount = [tracks count];
+	MIKMIDIOfflineRendererPart *parts = calloc(MAX(partCount, 1), sizeof(MIKMIDIOfflineRendererPart));
+	if (!parts) {
+		*error = [NSError errorWithDomain:NSPOSIXErrorDomain code:ENOMEM userInfo:nil];
+		return NO;
+	}
+
+	BOOL success = YES;
+	Float64 lastEventTime = 0;
+	for (NSUInteger i = 0; i < partCount && success; i++) {
+		success = [self preparePart:&parts[i] withTrack:tracks[i] error:error];
+		if (success && parts[i].eventCount > 0) {
+			lastEventTime = MAX(lastEventTime, parts[i].events[parts[i].eventCount - 1].sampleTime);
+		}
+	}
+
+	Float64 frameCount = 0;
+	if (success) {
+		frameCount = ceil(MAX(self.sequence.durationInSeconds * self.sampleRate, lastEventTime) + self.tailDuration * self.sampleRate);
+		success = [self renderParts:parts count:partCount frameCount:(SInt64)frameCount toURL:fileURL error:error];
+	}
+
+	for (NSUInteger i = 0; i < partCount; i++) {
+		[self disposePart:&parts[i]];
+	}
+	free(parts);
+
+	if (!success) return NO;
+
+	CFAbsoluteTime elapsedTime = CFAbsoluteTimeGetCurrent() - startTime;
+	self.renderedDuration = frameCount / self.sampleRate;
+	self.realtimeFactor = (elapsedTime > 0) ? self.renderedDuration / elapsedTime : 0;
+	return YES;
+}
+
+- (BOOL)renderParts:(MIKMIDIOfflineRendererPart *)parts count:(NSUInteger)partCount frameCount:(SInt64)frameCount toURL:(NSURL *)fileURL error:(NSError **)error
+{
+	AudioStreamBasicDescription fileFormat = {0};
+	fileFormat.mSampleRate = self.sampleRate;
+	fileFormat.mFormatID = kAudioFormatLinearPCM;
+	fileFormat.mFormatFlags = kLinearPCMFormatFlagIsSignedInteger | kLinearPCMFormatFlagIsPacked;
+	fileFormat.mBytesPerPacket = MIKMIDIOfflineRendererChannelCount * sizeof(SInt16);
+	fileFormat.mFramesPerPacket = 1;
+	fileFormat.mBytesPerFrame = MIKMIDIOfflineRendererChannelCount * sizeof(SInt16);
+	fileFormat.mChannelsPerFrame = MIKMIDIOfflineRendererChannelCount;
+	fileFormat.mBitsPerChannel = 8 * sizeof(SInt16);
+
+	ExtAudioFileRef file = NULL;
+	OSStatus err = ExtAudioFileCreateWithURL((__bridge CFURLRef)fileURL, kAudioFileWAVEType, &fileFormat, NULL, kAudioFileFlags_EraseFile, &file);
+	if (err) {
+		NSLog(@"ExtAudioFileCreateWithURL() failed with error %d in %s.", (int)err, __PRETTY_FUNCTION__);
+		*error = [NSError errorWithDomain:NSOSStatusErrorDomain code:err userInfo:nil];
+		return NO;
+	}
+	AudioStreamBasicDescription clientFormat = MIKMIDIOfflineRendererFloatFormat(self.sampleRate);
+	err = ExtAudioFileSetProperty(file, kExtAudioFileProperty_ClientDataFormat, sizeof(clientFormat), &clientFormat);
+	if (err) {
+		NSLog(@"ExtAudioFileSetProperty() failed with error %d in %s.", (int)err, __PRETTY_FUNCTION__);
+		*error = [NSError errorWithDomain:NSOSStatusErrorDomain code:err userInfo:nil];
+		ExtAudioFileDispose(file);
+		return NO;
+	}
+
+	UInt32 framesPerBlock = self.framesPerBlock;
+	float *mix[MIKMIDIOfflineRendererChannelCount] = {NULL};
+	AudioBufferList *mixBufferList = MIKMIDIOfflineRendererCreateBufferList(mix, framesPerBlock);
+	if (!mixBufferList) {
+		*error = [NSError errorWithDomain:NSPOSIXErrorDomain code:ENOMEM userInfo:nil];
+		ExtAudioFileDispose(file);
+		return NO;
+	}
+	dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+
+	for (SInt64 sampleTime = 0; sampleTime < frameCount && !err; sampleTime += framesPerBlock) {
+		UInt32 blockFrameCount = (UInt32)MIN((SInt64)framesPerBlock, frameCount - sampleTime);
+
+		// The instruments are independent, so each one renders its block on its own thread.
+		dispatch_apply(partCount, queue, ^(size_t i) {
+			MIKMIDIOfflineRendererRenderPart(&parts[i], sampleTime, blockFrameCount);
+		});
+
+		for (UInt32 channel = 0; channel < MIKMIDIOfflineRendererChannelCount; channel++) {
+			memset(mix[channel], 0, blockFrameCount * sizeof(float));
+			mixBufferList->mBuffers[channel].mDataByteSize = blockFrameCount * sizeof(float);
+		}
+		for (NSUInteger i = 0; i < partCount && !err; i++) {
+			if ((err = parts[i].status)) {
+				NSLog(@"AudioUnitRender() failed with error %d in %s.", (int)err, __PRETTY_FUNCTION__);
+				break;
+			}
+			for (UInt32 channel = 0; channel < MIKMIDIOfflineRendererChannelCount; channel++) {
+				float *restrict destination = mix[channel];
+				const float *restrict source = parts[i].samples[channel];
+				for (UInt32 frame = 0; frame < blockFrameCount; frame++) {
+					destination[frame] += source[frame];
+				}
+			}
+		}
+		if (err) break;
+
+		if ((err = ExtAudioFileWrite(file, blockFrameCount, mixBufferList))) {
+			NSLog(@"ExtAudioFileWrite() failed with error %d in %s.", (int)err, __PRETTY_FUNCTION__);
+		}
+	}
+
+	MIKMIDIOfflineRendererDisposeBufferList(mixBufferList, mix);
+	OSStatus disposeErr = ExtAudioFileDispose(file);
+	if (!err && disposeErr) {
+		NSLog(@"ExtAudioFileDispose() failed with error %d in %s.", (int)disposeErr, __PRETTY_FUNCTION__);
+		err = disposeErr;
+	}
+	if (err) {
+		*error = [NSError errorWithDomain:NSOSStatusErrorDomain code:err userInfo:nil];
+		return NO;
+	}
+	return YES;
+}
+
+#pragma mark - Parts
+
+- (NSArray *)audibleTracks
+{
+	NSArray *tracks = self.sequence.tracks;
+	NSArray *soloTracks = [tracks filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"solo == YES"]];
+	if ([soloTracks count]) tracks = soloTracks;
+	return [tracks filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"muted == NO"]];
+}
+
+- (BOOL)preparePart:(MIKMIDIOfflineRendererPart *)part withTrack:(MIKMIDITrack *)track error:(NSError **)error
+{
+	NSArray *trackEvents = track.events;
+	// A note becomes two events.
+	part->events = calloc(MAX(2 * [trackEvents count], 1), sizeof(MIKMIDIOfflineRendererEvent));
+	if (!part->events) {
+		*error = [NSError errorWithDomain:NSPOSIXErrorDomain code:ENOMEM userInfo:nil];
+		return NO;
+	}
+
+	MusicTimeStamp trackOffset = track.offset;
+	for (MIKMIDIEvent *event in trackEvents) {
+		if ([event isKindOfClass:[MIKMIDINoteEvent class]]) {
+			MIKMIDINoteEvent *noteEvent = (MIKMIDINoteEvent *)event;
+			UInt8 channel = noteEvent.channel & 0x0F;
+			MIKMIDIOfflineRendererEvent noteOn = {[self sampleTimeForBeats:noteEvent.timeStamp + trackOffset], 0x90 | channel, noteEvent.note, noteEvent.velocity};
+			MIKMIDIOfflineRendererEvent noteOff = {[self sampleTimeForBeats:noteEvent.endTimeStamp + trackOffset], 0x80 | channel, noteEvent.note, noteEvent.releaseVelocity};
+			part->events[part->eventCount++] = noteOn;
+			part->events[part->eventCount++] = noteOff;
+		} else if (event.eventType == kMusicEventType_MIDIChannelMessage && [event.data length] >= sizeof(MIDIChannelMessage)) {
+			const MIDIChannelMessage *message = [event.data bytes];
+			MIKMIDIOfflineRendererEvent channelEvent = {[self sampleTimeForBeats:event.timeStamp + trackOffset], message->status, message->data1, message->data2};
+			part->events[part->eventCount++] = channelEvent;
+		}
+	}
+	qsort(part->events, part->eventCount, sizeof(MIKMIDIOfflineRendererEvent), MIKMIDIOfflineRendererCompareEvents);
+
+	part->bufferList = MIKMIDIOfflineRendererCreateBufferList(part->samples, self.framesPerBlock);
+	if (!part->bufferList) {
+		*error = [NSError errorWithDomain:NSPOSIXErrorDomain code:ENOMEM userInfo:nil];
+		return NO;
+	}
+
+	AudioComponentDescription componentDescription = self.componentDescription;
+	AudioComponent component = AudioComponentFindNext(NULL, &componentDescription);
+	if (!component) {
+		NSLog(@"Unable to find the instrument audio unit in %s.", __PRETTY_FUNCTION__);
+		*error = [NSError MIKMIDIErrorWithCode:MIKMIDIUnknownErrorCode userInfo:nil];
+		return NO;
+	}
+	OSStatus err = AudioComponentInstanceNew(component, &part->instrument);
+	if (err) {
+		NSLog(@"AudioComponentInstanceNew() failed with error %d in %s.", (int)err, __PRETTY_FUNCTION__);
+		*error = [NSError errorWithDomain:NSOSStatusErrorDomain code:err userInfo:nil];
+		return NO;
+	}
+
+	UInt32 offlineRender = 1;
+	UInt32 framesPerBlock = self.framesPerBlock;
+	AudioStreamBasicDescription format = MIKMIDIOfflineRendererFloatFormat(self.sampleRate);
+	if ((err = AudioUnitSetProperty(part->instrument, kAudioUnitProperty_OfflineRender, kAudioUnitScope_Global, 0, &offlineRender, sizeof(offlineRender)))) {
+		// Not every instrument knows the property; it renders the same either way.
+		NSLog(@"AudioUnitSetProperty() (Offline Render) failed with error %d in %s.", (int)err, __PRETTY_FUNCTION__);
+	}
+	if ((err = AudioUnitSetProperty(part->instrument, kAudioUnitProperty_MaximumFramesPerSlice, kAudioUnitScope_Global, 0, &framesPerBlock, sizeof(framesPerBlock))) ||
+		(err = AudioUnitSetProperty(part->instrument, kAudioUnitProperty_StreamFormat, kAudioUnitScope_Output, 0, &format, sizeof(format)))) {
+		NSLog(@"AudioUnitSetProperty() failed with error %d in %s.", (int)err, __PRETTY_FUNCTION__);
+		*error = [NSError errorWithDomain:NSOSStatusErrorDomain code:err userInfo:nil];
+		return NO;
+	}
+	if ((err = AudioUnitInitialize(part->instrument))) {
+		NSLog(@"AudioUnitInitialize() failed with error %d in %s.", (int)err, __PRETTY_FUNCTION__);
+		*error = [NSError errorWithDomain:NSOSStatusErrorDomain code:err userInfo:nil];
+		return NO;
+	}
+	return YES;
+}
+
+- (void)disposePart:(MIKMIDIOfflineRendererPart *)part
+{
+	if (part->instrument) {
+		AudioUnitUninitialize(part->instrument);
+		AudioComponentInstanceDispose(part->instrument);
+		part->instrument = NULL;
+	}
+	if (part->bufferList) {
+		MIKMIDIOfflineRendererDisposeBufferList(part->bufferList, part->samples);
+		part->bufferList = NULL;
+	}
+	free(part->events);
+	part->events = NULL;
+}
+
+- (Float64)sampleTimeForBeats:(MusicTimeStamp)beats
+{
+	Float64 seconds = 0;
+	OSStatus err = MusicSequenceGetSecondsForBeats(self.sequence.musicSequence, beats, &seconds);
+	if (err) NSLog(@"MusicSequenceGetSecondsForBeats() failed with error %d in %s.", (int)err, __PRETTY_FUNCTION__);
+	return seconds * self.sampleRate;
+}
+
++ (AudioComponentDescription)appleSynthComponentDescription
+{
+	AudioComponentDescription instrumentcd = (AudioComponentDescription){0};
+	instrumentcd.componentManufacturer = kAudioUnitManufacturer_Apple;
+	instrumentcd.componentType = kAudioUnitType_MusicDevice;
+#if TARGET_OS_IPHONE
+	instrumentcd.componentSubType = kAudioUnitSubType_Sampler;
+#else
+	instrumentcd.componentSubType = kAudioUnitSubType_DLSSynth;
+#endif
+	return instrumentcd;
+}
+
+@end
@@ -78,11 +78,29 @@
  */
 @property (nonatomic, getter=isLooping) BOOL looping;
 
+/**
+ *  Whether or not the metronome clicks along with playback.
+ *
+ *  Clicks are generated from the sequence's time signatures just ahead of the playback position
+ *  and sent to the metronome with their time stamps. The sequence itself is never modified.
+ */
 @property (nonatomic, getter=isClickTrackEnabled) BOOL clickTrackEnabled;
+
+/**
+ *  The metronome that plays the clicks.
+ */
 @property (strong, nonatomic) MIKMIDIMetronome *metronome;
 
+/**
+ *  Whether or not playback stops once the playback position passes the end of the sequence
+ *  plus tailDuration. Ignored while looping. The default is YES.
+ */
 @property (nonatomic) BOOL stopPlaybackAtEndOfSequence;
 
+/**
+ *  The time stamp after which no clicks are played when stopPlaybackAtEndOfSequence is NO
+ *  and the player is not looping. The default is 480.
+ */
 @property (nonatomic) MusicTimeStamp maxClickTrackTimeStamp;
 
 @end
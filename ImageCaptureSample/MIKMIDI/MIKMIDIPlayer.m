@@ -12,6 +12,13 @@
 #import "MIKMIDIMetronome.h"
 #import "MIKMIDINoteEvent.h"
 #import "MIKMIDIClientDestinationEndpoint.h"
+#import "MIKMIDIMetaTimeSignatureEvent.h"
+#import "MIKMIDINoteOnCommand.h"
+#import "MIKMIDINoteOffCommand.h"
+#import "MIKMIDIDeviceManager.h"
+#import "MIKMIDIClock.h"
+#import "MIKMIDIUtilities.h"
+#import "MIKMIDIPlayerCore.h"
 
 #if !__has_feature(objc_arc)
 #error MIKMIDIPlayer.m must be compiled with ARC. Either turn on ARC for the project or set the -fobjc-arc flag for MIKMIDIMappingManager.m in the Build Phases for this target
@@ -24,12 +31,34 @@
 
 @property (strong, nonatomic) NSNumber *lastStoppedAtTimeStampNumber;
 
-@property (strong, nonatomic) NSDate *lastPlaybackStartedTime;
-
-@property (strong, nonatomic) MIKMIDIPlayer *clickPlayer;
-@property (nonatomic) BOOL isClickPlayer;
+@property (strong, nonatomic) NSTimer *processingTimer;
+@property (nonatomic) MusicTimeStamp nextClickTimeStamp;
+@property (strong, nonatomic) NSData *timeSignatureChanges;
 @property (strong, nonatomic) MIKMIDIClientDestinationEndpoint *metronomeEndpoint;
 
+- (void)processingTimerFired:(NSTimer *)timer;
+
+@end
+
+
+/**
+ *  Forwards the processing timer to a player it does not retain.
+ */
+@interface MIKMIDIPlayerTimerTarget : NSObject
+
+@property (weak, nonatomic) MIKMIDIPlayer *player;
+
+@end
+
+@implementation MIKMIDIPlayerTimerTarget
+
+- (void)processingTimerFired:(NSTimer *)timer
+{
+	MIKMIDIPlayer *player = self.player;
+	if (!player) return [timer invalidate];
+	[player processingTimerFired:timer];
+}
+
 @end
 
 
@@ -80,37 +109,30 @@
     if (self.isPlaying) [self stopPlayback];
 
     [self loopTracksWhenNeeded];
-	[self addClickTrackWhenNeededFromTimeStamp:position];
 
     OSStatus err = MusicPlayerSetTime(self.musicPlayer, position);
     if (err) return NSLog(@"MusicPlayerSetTime() failed with error %d in %s.", (int)err, __PRETTY_FUNCTION__);
 
-    Float64 sequenceDuration = self.sequence.durationInSeconds;
-    Float64 positionInTime;
-
-    err = MusicSequenceGetSecondsForBeats(self.sequence.musicSequence, position, &positionInTime);
-    if (err) return NSLog(@"MusicSequenceGetSecondsForBeats() failed with error %d in %s.", (int)err, __PRETTY_FUNCTION__);
-
     err = MusicPlayerStart(self.musicPlayer);
     if (err) return NSLog(@"MusicPlayerStart() failed with error %d in %s.", (int)err, __PRETTY_FUNCTION__);
-	[self.clickPlayer startPlaybackFromPosition:position];
 
     self.isPlaying = YES;
-    NSDate *startTime = [NSDate date];
-    self.lastPlaybackStartedTime = startTime;
-
-	if (self.stopPlaybackAtEndOfSequence) {
-		Float64 playbackDuration = (sequenceDuration - positionInTime) + self.tailDuration;
-		if (playbackDuration <= 0) return;
-
-		dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(playbackDuration * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
-			if ([startTime isEqualToDate:self.lastPlaybackStartedTime]) {
-				if (!self.isLooping) {
-					[self stopPlayback];
-				}
-			}
-		});
-	}
+
+	// Clicks are generated just ahead of the player's position instead of being written into the sequence,
+	// and the same position tells when playback has reached the end.
+	self.nextClickTimeStamp = position;
+	self.timeSignatureChanges = [self timeSignatureChangesOfSequence:self.sequence];
+	// The timer retains its target, so it fires through one that holds the player weakly and the player
+	// can still be deallocated while playing. It runs in the common modes so that clicks go on during scrolling.
+	MIKMIDIPlayerTimerTarget *timerTarget = [[MIKMIDIPlayerTimerTarget alloc] init];
+	timerTarget.player = self;
+	self.processingTimer = [NSTimer timerWithTimeInterval:0.05
+												   target:timerTarget
+												 selector:@selector(processingTimerFired:)
+												 userInfo:nil
+												  repeats:YES];
+	[[NSRunLoop currentRunLoop] addTimer:self.processingTimer forMode:NSRunLoopCommonModes];
+	[self.processingTimer fire];
 }
 
 - (void)resumePlayback
@@ -144,8 +166,8 @@
 
     [self unloopTracks];
 
-	[self.clickPlayer stopPlayback];
-	self.clickPlayer = nil;
+	self.processingTimer = nil;
+	self.timeSignatureChanges = nil;
     self.isPlaying = NO;
 }
 
@@ -176,44 +198,103 @@
 
 #pragma mark - Click Track
 
-- (void)addClickTrackWhenNeededFromTimeStamp:(MusicTimeStamp)fromTimeStamp
+- (void)processingTimerFired:(NSTimer *)timer
 {
-	if (self.isClickPlayer) return;
-	if (!self.isClickTrackEnabled) return;
-
-	self.clickPlayer = [[MIKMIDIPlayer alloc] init];
-	self.clickPlayer->_isClickPlayer = YES;
-	MIKMIDISequence *clickSequence = [MIKMIDISequence sequence];
-	[clickSequence.tempoTrack insertMIDIEvents:[NSSet setWithArray:self.sequence.tempoEvents]];
-	[clickSequence.tempoTrack insertMIDIEvents:[NSSet setWithArray:self.sequence.timeSignatureEvents]];
-	self.clickPlayer.sequence = clickSequence;
-	MIKMIDITrack *clickTrack = [clickSequence addTrack];
-
-	OSStatus err = MusicTrackSetDestMIDIEndpoint(clickTrack.musicTrack, (MIDIEndpointRef)self.metronomeEndpoint.objectRef);
-	if (err) {
-		NSLog(@"MusicTrackGetProperty() failed with error %d in %s.", (int)err, __PRETTY_FUNCTION__);
-		return;
+	MusicTimeStamp position = self.currentTimeStamp;
+
+	if (self.isClickTrackEnabled) {
+		// Clicks the timer was too late for are skipped rather than all sent at once.
+		if (self.nextClickTimeStamp < position) self.nextClickTimeStamp = position;
+		MusicTimeStamp lookaheadTimeStamp = position;
+		MIDITimeStamp lookaheadMIDITimeStamp = MIKMIDIGetCurrentTimeStamp() + [MIKMIDIClock midiTimeStampsPerTimeInterval:0.1];
+		OSStatus err = MusicPlayerGetBeatsForHostTime(self.musicPlayer, lookaheadMIDITimeStamp, &lookaheadTimeStamp);
+		if (err) NSLog(@"MusicPlayerGetBeatsForHostTime() failed with error %d in %s.", (int)err, __PRETTY_FUNCTION__);
+		[self scheduleClicksUpToTimeStamp:MAX(lookaheadTimeStamp, position)];
 	}
-	MusicTimeStamp toTimeStamp = self.stopPlaybackAtEndOfSequence ? self.sequence.length : self.maxClickTrackTimeStamp;
 
-	NSMutableSet *clickEvents = [NSMutableSet set];
+	if (self.stopPlaybackAtEndOfSequence && !self.isLooping) {
+		Float64 positionInTime = 0;
+		OSStatus err = MusicSequenceGetSecondsForBeats(self.sequence.musicSequence, position, &positionInTime);
+		if (err) return NSLog(@"MusicSequenceGetSecondsForBeats() failed with error %d in %s.", (int)err, __PRETTY_FUNCTION__);
+		if (positionInTime >= self.sequence.durationInSeconds + self.tailDuration) [self stopPlayback];
+	}
+}
+
+- (void)scheduleClicksUpToTimeStamp:(MusicTimeStamp)toTimeStamp
+{
+	MusicTimeStamp maxTimeStamp = self.isLooping ? toTimeStamp : (self.stopPlaybackAtEndOfSequence ? self.sequence.length : self.maxClickTrackTimeStamp);
+	NSArray *clickEvents = [self clickEventsFromTimeStamp:self.nextClickTimeStamp toTimeStamp:MIN(toTimeStamp, maxTimeStamp)];
+	if (![clickEvents count]) return;
+
+	NSMutableArray *commands = [NSMutableArray array];
+	for (MIKMIDINoteEvent *clickEvent in clickEvents) {
+		MIDITimeStamp onTimeStamp = 0;
+		MIDITimeStamp offTimeStamp = 0;
+		OSStatus err = MusicPlayerGetHostTimeForBeats(self.musicPlayer, clickEvent.timeStamp, &onTimeStamp);
+		if (!err) err = MusicPlayerGetHostTimeForBeats(self.musicPlayer, clickEvent.endTimeStamp, &offTimeStamp);
+		if (err) {
+			NSLog(@"MusicPlayerGetHostTimeForBeats() failed with error %d in %s.", (int)err, __PRETTY_FUNCTION__);
+			continue;
+		}
+
+		MIKMutableMIDINoteOnCommand *noteOn = [MIKMutableMIDINoteOnCommand commandForCommandType:MIKMIDICommandTypeNoteOn];
+		noteOn.midiTimestamp = onTimeStamp;
+		noteOn.channel = clickEvent.channel;
+		noteOn.note = clickEvent.note;
+		noteOn.velocity = clickEvent.velocity;
+		[commands addObject:noteOn];
+
+		MIKMutableMIDINoteOffCommand *noteOff = [MIKMutableMIDINoteOffCommand commandForCommandType:MIKMIDICommandTypeNoteOff];
+		noteOff.midiTimestamp = offTimeStamp;
+		noteOff.channel = clickEvent.channel;
+		noteOff.note = clickEvent.note;
+		noteOff.velocity = clickEvent.releaseVelocity;
+		[commands addObject:noteOff];
+	}
+
+	NSError *error;
+	if (commands.count && ![[MIKMIDIDeviceManager sharedDeviceManager] sendCommands:commands toEndpoint:self.metronomeEndpoint error:&error]) {
+		NSLog(@"%@: An error occurred scheduling the click commands %@. %@", NSStringFromClass([self class]), commands, error);
+	}
+}
+
+/**
+ *  Returns the clicks from the next click at or after fromTimeStamp up to, but not including, toTimeStamp,
+ *  and remembers where the next call should continue.
+ */
+- (NSArray *)clickEventsFromTimeStamp:(MusicTimeStamp)fromTimeStamp toTimeStamp:(MusicTimeStamp)toTimeStamp
+{
+	NSMutableArray *clickEvents = [NSMutableArray array];
 	MIDINoteMessage tickMessage = self.metronome.tickMessage;
 	MIDINoteMessage tockMessage = self.metronome.tockMessage;
-	MusicTimeStamp increment = 1;
-	for (MusicTimeStamp clickTimeStamp = floor(fromTimeStamp); clickTimeStamp <= toTimeStamp; clickTimeStamp += increment) {
-		MIKMIDITimeSignature timeSignature;
-		if (![clickSequence getTimeSignature:&timeSignature atTimeStamp:clickTimeStamp]) continue;
-		if (!timeSignature.numerator || !timeSignature.denominator) continue;
-
-		NSInteger adjustedTimeStamp = clickTimeStamp * timeSignature.denominator / 4.0;
-		BOOL isTick = !((adjustedTimeStamp + timeSignature.numerator) % (timeSignature.numerator));
-		increment = 4.0 / timeSignature.denominator;
-
-		MIDINoteMessage clickMessage = isTick ? tickMessage : tockMessage;
-		[clickEvents addObject:[MIKMIDINoteEvent noteEventWithTimeStamp:clickTimeStamp message:clickMessage]];
-	}
+	const MIKMIDIPlayerTimeSignatureChange *changes = self.timeSignatureChanges.bytes;
+	size_t changeCount = self.timeSignatureChanges.length / sizeof(MIKMIDIPlayerTimeSignatureChange);
+
+	MIKMIDIPlayerClick clicks[64];
+	size_t clickCount;
+	do {
+		clickCount = MIKMIDIPlayerPlaceClicks(changes, changeCount, self.sequence.length, self.isLooping, &fromTimeStamp, toTimeStamp, clicks, sizeof(clicks) / sizeof(clicks[0]));
+		for (size_t index = 0; index < clickCount; index++) {
+			MIDINoteMessage clickMessage = clicks[index].isTick ? tickMessage : tockMessage;
+			[clickEvents addObject:[MIKMIDINoteEvent noteEventWithTimeStamp:clicks[index].timeStamp message:clickMessage]];
+		}
+	} while (clickCount == sizeof(clicks) / sizeof(clicks[0]));
+
+	self.nextClickTimeStamp = fromTimeStamp;
+	return clickEvents;
+}
 
-	[clickTrack insertMIDIEvents:clickEvents];
+/**
+ *  Returns the time signature events of the sequence as MIKMIDIPlayerTimeSignatureChange structures.
+ */
+- (NSData *)timeSignatureChangesOfSequence:(MIKMIDISequence *)sequence
+{
+	NSMutableData *changes = [NSMutableData data];
+	for (MIKMIDIMetaTimeSignatureEvent *event in sequence.timeSignatureEvents) {
+		MIKMIDIPlayerTimeSignatureChange change = { .timeStamp = event.timeStamp, .numerator = event.numerator, .denominator = event.denominator };
+		[changes appendBytes:&change length:sizeof(change)];
+	}
+	return changes;
 }
 
 #pragma mark - Properties
@@ -244,6 +325,14 @@
     }
 }
 
+- (void)setProcessingTimer:(NSTimer *)processingTimer
+{
+	if (processingTimer != _processingTimer) {
+		[_processingTimer invalidate];
+		_processingTimer = processingTimer;
+	}
+}
+
 - (MusicTimeStamp)currentTimeStamp
 {
     MusicTimeStamp position = 0;
@@ -0,0 +1,92 @@
+//
+//  MIKMIDIPlayerCore.h
+//  MIKMIDI
+//
+
+#ifndef MIKMIDI_MIKMIDIPlayerCore_h
+#define MIKMIDI_MIKMIDIPlayerCore_h
+
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ *  The click placement of MIKMIDIPlayer in plain C, so that it can also be
+ *  built and checked off the device. Time stamps are in beats.
+ */
+
+typedef struct {
+	double timeStamp;
+	uint8_t numerator;
+	uint8_t denominator;
+} MIKMIDIPlayerTimeSignatureChange;
+
+typedef struct {
+	double timeStamp;
+	bool isTick;
+} MIKMIDIPlayerClick;
+
+/**
+ *  Places the clicks from the next click at or after *fromTimeStamp up to, but not including,
+ *  toTimeStamp, and sets *fromTimeStamp to where the next call should continue.
+ *
+ *  Clicks fall on every beat of the time signature in effect, counted from the time signature
+ *  change, so a change in the middle of a bar starts a new bar with a tick. Changes must be in
+ *  time stamp order; ones with a zero numerator or denominator are ignored, and 4/4 applies
+ *  before the first. When looping, the time stamps keep growing across loops of length beats
+ *  while the time signatures are looked up within the sequence.
+ *
+ *  @return The number of clicks placed, at most maxClickCount. When there are more, *fromTimeStamp
+ *  is left at the first one not placed.
+ */
+static inline size_t MIKMIDIPlayerPlaceClicks(const MIKMIDIPlayerTimeSignatureChange *changes, size_t changeCount, double length, bool isLooping, double *fromTimeStamp, double toTimeStamp, MIKMIDIPlayerClick *clicks, size_t maxClickCount)
+{
+	const double tolerance = 1e-6;
+	isLooping = isLooping && length > 0;
+	size_t clickCount = 0;
+	double clickTimeStamp = *fromTimeStamp;
+	while (clickTimeStamp < toTimeStamp && clickCount < maxClickCount) {
+		double loopOffset = isLooping ? floor(clickTimeStamp / length + tolerance) * length : 0;
+		double sequenceTimeStamp = fmax(clickTimeStamp - loopOffset, 0);
+
+		uint8_t numerator = 4;
+		uint8_t denominator = 4;
+		double signatureTimeStamp = 0;
+		double nextSignatureTimeStamp = isLooping ? length : DBL_MAX;
+		for (size_t index = 0; index < changeCount; index++) {
+			const MIKMIDIPlayerTimeSignatureChange *change = &changes[index];
+			if (change->timeStamp > sequenceTimeStamp + tolerance) {
+				nextSignatureTimeStamp = fmin(nextSignatureTimeStamp, change->timeStamp);
+				break;
+			}
+			if (change->numerator && change->denominator) {
+				numerator = change->numerator;
+				denominator = change->denominator;
+				signatureTimeStamp = change->timeStamp;
+			}
+		}
+
+		double increment = 4.0 / denominator;
+		double beat = ceil((sequenceTimeStamp - signatureTimeStamp) / increment - tolerance);
+		double beatTimeStamp = signatureTimeStamp + beat * increment;
+		if (beatTimeStamp >= nextSignatureTimeStamp - tolerance) {
+			// The next time signature, or the next loop, starts before this beat.
+			clickTimeStamp = loopOffset + nextSignatureTimeStamp;
+			continue;
+		}
+
+		clickTimeStamp = loopOffset + beatTimeStamp;
+		if (clickTimeStamp >= toTimeStamp) break;
+
+		clicks[clickCount].timeStamp = clickTimeStamp;
+		clicks[clickCount].isTick = fmod(beat, numerator) == 0;
+		clickCount++;
+		clickTimeStamp = fmin(clickTimeStamp + increment, loopOffset + nextSignatureTimeStamp);
+	}
+	*fromTimeStamp = clickTimeStamp;
+	return clickCount;
+}
+
+#endif
@@ -0,0 +1,73 @@
+//
+//  MIKMIDISystemExclusiveAssembler.h
+//  MIKMIDI
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreMIDI/CoreMIDI.h>
+
+/**
+ *  Block called with the data of a system exclusive message as it arrives.
+ *
+ *  @param chunk  The next bytes of the message. The first chunk starts with 0xF0 and the last one ends with 0xF7.
+ *  A nil chunk means the message in progress was cancelled or grew too long, and its earlier chunks should be thrown away.
+ *  @param isLast YES if this is the last chunk of the message.
+ */
+typedef void(^MIKMIDISystemExclusiveChunkHandler)(NSData *chunk, BOOL isLast);
+
+/**
+ *  MIKMIDISystemExclusiveAssembler puts back together the system exclusive messages of one source,
+ *  which CoreMIDI delivers split across as many MIDIPackets as it takes.
+ *
+ *  The bytes of a message are appended into a list of fixed size chunks, so earlier bytes
+ *  are never moved as a large dump grows. Realtime messages interleaved with the message's data
+ *  are pulled out and returned in the order they arrived. As the MIDI spec requires, any other
+ *  status byte cancels the message in progress.
+ *
+ *  By default, a completed message is returned as an MIKMIDISystemExclusiveCommand that adopts
+ *  the assembled bytes. If a chunkHandler is set, the data is instead handed out chunk by chunk
+ *  as it arrives and is not kept by the assembler.
+ *
+ *  MIKMIDIInputPort keeps one assembler per connected source. This class is not thread safe.
+ */
+@interface MIKMIDISystemExclusiveAssembler : NSObject
+
+/**
+ *  Processes the next packet from the source.
+ *
+ *  @param packet A MIDIPacket received from the source.
+ *
+ *  @return An array of the MIKMIDICommands the packet contains or completes, or nil if
+ *  the packet has no part in a system exclusive message and should be parsed as usual.
+ */
+- (NSArray *)commandsByAppendingMIDIPacket:(const MIDIPacket *)packet;
+
+/**
+ *  Drops the message in progress, if any.
+ */
+- (void)reset;
+
+/**
+ *  Whether a message has been started but not yet ended.
+ */
+@property (nonatomic, readonly, getter = isAssembling) BOOL assembling;
+
+/**
+ *  The largest message, including its delimiters, that is assembled. Longer messages are
+ *  dropped, and the rest of their bytes are skipped. The limit does not apply when chunks are
+ *  handed out through chunkHandler. Default is 1 MB.
+ */
+@property (nonatomic) NSUInteger maximumLength;
+
+/**
+ *  If set, messages are handed out chunk by chunk instead of being returned as commands.
+ *  Called synchronously from -commandsByAppendingMIDIPacket:.
+ */
+@property (nonatomic, copy) MIKMIDISystemExclusiveChunkHandler chunkHandler;
+
+/**
+ *  The number of messages that were cancelled or dropped for being too long.
+ */
+@property (nonatomic, readonly) NSUInteger discardedMessageCount;
+
+@end
@@ -0,0 +1,178 @@
+//
+//  MIKMIDISystemExclusiveAssembler.m
+//  MIKMIDI
+//
+
+#import "MIKMIDISystemExclusiveAssembler.h"
+#import "MIKMIDICommand_SubclassMethods.h"
+#import "MIKMIDISystemExclusiveCommand.h"
+#import "MIKMIDISystemExclusiveAssemblerCore.h"
+
+#if !__has_feature(objc_arc)
+#error MIKMIDISystemExclusiveAssembler.m must be compiled with ARC. Either turn on ARC for the project or set the -fobjc-arc flag for MIKMIDISystemExclusiveAssembler.m in the Build Phases for this target
+#endif
+
+#define kMIKMIDISysexChunkLength 4096
+
+/**
+ *  The packet being parsed, for the callbacks of the state machine.
+ */
+typedef struct {
+	__unsafe_unretained MIKMIDISystemExclusiveAssembler *assembler;
+	__unsafe_unretained NSMutableArray *result;
+	MIDITimeStamp timestamp;
+} MIKMIDISystemExclusiveAssemblerPacket;
+
+@interface MIKMIDISystemExclusiveAssembler ()
+
+@property (nonatomic, strong) NSMutableArray *chunks;
+@property (nonatomic) MIDITimeStamp startTimestamp;
+
+- (void)appendBytes:(const Byte *)bytes length:(NSUInteger)length;
+- (MIKMIDICommand *)finishMessage;
+- (void)cancelMessage;
+
+@end
+
+static void MIKMIDISystemExclusiveAssemblerOrdinaryBytes(void *context, const uint8_t *bytes, size_t length)
+{
+	MIKMIDISystemExclusiveAssemblerPacket *packet = context;
+	[packet->result addObjectsFromArray:[MIKMIDICommand commandsWithBytes:bytes length:length timestamp:packet->timestamp]];
+}
+
+static void MIKMIDISystemExclusiveAssemblerRealtimeByte(void *context, uint8_t status)
+{
+	MIKMIDISystemExclusiveAssemblerPacket *packet = context;
+	[packet->result addObjectsFromArray:[MIKMIDICommand commandsWithBytes:&status length:1 timestamp:packet->timestamp]];
+}
+
+static void MIKMIDISystemExclusiveAssemblerBeginMessage(void *context)
+{
+	MIKMIDISystemExclusiveAssemblerPacket *packet = context;
+	packet->assembler.startTimestamp = packet->timestamp;
+	[packet->assembler.chunks removeAllObjects];
+}
+
+static void MIKMIDISystemExclusiveAssemblerMessageBytes(void *context, const uint8_t *bytes, size_t length)
+{
+	MIKMIDISystemExclusiveAssemblerPacket *packet = context;
+	[packet->assembler appendBytes:bytes length:length];
+}
+
+static void MIKMIDISystemExclusiveAssemblerFinishMessage(void *context)
+{
+	MIKMIDISystemExclusiveAssemblerPacket *packet = context;
+	MIKMIDICommand *command = [packet->assembler finishMessage];
+	if (command) [packet->result addObject:command];
+}
+
+static void MIKMIDISystemExclusiveAssemblerCancelMessage(void *context)
+{
+	MIKMIDISystemExclusiveAssemblerPacket *packet = context;
+	[packet->assembler cancelMessage];
+}
+
+static const MIKMIDISystemExclusiveAssemblerCallbacks MIKMIDISystemExclusiveAssemblerPacketCallbacks = {
+	MIKMIDISystemExclusiveAssemblerOrdinaryBytes,
+	MIKMIDISystemExclusiveAssemblerRealtimeByte,
+	MIKMIDISystemExclusiveAssemblerBeginMessage,
+	MIKMIDISystemExclusiveAssemblerMessageBytes,
+	MIKMIDISystemExclusiveAssemblerFinishMessage,
+	MIKMIDISystemExclusiveAssemblerCancelMessage,
+};
+
+@implementation MIKMIDISystemExclusiveAssembler
+{
+	MIKMIDISystemExclusiveAssemblerParser _parser;
+}
+
+- (id)init
+{
+	self = [super init];
+	if (self) {
+		_maximumLength = 1024 * 1024;
+		_chunks = [[NSMutableArray alloc] init];
+		MIKMIDISystemExclusiveAssemblerInit(&_parser, _maximumLength);
+	}
+	return self;
+}
+
+#pragma mark - Public
+
+- (NSArray *)commandsByAppendingMIDIPacket:(const MIDIPacket *)packet
+{
+	// The limit does not apply when chunks are handed out.
+	_parser.maximumLength = self.chunkHandler ? SIZE_MAX : self.maximumLength;
+	NSMutableArray *result = [NSMutableArray array];
+	MIKMIDISystemExclusiveAssemblerPacket context = {self, result, packet->timeStamp};
+	if (!MIKMIDISystemExclusiveAssemblerParse(&_parser, packet->data, packet->length, &MIKMIDISystemExclusiveAssemblerPacketCallbacks, &context)) {
+		return nil;
+	}
+	return result;
+}
+
+- (void)reset
+{
+	MIKMIDISystemExclusiveAssemblerPacket context = {self, nil, 0};
+	MIKMIDISystemExclusiveAssemblerCancel(&_parser, &MIKMIDISystemExclusiveAssemblerPacketCallbacks, &context);
+}
+
+#pragma mark - Private
+
+- (void)appendBytes:(const Byte *)bytes length:(NSUInteger)length
+{
+	while (length > 0) {
+		NSMutableData *chunk = [self.chunks lastObject];
+		if (!chunk || [chunk length] == kMIKMIDISysexChunkLength) {
+			if (chunk && self.chunkHandler) {
+				self.chunkHandler(chunk, NO);
+				[self.chunks removeAllObjects];
+			}
+			chunk = [NSMutableData dataWithCapacity:kMIKMIDISysexChunkLength];
+			[self.chunks addObject:chunk];
+		}
+		NSUInteger count = MIN(length, kMIKMIDISysexChunkLength - [chunk length]);
+		[chunk appendBytes:bytes length:count];
+		bytes += count;
+		length -= count;
+	}
+}
+
+- (MIKMIDICommand *)finishMessage
+{
+	if (self.chunkHandler) {
+		self.chunkHandler([self.chunks lastObject], YES);
+		[self.chunks removeAllObjects];
+		return nil;
+	}
+
+	// A message that fits in one chunk is adopted as is; a longer one is joined once, into a buffer of exactly its length.
+	NSMutableData *messageData = [self.chunks firstObject];
+	if ([self.chunks count] > 1) {
+		messageData = [NSMutableData dataWithCapacity:_parser.length];
+		for (NSData *chunk in self.chunks) [messageData appendData:chunk];
+	}
+	[self.chunks removeAllObjects];
+
+	MIKMIDISystemExclusiveCommand *command = [[MIKMIDISystemExclusiveCommand alloc] init];
+	command.midiTimestamp = self.startTimestamp;
+	command.internalData = messageData;
+	return command;
+}
+
+/**
+ *  Throws away the chunks of a message the state machine cancelled.
+ */
+- (void)cancelMessage
+{
+	if (self.chunkHandler) self.chunkHandler(nil, YES);
+	[self.chunks removeAllObjects];
+}
+
+#pragma mark - Properties
+
+- (BOOL)isAssembling { return _parser.state == MIKMIDISystemExclusiveAssemblerStateAssembling; }
+
+- (NSUInteger)discardedMessageCount { return _parser.discardedMessageCount; }
+
+@end
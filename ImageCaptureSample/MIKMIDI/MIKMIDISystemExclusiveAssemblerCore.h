@@ -0,0 +1,142 @@
+//
+//  MIKMIDISystemExclusiveAssemblerCore.h
+//  MIKMIDI
+//
+
+#ifndef MIKMIDI_MIKMIDISystemExclusiveAssemblerCore_h
+#define MIKMIDI_MIKMIDISystemExclusiveAssemblerCore_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ *  The byte state machine of MIKMIDISystemExclusiveAssembler in plain C, so that it can
+ *  also be built, checked and measured off the device. Where the bytes go is left to callbacks.
+ */
+
+#define MIKMIDISystemExclusiveAssemblerStartDelimiter 0xF0
+#define MIKMIDISystemExclusiveAssemblerEndDelimiter 0xF7
+#define MIKMIDISystemExclusiveAssemblerFirstRealtimeStatus 0xF8
+
+typedef enum {
+	MIKMIDISystemExclusiveAssemblerStateIdle,
+	MIKMIDISystemExclusiveAssemblerStateAssembling,
+	MIKMIDISystemExclusiveAssemblerStateSkipping, // Dropping the rest of a message that grew too long
+} MIKMIDISystemExclusiveAssemblerState;
+
+typedef struct {
+	/** Bytes outside of a message, to be parsed as ordinary messages. */
+	void (*ordinaryBytes)(void *context, const uint8_t *bytes, size_t length);
+	/** A realtime message interleaved with the data of a message. */
+	void (*realtimeByte)(void *context, uint8_t status);
+	/** A message started; its start delimiter follows through messageBytes. */
+	void (*beginMessage)(void *context);
+	/** The next bytes of the message, including its delimiters. */
+	void (*messageBytes)(void *context, const uint8_t *bytes, size_t length);
+	/** The message ended with its end delimiter. */
+	void (*finishMessage)(void *context);
+	/** The message in progress was cancelled or grew too long. */
+	void (*cancelMessage)(void *context);
+} MIKMIDISystemExclusiveAssemblerCallbacks;
+
+typedef struct {
+	MIKMIDISystemExclusiveAssemblerState state;
+	/** The length of the message in progress, including its start delimiter. */
+	size_t length;
+	/** The largest message, including its delimiters, that is assembled; SIZE_MAX for no limit. */
+	size_t maximumLength;
+	/** The number of messages that were cancelled or dropped for being too long. */
+	size_t discardedMessageCount;
+} MIKMIDISystemExclusiveAssemblerParser;
+
+static inline void MIKMIDISystemExclusiveAssemblerInit(MIKMIDISystemExclusiveAssemblerParser *parser, size_t maximumLength)
+{
+	*parser = (MIKMIDISystemExclusiveAssemblerParser){0};
+	parser->maximumLength = maximumLength;
+}
+
+/**
+ *  Drops the message in progress, if any.
+ */
+static inline void MIKMIDISystemExclusiveAssemblerCancel(MIKMIDISystemExclusiveAssemblerParser *parser, const MIKMIDISystemExclusiveAssemblerCallbacks *callbacks, void *context)
+{
+	if (parser->state == MIKMIDISystemExclusiveAssemblerStateAssembling) {
+		parser->discardedMessageCount++;
+		callbacks->cancelMessage(context);
+	}
+	parser->length = 0;
+	parser->state = MIKMIDISystemExclusiveAssemblerStateIdle;
+}
+
+static inline void MIKMIDISystemExclusiveAssemblerAppend(MIKMIDISystemExclusiveAssemblerParser *parser, const uint8_t *bytes, size_t length, const MIKMIDISystemExclusiveAssemblerCallbacks *callbacks, void *context)
+{
+	if (parser->state != MIKMIDISystemExclusiveAssemblerStateAssembling) return;
+	if (parser->length > parser->maximumLength || length > parser->maximumLength - parser->length) {
+		MIKMIDISystemExclusiveAssemblerCancel(parser, callbacks, context);
+		parser->state = MIKMIDISystemExclusiveAssemblerStateSkipping;
+		return;
+	}
+	parser->length += length;
+	callbacks->messageBytes(context, bytes, length);
+}
+
+/**
+ *  Runs the bytes of a packet through the state machine.
+ *
+ *  Realtime messages inside a message are pulled out, and as the MIDI spec requires, any
+ *  other status byte cancels the message in progress and is then parsed as usual.
+ *
+ *  @return false if the packet has no part in a system exclusive message; no callback was made
+ *  and the packet should be parsed as usual.
+ */
+static inline bool MIKMIDISystemExclusiveAssemblerParse(MIKMIDISystemExclusiveAssemblerParser *parser, const uint8_t *bytes, size_t length, const MIKMIDISystemExclusiveAssemblerCallbacks *callbacks, void *context)
+{
+	if (parser->state == MIKMIDISystemExclusiveAssemblerStateIdle &&
+		!memchr(bytes, MIKMIDISystemExclusiveAssemblerStartDelimiter, length)) {
+		return false;
+	}
+
+	size_t index = 0;
+	while (index < length) {
+		if (parser->state == MIKMIDISystemExclusiveAssemblerStateIdle) {
+			// Ordinary messages before the start of a message or after the end of one
+			const uint8_t *start = memchr(bytes + index, MIKMIDISystemExclusiveAssemblerStartDelimiter, length - index);
+			size_t startIndex = start ? (size_t)(start - bytes) : length;
+			if (startIndex > index) callbacks->ordinaryBytes(context, bytes + index, startIndex - index);
+			if (!start) break;
+			parser->state = MIKMIDISystemExclusiveAssemblerStateAssembling;
+			parser->length = 0;
+			callbacks->beginMessage(context);
+			MIKMIDISystemExclusiveAssemblerAppend(parser, start, 1, callbacks, context);
+			index = startIndex + 1;
+			continue;
+		}
+
+		size_t runStart = index;
+		while (index < length && bytes[index] < 0x80) index++;
+		if (index > runStart) MIKMIDISystemExclusiveAssemblerAppend(parser, bytes + runStart, index - runStart, callbacks, context);
+		if (index == length) break;
+
+		uint8_t status = bytes[index];
+		if (status >= MIKMIDISystemExclusiveAssemblerFirstRealtimeStatus) {
+			// Realtime messages may appear anywhere, even in the middle of a system exclusive message
+			callbacks->realtimeByte(context, status);
+			index++;
+		} else if (status == MIKMIDISystemExclusiveAssemblerEndDelimiter) {
+			MIKMIDISystemExclusiveAssemblerAppend(parser, bytes + index, 1, callbacks, context);
+			// A message that was being skipped, or whose end delimiter went over the maximum length, just ends.
+			if (parser->state == MIKMIDISystemExclusiveAssemblerStateAssembling) callbacks->finishMessage(context);
+			parser->length = 0;
+			parser->state = MIKMIDISystemExclusiveAssemblerStateIdle;
+			index++;
+		} else {
+			// Any other status byte ends the message early. It is handled on the next pass.
+			MIKMIDISystemExclusiveAssemblerCancel(parser, callbacks, context);
+		}
+	}
+	return true;
+}
+
+#endif
@@ -60,19 +60,18 @@
 	return result;
 }
 
-- (id)initWithMIDIPacket:(MIDIPacket *)packet
+- (void)setInternalData:(NSMutableData *)internalData
 {
-    self = [super initWithMIDIPacket:packet];
-    if (self) {
-        if ([self.internalData length] > 1) {
-            UInt8 firstByte = self.dataByte1;
-            if (firstByte == 0) {
-                _has3ByteManufacturerID = YES;
-				if ([self.internalData length] < 4) [self.internalData increaseLengthBy:4-[self.internalData length]];
-            }
-        }
-    }
-    return self;
+	// Also set by MIKMIDISystemExclusiveAssembler, for messages assembled from several packets.
+	[super setInternalData:internalData];
+	_has3ByteManufacturerID = NO;
+	if ([self.internalData length] > 1) {
+		UInt8 firstByte = self.dataByte1;
+		if (firstByte == 0) {
+			_has3ByteManufacturerID = YES;
+			if ([self.internalData length] < 4) [self.internalData increaseLengthBy:4-[self.internalData length]];
+		}
+	}
 }
 
 - (UInt32)manufacturerID
@@ -139,7 +138,15 @@
 - (NSData *)sysexData
 {
 	NSUInteger sysexStartLocation = [self sysexDataStartLocation];
-	return [self.internalData subdataWithRange:NSMakeRange(sysexStartLocation, [self.internalData length]-sysexStartLocation-1)];
+	if ([self.internalData length] <= sysexStartLocation) return [NSData data];
+	NSRange sysexRange = NSMakeRange(sysexStartLocation, [self.internalData length]-sysexStartLocation-1);
+	if ([[self class] isMutable]) return [self.internalData subdataWithRange:sysexRange];
+	
+	// The bytes of an immutable command never change, so return a view onto them that keeps them alive instead of a copy.
+	NSMutableData *internalData = self.internalData;
+	return [[NSData alloc] initWithBytesNoCopy:(UInt8 *)[internalData mutableBytes] + sysexRange.location
+										length:sysexRange.length
+								   deallocator:^(void *bytes, NSUInteger length) { (void)internalData; }];
 }
 
 - (void)setSysexData:(NSData *)sysexData
@@ -0,0 +1,33 @@
+//
+//  MockCamera.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#if DEBUG
+
+#import <OLYCameraKit/OLYCamera.h>
+
+/**
+ * Stands in for a camera with configurable latencies, for measuring the app without hardware.
+ *
+ * The connection, run mode, property and still shooting commands succeed after
+ * the configured delays; the property commands block the caller like the real ones.
+ * There is no live view. Property changes made through it are not reported to
+ * the property delegate.
+ */
+@interface MockCamera : OLYCamera
+
+/** The time each property command takes. (default: 0.03) */
+@property (assign, nonatomic) NSTimeInterval propertyLatency;
+/** The time from taking a picture to the end of focusing. (default: 0.15) */
+@property (assign, nonatomic) NSTimeInterval focusLatency;
+/** The time from the end of focusing to the beginning of capturing. (default: 0.05) */
+@property (assign, nonatomic) NSTimeInterval captureLatency;
+/** The time from the beginning of capturing to the completion. (default: 0.3) */
+@property (assign, nonatomic) NSTimeInterval completionLatency;
+
+@end
+
+#endif
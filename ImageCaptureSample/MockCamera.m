@@ -0,0 +1,220 @@
+//
+//  MockCamera.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#if DEBUG
+
+#import "MockCamera.h"
+
+@interface MockCamera ()
+
+@property (assign, nonatomic) BOOL mockConnected;
+@property (assign, nonatomic) OLYCameraRunMode mockRunMode;
+@property (assign, nonatomic) OLYCameraLiveViewSize mockLiveViewSize;
+@property (assign, nonatomic) BOOL mockTakingPicture;
+@property (strong, nonatomic) NSMutableDictionary *propertyValues;
+
+@end
+
+@implementation MockCamera
+
+- (id)init
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	_propertyLatency = 0.03;
+	_focusLatency = 0.15;
+	_captureLatency = 0.05;
+	_completionLatency = 0.3;
+	_mockRunMode = OLYCameraRunModeUnknown;
+	_mockLiveViewSize = OLYCameraLiveViewSizeQVGA;
+	_propertyValues = [@{@"TAKEMODE": @"<TAKEMODE/P>",
+						 @"TAKE_DRIVE": @"<TAKE_DRIVE/DRIVE_NORMAL>",
+						 @"APERTURE": @"<APERTURE/5.6>",
+						 @"SHUTTER": @"<SHUTTER/250>",
+						 @"EXPREV": @"<EXPREV/0.0>",
+						 @"WB": @"<WB/WB_AUTO>",
+						 @"ISO": @"<ISO/Auto>",
+						 @"BATTERY_LEVEL": @"<BATTERY_LEVEL/FULL>",
+						 @"RECVIEW": @"<RECVIEW/ON>"} mutableCopy];
+	return self;
+}
+
+- (void)waitForLatency:(NSTimeInterval)latency
+{
+	if (latency > 0) {
+		[NSThread sleepForTimeInterval:latency];
+	}
+}
+
+#pragma mark - Connection
+
+- (BOOL)connected
+{
+	return self.mockConnected;
+}
+
+- (BOOL)connect:(NSError **)error
+{
+	[self waitForLatency:self.propertyLatency];
+	self.mockConnected = YES;
+	return YES;
+}
+
+- (BOOL)disconnectWithPowerOff:(BOOL)powerOff error:(NSError **)error
+{
+	self.mockConnected = NO;
+	self.mockRunMode = OLYCameraRunModeUnknown;
+	return YES;
+}
+
+#pragma mark - Camera system
+
+- (OLYCameraRunMode)runMode
+{
+	return self.mockRunMode;
+}
+
+- (BOOL)changeRunMode:(OLYCameraRunMode)mode error:(NSError **)error
+{
+	[self waitForLatency:self.propertyLatency];
+	self.mockRunMode = mode;
+	return YES;
+}
+
+- (NSString *)cameraPropertyValue:(NSString *)name error:(NSError **)error
+{
+	[self waitForLatency:self.propertyLatency];
+	@synchronized (self.propertyValues) {
+		return self.propertyValues[name];
+	}
+}
+
+- (NSDictionary *)cameraPropertyValues:(NSSet *)names error:(NSError **)error
+{
+	[self waitForLatency:self.propertyLatency];
+	NSMutableDictionary *values = [[NSMutableDictionary alloc] init];
+	@synchronized (self.propertyValues) {
+		for (NSString *name in names) {
+			NSString *value = self.propertyValues[name];
+			if (value) {
+				values[name] = value;
+			}
+		}
+	}
+	return values;
+}
+
+- (NSArray *)cameraPropertyValueList:(NSString *)name error:(NSError **)error
+{
+	[self waitForLatency:self.propertyLatency];
+	@synchronized (self.propertyValues) {
+		NSString *value = self.propertyValues[name];
+		return value ? @[value] : @[];
+	}
+}
+
+- (BOOL)setCameraPropertyValue:(NSString *)name value:(NSString *)value error:(NSError **)error
+{
+	[self waitForLatency:self.propertyLatency];
+	@synchronized (self.propertyValues) {
+		self.propertyValues[name] = value;
+	}
+	return YES;
+}
+
+- (BOOL)setCameraPropertyValues:(NSDictionary *)values error:(NSError **)error
+{
+	[self waitForLatency:self.propertyLatency];
+	@synchronized (self.propertyValues) {
+		[self.propertyValues addEntriesFromDictionary:values];
+	}
+	return YES;
+}
+
+#pragma mark - Recording
+
+- (OLYCameraLiveViewSize)liveViewSize
+{
+	return self.mockLiveViewSize;
+}
+
+- (BOOL)changeLiveViewSize:(OLYCameraLiveViewSize)size error:(NSError **)error
+{
+	[self waitForLatency:self.propertyLatency];
+	self.mockLiveViewSize = size;
+	return YES;
+}
+
+- (OLYCameraActionType)actionType
+{
+	NSString *takemode, *drivemode;
+	@synchronized (self.propertyValues) {
+		takemode = self.propertyValues[@"TAKEMODE"];
+		drivemode = self.propertyValues[@"TAKE_DRIVE"];
+	}
+	if ([takemode isEqualToString:@"<TAKEMODE/movie>"]) {
+		return OLYCameraActionTypeMovie;
+	}
+	if ([drivemode isEqualToString:@"<TAKE_DRIVE/DRIVE_CONTINUE>"]) {
+		return OLYCameraActionTypeSequential;
+	}
+	return OLYCameraActionTypeSingle;
+}
+
+- (BOOL)takingPicture
+{
+	return self.mockTakingPicture;
+}
+
+- (BOOL)recordingVideo
+{
+	return NO;
+}
+
+- (BOOL)mediaBusy
+{
+	return NO;
+}
+
+- (void)takePicture:(NSDictionary *)options progressHandler:(void (^)(OLYCameraTakingProgress progress, NSDictionary *info))progressHandler completionHandler:(void (^)(NSDictionary *info))completionHandler errorHandler:(void (^)(NSError *error))errorHandler
+{
+	self.mockTakingPicture = YES;
+	if (progressHandler) {
+		progressHandler(OLYCameraTakingProgressBeginFocusing, nil);
+	}
+	// The handlers are called on the main thread, as the SDK does.
+	NSTimeInterval endFocusingTime = self.focusLatency;
+	NSTimeInterval beginCapturingTime = endFocusingTime + self.captureLatency;
+	NSTimeInterval finishedTime = beginCapturingTime + self.completionLatency;
+	dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(endFocusingTime * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+		if (progressHandler) {
+			progressHandler(OLYCameraTakingProgressEndFocusing, @{OLYCameraTakingPictureProgressInfoFocusResultKey: @"ok"});
+			progressHandler(OLYCameraTakingProgressReadyCapturing, nil);
+		}
+	});
+	dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(beginCapturingTime * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+		if (progressHandler) {
+			progressHandler(OLYCameraTakingProgressBeginCapturing, nil);
+		}
+	});
+	dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(finishedTime * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+		if (progressHandler) {
+			progressHandler(OLYCameraTakingProgressEndCapturing, nil);
+			progressHandler(OLYCameraTakingProgressFinished, nil);
+		}
+		self.mockTakingPicture = NO;
+		if (completionHandler) {
+			completionHandler(@{});
+		}
+	});
+}
+
+@end
+
+#endif
@@ -0,0 +1,34 @@
+//
+//  MotionDetector.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+
+/**
+ * Detects motion in live view images by comparing a downsampled luma frame
+ * against a running background model, block by block.
+ *
+ * The detector is not thread safe; feed it from one serial queue.
+ */
+@interface MotionDetector : NSObject
+
+/** The region to watch, normalized to the live image. (0,0)-(1,1) watches everything. */
+@property (assign, nonatomic) CGRect region;
+/** The mean absolute difference per pixel above which a block counts as moving. */
+@property (assign, nonatomic) NSUInteger blockThreshold;
+/** The fraction of moving blocks in the region above which motion is reported. */
+@property (assign, nonatomic) float motionThreshold;
+/** The number of frames used to build up the background before motion is reported. */
+@property (assign, nonatomic) NSUInteger warmUpFrames;
+/** The score of the latest frame. (the fraction of moving blocks in the region) */
+@property (assign, nonatomic, readonly) float motionScore;
+
+- (id)initWithWidth:(size_t)width height:(size_t)height blockSize:(size_t)blockSize;
+- (BOOL)processImage:(UIImage *)image;
+- (BOOL)processLuma:(const uint8_t *)luma;
+- (void)reset;
+
+@end
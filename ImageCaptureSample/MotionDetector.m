@@ -0,0 +1,141 @@
+//
+//  MotionDetector.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "MotionDetector.h"
+#import "MotionDetectorCore.h"
+
+@interface MotionDetector ()
+
+@property (assign, nonatomic) size_t width;
+@property (assign, nonatomic) size_t height;
+
+@end
+
+@implementation MotionDetector
+{
+	MotionDetectorState _state;
+	uint8_t *_luma;
+	CGContextRef _context;
+}
+
+- (id)initWithWidth:(size_t)width height:(size_t)height blockSize:(size_t)blockSize
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	if (!MotionDetectorInit(&_state, width, height, blockSize)) {
+		return nil;
+	}
+	_width = width;
+	_height = height;
+	_region = CGRectMake(0, 0, 1, 1);
+
+	_luma = calloc(width * height, sizeof(uint8_t));
+	CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceGray();
+	_context = CGBitmapContextCreate(_luma, width, height, 8, width, colorSpace, (CGBitmapInfo)kCGImageAlphaNone);
+	CGColorSpaceRelease(colorSpace);
+	if (!_luma || !_context) {
+		return nil;
+	}
+	CGContextSetInterpolationQuality(_context, kCGInterpolationLow);
+	return self;
+}
+
+- (void)dealloc
+{
+	if (_context) {
+		CGContextRelease(_context);
+	}
+	free(_luma);
+	MotionDetectorDestroy(&_state);
+}
+
+- (void)setRegion:(CGRect)region
+{
+	_region = region;
+	MotionDetectorSetRegion(&_state, CGRectGetMinX(region), CGRectGetMinY(region), CGRectGetMaxX(region), CGRectGetMaxY(region));
+}
+
+- (NSUInteger)blockThreshold
+{
+	return _state.blockThreshold;
+}
+
+- (void)setBlockThreshold:(NSUInteger)blockThreshold
+{
+	_state.blockThreshold = (unsigned)blockThreshold;
+}
+
+- (float)motionThreshold
+{
+	return _state.motionThreshold;
+}
+
+- (void)setMotionThreshold:(float)motionThreshold
+{
+	_state.motionThreshold = motionThreshold;
+}
+
+- (NSUInteger)warmUpFrames
+{
+	return _state.warmUpFrames;
+}
+
+- (void)setWarmUpFrames:(NSUInteger)warmUpFrames
+{
+	_state.warmUpFrames = (unsigned)warmUpFrames;
+}
+
+- (float)motionScore
+{
+	return _state.motionScore;
+}
+
+/**
+ * Discards the background model.
+ */
+- (void)reset
+{
+	MotionDetectorReset(&_state);
+}
+
+/**
+ * Downsamples a live view image and examines it for motion.
+ *
+ * @param image A live view image.
+ * @return YES if motion in the region exceeds the threshold.
+ */
+- (BOOL)processImage:(UIImage *)image
+{
+	if (!image) {
+		return NO;
+	}
+	// Core Graphics does the downsampling and the conversion to luma at once.
+	// Drawing through UIKit keeps the image orientation the same as on the screen.
+	CGContextSaveGState(_context);
+	CGContextTranslateCTM(_context, 0, self.height);
+	CGContextScaleCTM(_context, 1, -1);
+	UIGraphicsPushContext(_context);
+	[image drawInRect:CGRectMake(0, 0, self.width, self.height)];
+	UIGraphicsPopContext();
+	CGContextRestoreGState(_context);
+	return [self processLuma:_luma];
+}
+
+/**
+ * Examines a downsampled luma frame for motion.
+ *
+ * @param luma A frame of width * height bytes.
+ * @return YES if motion in the region exceeds the threshold.
+ */
+- (BOOL)processLuma:(const uint8_t *)luma
+{
+	return MotionDetectorProcess(&_state, luma);
+}
+
+@end
@@ -0,0 +1,229 @@
+//
+//  MotionDetectorCore.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#ifndef ImageCaptureSample_MotionDetectorCore_h
+#define ImageCaptureSample_MotionDetectorCore_h
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*
+ * The work of MotionDetector in plain C, so that it can also be built and
+ * measured off the device.
+ */
+
+/** The background follows the scene with a time constant of 2^kMotionDetectorBackgroundShift frames. */
+enum { kMotionDetectorBackgroundShift = 3 };
+
+typedef struct {
+	size_t width;
+	size_t height;
+	size_t blockSize;
+	/** The region in blocks, [firstColumn, lastColumn) x [firstRow, lastRow). */
+	size_t firstColumn;
+	size_t lastColumn;
+	size_t firstRow;
+	size_t lastRow;
+	/** The mean absolute difference per pixel above which a block counts as moving. */
+	unsigned blockThreshold;
+	/** The fraction of moving blocks in the region above which motion is reported. */
+	float motionThreshold;
+	unsigned warmUpFrames;
+	unsigned processedFrames;
+	float motionScore;
+	uint8_t *background;
+	uint16_t *accumulator;
+} MotionDetectorState;
+
+/**
+ * Returns the sum of absolute differences of a block.
+ */
+static inline uint32_t MotionDetectorBlockSAD(const uint8_t *a, const uint8_t *b, size_t stride, size_t blockSize)
+{
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+	if (blockSize % 8 == 0) {
+		uint16x8_t accumulator = vdupq_n_u16(0);
+		for (size_t y = 0; y < blockSize; y++) {
+			const uint8_t *rowA = a + y * stride;
+			const uint8_t *rowB = b + y * stride;
+			for (size_t x = 0; x < blockSize; x += 8) {
+				accumulator = vabal_u8(accumulator, vld1_u8(rowA + x), vld1_u8(rowB + x));
+			}
+		}
+		uint32x4_t sum4 = vpaddlq_u16(accumulator);
+		uint64x2_t sum2 = vpaddlq_u32(sum4);
+		return (uint32_t)(vgetq_lane_u64(sum2, 0) + vgetq_lane_u64(sum2, 1));
+	}
+#endif
+	uint32_t sum = 0;
+	for (size_t y = 0; y < blockSize; y++) {
+		const uint8_t *rowA = a + y * stride;
+		const uint8_t *rowB = b + y * stride;
+		for (size_t x = 0; x < blockSize; x++) {
+			int difference = (int)rowA[x] - (int)rowB[x];
+			sum += (uint32_t)(difference < 0 ? -difference : difference);
+		}
+	}
+	return sum;
+}
+
+/**
+ * Counts the blocks in [firstColumn, lastColumn) x [firstRow, lastRow) whose
+ * sum of absolute differences exceeds the threshold.
+ */
+static inline size_t MotionDetectorCountMovingBlocks(const uint8_t *luma, const uint8_t *background, size_t width, size_t blockSize, size_t firstColumn, size_t lastColumn, size_t firstRow, size_t lastRow, uint32_t threshold)
+{
+	size_t movingBlocks = 0;
+	for (size_t row = firstRow; row < lastRow; row++) {
+		for (size_t column = firstColumn; column < lastColumn; column++) {
+			size_t offset = row * blockSize * width + column * blockSize;
+			if (MotionDetectorBlockSAD(luma + offset, background + offset, width, blockSize) > threshold) {
+				movingBlocks++;
+			}
+		}
+	}
+	return movingBlocks;
+}
+
+/**
+ * Starts the background model from a frame.
+ *
+ * The model is kept in 8.8 fixed point in accumulator; background holds it
+ * rounded to 8 bits for the block comparison.
+ */
+static inline void MotionDetectorResetBackground(uint16_t *accumulator, uint8_t *background, const uint8_t *luma, size_t pixels)
+{
+	for (size_t index = 0; index < pixels; index++) {
+		accumulator[index] = (uint16_t)(luma[index] << 8);
+		background[index] = luma[index];
+	}
+}
+
+/**
+ * Moves the background model 1/2^shift of the way to a frame.
+ *
+ * Stepping in 8 bits would floor the step and leave the background up to
+ * 2^shift - 1 levels below a brighter scene forever. With the fractional bits,
+ * the model settles within 1/256 of the scene from either side.
+ */
+static inline void MotionDetectorUpdateBackground(uint16_t *accumulator, uint8_t *background, const uint8_t *luma, size_t pixels, int shift)
+{
+	for (size_t index = 0; index < pixels; index++) {
+		int value = accumulator[index];
+		value += (((int)luma[index] << 8) - value) >> shift;
+		accumulator[index] = (uint16_t)value;
+		background[index] = (uint8_t)((value + 0x80) >> 8);
+	}
+}
+
+/**
+ * Sets up a detector watching the whole frame, with the default thresholds.
+ *
+ * @return false if the frame is smaller than a block or the background could not be allocated.
+ */
+static inline bool MotionDetectorInit(MotionDetectorState *state, size_t width, size_t height, size_t blockSize)
+{
+	*state = (MotionDetectorState){0};
+	if (blockSize == 0 || width < blockSize || height < blockSize) {
+		return false;
+	}
+	state->width = width;
+	state->height = height;
+	state->blockSize = blockSize;
+	state->lastColumn = width / blockSize;
+	state->lastRow = height / blockSize;
+	state->blockThreshold = 12;
+	state->motionThreshold = 0.05f;
+	state->warmUpFrames = 8;
+	state->background = calloc(width * height, sizeof(uint8_t));
+	state->accumulator = calloc(width * height, sizeof(uint16_t));
+	return state->background && state->accumulator;
+}
+
+static inline void MotionDetectorDestroy(MotionDetectorState *state)
+{
+	free(state->background);
+	free(state->accumulator);
+	state->background = NULL;
+	state->accumulator = NULL;
+}
+
+/**
+ * Discards the background model.
+ */
+static inline void MotionDetectorReset(MotionDetectorState *state)
+{
+	state->processedFrames = 0;
+	state->motionScore = 0;
+}
+
+/**
+ * Watches the blocks that a region, normalized to the frame, touches.
+ *
+ * The region is clipped to the frame; one outside of it watches nothing.
+ */
+static inline void MotionDetectorSetRegion(MotionDetectorState *state, double minX, double minY, double maxX, double maxY)
+{
+	size_t columns = state->width / state->blockSize;
+	size_t rows = state->height / state->blockSize;
+	minX = fmin(fmax(minX, 0), 1);
+	minY = fmin(fmax(minY, 0), 1);
+	maxX = fmin(fmax(maxX, 0), 1);
+	maxY = fmin(fmax(maxY, 0), 1);
+	state->firstColumn = (size_t)floor(minX * columns);
+	state->lastColumn = (size_t)ceil(maxX * columns);
+	state->firstRow = (size_t)floor(minY * rows);
+	state->lastRow = (size_t)ceil(maxY * rows);
+	if (state->firstColumn >= state->lastColumn || state->firstRow >= state->lastRow) {
+		state->firstColumn = state->lastColumn = 0;
+		state->firstRow = state->lastRow = 0;
+	}
+}
+
+/**
+ * Examines a luma frame of width * height bytes for motion and lets the background follow it.
+ *
+ * The first frame after a reset starts the background, and nothing is reported until
+ * warmUpFrames frames have been seen. motionScore is the fraction of moving blocks in the region.
+ *
+ * @return true if motion in the region exceeds the threshold.
+ */
+static inline bool MotionDetectorProcess(MotionDetectorState *state, const uint8_t *luma)
+{
+	size_t pixels = state->width * state->height;
+	if (state->processedFrames == 0) {
+		MotionDetectorResetBackground(state->accumulator, state->background, luma, pixels);
+		state->processedFrames = 1;
+		state->motionScore = 0;
+		return false;
+	}
+
+	size_t examinedBlocks = (state->lastColumn - state->firstColumn) * (state->lastRow - state->firstRow);
+	size_t movingBlocks = 0;
+	if (examinedBlocks > 0) {
+		uint32_t threshold = (uint32_t)(state->blockThreshold * state->blockSize * state->blockSize);
+		movingBlocks = MotionDetectorCountMovingBlocks(luma, state->background, state->width, state->blockSize, state->firstColumn, state->lastColumn, state->firstRow, state->lastRow, threshold);
+	}
+
+	// Let the background follow the scene slowly.
+	MotionDetectorUpdateBackground(state->accumulator, state->background, luma, pixels, kMotionDetectorBackgroundShift);
+
+	state->processedFrames++;
+	state->motionScore = examinedBlocks > 0 ? (float)movingBlocks / (float)examinedBlocks : 0;
+	if (state->processedFrames <= state->warmUpFrames) {
+		return false;
+	}
+	return state->motionScore > state->motionThreshold;
+}
+
+#endif
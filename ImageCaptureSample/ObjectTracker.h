@@ -0,0 +1,42 @@
+//
+//  ObjectTracker.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+
+/**
+ * Follows a subject in live view images by normalized cross-correlation of a
+ * template on a downsampled luma frame.
+ *
+ * The search covers a window around the last position only, so one frame costs a
+ * fixed, small amount of work. The template adapts slowly while the match is good,
+ * which lets the tracker follow gradual changes of the subject's appearance.
+ * The tracker is not thread safe; feed it from one serial queue.
+ */
+@interface ObjectTracker : NSObject
+
+/** The number of pixels the subject may move between two frames on the downsampled frame. (default: 12) */
+@property (assign, nonatomic) size_t searchRadius;
+/** The correlation below which the subject counts as lost. (default: 0.5) */
+@property (assign, nonatomic) float lostThreshold;
+/** The correlation above which the template is updated. (default: 0.8) */
+@property (assign, nonatomic) float updateThreshold;
+@property (assign, nonatomic, readonly, getter = isTracking) BOOL tracking;
+/** The center of the subject, normalized to the live image. */
+@property (assign, nonatomic, readonly) CGPoint position;
+/** The size of the template, normalized to the live image. */
+@property (assign, nonatomic, readonly) CGSize size;
+/** The correlation of the latest match, in the range of -1 to 1. */
+@property (assign, nonatomic, readonly) float confidence;
+
+- (id)initWithWidth:(size_t)width height:(size_t)height templateSize:(size_t)templateSize;
+- (BOOL)startTrackingAtPoint:(CGPoint)point inImage:(UIImage *)image;
+- (BOOL)startTrackingAtPoint:(CGPoint)point inLuma:(const uint8_t *)luma;
+- (BOOL)processImage:(UIImage *)image;
+- (BOOL)processLuma:(const uint8_t *)luma;
+- (void)stopTracking;
+
+@end
@@ -0,0 +1,175 @@
+//
+//  ObjectTracker.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "ObjectTracker.h"
+#import "ObjectTrackerCore.h"
+
+@interface ObjectTracker ()
+
+@property (assign, nonatomic) size_t width;
+@property (assign, nonatomic) size_t height;
+
+@end
+
+@implementation ObjectTracker
+{
+	ObjectTrackerState _state;
+	uint8_t *_luma;
+	CGContextRef _context;
+}
+
+- (id)initWithWidth:(size_t)width height:(size_t)height templateSize:(size_t)templateSize
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	if (!ObjectTrackerInit(&_state, width, height, templateSize)) {
+		return nil;
+	}
+	_width = width;
+	_height = height;
+
+	_luma = calloc(width * height, sizeof(uint8_t));
+	CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceGray();
+	_context = CGBitmapContextCreate(_luma, width, height, 8, width, colorSpace, (CGBitmapInfo)kCGImageAlphaNone);
+	CGColorSpaceRelease(colorSpace);
+	if (!_luma || !_context) {
+		return nil;
+	}
+	CGContextSetInterpolationQuality(_context, kCGInterpolationLow);
+	return self;
+}
+
+- (void)dealloc
+{
+	if (_context) {
+		CGContextRelease(_context);
+	}
+	free(_luma);
+	ObjectTrackerDestroy(&_state);
+}
+
+- (size_t)searchRadius
+{
+	return _state.searchRadius;
+}
+
+- (void)setSearchRadius:(size_t)searchRadius
+{
+	_state.searchRadius = searchRadius;
+}
+
+- (float)lostThreshold
+{
+	return _state.lostThreshold;
+}
+
+- (void)setLostThreshold:(float)lostThreshold
+{
+	_state.lostThreshold = lostThreshold;
+}
+
+- (float)updateThreshold
+{
+	return _state.updateThreshold;
+}
+
+- (void)setUpdateThreshold:(float)updateThreshold
+{
+	_state.updateThreshold = updateThreshold;
+}
+
+- (BOOL)isTracking
+{
+	return _state.tracking;
+}
+
+- (float)confidence
+{
+	return _state.confidence;
+}
+
+- (CGPoint)position
+{
+	CGFloat half = _state.templateSize / 2.0;
+	return CGPointMake((_state.templateX + half) / self.width, (_state.templateY + half) / self.height);
+}
+
+- (CGSize)size
+{
+	return CGSizeMake((CGFloat)_state.templateSize / self.width, (CGFloat)_state.templateSize / self.height);
+}
+
+#pragma mark -
+
+/**
+ * Takes the template around a point of a live view image.
+ *
+ * @param point The center of the subject, normalized to the live image.
+ * @return NO if the area has too little texture to be tracked.
+ */
+- (BOOL)startTrackingAtPoint:(CGPoint)point inImage:(UIImage *)image
+{
+	if (!image) {
+		return NO;
+	}
+	[self drawImage:image];
+	return [self startTrackingAtPoint:point inLuma:_luma];
+}
+
+- (BOOL)startTrackingAtPoint:(CGPoint)point inLuma:(const uint8_t *)luma
+{
+	return ObjectTrackerStart(&_state, point.x, point.y, luma);
+}
+
+- (void)stopTracking
+{
+	ObjectTrackerStop(&_state);
+}
+
+/**
+ * Downsamples a live view image and finds the subject in it.
+ *
+ * @return NO if the subject was lost.
+ */
+- (BOOL)processImage:(UIImage *)image
+{
+	if (!_state.tracking || !image) {
+		return NO;
+	}
+	[self drawImage:image];
+	return [self processLuma:_luma];
+}
+
+/**
+ * Finds the subject in a downsampled luma frame.
+ *
+ * @param luma A frame of width * height bytes.
+ * @return NO if the subject was lost.
+ */
+- (BOOL)processLuma:(const uint8_t *)luma
+{
+	return ObjectTrackerProcess(&_state, luma);
+}
+
+#pragma mark -
+
+- (void)drawImage:(UIImage *)image
+{
+	// Core Graphics does the downsampling and the conversion to luma at once.
+	// Drawing through UIKit keeps the image orientation the same as on the screen.
+	CGContextSaveGState(_context);
+	CGContextTranslateCTM(_context, 0, self.height);
+	CGContextScaleCTM(_context, 1, -1);
+	UIGraphicsPushContext(_context);
+	[image drawInRect:CGRectMake(0, 0, self.width, self.height)];
+	UIGraphicsPopContext();
+	CGContextRestoreGState(_context);
+}
+
+@end
@@ -0,0 +1,236 @@
+//
+//  ObjectTrackerCore.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#ifndef ImageCaptureSample_ObjectTrackerCore_h
+#define ImageCaptureSample_ObjectTrackerCore_h
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * The search and template work of ObjectTracker in plain C, so that it can
+ * also be built, checked and measured off the device.
+ */
+
+/** The template follows the subject with a time constant of 2^kObjectTrackerTemplateShift frames. */
+enum { kObjectTrackerTemplateShift = 4 };
+
+/** A template flatter than this has nothing to correlate with. */
+#define kObjectTrackerMinimumTemplateDeviation 2.0f
+
+typedef struct {
+	size_t width;
+	size_t height;
+	size_t templateSize;
+	/** The number of pixels the subject may move between two frames. */
+	size_t searchRadius;
+	/** The correlation below which the subject counts as lost. */
+	float lostThreshold;
+	/** The correlation above which the template is updated. */
+	float updateThreshold;
+	bool tracking;
+	/** The top left corner of the template in the frame. */
+	size_t templateX;
+	size_t templateY;
+	/** The correlation of the latest match, in the range of -1 to 1. */
+	float confidence;
+	float templateNorm;
+	float *templateLuma;
+	/** The template less its mean, so that the correlation needs no mean of the candidate. */
+	float *templateDeviation;
+} ObjectTrackerState;
+
+/**
+ * Sets up a tracker that is not tracking, with the default thresholds.
+ *
+ * @return false if the frame is smaller than the template or the template could not be allocated.
+ */
+static inline bool ObjectTrackerInit(ObjectTrackerState *state, size_t width, size_t height, size_t templateSize)
+{
+	*state = (ObjectTrackerState){0};
+	if (templateSize == 0 || width < templateSize || height < templateSize) {
+		return false;
+	}
+	state->width = width;
+	state->height = height;
+	state->templateSize = templateSize;
+	state->searchRadius = 12;
+	state->lostThreshold = 0.5f;
+	state->updateThreshold = 0.8f;
+	state->templateLuma = calloc(templateSize * templateSize, sizeof(float));
+	state->templateDeviation = calloc(templateSize * templateSize, sizeof(float));
+	return state->templateLuma && state->templateDeviation;
+}
+
+static inline void ObjectTrackerDestroy(ObjectTrackerState *state)
+{
+	free(state->templateLuma);
+	free(state->templateDeviation);
+	state->templateLuma = NULL;
+	state->templateDeviation = NULL;
+}
+
+static inline void ObjectTrackerUpdateTemplateDeviation(ObjectTrackerState *state)
+{
+	size_t pixels = state->templateSize * state->templateSize;
+	float mean = 0;
+	for (size_t index = 0; index < pixels; index++) {
+		mean += state->templateLuma[index];
+	}
+	mean /= pixels;
+	float sumOfSquares = 0;
+	for (size_t index = 0; index < pixels; index++) {
+		float deviation = state->templateLuma[index] - mean;
+		state->templateDeviation[index] = deviation;
+		sumOfSquares += deviation * deviation;
+	}
+	state->templateNorm = sqrtf(sumOfSquares);
+}
+
+/**
+ * Returns the normalized cross-correlation of the template with the candidate at x, y,
+ * or -2 if the candidate is too flat to tell.
+ */
+static inline float ObjectTrackerCorrelate(const ObjectTrackerState *state, const uint8_t *luma, size_t x, size_t y)
+{
+	size_t templateSize = state->templateSize;
+	size_t pixels = templateSize * templateSize;
+	// The template is zero-mean, so the cross term needs no mean of the candidate.
+	uint32_t sum = 0;
+	uint32_t sumOfSquares = 0;
+	float crossSum = 0;
+	for (size_t row = 0; row < templateSize; row++) {
+		const uint8_t *candidate = luma + (y + row) * state->width + x;
+		const float *deviation = state->templateDeviation + row * templateSize;
+		for (size_t column = 0; column < templateSize; column++) {
+			uint32_t value = candidate[column];
+			sum += value;
+			sumOfSquares += value * value;
+			crossSum += value * deviation[column];
+		}
+	}
+	float variance = (float)sumOfSquares - (float)sum * (float)sum / (float)pixels;
+	if (variance <= 1.0f) {
+		return -2.0f;
+	}
+	return crossSum / (sqrtf(variance) * state->templateNorm);
+}
+
+/**
+ * Finds the best match of the template within searchRadius of its last position.
+ *
+ * @return The correlation of the best match, or -2 if every candidate was too flat.
+ */
+static inline float ObjectTrackerSearch(const ObjectTrackerState *state, const uint8_t *luma, size_t *bestX, size_t *bestY)
+{
+	size_t radius = state->searchRadius;
+	size_t maximumX = state->width - state->templateSize;
+	size_t maximumY = state->height - state->templateSize;
+	size_t firstX = state->templateX > radius ? state->templateX - radius : 0;
+	size_t lastX = state->templateX + radius < maximumX ? state->templateX + radius : maximumX;
+	size_t firstY = state->templateY > radius ? state->templateY - radius : 0;
+	size_t lastY = state->templateY + radius < maximumY ? state->templateY + radius : maximumY;
+
+	float bestScore = -2.0f;
+	*bestX = state->templateX;
+	*bestY = state->templateY;
+	for (size_t y = firstY; y <= lastY; y++) {
+		for (size_t x = firstX; x <= lastX; x++) {
+			float score = ObjectTrackerCorrelate(state, luma, x, y);
+			if (score > bestScore) {
+				bestScore = score;
+				*bestX = x;
+				*bestY = y;
+			}
+		}
+	}
+	return bestScore;
+}
+
+/**
+ * Moves the template 1/2^kObjectTrackerTemplateShift of the way to the frame at its position.
+ */
+static inline void ObjectTrackerUpdateTemplate(ObjectTrackerState *state, const uint8_t *luma)
+{
+	size_t templateSize = state->templateSize;
+	for (size_t row = 0; row < templateSize; row++) {
+		const uint8_t *source = luma + (state->templateY + row) * state->width + state->templateX;
+		float *destination = state->templateLuma + row * templateSize;
+		for (size_t column = 0; column < templateSize; column++) {
+			destination[column] += (source[column] - destination[column]) / (1 << kObjectTrackerTemplateShift);
+		}
+	}
+	ObjectTrackerUpdateTemplateDeviation(state);
+}
+
+/**
+ * Takes the template around a point of a luma frame of width * height bytes.
+ *
+ * @param x, y The center of the subject, normalized to the frame. The template is kept within the frame.
+ * @return false if the area has too little texture to be tracked.
+ */
+static inline bool ObjectTrackerStart(ObjectTrackerState *state, double x, double y, const uint8_t *luma)
+{
+	size_t templateSize = state->templateSize;
+	double left = round(x * state->width - templateSize / 2.0);
+	double top = round(y * state->height - templateSize / 2.0);
+	state->templateX = (size_t)fmax(0, fmin(left, (double)(state->width - templateSize)));
+	state->templateY = (size_t)fmax(0, fmin(top, (double)(state->height - templateSize)));
+
+	for (size_t row = 0; row < templateSize; row++) {
+		const uint8_t *source = luma + (state->templateY + row) * state->width + state->templateX;
+		for (size_t column = 0; column < templateSize; column++) {
+			state->templateLuma[row * templateSize + column] = source[column];
+		}
+	}
+	ObjectTrackerUpdateTemplateDeviation(state);
+	float deviation = state->templateNorm / sqrtf((float)(templateSize * templateSize));
+	state->tracking = (deviation >= kObjectTrackerMinimumTemplateDeviation);
+	state->confidence = state->tracking ? 1.0f : 0.0f;
+	return state->tracking;
+}
+
+static inline void ObjectTrackerStop(ObjectTrackerState *state)
+{
+	state->tracking = false;
+	state->confidence = 0;
+}
+
+/**
+ * Finds the subject in a luma frame of width * height bytes.
+ *
+ * The template adapts to the frame while the match is above updateThreshold.
+ *
+ * @return false if the subject was lost, or was not being tracked.
+ */
+static inline bool ObjectTrackerProcess(ObjectTrackerState *state, const uint8_t *luma)
+{
+	if (!state->tracking) {
+		return false;
+	}
+	size_t bestX;
+	size_t bestY;
+	float bestScore = ObjectTrackerSearch(state, luma, &bestX, &bestY);
+	state->confidence = bestScore;
+	if (bestScore < state->lostThreshold) {
+		state->tracking = false;
+		return false;
+	}
+	state->templateX = bestX;
+	state->templateY = bestY;
+
+	// Follow slow changes of the subject, but only from a confident match.
+	if (bestScore > state->updateThreshold) {
+		ObjectTrackerUpdateTemplate(state, luma);
+	}
+	return true;
+}
+
+#endif
@@ -6,6 +6,9 @@
 //
 
 #import "AppDelegate.h"
+#import "CameraPropertyCache.h"
+#import "ContentBrowserViewController.h"
+#import "ContentDownloadManager.h"
 #import "SettingViewController.h"
 
 @interface SettingViewController ()
@@ -16,6 +19,8 @@
 @property (weak, nonatomic) IBOutlet UITableViewCell *qualityCellXGA;
 @property (weak, nonatomic) IBOutlet UITableViewCell *previewCell;
 @property (weak, nonatomic) IBOutlet UITableViewCell *poweroffCell;
+@property (weak, nonatomic) IBOutlet UITableViewCell *downloadCell;
+@property (weak, nonatomic) IBOutlet UITableViewCell *browseCell;
 @property (weak, nonatomic) IBOutlet UITableViewCell *cameraVersionCell;
 @property (weak, nonatomic) IBOutlet UITableViewCell *cameraKitVersionCell;
 @property (strong, nonatomic) NSArray *qualityCellList;
@@ -53,6 +58,10 @@
 	}
 	// Camera control section:
 	self.poweroffCell.textLabel.textColor = [self.view tintColor];
+	self.downloadCell.textLabel.textColor = [self.view tintColor];
+	self.browseCell.textLabel.textColor = [self.view tintColor];
+	[self updateDownloadCell];
+	[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(contentDownloadDidChange:) name:kAppDelegateContentDownloadDidChangeNotification object:nil];
 	// Camera version section:
 	OLYCamera *camera = AppDelegateCamera();
 	NSDictionary *hardwareInformation = [camera inquireHardwareInformation:nil];
@@ -75,6 +84,8 @@
 - (void)dealloc
 {
 	self.qualityCellList = nil;
+	
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
 }
 
 - (BOOL)prefersStatusBarHidden
@@ -138,11 +149,34 @@
 	} else if ([cell isEqual:self.poweroffCell]) {
 		// Camera control section:
 		AppDelegateCameraDisconnectWithPowerOff(YES);
+	} else if ([cell isEqual:self.downloadCell]) {
+		// Camera control section:
+		AppDelegateStartDownloadingContents();
+	} else if ([cell isEqual:self.browseCell]) {
+		// Camera control section:
+		[self.navigationController pushViewController:[[ContentBrowserViewController alloc] init] animated:YES];
 	} else {
 		// Ignore others.
 	}
 }
 
+- (void)contentDownloadDidChange:(NSNotification *)notification
+{
+	[self updateDownloadCell];
+}
+
+- (void)updateDownloadCell
+{
+	ContentDownloadManager *manager = AppDelegateContentDownloadManager();
+	NSString *text = NSLocalizedString(@"Download Contents", nil);
+	if (manager.downloading) {
+		text = [NSString stringWithFormat:@"%@ (%lu left, %.1f MB/s)", NSLocalizedString(@"Downloading", nil), (unsigned long)manager.pendingCount, manager.throughput / (1024.0 * 1024.0)];
+	} else if (manager.downloadedCount > 0 || manager.failedCount > 0) {
+		text = [NSString stringWithFormat:@"%@ (%lu done, %lu failed)", text, (unsigned long)manager.downloadedCount, (unsigned long)manager.failedCount];
+	}
+	self.downloadCell.textLabel.text = text;
+}
+
 - (void)applyLivePreviewQualityToCamera
 {
 	OLYCamera *camera = AppDelegateCamera();
@@ -152,6 +186,8 @@
 		if (![camera changeLiveViewSize:CGSizeFromString(userLivePreviewQuality) error:&error]) {
 			NSLog(@"To change the live view size is failed: %@", error ? error : @"Unknown error");
 		}
+		// The user's choice becomes the ceiling of the adaptive quality.
+		AppDelegateResetLiveViewQuality();
 	}
 }
 
@@ -164,9 +200,8 @@
 		recviewValue = @"<RECVIEW/OFF>";
 	}
 
-	OLYCamera *camera = AppDelegateCamera();
 	NSError *error = nil;
-	if (![camera setCameraPropertyValue:ICSCameraPropertyRecview value:recviewValue error:&error]) {
+	if (![AppDelegateCameraPropertyCache() setValue:recviewValue forProperty:ICSCameraPropertyRecview error:&error]) {
 		NSLog(@"To change the rec-view mode is failed: %@", error ? error : @"Unknown error");
 	}
 }
@@ -0,0 +1,54 @@
+//
+//  ShutterLatencyBenchmark.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class MIKMIDIClientSourceEndpoint;
+
+enum ShutterLatencyStage
+{
+	/** The note left the controller. (the time stamp of the MIDI packet) */
+	ShutterLatencyStageSent,
+	/** The note reached the MIDI handler on the main thread. */
+	ShutterLatencyStageDelivered,
+	/** The shutter action started. */
+	ShutterLatencyStageDispatched,
+	/** The take mode was changed for a still picture. (only when it had to be) */
+	ShutterLatencyStageTakemodeChanged,
+	/** The shot was handed to the capture controller. */
+	ShutterLatencyStageRequested,
+	/** The camera began capturing. */
+	ShutterLatencyStageBeginCapturing,
+	ShutterLatencyStageCount,
+};
+
+typedef enum ShutterLatencyStage ShutterLatencyStage;
+
+/**
+ * Measures the time from a pad on the controller to the beginning of capturing, stage by stage.
+ *
+ * A shutter note opens a sample and the stages it passes through are stamped
+ * until the camera begins capturing. A note arriving while a sample is open
+ * abandons the open one. Stages that a shot skips are left out of its intervals.
+ * The benchmark can also replay a note stream through a virtual MIDI source of
+ * its own, which takes the same path through the input port as a controller.
+ * All methods must be called on the main thread.
+ */
+@interface ShutterLatencyBenchmark : NSObject
+
+/** The virtual source the notes are replayed through. (created on first use) */
+@property (strong, nonatomic, readonly) MIKMIDIClientSourceEndpoint *replaySource;
+@property (assign, nonatomic, readonly) NSUInteger completedSamples;
+@property (assign, nonatomic, readonly) NSUInteger abandonedSamples;
+
+- (void)beginSampleWithMIDITimestamp:(uint64_t)timestamp;
+- (void)markStage:(ShutterLatencyStage)stage;
+- (void)reset;
+- (NSString *)percentileTable;
+- (void)replayNote:(uint8_t)note count:(NSUInteger)count interval:(NSTimeInterval)interval completionHandler:(void (^)())completionHandler;
+
+@end
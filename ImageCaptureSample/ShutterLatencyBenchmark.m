@@ -0,0 +1,200 @@
+//
+//  ShutterLatencyBenchmark.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "ShutterLatencyBenchmark.h"
+#import <mach/mach_time.h>
+#import "MIKMIDI.h"
+#import "MIKMIDIClientSourceEndpoint.h"
+
+/**
+ * The times of the stages of one shot, in host time. Zero means the stage was skipped.
+ */
+struct ShutterLatencySample
+{
+	uint64_t times[ShutterLatencyStageCount];
+};
+
+typedef struct ShutterLatencySample ShutterLatencySample;
+
+static NSString *const ShutterLatencyStageNames[ShutterLatencyStageCount] = {
+	@"sent",
+	@"delivered",
+	@"dispatched",
+	@"takemode",
+	@"requested",
+	@"capturing",
+};
+
+@interface ShutterLatencyBenchmark ()
+
+@property (assign, nonatomic, readwrite) NSUInteger completedSamples;
+@property (assign, nonatomic, readwrite) NSUInteger abandonedSamples;
+@property (strong, nonatomic) NSMutableData *samples;
+@property (assign, nonatomic) BOOL sampleOpen;
+
+@end
+
+@implementation ShutterLatencyBenchmark
+{
+	ShutterLatencySample _currentSample;
+	MIKMIDIClientSourceEndpoint *_replaySource;
+}
+
+- (id)init
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	_samples = [[NSMutableData alloc] init];
+	return self;
+}
+
+#pragma mark -
+
+/**
+ * Opens a sample for a shutter note.
+ *
+ * @param timestamp The host time stamp of the MIDI packet, or 0 if the source did not set one.
+ */
+- (void)beginSampleWithMIDITimestamp:(uint64_t)timestamp
+{
+	if (self.sampleOpen) {
+		self.abandonedSamples++;
+	}
+	uint64_t now = mach_absolute_time();
+	memset(&_currentSample, 0, sizeof(_currentSample));
+	_currentSample.times[ShutterLatencyStageSent] = (timestamp != 0 && timestamp <= now) ? timestamp : now;
+	_currentSample.times[ShutterLatencyStageDelivered] = now;
+	self.sampleOpen = YES;
+}
+
+- (void)markStage:(ShutterLatencyStage)stage
+{
+	if (!self.sampleOpen || stage >= ShutterLatencyStageCount || _currentSample.times[stage] != 0) {
+		return;
+	}
+	_currentSample.times[stage] = mach_absolute_time();
+	if (stage == ShutterLatencyStageBeginCapturing) {
+		[self.samples appendBytes:&_currentSample length:sizeof(_currentSample)];
+		self.completedSamples++;
+		self.sampleOpen = NO;
+	}
+}
+
+- (void)reset
+{
+	self.samples.length = 0;
+	self.completedSamples = 0;
+	self.abandonedSamples = 0;
+	self.sampleOpen = NO;
+}
+
+#pragma mark -
+
+/**
+ * Returns the percentiles of each stage interval and of the whole path, in milliseconds.
+ */
+- (NSString *)percentileTable
+{
+	mach_timebase_info_data_t timebase;
+	mach_timebase_info(&timebase);
+	double millisecondsPerTick = (double)timebase.numer / timebase.denom / 1000000.0;
+
+	const ShutterLatencySample *samples = self.samples.bytes;
+	NSUInteger count = self.samples.length / sizeof(ShutterLatencySample);
+	double *intervals = malloc(sizeof(double) * MAX(count, (NSUInteger)1));
+	if (!intervals) {
+		return nil;
+	}
+
+	NSMutableString *table = [[NSMutableString alloc] init];
+	[table appendFormat:@"%-22s %5s %8s %8s %8s %8s\n", "stage (ms)", "n", "p50", "p90", "p99", "max"];
+	for (NSUInteger stage = ShutterLatencyStageDelivered; stage <= ShutterLatencyStageCount; stage++) {
+		// The last row is the whole path.
+		BOOL total = (stage == ShutterLatencyStageCount);
+		NSUInteger intervalCount = 0;
+		for (NSUInteger index = 0; index < count; index++) {
+			const uint64_t *times = samples[index].times;
+			NSUInteger end = total ? ShutterLatencyStageBeginCapturing : stage;
+			if (times[end] == 0) {
+				continue;
+			}
+			NSUInteger start = ShutterLatencyStageSent;
+			if (!total) {
+				start = stage - 1;
+				while (start > ShutterLatencyStageSent && times[start] == 0) {
+					start--;
+				}
+			}
+			intervals[intervalCount++] = (times[end] - times[start]) * millisecondsPerTick;
+		}
+		NSString *name = total ? @"sent -> capturing" : [NSString stringWithFormat:@"-> %@", ShutterLatencyStageNames[stage]];
+		[table appendFormat:@"%-22s %5lu", name.UTF8String, (unsigned long)intervalCount];
+		if (intervalCount == 0) {
+			[table appendString:@"\n"];
+			continue;
+		}
+		qsort_b(intervals, intervalCount, sizeof(double), ^int(const void *a, const void *b) {
+			double difference = *(const double *)a - *(const double *)b;
+			return (difference > 0) - (difference < 0);
+		});
+		double percentiles[] = { 0.5, 0.9, 0.99 };
+		for (size_t index = 0; index < sizeof(percentiles) / sizeof(percentiles[0]); index++) {
+			// Nearest rank.
+			NSUInteger rank = (NSUInteger)ceil(percentiles[index] * intervalCount);
+			[table appendFormat:@" %8.1f", intervals[MAX(rank, (NSUInteger)1) - 1]];
+		}
+		[table appendFormat:@" %8.1f\n", intervals[intervalCount - 1]];
+	}
+	[table appendFormat:@"completed %lu, abandoned %lu\n", (unsigned long)self.completedSamples, (unsigned long)self.abandonedSamples];
+	free(intervals);
+	return table;
+}
+
+#pragma mark -
+
+- (MIKMIDIClientSourceEndpoint *)replaySource
+{
+	// Created on first use, so the endpoint is visible to other apps only while benchmarking.
+	if (!_replaySource) {
+		_replaySource = [[MIKMIDIClientSourceEndpoint alloc] initWithName:@"ImageCaptureSample Benchmark"];
+	}
+	return _replaySource;
+}
+
+/**
+ * Sends notes through the virtual source at a fixed interval, stamped with the time they are sent.
+ */
+- (void)replayNote:(uint8_t)note count:(NSUInteger)count interval:(NSTimeInterval)interval completionHandler:(void (^)())completionHandler
+{
+	if (count == 0 || !self.replaySource) {
+		if (completionHandler) {
+			completionHandler();
+		}
+		return;
+	}
+
+	MIKMutableMIDINoteOnCommand *noteOn = [[MIKMutableMIDINoteOnCommand alloc] init];
+	noteOn.note = note;
+	noteOn.velocity = 100;
+	noteOn.midiTimestamp = mach_absolute_time();
+	MIKMutableMIDINoteOffCommand *noteOff = [[MIKMutableMIDINoteOffCommand alloc] init];
+	noteOff.note = note;
+	noteOff.midiTimestamp = noteOn.midiTimestamp;
+	NSError *error = nil;
+	if (![self.replaySource sendCommands:@[noteOn, noteOff] error:&error]) {
+		NSLog(@"To send a replayed note is failed: %@", error ? error : @"Unknown error");
+	}
+
+	__weak ShutterLatencyBenchmark *weakSelf = self;
+	dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(interval * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+		[weakSelf replayNote:note count:count - 1 interval:interval completionHandler:completionHandler];
+	});
+}
+
+@end
@@ -0,0 +1,45 @@
+//
+//  Trace.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "TraceCore.h"
+
+/**
+ * Trace points compile to nothing unless TRACE_ENABLED is 1.
+ * It defaults to 1 in debug builds and can be set from the build settings.
+ */
+#ifndef TRACE_ENABLED
+#ifdef DEBUG
+#define TRACE_ENABLED 1
+#else
+#define TRACE_ENABLED 0
+#endif
+#endif
+
+/** The number of events each thread keeps; older ones are overwritten. */
+extern const NSUInteger TraceRingCapacity;
+
+extern void TraceRecord(const char *name, char phase, int64_t argument);
+extern NSData *TraceCopyChromeJSON(void);
+extern BOOL TraceWriteChromeJSON(NSURL *url, NSError **error);
+extern void TraceClear(void);
+
+#if TRACE_ENABLED
+/** Opens a duration on the current thread. */
+#define TRACE_BEGIN(name) TraceRecord((name), 'B', 0)
+/** Closes the latest duration of the same name on the current thread. */
+#define TRACE_END(name) TraceRecord((name), 'E', 0)
+/** Marks a point in time with a value. */
+#define TRACE_INSTANT(name, value) TraceRecord((name), 'i', (int64_t)(value))
+/** Records a value that is drawn as a graph. */
+#define TRACE_COUNTER(name, value) TraceRecord((name), 'C', (int64_t)(value))
+#else
+#define TRACE_BEGIN(name) do {} while (0)
+#define TRACE_END(name) do {} while (0)
+#define TRACE_INSTANT(name, value) do {} while (0)
+#define TRACE_COUNTER(name, value) do {} while (0)
+#endif
@@ -0,0 +1,161 @@
+//
+//  Trace.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "Trace.h"
+#import <libkern/OSAtomic.h>
+#import <mach/mach_time.h>
+#import <pthread.h>
+
+const NSUInteger TraceRingCapacity = kTraceRingCapacity - 1;
+
+/**
+ * The events of one thread. Only the owning thread writes; the exporter reads
+ * without a lock and drops whatever was overwritten while it copied.
+ */
+struct TraceRing
+{
+	TraceEventRing buffer;
+	volatile int32_t inUse;
+	uint64_t threadID;
+	char threadName[64];
+	struct TraceRing *next;
+};
+
+typedef struct TraceRing TraceRing;
+
+static pthread_key_t TraceRingKey;
+static TraceRing *volatile TraceRings = NULL;
+static volatile int64_t TraceClearTime = 0;
+
+static void TraceRingRelease(void *ring)
+{
+	// The events stay readable; the next new thread takes the ring over.
+	OSAtomicCompareAndSwap32Barrier(1, 0, &((TraceRing *)ring)->inUse);
+}
+
+static TraceRing *TraceCurrentRing(void)
+{
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		pthread_key_create(&TraceRingKey, TraceRingRelease);
+	});
+	TraceRing *ring = pthread_getspecific(TraceRingKey);
+	if (ring) {
+		return ring;
+	}
+
+	for (TraceRing *candidate = TraceRings; candidate; candidate = candidate->next) {
+		if (OSAtomicCompareAndSwap32Barrier(0, 1, &candidate->inUse)) {
+			ring = candidate;
+			break;
+		}
+	}
+	if (!ring) {
+		ring = calloc(1, sizeof(TraceRing));
+		if (!ring) {
+			return NULL;
+		}
+		ring->inUse = 1;
+		do {
+			ring->next = TraceRings;
+		} while (!OSAtomicCompareAndSwapPtrBarrier(ring->next, ring, (void *volatile *)&TraceRings));
+	}
+	TraceEventRingRestart(&ring->buffer);
+	pthread_threadid_np(NULL, &ring->threadID);
+	if (pthread_main_np()) {
+		strlcpy(ring->threadName, "main", sizeof(ring->threadName));
+	} else {
+		ring->threadName[0] = '\0';
+		pthread_getname_np(pthread_self(), ring->threadName, sizeof(ring->threadName));
+	}
+	OSMemoryBarrier();
+	pthread_setspecific(TraceRingKey, ring);
+	return ring;
+}
+
+/**
+ * Appends an event to the ring of the current thread.
+ * This takes no lock and allocates nothing after the first event of a thread.
+ */
+void TraceRecord(const char *name, char phase, int64_t argument)
+{
+	TraceRing *ring = TraceCurrentRing();
+	if (!ring) {
+		return;
+	}
+	TraceEventRingAppend(&ring->buffer, mach_absolute_time(), name, phase, argument);
+}
+
+/**
+ * Forgets the events recorded so far.
+ */
+void TraceClear(void)
+{
+	TraceClearTime = (int64_t)mach_absolute_time();
+	OSMemoryBarrier();
+}
+
+#pragma mark -
+
+/**
+ * Returns the recorded events in the Chrome trace event format, for chrome://tracing.
+ */
+NSData *TraceCopyChromeJSON(void)
+{
+	mach_timebase_info_data_t timebase;
+	mach_timebase_info(&timebase);
+	uint64_t clearTime = (uint64_t)TraceClearTime;
+	int processID = [NSProcessInfo processInfo].processIdentifier;
+
+	TraceEvent *events = malloc(sizeof(TraceEvent) * kTraceRingCapacity);
+	if (!events) {
+		return nil;
+	}
+	TraceWriter writer;
+	TraceWriterInit(&writer);
+	TraceWriterAppendFormat(&writer, "{\"traceEvents\":[");
+	BOOL separate = NO;
+	for (TraceRing *ring = TraceRings; ring; ring = ring->next) {
+		size_t count = TraceEventRingCopy(&ring->buffer, events, clearTime);
+		if (ring->threadName[0] != '\0') {
+			if (separate) {
+				TraceWriterAppendFormat(&writer, ",");
+			}
+			TraceWriterAppendThreadName(&writer, ring->threadName, processID, ring->threadID);
+			separate = YES;
+		}
+		for (size_t index = 0; index < count; index++) {
+			double microseconds = (double)events[index].timestamp * timebase.numer / timebase.denom / 1000.0;
+			if (separate) {
+				TraceWriterAppendFormat(&writer, ",");
+			}
+			TraceWriterAppendEvent(&writer, &events[index], microseconds, processID, ring->threadID);
+			separate = YES;
+		}
+	}
+	TraceWriterAppendFormat(&writer, "],\"displayTimeUnit\":\"ms\"}");
+	free(events);
+
+	if (writer.failed) {
+		TraceWriterDestroy(&writer);
+		return nil;
+	}
+	// The data takes the buffer over.
+	return [NSData dataWithBytesNoCopy:writer.buffer length:writer.length freeWhenDone:YES];
+}
+
+BOOL TraceWriteChromeJSON(NSURL *url, NSError **error)
+{
+	NSData *data = TraceCopyChromeJSON();
+	if (!data) {
+		if (error) {
+			*error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileWriteUnknownError userInfo:nil];
+		}
+		return NO;
+	}
+	return [data writeToURL:url options:NSDataWritingAtomic error:error];
+}
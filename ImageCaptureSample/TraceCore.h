@@ -0,0 +1,249 @@
+//
+//  TraceCore.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#ifndef ImageCaptureSample_TraceCore_h
+#define ImageCaptureSample_TraceCore_h
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * The event ring and the Chrome trace event format of Trace in plain C, so
+ * that they can also be built and checked off the device.
+ */
+
+enum
+{
+	kTraceRingCapacity = 4096,	// Must be a power of two.
+};
+
+/**
+ * One recorded event. The name must be a string literal; only its address is stored.
+ */
+struct TraceEvent
+{
+	uint64_t timestamp;
+	const char *name;
+	int64_t argument;
+	char phase;
+};
+
+typedef struct TraceEvent TraceEvent;
+
+/**
+ * The latest events of one thread. Only one thread appends; another may copy
+ * the events out at any time without a lock.
+ */
+struct TraceEventRing
+{
+	TraceEvent events[kTraceRingCapacity];
+	/** The number of events ever appended; the latest one is at (count - 1) modulo the capacity. */
+	volatile int64_t count;
+	/** The count when the current thread took the ring over; the events before it are not copied. */
+	volatile int64_t start;
+};
+
+typedef struct TraceEventRing TraceEventRing;
+
+/**
+ * Appends an event, overwriting the oldest one when the ring is full.
+ * This takes no lock and allocates nothing.
+ */
+static inline void TraceEventRingAppend(TraceEventRing *ring, uint64_t timestamp, const char *name, char phase, int64_t argument)
+{
+	int64_t count = ring->count;
+	TraceEvent *event = &ring->events[count & (kTraceRingCapacity - 1)];
+	event->timestamp = timestamp;
+	event->name = name;
+	event->argument = argument;
+	event->phase = phase;
+	// The event must be complete before a reader can see it counted.
+	__sync_synchronize();
+	ring->count = count + 1;
+}
+
+/**
+ * Hands the ring over to the thread that calls this, which appends from then on.
+ *
+ * The count goes on from where it was, so that a copy in progress never sees it
+ * go back; the events of the previous thread are left out of later copies instead.
+ */
+static inline void TraceEventRingRestart(TraceEventRing *ring)
+{
+	ring->start = ring->count;
+	// The events of the previous thread must be hidden before new ones are counted.
+	__sync_synchronize();
+}
+
+/**
+ * Copies the events recorded at or after since, oldest first.
+ *
+ * The writer may go on appending meanwhile. Events it overwrote while they
+ * were being copied may be torn and are left out, so every copied event is
+ * one that was recorded whole. The slot of the next event counts as being
+ * overwritten, so at most kTraceRingCapacity - 1 events are copied.
+ *
+ * @param events A buffer of kTraceRingCapacity events.
+ * @return The number of events copied to the front of events.
+ */
+static inline size_t TraceEventRingCopy(const TraceEventRing *ring, TraceEvent *events, uint64_t since)
+{
+	int64_t end = ring->count;
+	__sync_synchronize();
+	// Read after the count, so that a restart is seen before any event counted after it.
+	int64_t restart = ring->start;
+	int64_t first = end > kTraceRingCapacity ? end - kTraceRingCapacity : 0;
+	if (restart > first) {
+		first = restart < end ? restart : end;
+	}
+	for (int64_t index = first; index < end; index++) {
+		events[index - first] = ring->events[index & (kTraceRingCapacity - 1)];
+	}
+	__sync_synchronize();
+	// The writer may also be halfway through the event after the last one it counted.
+	int64_t overtaken = ring->count + 1 - kTraceRingCapacity;
+	int64_t start = overtaken > first ? overtaken : first;
+	size_t copied = 0;
+	for (int64_t index = start; index < end; index++) {
+		TraceEvent *event = &events[index - first];
+		if (event->timestamp < since || !event->name) {
+			continue;
+		}
+		events[copied++] = *event;
+	}
+	return copied;
+}
+
+/**
+ * A growing buffer that JSON text is written to.
+ */
+struct TraceWriter
+{
+	char *buffer;
+	size_t capacity;
+	size_t length;
+	/** Set when the buffer could not grow; the text is incomplete then. */
+	bool failed;
+};
+
+typedef struct TraceWriter TraceWriter;
+
+static inline void TraceWriterInit(TraceWriter *writer)
+{
+	writer->buffer = NULL;
+	writer->capacity = 0;
+	writer->length = 0;
+	writer->failed = false;
+}
+
+static inline void TraceWriterDestroy(TraceWriter *writer)
+{
+	free(writer->buffer);
+	TraceWriterInit(writer);
+}
+
+static inline bool TraceWriterReserve(TraceWriter *writer, size_t length)
+{
+	if (writer->failed) {
+		return false;
+	}
+	if (writer->length + length < writer->capacity) {
+		return true;
+	}
+	size_t capacity = writer->capacity ? writer->capacity : 4096;
+	while (writer->length + length >= capacity) {
+		capacity *= 2;
+	}
+	char *buffer = realloc(writer->buffer, capacity);
+	if (!buffer) {
+		writer->failed = true;
+		return false;
+	}
+	writer->buffer = buffer;
+	writer->capacity = capacity;
+	return true;
+}
+
+static inline void TraceWriterAppendFormat(TraceWriter *writer, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+static inline void TraceWriterAppendFormat(TraceWriter *writer, const char *format, ...)
+{
+	if (!TraceWriterReserve(writer, 64)) {
+		return;
+	}
+	va_list arguments;
+	va_start(arguments, format);
+	int length = vsnprintf(writer->buffer + writer->length, writer->capacity - writer->length, format, arguments);
+	va_end(arguments);
+	if (length < 0) {
+		writer->failed = true;
+		return;
+	}
+	if ((size_t)length >= writer->capacity - writer->length) {
+		if (!TraceWriterReserve(writer, (size_t)length)) {
+			return;
+		}
+		va_start(arguments, format);
+		vsnprintf(writer->buffer + writer->length, writer->capacity - writer->length, format, arguments);
+		va_end(arguments);
+	}
+	writer->length += (size_t)length;
+}
+
+/**
+ * Appends a string as a quoted JSON string.
+ */
+static inline void TraceWriterAppendString(TraceWriter *writer, const char *string)
+{
+	TraceWriterAppendFormat(writer, "\"");
+	for (const unsigned char *character = (const unsigned char *)string; *character; character++) {
+		if (*character == '"' || *character == '\\') {
+			TraceWriterAppendFormat(writer, "\\%c", *character);
+		} else if (*character < 0x20) {
+			TraceWriterAppendFormat(writer, "\\u%04x", *character);
+		} else {
+			TraceWriterAppendFormat(writer, "%c", *character);
+		}
+	}
+	TraceWriterAppendFormat(writer, "\"");
+}
+
+/**
+ * Appends the metadata event that names a thread.
+ */
+static inline void TraceWriterAppendThreadName(TraceWriter *writer, const char *threadName, int processID, uint64_t threadID)
+{
+	TraceWriterAppendFormat(writer, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%llu,\"args\":{\"name\":", processID, (unsigned long long)threadID);
+	TraceWriterAppendString(writer, threadName);
+	TraceWriterAppendFormat(writer, "}}");
+}
+
+/**
+ * Appends an event in the Chrome trace event format, for chrome://tracing.
+ *
+ * A counter carries its value under its own name; an instant is scoped to its thread.
+ */
+static inline void TraceWriterAppendEvent(TraceWriter *writer, const TraceEvent *event, double microseconds, int processID, uint64_t threadID)
+{
+	TraceWriterAppendFormat(writer, "{\"name\":");
+	TraceWriterAppendString(writer, event->name);
+	TraceWriterAppendFormat(writer, ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%llu", event->phase, microseconds, processID, (unsigned long long)threadID);
+	if (event->phase == 'C') {
+		TraceWriterAppendFormat(writer, ",\"args\":{");
+		TraceWriterAppendString(writer, event->name);
+		TraceWriterAppendFormat(writer, ":%lld}", (long long)event->argument);
+	} else if (event->phase == 'i') {
+		TraceWriterAppendFormat(writer, ",\"s\":\"t\",\"args\":{\"value\":%lld}", (long long)event->argument);
+	}
+	TraceWriterAppendFormat(writer, "}");
+}
+
+#endif
@@ -0,0 +1,53 @@
+//
+//  ZoomController.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <OLYCameraKit/OLYCamera.h>
+
+enum ZoomControllerInputMode
+{
+	/** The controller value is a position between the wide and the tele end. */
+	ZoomControllerInputModeAbsolute,
+	/** The controller value is a signed step. (1 to 63 toward tele, 65 to 127 toward wide) */
+	ZoomControllerInputModeRelative,
+};
+
+typedef enum ZoomControllerInputMode ZoomControllerInputMode;
+
+/**
+ * Drives the electric zoom lens to follow a knob or a fader.
+ *
+ * Only the latest target counts; targets that arrive while a request is in flight
+ * replace each other. Long moves drive the lens by speed and stop it when it passes
+ * the target, so a sweep of the fader costs two requests however many values it
+ * sends. Short moves drive the lens to the focal length directly.
+ * All methods must be called on the main thread.
+ */
+@interface ZoomController : NSObject
+
+@property (assign, nonatomic) ZoomControllerInputMode inputMode;
+/** The focal length ratio of one relative step. (default: 1.02) */
+@property (assign, nonatomic) float relativeStepRatio;
+/** The fraction of the zoom range above which the lens is driven by speed. (default: 0.25) */
+@property (assign, nonatomic) float speedDriveThreshold;
+/** The distance in millimeters at which the lens counts as on target. (default: 0.5) */
+@property (assign, nonatomic) float tolerance;
+@property (assign, nonatomic, readonly) float targetFocalLength;
+/** The distance between the target and the actual focal length. */
+@property (assign, nonatomic, readonly) float trackingError;
+/** The largest tracking error since the latest target was reached. */
+@property (assign, nonatomic, readonly) float maximumTrackingError;
+@property (assign, nonatomic, readonly) NSUInteger roundTrips;
+/** The number of targets replaced by a later one before the lens reached them. */
+@property (assign, nonatomic, readonly) NSUInteger coalescedTargets;
+
+- (id)initWithCamera:(OLYCamera *)camera;
+- (void)handleControllerValue:(NSUInteger)value;
+- (void)driveToFocalLength:(float)focalLength;
+- (void)stop;
+
+@end
@@ -0,0 +1,225 @@
+//
+//  ZoomController.m
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#import "ZoomController.h"
+#import "Trace.h"
+#import "ZoomControllerCore.h"
+
+static void *const ZoomControllerFocalLengthContext = (void *)&ZoomControllerFocalLengthContext;
+static void *const ZoomControllerDrivingContext = (void *)&ZoomControllerDrivingContext;
+
+@interface ZoomController ()
+
+@property (weak, nonatomic) OLYCamera *camera;
+@property (strong, nonatomic) dispatch_queue_t queue;
+
+@end
+
+@implementation ZoomController
+{
+	ZoomControllerState _state;
+}
+
+- (id)initWithCamera:(OLYCamera *)camera
+{
+	self = [super init];
+	if (!self) {
+		return nil;
+	}
+	_camera = camera;
+	_queue = dispatch_queue_create([NSString stringWithFormat:@"%@.zoom", [NSBundle mainBundle].bundleIdentifier].UTF8String, DISPATCH_QUEUE_SERIAL);
+	_inputMode = ZoomControllerInputModeAbsolute;
+	_relativeStepRatio = 1.02f;
+	ZoomControllerInit(&_state);
+	[camera addObserver:self forKeyPath:@"actualFocalLength" options:0 context:ZoomControllerFocalLengthContext];
+	[camera addObserver:self forKeyPath:@"drivingZoomLens" options:0 context:ZoomControllerDrivingContext];
+	return self;
+}
+
+- (void)dealloc
+{
+	@try {
+		[_camera removeObserver:self forKeyPath:@"actualFocalLength" context:ZoomControllerFocalLengthContext];
+		[_camera removeObserver:self forKeyPath:@"drivingZoomLens" context:ZoomControllerDrivingContext];
+	}
+	@catch (NSException *exception) {
+		// Ignore all exceptions.
+	}
+}
+
+- (float)speedDriveThreshold
+{
+	return _state.speedDriveThreshold;
+}
+
+- (void)setSpeedDriveThreshold:(float)speedDriveThreshold
+{
+	_state.speedDriveThreshold = speedDriveThreshold;
+}
+
+- (float)tolerance
+{
+	return _state.tolerance;
+}
+
+- (void)setTolerance:(float)tolerance
+{
+	_state.tolerance = tolerance;
+}
+
+- (float)targetFocalLength
+{
+	return _state.targetFocalLength;
+}
+
+- (float)trackingError
+{
+	return _state.trackingError;
+}
+
+- (float)maximumTrackingError
+{
+	return _state.maximumTrackingError;
+}
+
+- (NSUInteger)roundTrips
+{
+	return _state.roundTrips;
+}
+
+- (NSUInteger)coalescedTargets
+{
+	return _state.coalescedTargets;
+}
+
+#pragma mark -
+
+/**
+ * Takes a value of a control change message as the new target.
+ *
+ * @param value The controller value, in the range of 0 to 127.
+ */
+- (void)handleControllerValue:(NSUInteger)value
+{
+	float minimum = self.camera.minimumFocalLength;
+	float maximum = self.camera.maximumFocalLength;
+	if (minimum <= 0 || maximum <= minimum) {
+		// The lens has no zoom, or the camera has not told its range yet.
+		return;
+	}
+	float base = _state.hasTarget ? _state.targetFocalLength : self.camera.actualFocalLength;
+	float focalLength = ZoomControllerFocalLengthForValue((unsigned)MIN(value, (NSUInteger)127), self.inputMode == ZoomControllerInputModeRelative, base, self.relativeStepRatio, minimum, maximum);
+	if (isnan(focalLength)) {
+		return;
+	}
+	[self driveToFocalLength:focalLength];
+}
+
+- (void)driveToFocalLength:(float)focalLength
+{
+	OLYCamera *camera = self.camera;
+	ZoomControllerSetTarget(&_state, focalLength, camera.actualFocalLength, camera.minimumFocalLength, camera.maximumFocalLength);
+	[self updateDrive];
+}
+
+/**
+ * Drops the target and stops the lens where it is.
+ */
+- (void)stop
+{
+	ZoomControllerDropTarget(&_state);
+	[self updateDrive];
+}
+
+#pragma mark -
+
+/**
+ * Sends the next request that ZoomControllerNextRequest decides, if any.
+ */
+- (void)updateDrive
+{
+	float actual = self.camera.actualFocalLength;
+	switch (ZoomControllerNextRequest(&_state, actual, self.camera.minimumFocalLength, self.camera.maximumFocalLength)) {
+		case ZoomControllerRequestNone:
+			break;
+		case ZoomControllerRequestSpeed: {
+			OLYCameraDrivingZoomLensDirection direction = (_state.driveDirection > 0) ? OLYCameraDrivingZoomLensDirectionTele : OLYCameraDrivingZoomLensDirectionWide;
+			OLYCameraDrivingZoomLensSpeed speed = _state.driveFast ? OLYCameraDrivingZoomLensSpeedFast : OLYCameraDrivingZoomLensSpeedNormal;
+			[self issueRequest:^BOOL(OLYCamera *camera, NSError **error) {
+				return [camera startDrivingZoomLensForDirection:direction speed:speed error:error];
+			}];
+			break;
+		}
+		case ZoomControllerRequestTarget: {
+			float focalLength = _state.driveFocalLength;
+			[self issueRequest:^BOOL(OLYCamera *camera, NSError **error) {
+				return [camera startDrivingZoomLensToFocalLength:focalLength error:error];
+			}];
+			break;
+		}
+		case ZoomControllerRequestStop:
+			[self issueRequest:^BOOL(OLYCamera *camera, NSError **error) {
+				return [camera stopDrivingZoomLens:error];
+			}];
+			break;
+	}
+}
+
+- (void)issueRequest:(BOOL (^)(OLYCamera *camera, NSError **error))request
+{
+	TRACE_INSTANT("camera.zoom.issue", _state.requestState);
+	CFAbsoluteTime issueTime = CFAbsoluteTimeGetCurrent();
+
+	__weak ZoomController *weakSelf = self;
+	OLYCamera *camera = self.camera;
+	dispatch_async(self.queue, ^{
+		NSError *error = nil;
+		BOOL result = request(camera, &error);
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[weakSelf finishRequestWithResult:result error:error issueTime:issueTime];
+		});
+	});
+}
+
+- (void)finishRequestWithResult:(BOOL)result error:(NSError *)error issueTime:(CFAbsoluteTime)issueTime
+{
+	NSTimeInterval latency = CFAbsoluteTimeGetCurrent() - issueTime;
+	TRACE_INSTANT("camera.zoom.complete", latency * 1000000.0);
+	ZoomControllerFinishRequest(&_state, result, latency, self.camera.drivingZoomLens);
+	if (!result) {
+		NSLog(@"To drive the zoom lens is failed: %@", error ? error : @"Unknown error");
+		return;
+	}
+	[self updateDrive];
+}
+
+#pragma mark -
+
+- (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context
+{
+	if (context != ZoomControllerFocalLengthContext && context != ZoomControllerDrivingContext) {
+		[super observeValueForKeyPath:keyPath ofObject:object change:change context:context];
+		return;
+	}
+	if (![NSThread isMainThread]) {
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[self observeValueForKeyPath:keyPath ofObject:object change:change context:context];
+		});
+		return;
+	}
+
+	if (context == ZoomControllerFocalLengthContext) {
+		ZoomControllerObserveFocalLength(&_state, self.camera.actualFocalLength, CFAbsoluteTimeGetCurrent());
+		[self updateDrive];
+	} else if (!self.camera.drivingZoomLens) {
+		if (ZoomControllerObserveStop(&_state)) {
+			[self updateDrive];
+		}
+	}
+}
+
+@end
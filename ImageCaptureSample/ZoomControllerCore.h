@@ -0,0 +1,254 @@
+//
+//  ZoomControllerCore.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#ifndef ImageCaptureSample_ZoomControllerCore_h
+#define ImageCaptureSample_ZoomControllerCore_h
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * The drive decisions of ZoomController in plain C, so that they can also be
+ * built and checked against a simulated lens off the device. Focal lengths are
+ * in millimeters and times in seconds.
+ */
+
+typedef enum {
+	ZoomControllerDriveStateIdle,
+	ZoomControllerDriveStateSpeed,
+	ZoomControllerDriveStateTarget,
+} ZoomControllerDriveState;
+
+/** The request to send to the camera next. */
+typedef enum {
+	ZoomControllerRequestNone,
+	/** Drive by speed toward driveDirection, fast if driveFast. */
+	ZoomControllerRequestSpeed,
+	/** Drive to driveFocalLength. */
+	ZoomControllerRequestTarget,
+	ZoomControllerRequestStop,
+} ZoomControllerRequest;
+
+typedef struct {
+	/** The fraction of the zoom range above which the lens is driven by speed. */
+	float speedDriveThreshold;
+	/** The distance at which the lens counts as on target. */
+	float tolerance;
+	bool hasTarget;
+	float targetFocalLength;
+	ZoomControllerDriveState driveState;
+	int driveDirection;
+	bool driveFast;
+	float driveFocalLength;
+	bool requestInFlight;
+	/** The state the lens is in once the request in flight returns. */
+	ZoomControllerDriveState requestState;
+	/** Whether the lens stopped while the request was in flight. */
+	bool stopObserved;
+	double averageLatency;
+	float lensVelocity;
+	float lastFocalLength;
+	double lastFocalLengthTime;
+	/** The distance between the target and the actual focal length. */
+	float trackingError;
+	/** The largest tracking error since the latest target was reached. */
+	float maximumTrackingError;
+	unsigned roundTrips;
+	/** The number of targets replaced by a later one before the lens reached them. */
+	unsigned coalescedTargets;
+} ZoomControllerState;
+
+static inline void ZoomControllerInit(ZoomControllerState *state)
+{
+	*state = (ZoomControllerState){0};
+	state->speedDriveThreshold = 0.25f;
+	state->tolerance = 0.5f;
+}
+
+/**
+ * Returns the target for a control change value, or NAN if the value asks for no move.
+ *
+ * In relative mode, 1 to 63 are steps toward tele and 65 to 127 toward wide, each by
+ * stepRatio from base; otherwise the value is a position between minimum and maximum.
+ * Zooming looks even when the focal length changes by the same ratio for each step.
+ */
+static inline float ZoomControllerFocalLengthForValue(unsigned value, bool relative, float base, float stepRatio, float minimum, float maximum)
+{
+	if (value > 127) {
+		value = 127;
+	}
+	if (relative) {
+		if (value == 0 || value == 64) {
+			return NAN;
+		}
+		int steps = (value < 64) ? (int)value : (int)value - 128;
+		return base * powf(stepRatio, (float)steps);
+	}
+	return minimum * powf(maximum / minimum, value / 127.0f);
+}
+
+static inline void ZoomControllerUpdateTrackingError(ZoomControllerState *state, float actual)
+{
+	if (!state->hasTarget) {
+		return;
+	}
+	state->trackingError = fabsf(state->targetFocalLength - actual);
+	state->maximumTrackingError = fmaxf(state->maximumTrackingError, state->trackingError);
+}
+
+/**
+ * Takes a new target, clipped to the zoom range. Only the latest target counts.
+ */
+static inline void ZoomControllerSetTarget(ZoomControllerState *state, float focalLength, float actual, float minimum, float maximum)
+{
+	if (maximum <= minimum) {
+		return;
+	}
+	focalLength = fmaxf(minimum, fminf(focalLength, maximum));
+	if (state->hasTarget) {
+		state->coalescedTargets++;
+	} else {
+		state->maximumTrackingError = 0;
+	}
+	state->targetFocalLength = focalLength;
+	state->hasTarget = true;
+	ZoomControllerUpdateTrackingError(state, actual);
+}
+
+/**
+ * Drops the target, so that the lens is stopped where it is.
+ */
+static inline void ZoomControllerDropTarget(ZoomControllerState *state)
+{
+	state->hasTarget = false;
+	state->trackingError = 0;
+}
+
+static inline ZoomControllerRequest ZoomControllerIssue(ZoomControllerState *state, ZoomControllerRequest request, ZoomControllerDriveState requestState)
+{
+	state->requestInFlight = true;
+	state->requestState = requestState;
+	state->stopObserved = false;
+	state->roundTrips++;
+	return request;
+}
+
+/**
+ * Decides the next request from the target and the lens position.
+ *
+ * Nothing is sent while a request is in flight; the decision is made again with
+ * the latest target when it returns. A request other than none is in flight from
+ * here until ZoomControllerFinishRequest.
+ */
+static inline ZoomControllerRequest ZoomControllerNextRequest(ZoomControllerState *state, float actual, float minimum, float maximum)
+{
+	if (state->requestInFlight) {
+		return ZoomControllerRequestNone;
+	}
+	if (!state->hasTarget) {
+		if (state->driveState != ZoomControllerDriveStateIdle) {
+			return ZoomControllerIssue(state, ZoomControllerRequestStop, ZoomControllerDriveStateIdle);
+		}
+		return ZoomControllerRequestNone;
+	}
+
+	float error = state->targetFocalLength - actual;
+	switch (state->driveState) {
+		case ZoomControllerDriveStateIdle: {
+			if (fabsf(error) <= state->tolerance) {
+				state->hasTarget = false;
+				return ZoomControllerRequestNone;
+			}
+			float range = maximum - minimum;
+			if (fabsf(error) > range * state->speedDriveThreshold) {
+				state->driveDirection = (error > 0) ? 1 : -1;
+				state->driveFast = (fabsf(error) > range / 2);
+				state->lensVelocity = 0;
+				return ZoomControllerIssue(state, ZoomControllerRequestSpeed, ZoomControllerDriveStateSpeed);
+			}
+			state->driveFocalLength = state->targetFocalLength;
+			return ZoomControllerIssue(state, ZoomControllerRequestTarget, ZoomControllerDriveStateTarget);
+		}
+		case ZoomControllerDriveStateSpeed: {
+			// The lens keeps moving while the stop request travels; stop that much early.
+			float lead = fabsf(state->lensVelocity) * (float)state->averageLatency;
+			if (error * state->driveDirection <= state->tolerance + lead) {
+				return ZoomControllerIssue(state, ZoomControllerRequestStop, ZoomControllerDriveStateIdle);
+			}
+			return ZoomControllerRequestNone;
+		}
+		case ZoomControllerDriveStateTarget: {
+			if (fabsf(state->targetFocalLength - state->driveFocalLength) > state->tolerance) {
+				return ZoomControllerIssue(state, ZoomControllerRequestStop, ZoomControllerDriveStateIdle);
+			}
+			return ZoomControllerRequestNone;
+		}
+	}
+	return ZoomControllerRequestNone;
+}
+
+/**
+ * Takes the outcome of the request in flight.
+ *
+ * A failed request drops the target, since retrying at once would fail the same way.
+ *
+ * @param drivingZoomLens Whether the camera reports the lens as moving now.
+ */
+static inline void ZoomControllerFinishRequest(ZoomControllerState *state, bool succeeded, double latency, bool drivingZoomLens)
+{
+	state->requestInFlight = false;
+	state->averageLatency = (state->averageLatency > 0) ? state->averageLatency * 0.8 + latency * 0.2 : latency;
+	if (!succeeded) {
+		ZoomControllerDropTarget(state);
+		if (!drivingZoomLens) {
+			state->driveState = ZoomControllerDriveStateIdle;
+		}
+		return;
+	}
+	// A short drive may have ended before its request returned.
+	if (state->stopObserved && !drivingZoomLens) {
+		state->driveState = ZoomControllerDriveStateIdle;
+	} else {
+		state->driveState = state->requestState;
+	}
+}
+
+/**
+ * Takes a focal length the camera reported at time now, and follows the lens velocity while driving by speed.
+ */
+static inline void ZoomControllerObserveFocalLength(ZoomControllerState *state, float focalLength, double now)
+{
+	double interval = now - state->lastFocalLengthTime;
+	if (state->driveState == ZoomControllerDriveStateSpeed && interval > 0 && interval < 1.0) {
+		float velocity = (focalLength - state->lastFocalLength) / (float)interval;
+		state->lensVelocity = (state->lensVelocity != 0) ? state->lensVelocity * 0.5f + velocity * 0.5f : velocity;
+	}
+	state->lastFocalLength = focalLength;
+	state->lastFocalLengthTime = now;
+	ZoomControllerUpdateTrackingError(state, focalLength);
+}
+
+/**
+ * Takes the camera reporting that the lens stopped.
+ *
+ * @return true if the drive state changed, so that the next request needs deciding.
+ */
+static inline bool ZoomControllerObserveStop(ZoomControllerState *state)
+{
+	if (state->requestInFlight) {
+		state->stopObserved = true;
+		return false;
+	}
+	if (state->driveState == ZoomControllerDriveStateIdle) {
+		return false;
+	}
+	state->driveState = ZoomControllerDriveStateIdle;
+	return true;
+}
+
+#endif
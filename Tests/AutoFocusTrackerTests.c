@@ -0,0 +1,239 @@
+//
+//  AutoFocusTrackerTests.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include "TestSupport.h"
+#include "AutoFocusTrackerCore.h"
+
+/*
+ * Runs the request scheduling against a simulated camera on a millisecond clock.
+ *
+ * The camera takes one focus request at a time and answers it latency seconds
+ * after it is sent. It keeps count of the requests it was sent while busy, and of
+ * the locks left held after the tracking stopped.
+ */
+
+#define kStep 0.001
+#define kTouchInterval (1.0 / 60.0)
+
+typedef struct {
+	AutoFocusTrackerState tracker;
+	double now;
+	/** When the wait asked for by the tracker is over, or a negative time for none. */
+	double waitEnd;
+	/** The camera. */
+	double latency;
+	bool failRequests;
+	bool busy;
+	double answerTime;
+	size_t requestGeneration;
+	double requestX;
+	unsigned overlappingRequests;
+	bool locked;
+	double lockedX;
+	unsigned unlocks;
+	/** What the tracker did. */
+	double issueTimes[256];
+	unsigned issues;
+	unsigned reports;
+	unsigned reportedFailures;
+	double reportedX;
+} Simulation;
+
+static void Start(Simulation *simulation, double latency)
+{
+	*simulation = (Simulation){.latency = latency, .waitEnd = -1, .now = 1.0};
+	AutoFocusTrackerInit(&simulation->tracker);
+}
+
+static void Unlock(Simulation *simulation)
+{
+	simulation->unlocks++;
+	simulation->locked = false;
+}
+
+/**
+ * Sends the waiting point if the tracker decides so, as issuePendingPoint does.
+ */
+static void Issue(Simulation *simulation)
+{
+	double x, y, wait;
+	size_t generation;
+	AutoFocusTrackerAction action = AutoFocusTrackerNextAction(&simulation->tracker, simulation->now, &x, &y, &generation, &wait);
+	if (action == AutoFocusTrackerActionWait) {
+		simulation->waitEnd = simulation->now + wait;
+		return;
+	}
+	if (action != AutoFocusTrackerActionIssue) {
+		return;
+	}
+	if (simulation->busy) {
+		simulation->overlappingRequests++;
+	}
+	if (simulation->issues < sizeof(simulation->issueTimes) / sizeof(simulation->issueTimes[0])) {
+		simulation->issueTimes[simulation->issues] = simulation->now;
+	}
+	simulation->issues++;
+	// The previous lock is released before the point moves.
+	simulation->locked = false;
+	simulation->busy = true;
+	simulation->answerTime = simulation->now + simulation->latency;
+	simulation->requestGeneration = generation;
+	simulation->requestX = x;
+}
+
+static void TrackPoint(Simulation *simulation, double x)
+{
+	AutoFocusTrackerTrackPoint(&simulation->tracker, x, 0.5);
+	Issue(simulation);
+}
+
+static void Stop(Simulation *simulation)
+{
+	if (AutoFocusTrackerStop(&simulation->tracker)) {
+		Unlock(simulation);
+	}
+}
+
+/**
+ * Advances the clock by seconds, answering requests and ending waits as they fall due.
+ */
+static void Run(Simulation *simulation, double seconds)
+{
+	double end = simulation->now + seconds;
+	while (simulation->now < end) {
+		simulation->now += kStep;
+		if (simulation->busy && simulation->now >= simulation->answerTime) {
+			simulation->busy = false;
+			bool succeeded = !simulation->failRequests;
+			if (succeeded) {
+				simulation->locked = true;
+				simulation->lockedX = simulation->requestX;
+			}
+			bool unlock;
+			bool latest = AutoFocusTrackerFinishRequest(&simulation->tracker, simulation->requestGeneration, simulation->latency, succeeded, &unlock);
+			if (unlock) {
+				Unlock(simulation);
+			}
+			if (latest) {
+				simulation->reports++;
+				simulation->reportedFailures += !succeeded;
+				simulation->reportedX = simulation->requestX;
+			}
+			Issue(simulation);
+		}
+		if (simulation->waitEnd >= 0 && simulation->now >= simulation->waitEnd) {
+			simulation->waitEnd = -1;
+			AutoFocusTrackerFinishWait(&simulation->tracker);
+			Issue(simulation);
+		}
+	}
+}
+
+/**
+ * Drags from 0 to 1 for seconds, with a touch every kTouchInterval.
+ *
+ * @return The number of points.
+ */
+static unsigned Drag(Simulation *simulation, double seconds)
+{
+	unsigned points = (unsigned)(seconds / kTouchInterval);
+	for (unsigned index = 1; index <= points; index++) {
+		TrackPoint(simulation, (double)index / points);
+		Run(simulation, kTouchInterval);
+	}
+	return points;
+}
+
+static void testDragFollowsCameraRate(void)
+{
+	Simulation simulation;
+	Start(&simulation, 0.25);
+	unsigned points = Drag(&simulation, 2.0);
+	Run(&simulation, 1.0);
+	CHECK(simulation.overlappingRequests == 0);
+	// One request per answer of the camera, and the last point after the drag ends.
+	CHECK(simulation.issues <= 2.0 / 0.25 + 2);
+	CHECK(simulation.issues >= 2.0 / 0.25);
+	CHECK(simulation.tracker.issuedRequests + simulation.tracker.coalescedPoints == points);
+	// The camera ends focused on where the finger stopped, and that is reported.
+	CHECK(simulation.locked);
+	CHECK_NEAR(simulation.lockedX, 1.0, 1e-9);
+	CHECK_NEAR(simulation.reportedX, 1.0, 1e-9);
+	CHECK(simulation.reports < simulation.issues);
+}
+
+static void testKeepsMinimumInterval(void)
+{
+	Simulation simulation;
+	Start(&simulation, 0.02);
+	Drag(&simulation, 1.0);
+	Run(&simulation, 0.5);
+	CHECK(simulation.overlappingRequests == 0);
+	CHECK(simulation.issues >= 9);
+	CHECK(simulation.issues <= 11);
+	for (unsigned index = 1; index < simulation.issues; index++) {
+		CHECK(simulation.issueTimes[index] - simulation.issueTimes[index - 1] >= simulation.tracker.minimumInterval - kStep / 2);
+	}
+	CHECK_NEAR(simulation.lockedX, 1.0, 1e-9);
+}
+
+static void testDropsSupersededResult(void)
+{
+	Simulation simulation;
+	Start(&simulation, 0.3);
+	TrackPoint(&simulation, 0.2);
+	Run(&simulation, 0.1);
+	TrackPoint(&simulation, 0.8);
+	Run(&simulation, 1.0);
+	// The first request ran to its end but only the second one was reported.
+	CHECK(simulation.issues == 2);
+	CHECK(simulation.reports == 1);
+	CHECK_NEAR(simulation.reportedX, 0.8, 1e-9);
+	CHECK_NEAR(simulation.lockedX, 0.8, 1e-9);
+}
+
+static void testStopReleasesLateLock(void)
+{
+	Simulation simulation;
+	Start(&simulation, 0.3);
+	TrackPoint(&simulation, 0.5);
+	Run(&simulation, 0.1);
+	TrackPoint(&simulation, 0.6);
+	Stop(&simulation);
+	Run(&simulation, 1.0);
+	// The request in flight locked after the stop; the lock is released again and nothing is reported.
+	CHECK(simulation.issues == 1);
+	CHECK(simulation.reports == 0);
+	CHECK(!simulation.locked);
+	CHECK(simulation.unlocks == 2);
+	CHECK(!simulation.tracker.tracking);
+}
+
+static void testReportsFailureOfLatest(void)
+{
+	Simulation simulation;
+	Start(&simulation, 0.1);
+	simulation.failRequests = true;
+	TrackPoint(&simulation, 0.5);
+	Run(&simulation, 0.5);
+	CHECK(simulation.reports == 1);
+	CHECK(simulation.reportedFailures == 1);
+	CHECK(!simulation.locked);
+	// A failed lock leaves nothing to release after a stop.
+	Stop(&simulation);
+	CHECK(simulation.unlocks == 1);
+}
+
+int main(void)
+{
+	RUN(testDragFollowsCameraRate);
+	RUN(testKeepsMinimumInterval);
+	RUN(testDropsSupersededResult);
+	RUN(testStopReleasesLateLock);
+	RUN(testReportsFailureOfLatest);
+	return TestResult();
+}
@@ -0,0 +1,224 @@
+//
+//  CameraLiveImageAreaMappingTests.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include "TestSupport.h"
+#include "UIKitShim.h"
+#include "CameraLiveImageAreaMapping.h"
+
+/*
+ * The conversions as CameraLiveImageView computed them for every point before
+ * the mapping was cached; the cached mapping must give the same results.
+ */
+
+static CGPoint ReferencePointFromImageArea(CGPoint point, CGSize imageSize, CGSize viewSize, UIViewContentMode contentMode)
+{
+	CGPoint viewPoint = point;
+	CGFloat ratioX = viewSize.width / imageSize.width;
+	CGFloat ratioY = viewSize.height / imageSize.height;
+	CGFloat scale = 0.0;
+
+	switch (contentMode) {
+		case UIViewContentModeScaleToFill:
+		case UIViewContentModeRedraw:
+			viewPoint.x *= ratioX;
+			viewPoint.y *= ratioY;
+			break;
+		case UIViewContentModeScaleAspectFit:
+			scale = MIN(ratioX, ratioY);
+			viewPoint.x *= scale;
+			viewPoint.y *= scale;
+			viewPoint.x += (viewSize.width  - imageSize.width  * scale) / 2.0f;
+			viewPoint.y += (viewSize.height - imageSize.height * scale) / 2.0f;
+			break;
+		case UIViewContentModeScaleAspectFill:
+			scale = MAX(ratioX, ratioY);
+			viewPoint.x *= scale;
+			viewPoint.y *= scale;
+			viewPoint.x += (viewSize.width  - imageSize.width  * scale) / 2.0f;
+			viewPoint.y += (viewSize.height - imageSize.height * scale) / 2.0f;
+			break;
+		case UIViewContentModeCenter:
+			viewPoint.x += viewSize.width / 2.0  - imageSize.width  / 2.0f;
+			viewPoint.y += viewSize.height / 2.0 - imageSize.height / 2.0f;
+			break;
+		case UIViewContentModeTop:
+			viewPoint.x += viewSize.width / 2.0 - imageSize.width / 2.0f;
+			break;
+		case UIViewContentModeBottom:
+			viewPoint.x += viewSize.width / 2.0 - imageSize.width / 2.0f;
+			viewPoint.y += viewSize.height - imageSize.height;
+			break;
+		case UIViewContentModeLeft:
+			viewPoint.y += viewSize.height / 2.0 - imageSize.height / 2.0f;
+			break;
+		case UIViewContentModeRight:
+			viewPoint.x += viewSize.width - imageSize.width;
+			viewPoint.y += viewSize.height / 2.0 - imageSize.height / 2.0f;
+			break;
+		case UIViewContentModeTopRight:
+			viewPoint.x += viewSize.width - imageSize.width;
+			break;
+		case UIViewContentModeBottomLeft:
+			viewPoint.y += viewSize.height - imageSize.height;
+			break;
+		case UIViewContentModeBottomRight:
+			viewPoint.x += viewSize.width  - imageSize.width;
+			viewPoint.y += viewSize.height - imageSize.height;
+			break;
+		case UIViewContentModeTopLeft:
+		default:
+			break;
+	}
+	return viewPoint;
+}
+
+static CGPoint ReferencePointFromViewArea(CGPoint point, CGSize imageSize, CGSize viewSize, UIViewContentMode contentMode)
+{
+	CGPoint imagePoint = point;
+	CGFloat ratioX = viewSize.width / imageSize.width;
+	CGFloat ratioY = viewSize.height / imageSize.height;
+	CGFloat scale = 0.0;
+
+	switch (contentMode) {
+		case UIViewContentModeScaleToFill:
+		case UIViewContentModeRedraw:
+			imagePoint.x /= ratioX;
+			imagePoint.y /= ratioY;
+			break;
+		case UIViewContentModeScaleAspectFit:
+			scale = MIN(ratioX, ratioY);
+			imagePoint.x -= (viewSize.width  - imageSize.width  * scale) / 2.0f;
+			imagePoint.y -= (viewSize.height - imageSize.height * scale) / 2.0f;
+			imagePoint.x /= scale;
+			imagePoint.y /= scale;
+			break;
+		case UIViewContentModeScaleAspectFill:
+			scale = MAX(ratioX, ratioY);
+			imagePoint.x -= (viewSize.width  - imageSize.width  * scale) / 2.0f;
+			imagePoint.y -= (viewSize.height - imageSize.height * scale) / 2.0f;
+			imagePoint.x /= scale;
+			imagePoint.y /= scale;
+			break;
+		case UIViewContentModeCenter:
+			imagePoint.x -= (viewSize.width - imageSize.width)  / 2.0f;
+			imagePoint.y -= (viewSize.height - imageSize.height) / 2.0f;
+			break;
+		case UIViewContentModeTop:
+			imagePoint.x -= (viewSize.width - imageSize.width)  / 2.0f;
+			break;
+		case UIViewContentModeBottom:
+			imagePoint.x -= (viewSize.width - imageSize.width)  / 2.0f;
+			imagePoint.y -= (viewSize.height - imageSize.height);
+			break;
+		case UIViewContentModeLeft:
+			imagePoint.y -= (viewSize.height - imageSize.height) / 2.0f;
+			break;
+		case UIViewContentModeRight:
+			imagePoint.x -= (viewSize.width - imageSize.width);
+			imagePoint.y -= (viewSize.height - imageSize.height) / 2.0f;
+			break;
+		case UIViewContentModeTopRight:
+			imagePoint.x -= (viewSize.width - imageSize.width);
+			break;
+		case UIViewContentModeBottomLeft:
+			imagePoint.y -= (viewSize.height - imageSize.height);
+			break;
+		case UIViewContentModeBottomRight:
+			imagePoint.x -= (viewSize.width - imageSize.width);
+			imagePoint.y -= (viewSize.height - imageSize.height);
+			break;
+		case UIViewContentModeTopLeft:
+		default:
+			break;
+	}
+	return imagePoint;
+}
+
+static CGRect ReferenceRect(CGRect rect, CGSize imageSize, CGSize viewSize, UIViewContentMode contentMode, int fromImageArea)
+{
+	CGPoint (*convert)(CGPoint, CGSize, CGSize, UIViewContentMode) = fromImageArea ? ReferencePointFromImageArea : ReferencePointFromViewArea;
+	CGPoint topLeft = convert(rect.origin, imageSize, viewSize, contentMode);
+	CGPoint bottomRight = convert(CGPointMake(CGRectGetMaxX(rect), CGRectGetMaxY(rect)), imageSize, viewSize, contentMode);
+	return CGRectMake(topLeft.x, topLeft.y, ABS(bottomRight.x - topLeft.x), ABS(bottomRight.y - topLeft.y));
+}
+
+static const CGFloat kImageSizes[][2] = {
+	{ 320, 240 }, { 640, 480 }, { 800, 600 }, { 1024, 768 }, { 240, 320 }, { 480, 640 }, { 333, 217.5 },
+};
+static const CGFloat kViewSizes[][2] = {
+	{ 320, 480 }, { 480, 320 }, { 320, 568 }, { 568, 320 }, { 768, 1024 }, { 1024, 768 }, { 375.5, 667 }, { 100, 100 },
+};
+
+#define COUNT(array) (sizeof(array) / sizeof((array)[0]))
+
+static void testMappingMatchesPerPointConversion(void)
+{
+	unsigned compared = 0;
+	unsigned mismatches = 0;
+	for (size_t imageIndex = 0; imageIndex < COUNT(kImageSizes); imageIndex++) {
+		for (size_t viewIndex = 0; viewIndex < COUNT(kViewSizes); viewIndex++) {
+			CGSize imageSize = CGSizeMake(kImageSizes[imageIndex][0], kImageSizes[imageIndex][1]);
+			CGSize viewSize = CGSizeMake(kViewSizes[viewIndex][0], kViewSizes[viewIndex][1]);
+			for (int mode = UIViewContentModeScaleToFill; mode <= UIViewContentModeBottomRight; mode++) {
+				UIViewContentMode contentMode = (UIViewContentMode)mode;
+				CameraLiveImageAreaMapping mapping = CameraLiveImageAreaMappingMake(imageSize, viewSize, contentMode);
+				for (int step = -4; step <= 20; step++) {
+					CGPoint point = CGPointMake(step * 53.25, step * 31.7 + 0.1);
+					CGPoint expected = ReferencePointFromImageArea(point, imageSize, viewSize, contentMode);
+					CGPoint actual = CameraLiveImageMapPointFromImageArea(&mapping, point);
+					mismatches += (actual.x != expected.x || actual.y != expected.y);
+					expected = ReferencePointFromViewArea(point, imageSize, viewSize, contentMode);
+					actual = CameraLiveImageMapPointFromViewArea(&mapping, point);
+					mismatches += (actual.x != expected.x || actual.y != expected.y);
+
+					CGRect rect = CGRectMake(point.x, point.y, 40.5 + step, 30.25);
+					for (int fromImageArea = 0; fromImageArea <= 1; fromImageArea++) {
+						CGRect expectedRect = ReferenceRect(rect, imageSize, viewSize, contentMode, fromImageArea);
+						CGRect actualRect = fromImageArea ? CameraLiveImageMapRectFromImageArea(&mapping, rect) : CameraLiveImageMapRectFromViewArea(&mapping, rect);
+						mismatches += (actualRect.origin.x != expectedRect.origin.x || actualRect.origin.y != expectedRect.origin.y ||
+									   actualRect.size.width != expectedRect.size.width || actualRect.size.height != expectedRect.size.height);
+					}
+					compared += 4;
+				}
+			}
+		}
+	}
+	CHECK(compared > 10000);
+	CHECK(mismatches == 0);
+}
+
+static void testMappingIsKeyedOnTheWholeLayout(void)
+{
+	CGSize imageSize = CGSizeMake(640, 480);
+	CGSize viewSize = CGSizeMake(320, 568);
+	CameraLiveImageAreaMapping mapping = CameraLiveImageAreaMappingMake(imageSize, viewSize, UIViewContentModeScaleAspectFit);
+	CHECK(CameraLiveImageAreaMappingMatches(&mapping, imageSize, viewSize, UIViewContentModeScaleAspectFit));
+	// Rotating the view keeps the image size; the mapping must still be made again.
+	CHECK(!CameraLiveImageAreaMappingMatches(&mapping, imageSize, CGSizeMake(568, 320), UIViewContentModeScaleAspectFit));
+	CHECK(!CameraLiveImageAreaMappingMatches(&mapping, CGSizeMake(320, 240), viewSize, UIViewContentModeScaleAspectFit));
+	CHECK(!CameraLiveImageAreaMappingMatches(&mapping, imageSize, viewSize, UIViewContentModeScaleAspectFill));
+}
+
+static void testRoundTripReturnsThePoint(void)
+{
+	CameraLiveImageAreaMapping mapping = CameraLiveImageAreaMappingMake(CGSizeMake(640, 480), CGSizeMake(320, 568), UIViewContentModeScaleAspectFit);
+	CGPoint point = CGPointMake(123.5, 456.25);
+	CGPoint viewPoint = CameraLiveImageMapPointFromImageArea(&mapping, point);
+	CGPoint imagePoint = CameraLiveImageMapPointFromViewArea(&mapping, viewPoint);
+	CHECK_NEAR(imagePoint.x, point.x, 1e-3);
+	CHECK_NEAR(imagePoint.y, point.y, 1e-3);
+	// The image is letterboxed in the middle of the tall view.
+	CHECK_NEAR(CameraLiveImageMapPointFromImageArea(&mapping, CGPointMake(0, 0)).y, (568 - 240) / 2.0, 1e-6);
+}
+
+int main(void)
+{
+	RUN(testMappingMatchesPerPointConversion);
+	RUN(testMappingIsKeyedOnTheWholeLayout);
+	RUN(testRoundTripReturnsThePoint);
+	return TestResult();
+}
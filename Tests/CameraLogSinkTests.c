@@ -0,0 +1,197 @@
+//
+//  CameraLogSinkTests.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include "TestSupport.h"
+#include "CameraLogSinkCore.h"
+
+enum
+{
+	kProducerCount = 4,
+	kMessagesPerProducer = 100000,
+};
+
+static CameraLogRing Ring;
+
+/**
+ * Puts a message in the ring as CameraLogSink does; the level carries the producer
+ * and the time the index, so that the text can be checked against them.
+ */
+static bool PutMessage(int producer, int64_t index)
+{
+	int64_t position;
+	CameraLogSlot *slot = CameraLogRingClaim(&Ring, &position);
+	if (!slot) {
+		return false;
+	}
+	int length = snprintf(slot->text, kCameraLogMessageLength, "producer %d message %lld", producer, (long long)index);
+	slot->time = (double)index;
+	slot->level = producer;
+	slot->length = (uint32_t)length;
+	CameraLogRingPublish(slot, position);
+	return true;
+}
+
+/**
+ * Returns whether a slot holds a whole message as PutMessage wrote it.
+ */
+static bool IsWholeMessage(const CameraLogSlot *slot)
+{
+	char expected[kCameraLogMessageLength];
+	int length = snprintf(expected, sizeof(expected), "producer %d message %lld", slot->level, (long long)slot->time);
+	return slot->length == (uint32_t)length && memcmp(slot->text, expected, (size_t)length) == 0;
+}
+
+static void testTakesMessagesInOrder(void)
+{
+	CHECK(CameraLogRingInit(&Ring));
+	CHECK(!CameraLogRingPeek(&Ring));
+	for (int64_t index = 0; index < 10; index++) {
+		CHECK(PutMessage(0, index));
+	}
+	for (int64_t index = 0; index < 10; index++) {
+		const CameraLogSlot *slot = CameraLogRingPeek(&Ring);
+		CHECK(slot != NULL);
+		if (!slot) {
+			break;
+		}
+		CHECK(slot->time == (double)index);
+		CHECK(IsWholeMessage(slot));
+		CameraLogRingRelease(&Ring);
+	}
+	CHECK(!CameraLogRingPeek(&Ring));
+	CHECK(Ring.writtenCount == 10);
+	CHECK(Ring.droppedCount == 0);
+	CameraLogRingDestroy(&Ring);
+}
+
+static void testDropsWhenFull(void)
+{
+	CHECK(CameraLogRingInit(&Ring));
+	for (int64_t index = 0; index < kCameraLogRingCapacity; index++) {
+		CHECK(PutMessage(0, index));
+	}
+	CHECK(!PutMessage(0, kCameraLogRingCapacity));
+	CHECK(!PutMessage(0, kCameraLogRingCapacity + 1));
+	CHECK(Ring.droppedCount == 2);
+
+	// Freeing one slot makes room for one more message, after the ones already held.
+	CameraLogRingRelease(&Ring);
+	CHECK(PutMessage(0, kCameraLogRingCapacity + 2));
+	CHECK(!PutMessage(0, kCameraLogRingCapacity + 3));
+	int64_t expected = 1;
+	const CameraLogSlot *slot;
+	while ((slot = CameraLogRingPeek(&Ring))) {
+		CHECK(slot->time == (double)expected);
+		expected = (expected == kCameraLogRingCapacity - 1) ? kCameraLogRingCapacity + 2 : expected + 1;
+		CameraLogRingRelease(&Ring);
+	}
+	CHECK(expected == kCameraLogRingCapacity + 3);
+	CameraLogRingDestroy(&Ring);
+}
+
+static volatile int ProducersDone = 0;
+static volatile int32_t ProducerDrops[kProducerCount];
+
+static void *ProduceMessages(void *context)
+{
+	int producer = (int)(intptr_t)context;
+	int32_t drops = 0;
+	for (int64_t index = 0; index < kMessagesPerProducer; index++) {
+		// Unlike the SDK, wait for room, so that the writer is kept busy and every message is written.
+		while (!PutMessage(producer, index)) {
+			drops++;
+			sched_yield();
+		}
+	}
+	ProducerDrops[producer] = drops;
+	__sync_fetch_and_add(&ProducersDone, 1);
+	return NULL;
+}
+
+/**
+ * Several threads log at once while the writer drains, as when the SDK logs
+ * from its own queues. Every message must come out whole and in the order its
+ * producer put it in, and every refused claim must be counted as dropped.
+ */
+static void testManyProducersThroughput(void)
+{
+	CHECK(CameraLogRingInit(&Ring));
+	ProducersDone = 0;
+	pthread_t producers[kProducerCount];
+	int started = 0;
+	double start = TestSeconds();
+	for (int producer = 0; producer < kProducerCount; producer++) {
+		if (pthread_create(&producers[producer], NULL, ProduceMessages, (void *)(intptr_t)producer) != 0) {
+			CHECK(!"a producer thread could not start");
+			break;
+		}
+		started++;
+	}
+
+	int64_t lastIndex[kProducerCount];
+	for (int producer = 0; producer < kProducerCount; producer++) {
+		lastIndex[producer] = -1;
+	}
+	int64_t taken = 0;
+	int torn = 0;
+	int unordered = 0;
+	for (;;) {
+		int done = ProducersDone;
+		__sync_synchronize();
+		const CameraLogSlot *slot;
+		int64_t pass = taken;
+		while ((slot = CameraLogRingPeek(&Ring))) {
+			if (slot->level < 0 || slot->level >= kProducerCount || !IsWholeMessage(slot)) {
+				torn++;
+			} else {
+				int64_t index = (int64_t)slot->time;
+				if (index <= lastIndex[slot->level]) {
+					unordered++;
+				}
+				lastIndex[slot->level] = index;
+			}
+			CameraLogRingRelease(&Ring);
+			taken++;
+		}
+		// Only a pass that began after the last producer finished has seen everything.
+		if (done == started) {
+			break;
+		}
+		if (taken == pass) {
+			sched_yield();
+		}
+	}
+	double elapsed = TestSeconds() - start;
+	for (int producer = 0; producer < started; producer++) {
+		pthread_join(producers[producer], NULL);
+	}
+
+	int64_t dropped = 0;
+	for (int producer = 0; producer < started; producer++) {
+		dropped += ProducerDrops[producer];
+	}
+	int64_t total = (int64_t)started * kMessagesPerProducer;
+	CHECK(torn == 0);
+	CHECK(unordered == 0);
+	CHECK(taken == Ring.writtenCount);
+	CHECK(dropped == Ring.droppedCount);
+	CHECK(taken == total);
+	printf("     %d producers: %.2f M messages/s, %lld claims refused while full\n", started, taken / elapsed * 1e-6, (long long)dropped);
+	CameraLogRingDestroy(&Ring);
+}
+
+int main(void)
+{
+	RUN(testTakesMessagesInOrder);
+	RUN(testDropsWhenFull);
+	RUN(testManyProducersThroughput);
+	return TestResult();
+}
@@ -0,0 +1,271 @@
+//
+//  ConnectionHealthMonitorTests.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include <stdlib.h>
+#include "TestSupport.h"
+#include "ConnectionHealthMonitorCore.h"
+
+/*
+ * Replays network traces through the evaluation windows and the policy, as
+ * ConnectionHealthMonitor runs them on the device.
+ *
+ * usage: ConnectionHealthMonitorTests [trace.txt ...]
+ *
+ * A trace is a throughput trace of the link, one "kilobytes_per_second latency_ms"
+ * line per second, such as a throughput logger on the phone records. Each
+ * given trace is replayed after the tests and its decisions are printed.
+ *
+ * The camera sends up to kFrameRate frames a second, but no faster than the link
+ * carries a frame of the current size. A command is issued every kCommandInterval
+ * seconds and waits behind the frame being sent.
+ */
+
+#define kFrameRate 30.0
+#define kCommandInterval 0.5
+#define kEvaluationInterval 1.0
+#define kTick 0.001
+
+enum { kMaximumStep = 3 };
+
+/** The frame sizes of QVGA, VGA, SVGA and XGA in kilobytes. */
+static const double FrameKilobytes[kMaximumStep + 1] = { 8.0, 20.0, 32.0, 50.0 };
+
+typedef struct {
+	double kilobytesPerSecond;
+	double latency;
+} TraceSecond;
+
+typedef struct {
+	ConnectionHealthWindow window;
+	HysteresisQualityPolicyState policy;
+	size_t step;
+	unsigned changes;
+	double secondsAtStep[kMaximumStep + 1];
+	/** The step of each second, for the checks. */
+	size_t *steps;
+} Replay;
+
+static void Evaluate(Replay *replay, double time)
+{
+	ConnectionHealthSample sample;
+	if (!ConnectionHealthWindowClose(&replay->window, time, &sample)) {
+		return;
+	}
+	int change = HysteresisQualityPolicyStepChange(&replay->policy, &sample, replay->step, kMaximumStep);
+	size_t step = ConnectionHealthNextStep(replay->step, change, kMaximumStep);
+	if (step == replay->step) {
+		return;
+	}
+	replay->step = step;
+	replay->changes++;
+	replay->window.lastFrameTime = 0;
+}
+
+/**
+ * Runs a trace of count seconds on a millisecond clock, starting at the largest size.
+ */
+static void RunTrace(Replay *replay, const TraceSecond *trace, size_t count)
+{
+	*replay = (Replay){.step = kMaximumStep};
+	HysteresisQualityPolicyInit(&replay->policy);
+	replay->steps = calloc(count, sizeof(size_t));
+	uint32_t seed = 7;
+
+	// The clock starts at one second, since a time of zero means none to the window.
+	double start = 1.0;
+	double nextFrame = start;
+	double nextCommand = start;
+	double nextTimer = start + kEvaluationInterval;
+	for (double now = start; now < start + count; now += kTick) {
+		size_t second = (size_t)(now - start);
+		if (second >= count) {
+			break;
+		}
+		const TraceSecond *link = &trace[second];
+		if (now >= nextFrame) {
+			if (link->kilobytesPerSecond > 0) {
+				if (ConnectionHealthWindowRecordFrame(&replay->window, (size_t)(FrameKilobytes[replay->step] * 1024), now, kEvaluationInterval)) {
+					Evaluate(replay, now);
+				}
+				double interval = FrameKilobytes[replay->step] / link->kilobytesPerSecond;
+				if (interval < 1.0 / kFrameRate) {
+					interval = 1.0 / kFrameRate;
+				}
+				// Up to 20% of jitter, as on a shared channel.
+				nextFrame = now + interval * (0.9 + 0.2 * (TestRandom(&seed) % 1000) / 1000.0);
+			} else {
+				nextFrame = now + kTick;
+			}
+		}
+		if (now >= nextCommand) {
+			if (link->kilobytesPerSecond > 0) {
+				double queueing = FrameKilobytes[replay->step] / link->kilobytesPerSecond;
+				ConnectionHealthWindowRecordCommandLatency(&replay->window, link->latency + queueing);
+			}
+			nextCommand = now + kCommandInterval;
+		}
+		if (now >= nextTimer) {
+			// The timer only notices when the frames stop coming.
+			if (now - replay->window.windowStartTime >= kEvaluationInterval) {
+				Evaluate(replay, now);
+			}
+			nextTimer = now + kEvaluationInterval;
+		}
+		replay->steps[second] = replay->step;
+		replay->secondsAtStep[replay->step] += kTick;
+	}
+}
+
+static void FinishReplay(Replay *replay)
+{
+	free(replay->steps);
+	replay->steps = NULL;
+}
+
+/**
+ * Fills seconds first to last - 1 of a trace with one condition.
+ */
+static void FillTrace(TraceSecond *trace, size_t first, size_t last, double kilobytesPerSecond, double latency)
+{
+	for (size_t second = first; second < last; second++) {
+		trace[second] = (TraceSecond){kilobytesPerSecond, latency};
+	}
+}
+
+static void testKeepsSizeOnHealthyLink(void)
+{
+	TraceSecond trace[60];
+	FillTrace(trace, 0, 60, 3000, 0.02);
+	Replay replay;
+	RunTrace(&replay, trace, 60);
+	CHECK(replay.changes == 0);
+	CHECK(replay.step == kMaximumStep);
+	FinishReplay(&replay);
+}
+
+static void testStepsDownInCongestionAndRecovers(void)
+{
+	TraceSecond trace[70];
+	FillTrace(trace, 0, 10, 3000, 0.02);
+	FillTrace(trace, 10, 25, 150, 0.05);
+	FillTrace(trace, 25, 70, 3000, 0.02);
+	Replay replay;
+	RunTrace(&replay, trace, 70);
+	// Two bad windows, and one more that straddles the onset.
+	CHECK(replay.steps[13] < kMaximumStep);
+	// At 150 kB/s only VGA and below keep up.
+	CHECK(replay.steps[24] <= 1);
+	CHECK(replay.steps[24] >= 1);
+	CHECK(replay.step == kMaximumStep);
+	FinishReplay(&replay);
+}
+
+static void testStallKeepsSize(void)
+{
+	TraceSecond trace[40];
+	FillTrace(trace, 0, 10, 3000, 0.02);
+	FillTrace(trace, 10, 20, 0, 0);
+	FillTrace(trace, 20, 40, 3000, 0.02);
+	Replay replay;
+	RunTrace(&replay, trace, 40);
+	// The windows without frames say nothing, and the gap is a single bad window.
+	CHECK(replay.changes == 0);
+	FinishReplay(&replay);
+}
+
+static void testStepsDownForSlowCommands(void)
+{
+	TraceSecond trace[30];
+	FillTrace(trace, 0, 10, 3000, 0.02);
+	FillTrace(trace, 10, 30, 3000, 0.5);
+	Replay replay;
+	RunTrace(&replay, trace, 30);
+	CHECK(replay.steps[9] == kMaximumStep);
+	CHECK(replay.steps[13] < kMaximumStep);
+	CHECK(replay.step == 0);
+	FinishReplay(&replay);
+}
+
+/**
+ * A link at the edge of VGA: QVGA is good and VGA is bad, so every step up fails.
+ * The backoff must keep the tries rare and the time at the bad size short.
+ */
+static void testSettlesOnMarginalLink(void)
+{
+	enum { kSeconds = 300 };
+	TraceSecond trace[kSeconds];
+	FillTrace(trace, 0, kSeconds, 95, 0.02);
+	Replay replay;
+	RunTrace(&replay, trace, kSeconds);
+	CHECK(replay.steps[kSeconds - 1] <= 1);
+	// Without the backoff, a try every seven seconds would make over 80 changes.
+	CHECK(replay.changes <= 20);
+	double settled = 0;
+	for (size_t second = 30; second < kSeconds; second++) {
+		settled += (replay.steps[second] == 0);
+	}
+	CHECK(settled / (kSeconds - 30) >= 0.9);
+	FinishReplay(&replay);
+}
+
+static TraceSecond *LoadTrace(const char *path, size_t *count)
+{
+	FILE *file = fopen(path, "r");
+	if (!file) {
+		return NULL;
+	}
+	size_t capacity = 256;
+	TraceSecond *trace = malloc(capacity * sizeof(TraceSecond));
+	*count = 0;
+	double kilobytesPerSecond, latency;
+	while (trace && fscanf(file, "%lf %lf", &kilobytesPerSecond, &latency) == 2) {
+		if (*count == capacity) {
+			capacity *= 2;
+			TraceSecond *grown = realloc(trace, capacity * sizeof(TraceSecond));
+			if (!grown) {
+				free(trace);
+				trace = NULL;
+				break;
+			}
+			trace = grown;
+		}
+		trace[(*count)++] = (TraceSecond){kilobytesPerSecond, latency / 1000.0};
+	}
+	fclose(file);
+	return trace;
+}
+
+static void ReplayTraceFile(const char *path)
+{
+	size_t count = 0;
+	TraceSecond *trace = LoadTrace(path, &count);
+	if (!trace || count == 0) {
+		fprintf(stderr, "%s: could not read the trace\n", path);
+		TestFailures++;
+		free(trace);
+		return;
+	}
+	Replay replay;
+	RunTrace(&replay, trace, count);
+	printf("%s: %zu s, %u changes, QVGA %.0f s, VGA %.0f s, SVGA %.0f s, XGA %.0f s\n", path, count, replay.changes,
+		replay.secondsAtStep[0], replay.secondsAtStep[1], replay.secondsAtStep[2], replay.secondsAtStep[3]);
+	FinishReplay(&replay);
+	free(trace);
+}
+
+int main(int argc, char *argv[])
+{
+	RUN(testKeepsSizeOnHealthyLink);
+	RUN(testStepsDownInCongestionAndRecovers);
+	RUN(testStallKeepsSize);
+	RUN(testStepsDownForSlowCommands);
+	RUN(testSettlesOnMarginalLink);
+	for (int index = 1; index < argc; index++) {
+		ReplayTraceFile(argv[index]);
+	}
+	return TestResult();
+}
@@ -0,0 +1,196 @@
+//
+//  ContentCacheBenchmark.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "TestSupport.h"
+#include "ContentCacheCore.h"
+
+/*
+ * Measures the disk tier of the content cache on a synthetic browsing session.
+ *
+ * usage: ContentCacheBenchmark [directory]
+ *
+ * Thumbnails of 8 to 40 KB are stored into a 32 MB budget while earlier ones are looked
+ * up with a bias towards recent ones, as when scrolling back and forth through a card.
+ * The pack is appended to, evicted from and compacted as ContentCache does, with the pack
+ * synced before each index write. The compaction time is how long lookups were held up
+ * before it moved off the cache queue.
+ */
+
+enum
+{
+	kStoreCount = 20000,
+	kLookupsPerStore = 4,
+	kIndexSaveInterval = 200,
+};
+
+int main(int argc, char *argv[])
+{
+	const char *directory = argc >= 2 ? argv[1] : "/tmp";
+	char packPath[512];
+	char compactedPath[512];
+	snprintf(packPath, sizeof(packPath), "%s/ContentCacheBenchmark-0.pack", directory);
+	snprintf(compactedPath, sizeof(compactedPath), "%s/ContentCacheBenchmark-1.pack", directory);
+	int fd = open(packPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		fprintf(stderr, "To open %s is failed.\n", packPath);
+		return 1;
+	}
+
+	const uint64_t byteLimit = 32 * 1024 * 1024;
+	ContentCacheEntry *entries = calloc(kStoreCount, sizeof(ContentCacheEntry));
+	size_t *keys = calloc(kStoreCount, sizeof(size_t));
+	size_t *order = calloc(kStoreCount, sizeof(size_t));
+	uint64_t *compactedOffsets = calloc(kStoreCount, sizeof(uint64_t));
+	ContentCacheEntry *liveEntries = calloc(kStoreCount, sizeof(ContentCacheEntry));
+	uint8_t *thumbnail = malloc(40 * 1024);
+	uint32_t seed = 1;
+	for (size_t index = 0; index < 40 * 1024; index++) {
+		thumbnail[index] = (uint8_t)TestRandom(&seed);
+	}
+
+	size_t liveCount = 0;
+	uint64_t packLength = 0;
+	uint64_t usage = 0;
+	uint64_t appendedBytes = 0;
+	double appendTime = 0, syncTime = 0, evictTime = 0, lookupTime = 0, compactTime = 0, longestCompaction = 0;
+	unsigned long lookups = 0, hits = 0, evictions = 0, compactions = 0, syncs = 0;
+	uint64_t compactedBytes = 0;
+	const uint8_t *mapped = NULL;
+	uint64_t mappedLength = 0;
+	volatile uint32_t checksum = 0;
+	double clock = 0;
+
+	for (size_t store = 0; store < kStoreCount; store++) {
+		size_t length = 8 * 1024 + TestRandom(&seed) % (32 * 1024);
+		double start = TestSeconds();
+		uint64_t offset;
+		if (!ContentCacheAppend(fd, thumbnail, length, &offset)) {
+			fprintf(stderr, "To append to %s is failed.\n", packPath);
+			return 1;
+		}
+		appendTime += TestSeconds() - start;
+		appendedBytes += length;
+		packLength = offset + length;
+		usage += length;
+		entries[liveCount].offset = offset;
+		entries[liveCount].length = length;
+		entries[liveCount].accessTime = ++clock;
+		keys[liveCount] = store;
+		liveCount++;
+
+		if (usage > byteLimit) {
+			start = TestSeconds();
+			size_t evictedCount = ContentCacheSelectEvictions(entries, liveCount, usage, byteLimit / 10 * 9, order);
+			for (size_t index = 0; index < evictedCount; index++) {
+				usage -= entries[order[index]].length;
+				entries[order[index]].length = 0;
+			}
+			size_t kept = 0;
+			for (size_t index = 0; index < liveCount; index++) {
+				if (entries[index].length > 0) {
+					entries[kept] = entries[index];
+					keys[kept] = keys[index];
+					kept++;
+				}
+			}
+			liveCount = kept;
+			evictions += evictedCount;
+			evictTime += TestSeconds() - start;
+		}
+
+		if (ContentCacheShouldCompact(packLength, usage)) {
+			start = TestSeconds();
+			if (mapped) {
+				munmap((void *)mapped, mappedLength);
+			}
+			mapped = mmap(NULL, packLength, PROT_READ, MAP_SHARED, fd, 0);
+			mappedLength = packLength;
+			int compactedFd = open(compactedPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+			memcpy(liveEntries, entries, liveCount * sizeof(ContentCacheEntry));
+			uint64_t compactedLength = 0;
+			if (mapped == MAP_FAILED || compactedFd < 0 || !ContentCacheCopyEntries(mapped, packLength, liveEntries, liveCount, compactedFd, compactedOffsets, &compactedLength) || fsync(compactedFd) != 0) {
+				fprintf(stderr, "To compact %s is failed.\n", packPath);
+				return 1;
+			}
+			munmap((void *)mapped, mappedLength);
+			mapped = NULL;
+			for (size_t index = 0; index < liveCount; index++) {
+				entries[index].offset = compactedOffsets[index];
+			}
+			rename(compactedPath, packPath);
+			close(fd);
+			fd = compactedFd;
+			packLength = compactedLength;
+			double elapsed = TestSeconds() - start;
+			compactTime += elapsed;
+			longestCompaction = elapsed > longestCompaction ? elapsed : longestCompaction;
+			compactedBytes += compactedLength;
+			compactions++;
+		}
+
+		if (store % kIndexSaveInterval == kIndexSaveInterval - 1) {
+			start = TestSeconds();
+			fsync(fd);
+			syncTime += TestSeconds() - start;
+			syncs++;
+		}
+
+		start = TestSeconds();
+		for (int lookup = 0; lookup < kLookupsPerStore; lookup++) {
+			// Mostly the last few hundred stored, sometimes anything since the start.
+			size_t back = TestRandom(&seed) % 8 ? TestRandom(&seed) % 300 : TestRandom(&seed) % (store + 1);
+			size_t wanted = back <= store ? store - back : 0;
+			lookups++;
+			// The index is in store order, so a binary search stands in for the dictionary.
+			size_t low = 0, high = liveCount;
+			while (low < high) {
+				size_t middle = (low + high) / 2;
+				if (keys[middle] < wanted) {
+					low = middle + 1;
+				} else {
+					high = middle;
+				}
+			}
+			if (low == liveCount || keys[low] != wanted) {
+				continue;
+			}
+			ContentCacheEntry *entry = &entries[low];
+			if (!mapped || entry->offset + entry->length > mappedLength) {
+				if (mapped) {
+					munmap((void *)mapped, mappedLength);
+				}
+				mapped = mmap(NULL, packLength, PROT_READ, MAP_SHARED, fd, 0);
+				mappedLength = packLength;
+			}
+			checksum += mapped[entry->offset] + mapped[entry->offset + entry->length - 1];
+			entry->accessTime = ++clock;
+			hits++;
+		}
+		lookupTime += TestSeconds() - start;
+	}
+
+	double megabytes = appendedBytes / (1024.0 * 1024.0);
+	printf("content cache: append %.0f MB/s, %.2f us/lookup (%.0f%% hit), evict %.1f us/store (%lu evicted)\n", megabytes / appendTime, lookupTime / lookups * 1e6, 100.0 * hits / lookups, evictTime / kStoreCount * 1e6, evictions);
+	printf("content cache: %lu compactions at %.0f MB/s, longest %.1f ms; pack sync %.2f ms per index write\n", compactions, compactedBytes / (1024.0 * 1024.0) / compactTime, longestCompaction * 1e3, syncs ? syncTime / syncs * 1e3 : 0);
+
+	if (mapped) {
+		munmap((void *)mapped, mappedLength);
+	}
+	close(fd);
+	unlink(packPath);
+	free(entries);
+	free(keys);
+	free(order);
+	free(compactedOffsets);
+	free(liveEntries);
+	free(thumbnail);
+	return 0;
+}
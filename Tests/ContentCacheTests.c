@@ -0,0 +1,142 @@
+//
+//  ContentCacheTests.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "TestSupport.h"
+#include "ContentCacheCore.h"
+
+static void testNothingEvictedWithinTarget(void)
+{
+	ContentCacheEntry entries[] = {{0, 10, 3}, {10, 10, 1}};
+	size_t order[2];
+	CHECK(ContentCacheSelectEvictions(entries, 2, 20, 20, order) == 0);
+	CHECK(ContentCacheSelectEvictions(entries, 0, 20, 10, order) == 0);
+}
+
+static void testEvictsLeastRecentlyUsedFirst(void)
+{
+	ContentCacheEntry entries[] = {{0, 10, 5}, {10, 10, 2}, {20, 10, 9}, {30, 10, 1}, {40, 10, 7}};
+	size_t order[5];
+	size_t count = ContentCacheSelectEvictions(entries, 5, 50, 25, order);
+	CHECK(count == 3);
+	CHECK(order[0] == 3);
+	CHECK(order[1] == 1);
+	CHECK(order[2] == 0);
+}
+
+static void testEvictsEverythingIfNeeded(void)
+{
+	ContentCacheEntry entries[] = {{0, 10, 2}, {10, 10, 1}};
+	size_t order[2];
+	CHECK(ContentCacheSelectEvictions(entries, 2, 30, 0, order) == 2);
+	CHECK(order[0] == 1);
+	CHECK(order[1] == 0);
+}
+
+static void testEvictionMatchesSortOnRandomIndex(void)
+{
+	// The selection is the oldest entries in order, like sorting the whole index.
+	enum { kCount = 1000 };
+	static ContentCacheEntry entries[kCount];
+	static size_t order[kCount];
+	uint32_t seed = 7;
+	uint64_t usage = 0;
+	for (size_t index = 0; index < kCount; index++) {
+		entries[index].length = 1 + TestRandom(&seed) % 1000;
+		entries[index].accessTime = TestRandom(&seed) % 100000;
+		usage += entries[index].length;
+	}
+	uint64_t target = usage / 3;
+	size_t count = ContentCacheSelectEvictions(entries, kCount, usage, target, order);
+	int unordered = 0;
+	uint64_t remaining = usage;
+	double newestEvicted = 0;
+	for (size_t index = 0; index < count; index++) {
+		if (index > 0 && entries[order[index]].accessTime < entries[order[index - 1]].accessTime) {
+			unordered++;
+		}
+		remaining -= entries[order[index]].length;
+		newestEvicted = entries[order[index]].accessTime;
+	}
+	CHECK(unordered == 0);
+	CHECK(remaining <= target);
+	CHECK(remaining + entries[order[count - 1]].length > target);
+	int olderKept = 0;
+	for (size_t index = count; index < kCount; index++) {
+		if (entries[order[index]].accessTime < newestEvicted) {
+			olderKept++;
+		}
+	}
+	CHECK(olderKept == 0);
+}
+
+static void testShouldCompact(void)
+{
+	const uint64_t megabyte = 1024 * 1024;
+	CHECK(!ContentCacheShouldCompact(megabyte, 0));
+	CHECK(!ContentCacheShouldCompact(10 * megabyte, 6 * megabyte));
+	CHECK(ContentCacheShouldCompact(10 * megabyte, 4 * megabyte));
+	CHECK(!ContentCacheShouldCompact(megabyte, 2 * megabyte));
+}
+
+static int OpenTemporaryPack(char *path)
+{
+	strcpy(path, "/tmp/ContentCacheTests-XXXXXX");
+	return mkstemp(path);
+}
+
+static void testAppendReturnsOffsets(void)
+{
+	char path[64];
+	int fd = OpenTemporaryPack(path);
+	CHECK(fd >= 0);
+	uint64_t offset = 1;
+	CHECK(ContentCacheAppend(fd, "abc", 3, &offset));
+	CHECK(offset == 0);
+	CHECK(ContentCacheAppend(fd, "defgh", 5, &offset));
+	CHECK(offset == 3);
+	char bytes[8];
+	CHECK(pread(fd, bytes, 8, 0) == 8);
+	CHECK(memcmp(bytes, "abcdefgh", 8) == 0);
+	close(fd);
+	unlink(path);
+}
+
+static void testCopyEntriesPacksLiveEntries(void)
+{
+	const uint8_t pack[] = "0123456789";
+	ContentCacheEntry entries[] = {{6, 3, 0}, {8, 4, 0}, {1, 2, 0}, {20, 1, 0}};
+	uint64_t offsets[4];
+	uint64_t length = 0;
+	char path[64];
+	int fd = OpenTemporaryPack(path);
+	CHECK(fd >= 0);
+	CHECK(ContentCacheCopyEntries(pack, 10, entries, 4, fd, offsets, &length));
+	CHECK(length == 5);
+	CHECK(offsets[0] == 0);
+	CHECK(offsets[1] == kContentCacheNoOffset);
+	CHECK(offsets[2] == 3);
+	CHECK(offsets[3] == kContentCacheNoOffset);
+	char bytes[6] = {0};
+	CHECK(pread(fd, bytes, sizeof(bytes), 0) == 5);
+	CHECK(memcmp(bytes, "67812", 5) == 0);
+	close(fd);
+	unlink(path);
+}
+
+int main(void)
+{
+	RUN(testNothingEvictedWithinTarget);
+	RUN(testEvictsLeastRecentlyUsedFirst);
+	RUN(testEvictsEverythingIfNeeded);
+	RUN(testEvictionMatchesSortOnRandomIndex);
+	RUN(testShouldCompact);
+	RUN(testAppendReturnsOffsets);
+	RUN(testCopyEntriesPacksLiveEntries);
+	return TestResult();
+}
@@ -0,0 +1,158 @@
+//
+//  IntervalometerTests.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include "TestSupport.h"
+#include "IntervalometerCore.h"
+
+/**
+ * Runs slots against a simulated clock whose timers fire late by the delay the
+ * function returns, as dispatch_after on a busy main thread does.
+ *
+ * @return The number of shots taken.
+ */
+static unsigned long Run(IntervalometerState *state, double startTime, double (*lateness)(unsigned long index, uint32_t *seed), bool (*canTakeShot)(unsigned long index), unsigned long *shotIndexes, unsigned long maxShots)
+{
+	uint32_t seed = 28;
+	unsigned long shots = 0;
+	double now = startTime;
+	IntervalometerStart(state, now);
+	unsigned long index;
+	double scheduledTime;
+	while (shots < maxShots && IntervalometerNextSlot(state, &index, &scheduledTime)) {
+		now = fmax(now, scheduledTime) + lateness(index, &seed);
+		bool canTake = canTakeShot ? canTakeShot(index) : true;
+		if (IntervalometerFire(state, &index, now, canTake)) {
+			shotIndexes[shots++] = index;
+		}
+	}
+	return shots;
+}
+
+static double Punctual(unsigned long index, uint32_t *seed)
+{
+	(void)index;
+	(void)seed;
+	return 0;
+}
+
+static double Jittery(unsigned long index, uint32_t *seed)
+{
+	(void)index;
+	// Up to 50 ms late, as with a main thread that is drawing.
+	return (double)(TestRandom(seed) % 50000) * 1e-6;
+}
+
+static double StalledAtFifth(unsigned long index, uint32_t *seed)
+{
+	(void)seed;
+	// The fifth timer fires three and a half intervals late.
+	return index == 5 ? 3.5 : 0;
+}
+
+static bool BusyOnOdd(unsigned long index)
+{
+	return index % 2 == 0;
+}
+
+static void testPunctualRunTakesEverySlot(void)
+{
+	IntervalometerState state = {.interval = 2.0, .numberOfShots = 10};
+	unsigned long indexes[16];
+	CHECK(Run(&state, 100, Punctual, NULL, indexes, 16) == 10);
+	for (unsigned long shot = 0; shot < 10; shot++) {
+		CHECK(indexes[shot] == shot);
+	}
+	CHECK(state.takenShots == 10);
+	CHECK(state.skippedShots == 0);
+	CHECK(state.maximumTimingError == 0);
+}
+
+static void testJitterDoesNotAccumulate(void)
+{
+	// Slots are placed from the start, so a thousand late timers do not push the last shot back.
+	IntervalometerState state = {.interval = 1.0, .numberOfShots = 1000};
+	static unsigned long indexes[1000];
+	CHECK(Run(&state, 0, Jittery, NULL, indexes, 1000) == 1000);
+	CHECK(state.skippedShots == 0);
+	CHECK(state.maximumTimingError < 0.05);
+	CHECK_NEAR(state.totalTimingError / state.takenShots, 0.025, 0.005);
+	unsigned long index;
+	double scheduledTime;
+	CHECK(!IntervalometerNextSlot(&state, &index, &scheduledTime));
+}
+
+static void testLateTimerSkipsMissedSlots(void)
+{
+	IntervalometerState state = {.interval = 1.0, .numberOfShots = 0};
+	unsigned long indexes[12];
+	CHECK(Run(&state, 0, StalledAtFifth, NULL, indexes, 12) == 12);
+	// Slot 5 fires at 8.5, in slot 8; 5, 6 and 7 are skipped and the run stays on the grid.
+	CHECK(indexes[4] == 4);
+	CHECK(indexes[5] == 8);
+	CHECK(indexes[6] == 9);
+	CHECK(state.skippedShots == 3);
+	CHECK_NEAR(state.maximumTimingError, 0.5, 1e-9);
+}
+
+static void testLateTimerNeverSkipsPastLastSlot(void)
+{
+	IntervalometerState state = {.interval = 1.0, .numberOfShots = 7};
+	unsigned long indexes[8];
+	CHECK(Run(&state, 0, StalledAtFifth, NULL, indexes, 8) == 6);
+	// Slot 5 fires at 8.5, past the run; the last slot takes the shot.
+	CHECK(indexes[5] == 6);
+	CHECK(state.skippedShots == 1);
+	CHECK(state.nextIndex == 7);
+}
+
+static void testBusyCameraSkipsSlot(void)
+{
+	IntervalometerState state = {.interval = 1.0, .numberOfShots = 10};
+	unsigned long indexes[10];
+	CHECK(Run(&state, 0, Punctual, BusyOnOdd, indexes, 10) == 5);
+	for (unsigned long shot = 0; shot < 5; shot++) {
+		CHECK(indexes[shot] == shot * 2);
+	}
+	CHECK(state.skippedShots == 5);
+	CHECK(state.takenShots == 5);
+}
+
+static void testTimerBeforeStartTime(void)
+{
+	// A timer that fires early is kept on its slot.
+	IntervalometerState state = {.interval = 1.0, .numberOfShots = 0};
+	IntervalometerStart(&state, 10);
+	unsigned long index = 0;
+	CHECK(IntervalometerFire(&state, &index, 9.999, true));
+	CHECK(index == 0);
+	CHECK(state.nextIndex == 1);
+}
+
+static void testRampProgress(void)
+{
+	IntervalometerState state = {.interval = 1.0, .numberOfShots = 5};
+	CHECK(IntervalometerRampProgress(&state, 0) == 0);
+	CHECK_NEAR(IntervalometerRampProgress(&state, 2), 0.5, 1e-6);
+	CHECK(IntervalometerRampProgress(&state, 4) == 1);
+	CHECK(IntervalometerRampProgress(&state, 9) == 1);
+	state.numberOfShots = 0;
+	CHECK(IntervalometerRampProgress(&state, 3) == 0);
+	state.numberOfShots = 1;
+	CHECK(IntervalometerRampProgress(&state, 0) == 0);
+}
+
+int main(void)
+{
+	RUN(testPunctualRunTakesEverySlot);
+	RUN(testJitterDoesNotAccumulate);
+	RUN(testLateTimerSkipsMissedSlots);
+	RUN(testLateTimerNeverSkipsPastLastSlot);
+	RUN(testBusyCameraSkipsSlot);
+	RUN(testTimerBeforeStartTime);
+	RUN(testRampProgress);
+	return TestResult();
+}
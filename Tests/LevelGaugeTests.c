@@ -0,0 +1,154 @@
+//
+//  LevelGaugeTests.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include "TestSupport.h"
+#include "LevelGaugeCore.h"
+
+static const double kMinimumCutoff = 1.0;
+static const double kBeta = 0.05;
+static const double kDerivativeCutoff = 1.0;
+static const double kInterval = 0.1;
+
+/**
+ * Filters roll samples the way LevelGauge does.
+ */
+struct RollFilter
+{
+	OneEuroFilterState state;
+	double unwrapped;
+};
+
+typedef struct RollFilter RollFilter;
+
+static void RollFilterInit(RollFilter *filter)
+{
+	OneEuroFilterReset(&filter->state);
+	filter->unwrapped = NAN;
+}
+
+static double RollFilterStep(RollFilter *filter, double roll, double time)
+{
+	filter->unwrapped = isnan(filter->unwrapped) ? roll : LevelGaugeUnwrapAngle(filter->unwrapped, roll);
+	return LevelGaugeWrapAngle(OneEuroFilterStep(&filter->state, kMinimumCutoff, kBeta, kDerivativeCutoff, filter->unwrapped, time));
+}
+
+/**
+ * Returns the distance between two angles along the circle.
+ */
+static double AngleDistance(double a, double b)
+{
+	return fabs(remainder(a - b, 360.0));
+}
+
+static void testUnwrapAngle(void)
+{
+	CHECK_NEAR(LevelGaugeUnwrapAngle(0, 10), 10, 1e-9);
+	CHECK_NEAR(LevelGaugeUnwrapAngle(179, -179), 181, 1e-9);
+	CHECK_NEAR(LevelGaugeUnwrapAngle(-179, 179), -181, 1e-9);
+	CHECK_NEAR(LevelGaugeUnwrapAngle(540, -170), 550, 1e-9);
+	CHECK_NEAR(LevelGaugeUnwrapAngle(-900, 170), -910, 1e-9);
+}
+
+static void testWrapAngle(void)
+{
+	CHECK_NEAR(LevelGaugeWrapAngle(181), -179, 1e-9);
+	CHECK_NEAR(LevelGaugeWrapAngle(-181), 179, 1e-9);
+	CHECK_NEAR(LevelGaugeWrapAngle(725), 5, 1e-9);
+	CHECK(fabs(LevelGaugeWrapAngle(180)) == 180);
+}
+
+static void testStillSignalIsSmoothed(void)
+{
+	OneEuroFilterState state;
+	OneEuroFilterReset(&state);
+	uint32_t seed = 39;
+	double rawSquares = 0;
+	double filteredSquares = 0;
+	for (int sample = 0; sample < 400; sample++) {
+		double noise = ((double)(TestRandom(&seed) % 2001) / 1000.0 - 1.0) * 0.5;
+		double value = OneEuroFilterStep(&state, kMinimumCutoff, kBeta, kDerivativeCutoff, 2.0 + noise, sample * kInterval);
+		if (sample >= 50) {
+			rawSquares += noise * noise;
+			filteredSquares += (value - 2.0) * (value - 2.0);
+		}
+	}
+	CHECK(sqrt(filteredSquares) < sqrt(rawSquares) * 0.6);
+}
+
+static void testRepeatedSampleIsIgnored(void)
+{
+	OneEuroFilterState state;
+	OneEuroFilterReset(&state);
+	CHECK_NEAR(OneEuroFilterStep(&state, kMinimumCutoff, kBeta, kDerivativeCutoff, 1.0, 1.0), 1.0, 1e-12);
+	CHECK_NEAR(OneEuroFilterStep(&state, kMinimumCutoff, kBeta, kDerivativeCutoff, 9.0, 1.0), 1.0, 1e-12);
+	CHECK(OneEuroFilterStep(&state, kMinimumCutoff, kBeta, kDerivativeCutoff, 9.0, 1.1) > 1.0);
+}
+
+static void testJitterAcrossHalfTurnDoesNotJump(void)
+{
+	// Held upside down, the camera reports roll flipping between 179 and -179.
+	RollFilter filter;
+	RollFilterInit(&filter);
+	uint32_t seed = 1;
+	for (int sample = 0; sample < 300; sample++) {
+		double roll = (TestRandom(&seed) & 1) ? 179.0 : -179.0;
+		double filtered = RollFilterStep(&filter, roll, sample * kInterval);
+		CHECK(AngleDistance(filtered, 180.0) <= 1.0 + 1e-9);
+		CHECK(filtered >= -180.0 && filtered <= 180.0);
+	}
+}
+
+static void testFollowsFullTurns(void)
+{
+	// Turning steadily through three whole turns, the filter keeps up and never jumps.
+	RollFilter filter;
+	RollFilterInit(&filter);
+	double previous = NAN;
+	double maximumLag = 0;
+	double maximumStep = 0;
+	for (int sample = 0; sample <= 1080; sample++) {
+		double angle = sample * 3.0;
+		double filtered = RollFilterStep(&filter, LevelGaugeWrapAngle(angle), sample * kInterval);
+		if (!isnan(previous)) {
+			maximumStep = fmax(maximumStep, AngleDistance(filtered, previous));
+		}
+		if (sample >= 20) {
+			maximumLag = fmax(maximumLag, AngleDistance(filtered, angle));
+		}
+		previous = filtered;
+	}
+	CHECK(maximumStep < 6.0);
+	CHECK(maximumLag < 6.0);
+	CHECK(fabs(filter.unwrapped - 3240.0) < 1e-6);
+}
+
+static void testSettlesAfterCrossingHalfTurn(void)
+{
+	// A single swing from 170 to -170 settles at -170, not 20 degrees short of it.
+	RollFilter filter;
+	RollFilterInit(&filter);
+	double filtered = 0;
+	for (int sample = 0; sample < 50; sample++) {
+		filtered = RollFilterStep(&filter, 170.0, sample * kInterval);
+	}
+	for (int sample = 50; sample < 150; sample++) {
+		filtered = RollFilterStep(&filter, -170.0, sample * kInterval);
+	}
+	CHECK_NEAR(filtered, -170.0, 0.01);
+}
+
+int main(void)
+{
+	RUN(testUnwrapAngle);
+	RUN(testWrapAngle);
+	RUN(testStillSignalIsSmoothed);
+	RUN(testRepeatedSampleIsIgnored);
+	RUN(testJitterAcrossHalfTurnDoesNotJump);
+	RUN(testFollowsFullTurns);
+	RUN(testSettlesAfterCrossingHalfTurn);
+	return TestResult();
+}
@@ -0,0 +1,93 @@
+//
+//  MIDIActionMapperBenchmark.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include <stdlib.h>
+#include "TestSupport.h"
+#include "MIDIActionMapperCore.h"
+
+/*
+ * Measures compiling a set of rules and matching a stream of messages against it.
+ *
+ * The rules are those of a typical controller layout: pads and keys on any channel,
+ * edge triggered pedals and knobs, and program changes. The messages are mostly
+ * controller moves and clock-rate noise that match nothing, as from a busy keyboard.
+ */
+
+enum
+{
+	kRuleCount = 64,
+	kMessageCount = 1 << 16,
+};
+
+static MIDIActionKeyedSlot KeyedSlots[kMIDIActionTableMaximumSlotCount];
+static MIDIActionEntry Entries[kMIDIActionTableCount];
+static MIDIActionSlot Slots[kMIDIActionTableMaximumSlotCount];
+
+static void Count(void *context, uint8_t action, uint8_t value)
+{
+	(void)action;
+	(void)value;
+	(*(unsigned *)context)++;
+}
+
+static void MakeRules(MIDIActionRule *rules)
+{
+	for (size_t index = 0; index < kRuleCount; index++) {
+		MIDIActionRule *rule = &rules[index];
+		rule->status = (index % 3 == 0) ? 0x90 : (index % 3 == 1) ? 0xB0 : 0xC0;
+		rule->number = (int)(36 + index);
+		rule->channel = (int)(index % 4 == 0 ? 0 : index % 16 + 1);
+		rule->minimum = (rule->status == 0x90) ? 1 : (rule->status == 0xC0) ? (int)index : 64;
+		rule->maximum = (rule->status == 0xC0) ? (int)index + 1 : 127;
+		rule->action = (uint8_t)(index % 6);
+		rule->edge = (index % 2 == 1);
+	}
+}
+
+int main(void)
+{
+	MIDIActionRule rules[kRuleCount];
+	MakeRules(rules);
+
+	uint8_t *messages = malloc(kMessageCount * 3);
+	uint32_t seed = 1;
+	for (size_t index = 0; index < kMessageCount; index++) {
+		uint32_t random = TestRandom(&seed);
+		static const uint8_t types[] = {0x80, 0x90, 0xB0, 0xB0, 0xB0, 0xC0, 0xE0, 0xF0};
+		messages[index * 3] = types[random % 8] | ((random >> 3) & 0x0F);
+		messages[index * 3 + 1] = (random >> 7) & 0x7F;
+		messages[index * 3 + 2] = (random >> 14) & 0x7F;
+	}
+
+	const unsigned compileRounds = 200;
+	size_t slotCount = 0;
+	double start = TestSeconds();
+	for (unsigned round = 0; round < compileRounds; round++) {
+		slotCount = 0;
+		for (size_t index = 0; index < kRuleCount; index++) {
+			slotCount = MIDIActionCompileRule(&rules[index], KeyedSlots, slotCount);
+		}
+		MIDIActionBuildTable(KeyedSlots, slotCount, Entries, Slots);
+	}
+	double compileElapsed = TestSeconds() - start;
+
+	unsigned performed = 0;
+	const unsigned matchRounds = 100;
+	start = TestSeconds();
+	for (unsigned round = 0; round < matchRounds; round++) {
+		for (size_t index = 0; index < kMessageCount; index++) {
+			const uint8_t *message = &messages[index * 3];
+			MIDIActionMatch(Entries, Slots, message[0], message[1], message[2], Count, &performed);
+		}
+	}
+	double matchElapsed = TestSeconds() - start;
+	double matched = (double)kMessageCount * matchRounds;
+	printf("MIDI action mapper: %d rules to %zu slots in %.1f us, %.1f ns/message, %u actions in %d messages\n", kRuleCount, slotCount, compileElapsed / compileRounds * 1e6, matchElapsed / matched * 1e9, performed / matchRounds, kMessageCount);
+
+	free(messages);
+	return 0;
+}
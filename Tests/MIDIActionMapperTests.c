@@ -0,0 +1,200 @@
+//
+//  MIDIActionMapperTests.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include "TestSupport.h"
+#include "MIDIActionMapperCore.h"
+
+enum
+{
+	kMaxSlots = 4096,
+	kMaxPerformed = 16,
+};
+
+static MIDIActionKeyedSlot KeyedSlots[kMIDIActionTableMaximumSlotCount];
+static MIDIActionEntry Entries[kMIDIActionTableCount];
+static MIDIActionSlot Slots[kMaxSlots];
+
+typedef struct {
+	size_t count;
+	uint8_t actions[kMaxPerformed];
+	uint8_t values[kMaxPerformed];
+} Performed;
+
+static void Record(void *context, uint8_t action, uint8_t value)
+{
+	Performed *performed = context;
+	if (performed->count < kMaxPerformed) {
+		performed->actions[performed->count] = action;
+		performed->values[performed->count] = value;
+	}
+	performed->count++;
+}
+
+static size_t Build(const MIDIActionRule *rules, size_t ruleCount)
+{
+	size_t slotCount = 0;
+	for (size_t index = 0; index < ruleCount; index++) {
+		slotCount = MIDIActionCompileRule(&rules[index], KeyedSlots, slotCount);
+	}
+	MIDIActionBuildTable(KeyedSlots, slotCount, Entries, Slots);
+	return slotCount;
+}
+
+static Performed Match(uint8_t status, uint8_t dataByte1, uint8_t dataByte2)
+{
+	Performed performed = {.count = 0};
+	MIDIActionMatch(Entries, Slots, status, dataByte1, dataByte2, Record, &performed);
+	return performed;
+}
+
+static void testNoteOnAnyChannel(void)
+{
+	MIDIActionRule rules[] = {{.status = 0x90, .number = 60, .channel = 0, .minimum = 1, .maximum = 127, .action = 3}};
+	CHECK(Build(rules, 1) == 16);
+	for (uint8_t channel = 0; channel < 16; channel++) {
+		Performed performed = Match(0x90 | channel, 60, 100);
+		CHECK(performed.count == 1);
+		CHECK(performed.actions[0] == 3);
+		CHECK(performed.values[0] == 100);
+	}
+	CHECK(Match(0x90, 61, 100).count == 0);
+	CHECK(Match(0xB0, 60, 100).count == 0);
+}
+
+static void testChannelIsOneBased(void)
+{
+	MIDIActionRule rules[] = {{.status = 0xB0, .number = 7, .channel = 10, .minimum = 0, .maximum = 127, .action = 1}};
+	CHECK(Build(rules, 1) == 1);
+	CHECK(Match(0xB9, 7, 0).count == 1);
+	CHECK(Match(0xB0, 7, 0).count == 0);
+	CHECK(Match(0xBA, 7, 0).count == 0);
+}
+
+static void testNoteOffIsVelocityZero(void)
+{
+	MIDIActionRule rules[] = {
+		{.status = 0x90, .number = 36, .channel = 1, .minimum = 1, .maximum = 127, .action = 1},
+		{.status = 0x90, .number = 36, .channel = 1, .minimum = 0, .maximum = 0, .action = 2},
+	};
+	Build(rules, 2);
+	Performed performed = Match(0x80, 36, 64);
+	CHECK(performed.count == 1);
+	CHECK(performed.actions[0] == 2);
+	CHECK(performed.values[0] == 0);
+	performed = Match(0x90, 36, 0);
+	CHECK(performed.count == 1);
+	CHECK(performed.actions[0] == 2);
+}
+
+static void testLevelFiresOnEveryMessageInRange(void)
+{
+	MIDIActionRule rules[] = {{.status = 0xB0, .number = 1, .channel = 1, .minimum = 64, .maximum = 127, .action = 1}};
+	Build(rules, 1);
+	CHECK(Match(0xB0, 1, 70).count == 1);
+	CHECK(Match(0xB0, 1, 80).count == 1);
+	CHECK(Match(0xB0, 1, 10).count == 0);
+	CHECK(Match(0xB0, 1, 127).count == 1);
+}
+
+static void testEdgeFiresWhenEnteringRange(void)
+{
+	MIDIActionRule rules[] = {{.status = 0xB0, .number = 64, .channel = 1, .minimum = 64, .maximum = 127, .action = 1, .edge = true}};
+	Build(rules, 1);
+	CHECK(Match(0xB0, 64, 127).count == 1);
+	CHECK(Match(0xB0, 64, 100).count == 0);
+	CHECK(Match(0xB0, 64, 0).count == 0);
+	CHECK(Match(0xB0, 64, 64).count == 1);
+}
+
+static void testEdgeStartsOutOfRangeAfterRebuild(void)
+{
+	MIDIActionRule rules[] = {{.status = 0x90, .number = 60, .channel = 1, .minimum = 1, .maximum = 127, .action = 1, .edge = true}};
+	Build(rules, 1);
+	CHECK(Match(0x90, 60, 100).count == 1);
+	CHECK(Match(0x90, 60, 100).count == 0);
+	Build(rules, 1);
+	CHECK(Match(0x90, 60, 100).count == 1);
+}
+
+static void testProgramRuleCoversRange(void)
+{
+	MIDIActionRule rules[] = {{.status = 0xC0, .channel = 2, .minimum = 10, .maximum = 12, .action = 5}};
+	CHECK(Build(rules, 1) == 3);
+	CHECK(Match(0xC1, 9, 0).count == 0);
+	for (uint8_t program = 10; program <= 12; program++) {
+		Performed performed = Match(0xC1, program, 0);
+		CHECK(performed.count == 1);
+		CHECK(performed.values[0] == program);
+	}
+	CHECK(Match(0xC1, 13, 0).count == 0);
+}
+
+static void testRulesKeepTheirOrder(void)
+{
+	MIDIActionRule rules[] = {
+		{.status = 0xB0, .number = 20, .channel = 0, .minimum = 0, .maximum = 127, .action = 4},
+		{.status = 0x90, .number = 20, .channel = 1, .minimum = 1, .maximum = 127, .action = 9},
+		{.status = 0xB0, .number = 20, .channel = 1, .minimum = 0, .maximum = 127, .action = 2},
+		{.status = 0xB0, .number = 20, .channel = 0, .minimum = 0, .maximum = 127, .action = 7},
+	};
+	Build(rules, 4);
+	Performed performed = Match(0xB0, 20, 5);
+	CHECK(performed.count == 3);
+	CHECK(performed.actions[0] == 4);
+	CHECK(performed.actions[1] == 2);
+	CHECK(performed.actions[2] == 7);
+}
+
+static void testInvalidRulesAreSkipped(void)
+{
+	MIDIActionRule rules[] = {
+		{.status = 0xA0, .number = 1, .channel = 1, .minimum = 0, .maximum = 127},
+		{.status = 0x90, .number = 128, .channel = 1, .minimum = 0, .maximum = 127},
+		{.status = 0x90, .number = 1, .channel = 17, .minimum = 0, .maximum = 127},
+		{.status = 0x90, .number = 1, .channel = 1, .minimum = 90, .maximum = 80},
+		{.status = 0x90, .number = 1, .channel = 1, .minimum = -1, .maximum = 127},
+		{.status = 0xB0, .number = 1, .channel = 1, .minimum = 0, .maximum = 128},
+	};
+	for (size_t index = 0; index < sizeof(rules) / sizeof(rules[0]); index++) {
+		CHECK(MIDIActionRuleSlotCount(&rules[index]) == 0);
+		CHECK(MIDIActionCompileRule(&rules[index], KeyedSlots, 5) == 5);
+	}
+}
+
+static void testOtherMessagesMatchNothing(void)
+{
+	MIDIActionRule rules[] = {{.status = 0xB0, .number = 0, .channel = 0, .minimum = 0, .maximum = 127, .action = 1}};
+	Build(rules, 1);
+	CHECK(Match(0xF0, 0, 0).count == 0);
+	CHECK(Match(0xF8, 0, 0).count == 0);
+	CHECK(Match(0xB0, 0, 0).count == 1);
+}
+
+static void testTableDoesNotOverflow(void)
+{
+	// A program rule on every channel takes 16 * 128 slots; the table holds 31 of them.
+	MIDIActionRule rule = {.status = 0xC0, .channel = 0, .minimum = 0, .maximum = 127};
+	size_t slotCount = kMIDIActionTableMaximumSlotCount - 2047;
+	CHECK(MIDIActionCompileRule(&rule, KeyedSlots, slotCount) == slotCount);
+	CHECK(MIDIActionCompileRule(&rule, KeyedSlots, slotCount - 1) == slotCount - 1 + 2048);
+}
+
+int main(void)
+{
+	RUN(testNoteOnAnyChannel);
+	RUN(testChannelIsOneBased);
+	RUN(testNoteOffIsVelocityZero);
+	RUN(testLevelFiresOnEveryMessageInRange);
+	RUN(testEdgeFiresWhenEnteringRange);
+	RUN(testEdgeStartsOutOfRangeAfterRebuild);
+	RUN(testProgramRuleCoversRange);
+	RUN(testRulesKeepTheirOrder);
+	RUN(testInvalidRulesAreSkipped);
+	RUN(testOtherMessagesMatchNothing);
+	RUN(testTableDoesNotOverflow);
+	return TestResult();
+}
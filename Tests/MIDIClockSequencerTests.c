@@ -0,0 +1,188 @@
+//
+//  MIDIClockSequencerTests.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include "TestSupport.h"
+#include "MIDIClockSequencerCore.h"
+
+static const double kPhaseGain = 0.1;
+static const double kFrequencyGain = 0.01;
+static const int kTicksPerQuarterNote = 24;
+
+/**
+ * Returns uniform jitter in [-amplitude, amplitude].
+ */
+static double Jitter(uint32_t *seed, double amplitude)
+{
+	return ((double)(TestRandom(seed) % 20001) / 10000.0 - 1.0) * amplitude;
+}
+
+static double PeriodForTempo(double tempo)
+{
+	return 60.0 / tempo / kTicksPerQuarterNote;
+}
+
+/**
+ * Feeds a jittered clock and measures where the loop places the next beat.
+ *
+ * @return The largest beat placement error after the first settle ticks, in seconds.
+ */
+static double RunClock(MIDIClockLoop *loop, double tempo, double jitter, int ticks, int settle, uint32_t seed, double *rmsError)
+{
+	double period = PeriodForTempo(tempo);
+	double maximum = 0;
+	double sumSquares = 0;
+	int measured = 0;
+	for (int tick = 0; tick < ticks; tick++) {
+		double trueTime = 1.0 + tick * period;
+		MIDIClockLoopUpdate(loop, trueTime + Jitter(&seed, jitter), kPhaseGain, kFrequencyGain);
+		if (tick < settle) {
+			continue;
+		}
+		// Where the sequencer would aim a trigger on the next quarter note.
+		int beatTick = (tick / kTicksPerQuarterNote + 1) * kTicksPerQuarterNote;
+		double predicted = loop->filteredTime + (beatTick - tick) * loop->period;
+		double error = predicted - (1.0 + beatTick * period);
+		maximum = fmax(maximum, fabs(error));
+		sumSquares += error * error;
+		measured++;
+	}
+	if (rmsError) {
+		*rmsError = measured > 0 ? sqrt(sumSquares / measured) : 0;
+	}
+	return maximum;
+}
+
+static void testLocksToSteadyClock(void)
+{
+	MIDIClockLoop loop;
+	MIDIClockLoopInit(&loop, PeriodForTempo(120));
+	double maximum = RunClock(&loop, 97, 0, 200, 100, 1, NULL);
+	CHECK_NEAR(60.0 / (loop.period * kTicksPerQuarterNote), 97, 0.01);
+	CHECK(maximum < 1e-6);
+}
+
+static void testJitterIsFilteredOut(void)
+{
+	// USB and main queue delivery jitter of +-2 ms on every tick.
+	MIDIClockLoop loop;
+	MIDIClockLoopInit(&loop, PeriodForTempo(120));
+	double rms = 0;
+	double maximum = RunClock(&loop, 120, 0.002, 2400, 480, 2, &rms);
+	CHECK_NEAR(60.0 / (loop.period * kTicksPerQuarterNote), 120, 0.5);
+	// The raw ticks are off by 1.15 ms RMS; the beat placement must be better.
+	CHECK(rms < 0.001);
+	CHECK(maximum < 0.003);
+	printf("     +-2 ms jitter: beat error %.3f ms RMS, %.3f ms max\n", rms * 1000, maximum * 1000);
+}
+
+static void testHeavyJitterStaysLocked(void)
+{
+	MIDIClockLoop loop;
+	MIDIClockLoopInit(&loop, PeriodForTempo(120));
+	double rms = 0;
+	RunClock(&loop, 140, 0.006, 4800, 960, 3, &rms);
+	CHECK(loop.receivedTicks > 4000);
+	CHECK_NEAR(60.0 / (loop.period * kTicksPerQuarterNote), 140, 1.5);
+	CHECK(rms < 0.004);
+}
+
+static void testFollowsTempoChange(void)
+{
+	MIDIClockLoop loop;
+	MIDIClockLoopInit(&loop, PeriodForTempo(120));
+	uint32_t seed = 4;
+	double time = 1.0;
+	for (int tick = 0; tick < 480; tick++) {
+		MIDIClockLoopUpdate(&loop, time + Jitter(&seed, 0.001), kPhaseGain, kFrequencyGain);
+		time += PeriodForTempo(120);
+	}
+	for (int tick = 0; tick < 960; tick++) {
+		MIDIClockLoopUpdate(&loop, time + Jitter(&seed, 0.001), kPhaseGain, kFrequencyGain);
+		time += PeriodForTempo(128);
+	}
+	CHECK_NEAR(60.0 / (loop.period * kTicksPerQuarterNote), 128, 0.5);
+}
+
+static void testRelocksAfterJump(void)
+{
+	MIDIClockLoop loop;
+	MIDIClockLoopInit(&loop, PeriodForTempo(120));
+	RunClock(&loop, 120, 0, 100, 100, 5, NULL);
+	// The clock stops for a second and comes back at another tempo.
+	double period = PeriodForTempo(90);
+	for (int tick = 0; tick < 100; tick++) {
+		MIDIClockLoopUpdate(&loop, 10.0 + tick * period, kPhaseGain, kFrequencyGain);
+	}
+	CHECK_NEAR(60.0 / (loop.period * kTicksPerQuarterNote), 90, 0.01);
+	CHECK_NEAR(loop.filteredTime, 10.0 + 99 * period, 1e-6);
+}
+
+static void testNextTriggerTick(void)
+{
+	CHECK(MIDIClockNextTriggerTick(0, 0, 24) == 0);
+	CHECK(MIDIClockNextTriggerTick(1, 0, 24) == 24);
+	CHECK(MIDIClockNextTriggerTick(24, 0, 24) == 24);
+	CHECK(MIDIClockNextTriggerTick(0, 6, 24) == 6);
+	CHECK(MIDIClockNextTriggerTick(7, 6, 24) == 30);
+	CHECK(MIDIClockNextTriggerTick(5, 30, 96) == 30);
+}
+
+static void testOverlappingCapturesAreMeasuredInOrder(void)
+{
+	// At fast divisions the next action is issued before the camera reports the
+	// previous capture; each report must be matched with its own action.
+	MIDIClockCaptureQueue queue = { 0 };
+	MIDIClockCapture capture;
+	MIDIClockCaptureQueuePush(&queue, 1.00, 1.10);
+	MIDIClockCaptureQueuePush(&queue, 1.25, 1.35);
+	CHECK(MIDIClockCaptureQueuePop(&queue, 1.12, 2.0, &capture));
+	CHECK_NEAR(1.12 - capture.actionTime, 0.12, 1e-9);
+	CHECK_NEAR(1.12 - capture.targetTime, 0.02, 1e-9);
+	MIDIClockCaptureQueuePush(&queue, 1.50, 1.60);
+	CHECK(MIDIClockCaptureQueuePop(&queue, 1.36, 2.0, &capture));
+	CHECK_NEAR(capture.targetTime, 1.35, 1e-9);
+	CHECK(MIDIClockCaptureQueuePop(&queue, 1.61, 2.0, &capture));
+	CHECK_NEAR(capture.targetTime, 1.60, 1e-9);
+	CHECK(!MIDIClockCaptureQueuePop(&queue, 1.70, 2.0, &capture));
+}
+
+static void testRefusedCapturesAreDiscarded(void)
+{
+	MIDIClockCaptureQueue queue = { 0 };
+	MIDIClockCapture capture;
+	MIDIClockCaptureQueuePush(&queue, 1.0, 1.1);
+	MIDIClockCaptureQueuePush(&queue, 5.0, 5.1);
+	CHECK(MIDIClockCaptureQueuePop(&queue, 5.2, 2.0, &capture));
+	CHECK_NEAR(capture.actionTime, 5.0, 1e-9);
+	CHECK(queue.count == 0);
+}
+
+static void testFullQueueDropsOldest(void)
+{
+	MIDIClockCaptureQueue queue = { 0 };
+	MIDIClockCapture capture;
+	for (int index = 0; index < MIDIClockCaptureQueueCapacity + 3; index++) {
+		MIDIClockCaptureQueuePush(&queue, index, index + 0.5);
+	}
+	CHECK(queue.count == MIDIClockCaptureQueueCapacity);
+	CHECK(MIDIClockCaptureQueuePop(&queue, 10.0, 100.0, &capture));
+	CHECK_NEAR(capture.actionTime, 3, 1e-9);
+}
+
+int main(void)
+{
+	RUN(testLocksToSteadyClock);
+	RUN(testJitterIsFilteredOut);
+	RUN(testHeavyJitterStaysLocked);
+	RUN(testFollowsTempoChange);
+	RUN(testRelocksAfterJump);
+	RUN(testNextTriggerTick);
+	RUN(testOverlappingCapturesAreMeasuredInOrder);
+	RUN(testRefusedCapturesAreDiscarded);
+	RUN(testFullQueueDropsOldest);
+	return TestResult();
+}
@@ -0,0 +1,175 @@
+//
+//  MIDISourceMergerTests.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include "TestSupport.h"
+#include "MIDISourceMergerCore.h"
+
+enum { kMaxReleased = 256 };
+
+static MIDISourceMergerEntry Released[kMaxReleased];
+
+static size_t Insert(MIDISourceMergerQueue *queue, uint64_t timestamp, size_t sourceID)
+{
+	MIDISourceMergerEntry entry = {timestamp, sourceID};
+	return MIDISourceMergerInsert(queue, entry);
+}
+
+/**
+ * Releases the entries stamped at or before time, and returns how many.
+ */
+static size_t ReleaseUntil(MIDISourceMergerQueue *queue, uint64_t time, uint64_t now)
+{
+	size_t count = MIDISourceMergerReleasableCount(queue, time);
+	MIDISourceMergerRelease(queue, count, Released);
+	for (size_t index = 0; index < count; index++) {
+		MIDISourceMergerNoteHandOut(queue, Released[index], now);
+	}
+	return count;
+}
+
+static void testInOrderEntriesAreAppended(void)
+{
+	MIDISourceMergerQueue queue;
+	MIDISourceMergerInit(&queue);
+	CHECK(Insert(&queue, 10, 0) == 0);
+	CHECK(Insert(&queue, 20, 1) == 1);
+	CHECK(Insert(&queue, 20, 0) == 2);
+	CHECK(queue.reorderedCommands == 0);
+	CHECK(ReleaseUntil(&queue, 100, 100) == 3);
+	CHECK(Released[1].sourceID == 1);
+	CHECK(Released[2].sourceID == 0);
+	MIDISourceMergerDestroy(&queue);
+}
+
+static void testOutOfOrderEntriesAreSorted(void)
+{
+	MIDISourceMergerQueue queue;
+	MIDISourceMergerInit(&queue);
+	// Two sources whose batches arrive interleaved.
+	Insert(&queue, 10, 0);
+	Insert(&queue, 30, 0);
+	CHECK(Insert(&queue, 20, 1) == 1);
+	CHECK(Insert(&queue, 5, 1) == 0);
+	CHECK(queue.reorderedCommands == 2);
+	CHECK(ReleaseUntil(&queue, 100, 100) == 4);
+	CHECK(Released[0].timestamp == 5);
+	CHECK(Released[1].timestamp == 10);
+	CHECK(Released[2].timestamp == 20);
+	CHECK(Released[3].timestamp == 30);
+	MIDISourceMergerDestroy(&queue);
+}
+
+static void testReleaseStopsAtTime(void)
+{
+	MIDISourceMergerQueue queue;
+	MIDISourceMergerInit(&queue);
+	Insert(&queue, 10, 0);
+	Insert(&queue, 20, 0);
+	Insert(&queue, 30, 0);
+	CHECK(ReleaseUntil(&queue, 9, 12) == 0);
+	CHECK(ReleaseUntil(&queue, 20, 25) == 2);
+	CHECK(queue.count == 1);
+	CHECK(queue.entries[0].timestamp == 30);
+	CHECK(queue.lastReleasedTimestamp == 20);
+	MIDISourceMergerDestroy(&queue);
+}
+
+static void testLateEntriesAreCounted(void)
+{
+	MIDISourceMergerQueue queue;
+	MIDISourceMergerInit(&queue);
+	Insert(&queue, 10, 0);
+	Insert(&queue, 20, 0);
+	ReleaseUntil(&queue, 20, 20);
+	// Behind what was handed out; it cannot be put in order any more.
+	CHECK(Insert(&queue, 15, 1) == kMIDISourceMergerLate);
+	CHECK(queue.lateCommands == 1);
+	CHECK(queue.count == 0);
+	// The same time stamp as the latest one handed out is still in order.
+	CHECK(Insert(&queue, 20, 1) == 0);
+	CHECK(queue.lateCommands == 1);
+	MIDISourceMergerDestroy(&queue);
+}
+
+static void testMaximumDelay(void)
+{
+	MIDISourceMergerQueue queue;
+	MIDISourceMergerInit(&queue);
+	Insert(&queue, 100, 0);
+	Insert(&queue, 130, 0);
+	ReleaseUntil(&queue, 130, 140);
+	CHECK(queue.maximumDelay == 40);
+	Insert(&queue, 200, 0);
+	ReleaseUntil(&queue, 200, 210);
+	CHECK(queue.maximumDelay == 40);
+	// A clock that reads before the stamp does not count as a delay.
+	Insert(&queue, 300, 0);
+	ReleaseUntil(&queue, 300, 290);
+	CHECK(queue.maximumDelay == 40);
+	MIDISourceMergerResetStatistics(&queue);
+	CHECK(queue.maximumDelay == 0);
+	CHECK(queue.reorderedCommands == 0);
+	CHECK(queue.lateCommands == 0);
+	MIDISourceMergerDestroy(&queue);
+}
+
+static void testStamp(void)
+{
+	CHECK(MIDISourceMergerStamp(0, 50) == 50);
+	CHECK(MIDISourceMergerStamp(40, 50) == 40);
+	CHECK(MIDISourceMergerStamp(60, 50) == 50);
+}
+
+static void testShuffledStreamComesOutSorted(void)
+{
+	// Four sources, each in order, arriving in random batches within the window.
+	MIDISourceMergerQueue queue;
+	MIDISourceMergerInit(&queue);
+	uint64_t next[4] = {0, 0, 0, 0};
+	uint32_t random = 7;
+	uint64_t previous = 0;
+	size_t releasedCount = 0;
+	int outOfOrder = 0;
+	for (uint64_t now = 1000; now < 101000; now += 100) {
+		for (int batch = 0; batch < 3; batch++) {
+			size_t sourceID = TestRandom(&random) % 4;
+			uint64_t timestamp = now - TestRandom(&random) % 300;
+			if (timestamp < next[sourceID]) {
+				timestamp = next[sourceID];
+			}
+			next[sourceID] = timestamp;
+			Insert(&queue, timestamp, sourceID);
+		}
+		size_t count = ReleaseUntil(&queue, now - 300, now);
+		for (size_t index = 0; index < count; index++) {
+			if (Released[index].timestamp < previous) {
+				outOfOrder++;
+			}
+			previous = Released[index].timestamp;
+		}
+		releasedCount += count;
+	}
+	releasedCount += ReleaseUntil(&queue, UINT64_MAX, 101000);
+	CHECK(outOfOrder == 0);
+	CHECK(queue.lateCommands == 0);
+	CHECK(queue.reorderedCommands > 0);
+	CHECK(releasedCount == 3000);
+	CHECK(queue.maximumDelay <= 600);
+	MIDISourceMergerDestroy(&queue);
+}
+
+int main(void)
+{
+	RUN(testInOrderEntriesAreAppended);
+	RUN(testOutOfOrderEntriesAreSorted);
+	RUN(testReleaseStopsAtTime);
+	RUN(testLateEntriesAreCounted);
+	RUN(testMaximumDelay);
+	RUN(testStamp);
+	RUN(testShuffledStreamComesOutSorted);
+	return TestResult();
+}
@@ -0,0 +1,238 @@
+//
+//  MIKMIDIEndpointSynthesizerTests.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include <math.h>
+#include <pthread.h>
+#include "TestSupport.h"
+#include "MIKMIDIEndpointSynthesizerCore.h"
+
+// The host clock of ARM devices ticks 24 million times a second; that of Intel Macs once a nanosecond.
+static const double kDeviceTicksPerSecond = 24000000.0;
+static const double kNanosecondTicksPerSecond = 1000000000.0;
+static const double kSampleRate = 44100.0;
+static const uint32_t kFrameCount = 512;
+
+static uint64_t TicksForFrames(double frames, double ticksPerSecond)
+{
+	return (uint64_t)(frames / kSampleRate * ticksPerSecond);
+}
+
+static void testDueEventsSoundAtStart(void)
+{
+	uint64_t bufferTime = 1000000;
+	CHECK(MIKMIDIEndpointSynthesizerSampleOffset(0, bufferTime, kFrameCount, kSampleRate, kDeviceTicksPerSecond) == 0);
+	CHECK(MIKMIDIEndpointSynthesizerSampleOffset(bufferTime - 1, bufferTime, kFrameCount, kSampleRate, kDeviceTicksPerSecond) == 0);
+	CHECK(MIKMIDIEndpointSynthesizerSampleOffset(bufferTime, bufferTime, kFrameCount, kSampleRate, kDeviceTicksPerSecond) == 0);
+}
+
+static void testEventsInBufferSoundAtTheirFrame(void)
+{
+	uint64_t bufferTime = 5000000000ULL;
+	for (uint32_t frame = 0; frame < kFrameCount; frame += 37) {
+		// Half a frame in, so the rounding of the tick count cannot move it to the previous frame.
+		uint64_t eventTime = bufferTime + TicksForFrames(frame + 0.5, kDeviceTicksPerSecond);
+		CHECK(MIKMIDIEndpointSynthesizerSampleOffset(eventTime, bufferTime, kFrameCount, kSampleRate, kDeviceTicksPerSecond) == frame);
+		eventTime = bufferTime + TicksForFrames(frame + 0.5, kNanosecondTicksPerSecond);
+		CHECK(MIKMIDIEndpointSynthesizerSampleOffset(eventTime, bufferTime, kFrameCount, kSampleRate, kNanosecondTicksPerSecond) == frame);
+	}
+}
+
+static void testLaterEventsAreNotDue(void)
+{
+	uint64_t bufferTime = 5000000000ULL;
+	uint64_t lastFrameTime = bufferTime + TicksForFrames(kFrameCount - 0.5, kDeviceTicksPerSecond);
+	uint64_t nextBufferTime = bufferTime + TicksForFrames(kFrameCount + 0.5, kDeviceTicksPerSecond);
+	CHECK(MIKMIDIEndpointSynthesizerSampleOffset(lastFrameTime, bufferTime, kFrameCount, kSampleRate, kDeviceTicksPerSecond) == kFrameCount - 1);
+	CHECK(MIKMIDIEndpointSynthesizerSampleOffset(nextBufferTime, bufferTime, kFrameCount, kSampleRate, kDeviceTicksPerSecond) == MIKMIDIEndpointSynthesizerNotDue);
+	CHECK(MIKMIDIEndpointSynthesizerSampleOffset(UINT64_MAX, bufferTime, kFrameCount, kSampleRate, kDeviceTicksPerSecond) == MIKMIDIEndpointSynthesizerNotDue);
+}
+
+static void testLongUptimeKeepsPrecision(void)
+{
+	// After a month of uptime the difference is still taken in integer ticks.
+	uint64_t bufferTime = (uint64_t)(31.0 * 24 * 3600 * kDeviceTicksPerSecond);
+	uint64_t eventTime = bufferTime + TicksForFrames(100.5, kDeviceTicksPerSecond);
+	CHECK(MIKMIDIEndpointSynthesizerSampleOffset(eventTime, bufferTime, kFrameCount, kSampleRate, kDeviceTicksPerSecond) == 100);
+}
+
+typedef struct {
+	uint64_t bufferTime;
+	uint32_t bufferIndex;
+	uint64_t startTime;
+	int played;
+	int misplaced;
+	int order[MIKMIDIEndpointSynthesizerQueueCapacity + MIKMIDIEndpointSynthesizerPendingCapacity];
+} Recorder;
+
+/**
+ *  Records the events played and checks that each sounds at the frame its time stamp falls on.
+ */
+static void RecordEvent(void *context, const MIKMIDIEndpointSynthesizerEvent *event, uint32_t sampleOffset)
+{
+	Recorder *recorder = context;
+	if (event->timeStamp > recorder->startTime) {
+		double expectedFrame = (double)(event->timeStamp - recorder->startTime) * kSampleRate / kDeviceTicksPerSecond - recorder->bufferIndex * kFrameCount;
+		if (fabs(expectedFrame - sampleOffset) > 1.0) recorder->misplaced++;
+	}
+	recorder->order[recorder->played++] = event->data1 | (event->data2 << 7);
+}
+
+static MIKMIDIEndpointSynthesizerSchedule *NewSchedule(void)
+{
+	static MIKMIDIEndpointSynthesizerSchedule schedule;
+	memset(&schedule, 0, sizeof(schedule));
+	schedule.sampleRate = kSampleRate;
+	schedule.hostTicksPerSecond = kDeviceTicksPerSecond;
+	return &schedule;
+}
+
+static void testEventsScheduledAcrossBuffersSoundOnce(void)
+{
+	// Events spread over many buffers are each played once, in the buffer and at the frame they fall on.
+	MIKMIDIEndpointSynthesizerSchedule *schedule = NewSchedule();
+	static Recorder recorder;
+	memset(&recorder, 0, sizeof(recorder));
+	recorder.startTime = 1000000;
+	uint32_t seed = 48;
+	for (uint8_t index = 0; index < 64; index++) {
+		double frame = (double)(TestRandom(&seed) % (kFrameCount * 20)) + 0.5;
+		MIKMIDIEndpointSynthesizerEvent event = {recorder.startTime + TicksForFrames(frame, kDeviceTicksPerSecond), 0x90, index, 100};
+		CHECK(MIKMIDIEndpointSynthesizerPushEvent(schedule, event));
+	}
+
+	for (recorder.bufferIndex = 0; recorder.bufferIndex < 21; recorder.bufferIndex++) {
+		uint64_t bufferTime = recorder.startTime + TicksForFrames(recorder.bufferIndex * kFrameCount, kDeviceTicksPerSecond);
+		MIKMIDIEndpointSynthesizerPlayDueEvents(schedule, bufferTime, kFrameCount, RecordEvent, &recorder);
+		for (uint32_t index = 1; index < schedule->pendingCount; index++) {
+			CHECK(schedule->pending[index - 1].timeStamp <= schedule->pending[index].timeStamp);
+		}
+	}
+	CHECK(recorder.played == 64);
+	CHECK(schedule->pendingCount == 0);
+	CHECK(recorder.misplaced == 0);
+}
+
+static void testQueueKeepsOrderAcrossWraps(void)
+{
+	MIKMIDIEndpointSynthesizerSchedule *schedule = NewSchedule();
+	int next = 0;
+	int expected = 0;
+	int misordered = 0;
+	for (int round = 0; round < 10; round++) {
+		// Unbalanced pushes and pops, so the positions wrap at different slots.
+		for (int push = 0; push < 300; push++) {
+			MIKMIDIEndpointSynthesizerEvent event = {0, 0x90, (uint8_t)(next & 0x7F), (uint8_t)((next >> 7) & 0x7F)};
+			CHECK(MIKMIDIEndpointSynthesizerPushEvent(schedule, event));
+			next++;
+		}
+		MIKMIDIEndpointSynthesizerEvent event;
+		for (int pop = 0; pop < 300 && MIKMIDIEndpointSynthesizerPopEvent(schedule, &event); pop++) {
+			if ((event.data1 | (event.data2 << 7)) != (expected & 0x3FFF)) misordered++;
+			expected++;
+		}
+	}
+	CHECK(misordered == 0);
+	CHECK(expected == next);
+}
+
+static void testFullQueueRefusesEvents(void)
+{
+	MIKMIDIEndpointSynthesizerSchedule *schedule = NewSchedule();
+	MIKMIDIEndpointSynthesizerEvent event = {0, 0x90, 60, 100};
+	for (int index = 0; index < MIKMIDIEndpointSynthesizerQueueCapacity; index++) {
+		CHECK(MIKMIDIEndpointSynthesizerPushEvent(schedule, event));
+	}
+	CHECK(!MIKMIDIEndpointSynthesizerPushEvent(schedule, event));
+	CHECK(MIKMIDIEndpointSynthesizerPopEvent(schedule, &event));
+	CHECK(MIKMIDIEndpointSynthesizerPushEvent(schedule, event));
+	CHECK(!MIKMIDIEndpointSynthesizerPushEvent(schedule, event));
+}
+
+static void testFullPendingListPlaysAtOnce(void)
+{
+	// Events that do not fit in the pending list play at the start of the buffer, and none are lost.
+	MIKMIDIEndpointSynthesizerSchedule *schedule = NewSchedule();
+	static Recorder recorder;
+	memset(&recorder, 0, sizeof(recorder));
+	uint64_t farAhead = 1000000000000ULL;
+	int pushed = 0;
+	for (int batch = 0; batch < 3; batch++) {
+		for (int index = 0; index < 300; index++, pushed++) {
+			MIKMIDIEndpointSynthesizerEvent event = {farAhead, 0x90, (uint8_t)(pushed & 0x7F), (uint8_t)(pushed >> 7)};
+			CHECK(MIKMIDIEndpointSynthesizerPushEvent(schedule, event));
+		}
+		MIKMIDIEndpointSynthesizerPlayDueEvents(schedule, 0, kFrameCount, RecordEvent, &recorder);
+	}
+	CHECK(schedule->pendingCount == MIKMIDIEndpointSynthesizerPendingCapacity);
+	CHECK(recorder.played == pushed - MIKMIDIEndpointSynthesizerPendingCapacity);
+	CHECK(recorder.order[0] == MIKMIDIEndpointSynthesizerPendingCapacity);
+	recorder.startTime = farAhead;
+	CHECK(MIKMIDIEndpointSynthesizerPlayDueEvents(schedule, farAhead, kFrameCount, RecordEvent, &recorder) == MIKMIDIEndpointSynthesizerPendingCapacity);
+	CHECK(recorder.played == pushed);
+}
+
+enum { kThreadedEventCount = 200000 };
+
+static void *PushEvents(void *context)
+{
+	MIKMIDIEndpointSynthesizerSchedule *schedule = context;
+	for (int index = 0; index < kThreadedEventCount;) {
+		MIKMIDIEndpointSynthesizerEvent event = {(uint64_t)index, 0x90, (uint8_t)(index & 0x7F), (uint8_t)((index >> 7) & 0x7F)};
+		if (MIKMIDIEndpointSynthesizerPushEvent(schedule, event)) index++;
+	}
+	return NULL;
+}
+
+static void testQueueAcrossThreads(void)
+{
+	// The render thread sees every event once and in order while the producer runs on another thread.
+	MIKMIDIEndpointSynthesizerSchedule *schedule = NewSchedule();
+	pthread_t producer;
+	pthread_create(&producer, NULL, PushEvents, schedule);
+	int received = 0;
+	int corrupted = 0;
+	while (received < kThreadedEventCount) {
+		MIKMIDIEndpointSynthesizerEvent event;
+		if (!MIKMIDIEndpointSynthesizerPopEvent(schedule, &event)) continue;
+		if (event.timeStamp != (uint64_t)received || (event.data1 | (event.data2 << 7)) != (received & 0x3FFF)) corrupted++;
+		received++;
+	}
+	pthread_join(producer, NULL);
+	CHECK(corrupted == 0);
+	CHECK(schedule->readPosition == schedule->writePosition);
+}
+
+static void testInsertKeepsOrderOfEqualTimes(void)
+{
+	MIKMIDIEndpointSynthesizerEvent pending[4];
+	uint32_t pendingCount = 0;
+	MIKMIDIEndpointSynthesizerEvent noteOn = {200, 0x90, 60, 100};
+	MIKMIDIEndpointSynthesizerEvent noteOff = {200, 0x80, 60, 0};
+	MIKMIDIEndpointSynthesizerEvent earlier = {100, 0xB0, 7, 90};
+	MIKMIDIEndpointSynthesizerInsertEvent(pending, &pendingCount, noteOn);
+	MIKMIDIEndpointSynthesizerInsertEvent(pending, &pendingCount, noteOff);
+	MIKMIDIEndpointSynthesizerInsertEvent(pending, &pendingCount, earlier);
+	CHECK(pendingCount == 3);
+	CHECK(pending[0].status == 0xB0);
+	CHECK(pending[1].status == 0x90);
+	CHECK(pending[2].status == 0x80);
+}
+
+int main(void)
+{
+	RUN(testDueEventsSoundAtStart);
+	RUN(testEventsInBufferSoundAtTheirFrame);
+	RUN(testLaterEventsAreNotDue);
+	RUN(testLongUptimeKeepsPrecision);
+	RUN(testEventsScheduledAcrossBuffersSoundOnce);
+	RUN(testQueueKeepsOrderAcrossWraps);
+	RUN(testFullQueueRefusesEvents);
+	RUN(testFullPendingListPlaysAtOnce);
+	RUN(testQueueAcrossThreads);
+	RUN(testInsertKeepsOrderOfEqualTimes);
+	return TestResult();
+}
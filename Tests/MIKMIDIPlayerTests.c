@@ -0,0 +1,195 @@
+//
+//  MIKMIDIPlayerTests.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include <string.h>
+#include "TestSupport.h"
+#include "MIKMIDIPlayerCore.h"
+
+enum
+{
+	kMaxClicks = 256,
+};
+
+static MIKMIDIPlayerClick Clicks[kMaxClicks];
+
+/**
+ * Places all the clicks from fromTimeStamp to toTimeStamp in one call.
+ */
+static size_t PlaceClicks(const MIKMIDIPlayerTimeSignatureChange *changes, size_t changeCount, double length, bool isLooping, double fromTimeStamp, double toTimeStamp)
+{
+	return MIKMIDIPlayerPlaceClicks(changes, changeCount, length, isLooping, &fromTimeStamp, toTimeStamp, Clicks, kMaxClicks);
+}
+
+static void CheckClick(size_t index, double timeStamp, bool isTick)
+{
+	CHECK_NEAR(Clicks[index].timeStamp, timeStamp, 1e-9);
+	CHECK(Clicks[index].isTick == isTick);
+}
+
+static void testCommonTimeWithoutChanges(void)
+{
+	size_t count = PlaceClicks(NULL, 0, 16, false, 0, 8);
+	CHECK(count == 8);
+	for (size_t index = 0; index < count; index++) {
+		CheckClick(index, index, index % 4 == 0);
+	}
+}
+
+static void testChangeOnBarLine(void)
+{
+	// Two bars of 4/4, then 3/4.
+	MIKMIDIPlayerTimeSignatureChange changes[] = {{0, 4, 4}, {8, 3, 4}};
+	size_t count = PlaceClicks(changes, 2, 32, false, 0, 14);
+	CHECK(count == 14);
+	for (size_t index = 0; index < 8; index++) {
+		CheckClick(index, index, index % 4 == 0);
+	}
+	for (size_t index = 8; index < count; index++) {
+		CheckClick(index, index, (index - 8) % 3 == 0);
+	}
+}
+
+static void testChangeInMiddleOfBarStartsNewBar(void)
+{
+	// 4/4 cut short after three beats by 6/8, whose eighth notes are half a beat apart.
+	MIKMIDIPlayerTimeSignatureChange changes[] = {{3, 6, 8}};
+	size_t count = PlaceClicks(changes, 1, 32, false, 0, 7);
+	CHECK(count == 11);
+	CheckClick(0, 0, true);
+	CheckClick(1, 1, false);
+	CheckClick(2, 2, false);
+	for (size_t index = 3; index < count; index++) {
+		CheckClick(index, 3 + (index - 3) * 0.5, (index - 3) % 6 == 0);
+	}
+}
+
+static void testChangeOffTheBeatGrid(void)
+{
+	// A change at 2.5 beats cuts the beat at 2 short, and its bar starts with a tick at 2.5.
+	MIKMIDIPlayerTimeSignatureChange changes[] = {{2.5, 2, 4}};
+	size_t count = PlaceClicks(changes, 1, 32, false, 0, 5);
+	CHECK(count == 6);
+	CheckClick(0, 0, true);
+	CheckClick(1, 1, false);
+	CheckClick(2, 2, false);
+	CheckClick(3, 2.5, true);
+	CheckClick(4, 3.5, false);
+	CheckClick(5, 4.5, true);
+}
+
+static void testInvalidChangeIsIgnored(void)
+{
+	MIKMIDIPlayerTimeSignatureChange changes[] = {{0, 3, 4}, {3, 0, 4}, {6, 2, 0}};
+	size_t count = PlaceClicks(changes, 3, 32, false, 0, 9);
+	CHECK(count == 9);
+	for (size_t index = 0; index < count; index++) {
+		CheckClick(index, index, index % 3 == 0);
+	}
+}
+
+static void testStartingInMiddleOfBar(void)
+{
+	MIKMIDIPlayerTimeSignatureChange changes[] = {{0, 3, 4}};
+	size_t count = PlaceClicks(changes, 1, 32, false, 4.25, 7);
+	CHECK(count == 2);
+	CheckClick(0, 5, false);
+	CheckClick(1, 6, true);
+}
+
+static void testLoopRestartsBars(void)
+{
+	// A sequence of 7 beats in 3/4 loops after a short bar, and each loop starts with a tick.
+	MIKMIDIPlayerTimeSignatureChange changes[] = {{0, 3, 4}};
+	size_t count = PlaceClicks(changes, 1, 7, true, 0, 21);
+	CHECK(count == 21);
+	for (size_t index = 0; index < count; index++) {
+		CheckClick(index, index, (index % 7) % 3 == 0);
+	}
+}
+
+static void testLoopRepeatsChanges(void)
+{
+	// 4/4 for a bar, then 6/8 until the loop ends at 7 beats.
+	MIKMIDIPlayerTimeSignatureChange changes[] = {{0, 4, 4}, {4, 6, 8}};
+	size_t count = PlaceClicks(changes, 2, 7, true, 0, 14);
+	CHECK(count == 20);
+	for (size_t loop = 0; loop < 2; loop++) {
+		size_t first = loop * 10;
+		double offset = loop * 7.0;
+		for (size_t index = 0; index < 4; index++) {
+			CheckClick(first + index, offset + index, index == 0);
+		}
+		for (size_t index = 0; index < 6; index++) {
+			CheckClick(first + 4 + index, offset + 4 + index * 0.5, index == 0);
+		}
+	}
+}
+
+static void testLoopingWithoutLengthDoesNotLoop(void)
+{
+	size_t count = PlaceClicks(NULL, 0, 0, true, 0, 6);
+	CHECK(count == 6);
+	CheckClick(4, 4, true);
+	CheckClick(5, 5, false);
+}
+
+static void testChunkedCallsMatchOneCall(void)
+{
+	// Placing the clicks a timer tick at a time, and a few at a time, gives the clicks of one call.
+	MIKMIDIPlayerTimeSignatureChange changes[] = {{0, 5, 4}, {7.5, 7, 8}, {11, 2, 2}};
+	size_t expectedCount = PlaceClicks(changes, 3, 19, true, 0, 60);
+	MIKMIDIPlayerClick expected[kMaxClicks];
+	memcpy(expected, Clicks, sizeof(expected));
+
+	size_t count = 0;
+	int mismatched = 0;
+	double nextTimeStamp = 0;
+	for (double position = 0.1; position < 60.05; position += 0.1) {
+		double toTimeStamp = position < 60 ? position : 60;
+		MIKMIDIPlayerClick clicks[3];
+		size_t placed;
+		do {
+			placed = MIKMIDIPlayerPlaceClicks(changes, 3, 19, true, &nextTimeStamp, toTimeStamp, clicks, 3);
+			for (size_t index = 0; index < placed; index++, count++) {
+				if (count >= expectedCount || clicks[index].timeStamp != expected[count].timeStamp || clicks[index].isTick != expected[count].isTick) {
+					mismatched++;
+				}
+			}
+		} while (placed == 3);
+	}
+	CHECK(count == expectedCount);
+	CHECK(mismatched == 0);
+}
+
+static void testFromTimeStampAdvances(void)
+{
+	double fromTimeStamp = 0;
+	MIKMIDIPlayerClick clicks[2];
+	CHECK(MIKMIDIPlayerPlaceClicks(NULL, 0, 0, false, &fromTimeStamp, 10, clicks, 2) == 2);
+	CHECK_NEAR(fromTimeStamp, 2, 1e-9);
+	CHECK(MIKMIDIPlayerPlaceClicks(NULL, 0, 0, false, &fromTimeStamp, 2, clicks, 2) == 0);
+	CHECK_NEAR(fromTimeStamp, 2, 1e-9);
+	fromTimeStamp = 2.5;
+	CHECK(MIKMIDIPlayerPlaceClicks(NULL, 0, 0, false, &fromTimeStamp, 3, clicks, 2) == 0);
+	CHECK_NEAR(fromTimeStamp, 3, 1e-9);
+}
+
+int main(void)
+{
+	RUN(testCommonTimeWithoutChanges);
+	RUN(testChangeOnBarLine);
+	RUN(testChangeInMiddleOfBarStartsNewBar);
+	RUN(testChangeOffTheBeatGrid);
+	RUN(testInvalidChangeIsIgnored);
+	RUN(testStartingInMiddleOfBar);
+	RUN(testLoopRestartsBars);
+	RUN(testLoopRepeatsChanges);
+	RUN(testLoopingWithoutLengthDoesNotLoop);
+	RUN(testChunkedCallsMatchOneCall);
+	RUN(testFromTimeStampAdvances);
+	return TestResult();
+}
@@ -0,0 +1,141 @@
+//
+//  MIKMIDISystemExclusiveAssemblerBenchmark.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include <stdlib.h>
+#include "TestSupport.h"
+#include "MIKMIDISystemExclusiveAssemblerCore.h"
+
+/*
+ * Measures the parse throughput of the system exclusive state machine on three streams,
+ * split into packets as CoreMIDI delivers them:
+ *
+ *   dump      One large message, as from a sample or patch dump, with a clock every 1000 bytes.
+ *   messages  Short messages between notes, as from a controller's parameter changes.
+ *   ordinary  No system exclusive data at all, which should cost next to nothing.
+ *
+ * The callbacks copy the message bytes out, as the assembler's chunks do.
+ */
+
+enum
+{
+	kStreamLength = 8 * 1024 * 1024,
+	kPacketLength = 256,
+	kRounds = 8,
+};
+
+typedef struct {
+	uint8_t *message;
+	size_t messageLength;
+	size_t ordinaryBytes;
+	size_t realtimeBytes;
+	size_t messages;
+} Sink;
+
+static void OrdinaryBytes(void *context, const uint8_t *bytes, size_t length)
+{
+	(void)bytes;
+	((Sink *)context)->ordinaryBytes += length;
+}
+
+static void RealtimeByte(void *context, uint8_t status)
+{
+	(void)status;
+	((Sink *)context)->realtimeBytes++;
+}
+
+static void BeginMessage(void *context)
+{
+	((Sink *)context)->messageLength = 0;
+}
+
+static void MessageBytes(void *context, const uint8_t *bytes, size_t length)
+{
+	Sink *sink = context;
+	memcpy(sink->message + sink->messageLength, bytes, length);
+	sink->messageLength += length;
+}
+
+static void FinishMessage(void *context)
+{
+	((Sink *)context)->messages++;
+}
+
+static void CancelMessage(void *context)
+{
+	((Sink *)context)->messageLength = 0;
+}
+
+static const MIKMIDISystemExclusiveAssemblerCallbacks Callbacks = {OrdinaryBytes, RealtimeByte, BeginMessage, MessageBytes, FinishMessage, CancelMessage};
+
+static void MakeDump(uint8_t *stream, uint32_t *random)
+{
+	stream[0] = 0xF0;
+	for (size_t index = 1; index < kStreamLength - 1; index++) {
+		stream[index] = (index % 1000 == 0) ? 0xF8 : (uint8_t)(TestRandom(random) & 0x7F);
+	}
+	stream[kStreamLength - 1] = 0xF7;
+}
+
+static void MakeMessages(uint8_t *stream, uint32_t *random)
+{
+	size_t index = 0;
+	while (index + 32 <= kStreamLength) {
+		stream[index++] = 0x90;
+		stream[index++] = 60;
+		stream[index++] = 100;
+		stream[index++] = 0xF0;
+		for (int byte = 0; byte < 14; byte++) {
+			stream[index++] = (uint8_t)(TestRandom(random) & 0x7F);
+		}
+		stream[index++] = 0xF7;
+		for (int byte = 0; byte < 13; byte++) {
+			stream[index++] = (byte % 3 == 0) ? 0xB0 : (uint8_t)(TestRandom(random) & 0x7F);
+		}
+	}
+	memset(stream + index, 0xF8, kStreamLength - index);
+}
+
+static void MakeOrdinary(uint8_t *stream, uint32_t *random)
+{
+	for (size_t index = 0; index < kStreamLength; index++) {
+		stream[index] = (index % 3 == 0) ? 0xB0 : (uint8_t)(TestRandom(random) & 0x7F);
+	}
+}
+
+static void Measure(const char *name, const uint8_t *stream)
+{
+	Sink sink = {0};
+	sink.message = malloc(kStreamLength);
+	MIKMIDISystemExclusiveAssemblerParser parser;
+	MIKMIDISystemExclusiveAssemblerInit(&parser, SIZE_MAX);
+	size_t unclaimedPackets = 0;
+	double start = TestSeconds();
+	for (int round = 0; round < kRounds; round++) {
+		for (size_t offset = 0; offset < kStreamLength; offset += kPacketLength) {
+			if (!MIKMIDISystemExclusiveAssemblerParse(&parser, stream + offset, kPacketLength, &Callbacks, &sink)) {
+				unclaimedPackets++;
+			}
+		}
+	}
+	double elapsed = TestSeconds() - start;
+	printf("system exclusive %-8s %7.0f MB/s, %zu messages, %zu realtime bytes, %zu packets left to the ordinary parser\n", name, (double)kStreamLength * kRounds / elapsed / 1e6, sink.messages / kRounds, sink.realtimeBytes / kRounds, unclaimedPackets / kRounds);
+	free(sink.message);
+}
+
+int main(void)
+{
+	uint8_t *stream = malloc(kStreamLength);
+	uint32_t random = 1;
+	MakeDump(stream, &random);
+	Measure("dump", stream);
+	MakeMessages(stream, &random);
+	Measure("messages", stream);
+	MakeOrdinary(stream, &random);
+	Measure("ordinary", stream);
+	free(stream);
+	return 0;
+}
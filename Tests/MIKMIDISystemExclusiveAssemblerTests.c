@@ -0,0 +1,201 @@
+//
+//  MIKMIDISystemExclusiveAssemblerTests.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include "TestSupport.h"
+#include "MIKMIDISystemExclusiveAssemblerCore.h"
+
+enum { kMaxBytes = 4096 };
+
+/**
+ * What the state machine handed out, as the assembler would see it.
+ */
+typedef struct {
+	uint8_t message[kMaxBytes];
+	size_t messageLength;
+	uint8_t ordinary[kMaxBytes];
+	size_t ordinaryLength;
+	uint8_t realtime[kMaxBytes];
+	size_t realtimeCount;
+	unsigned begun;
+	unsigned finished;
+	unsigned cancelled;
+} Recording;
+
+static void OrdinaryBytes(void *context, const uint8_t *bytes, size_t length)
+{
+	Recording *recording = context;
+	memcpy(recording->ordinary + recording->ordinaryLength, bytes, length);
+	recording->ordinaryLength += length;
+}
+
+static void RealtimeByte(void *context, uint8_t status)
+{
+	Recording *recording = context;
+	recording->realtime[recording->realtimeCount++] = status;
+}
+
+static void BeginMessage(void *context)
+{
+	Recording *recording = context;
+	recording->begun++;
+	recording->messageLength = 0;
+}
+
+static void MessageBytes(void *context, const uint8_t *bytes, size_t length)
+{
+	Recording *recording = context;
+	memcpy(recording->message + recording->messageLength, bytes, length);
+	recording->messageLength += length;
+}
+
+static void FinishMessage(void *context)
+{
+	((Recording *)context)->finished++;
+}
+
+static void CancelMessage(void *context)
+{
+	Recording *recording = context;
+	recording->cancelled++;
+	recording->messageLength = 0;
+}
+
+static const MIKMIDISystemExclusiveAssemblerCallbacks Callbacks = {OrdinaryBytes, RealtimeByte, BeginMessage, MessageBytes, FinishMessage, CancelMessage};
+
+static Recording TheRecording;
+
+static bool Parse(MIKMIDISystemExclusiveAssemblerParser *parser, const uint8_t *bytes, size_t length)
+{
+	return MIKMIDISystemExclusiveAssemblerParse(parser, bytes, length, &Callbacks, &TheRecording);
+}
+
+static void Start(MIKMIDISystemExclusiveAssemblerParser *parser, size_t maximumLength)
+{
+	memset(&TheRecording, 0, sizeof(TheRecording));
+	MIKMIDISystemExclusiveAssemblerInit(parser, maximumLength);
+}
+
+static void testOrdinaryPacketIsLeftAlone(void)
+{
+	MIKMIDISystemExclusiveAssemblerParser parser;
+	Start(&parser, SIZE_MAX);
+	const uint8_t packet[] = {0x90, 60, 100, 0x80, 60, 0};
+	CHECK(!Parse(&parser, packet, sizeof(packet)));
+	CHECK(TheRecording.ordinaryLength == 0);
+}
+
+static void testMessageAcrossPackets(void)
+{
+	MIKMIDISystemExclusiveAssemblerParser parser;
+	Start(&parser, SIZE_MAX);
+	const uint8_t first[] = {0x90, 60, 100, 0xF0, 0x43, 0x10};
+	const uint8_t second[] = {0x01, 0x02};
+	const uint8_t third[] = {0x03, 0xF7, 0xB0, 7, 100};
+	CHECK(Parse(&parser, first, sizeof(first)));
+	CHECK(parser.state == MIKMIDISystemExclusiveAssemblerStateAssembling);
+	// A packet in the middle of a message has no start delimiter, but belongs to it.
+	CHECK(Parse(&parser, second, sizeof(second)));
+	CHECK(Parse(&parser, third, sizeof(third)));
+	const uint8_t message[] = {0xF0, 0x43, 0x10, 0x01, 0x02, 0x03, 0xF7};
+	CHECK(TheRecording.begun == 1);
+	CHECK(TheRecording.finished == 1);
+	CHECK(TheRecording.messageLength == sizeof(message));
+	CHECK(memcmp(TheRecording.message, message, sizeof(message)) == 0);
+	const uint8_t ordinary[] = {0x90, 60, 100, 0xB0, 7, 100};
+	CHECK(TheRecording.ordinaryLength == sizeof(ordinary));
+	CHECK(memcmp(TheRecording.ordinary, ordinary, sizeof(ordinary)) == 0);
+	CHECK(parser.state == MIKMIDISystemExclusiveAssemblerStateIdle);
+}
+
+static void testRealtimeBytesArePulledOut(void)
+{
+	MIKMIDISystemExclusiveAssemblerParser parser;
+	Start(&parser, SIZE_MAX);
+	const uint8_t packet[] = {0xF0, 0x01, 0xF8, 0x02, 0xFE, 0xF7};
+	Parse(&parser, packet, sizeof(packet));
+	CHECK(TheRecording.realtimeCount == 2);
+	CHECK(TheRecording.realtime[0] == 0xF8);
+	CHECK(TheRecording.realtime[1] == 0xFE);
+	CHECK(TheRecording.messageLength == 4);
+	CHECK(TheRecording.finished == 1);
+}
+
+static void testStatusByteCancelsMessage(void)
+{
+	MIKMIDISystemExclusiveAssemblerParser parser;
+	Start(&parser, SIZE_MAX);
+	const uint8_t packet[] = {0xF0, 0x01, 0x02, 0x90, 60, 100};
+	Parse(&parser, packet, sizeof(packet));
+	CHECK(TheRecording.cancelled == 1);
+	CHECK(TheRecording.finished == 0);
+	CHECK(parser.discardedMessageCount == 1);
+	// The status byte that cancelled the message is parsed as usual.
+	CHECK(TheRecording.ordinaryLength == 3);
+	CHECK(TheRecording.ordinary[0] == 0x90);
+}
+
+static void testTooLongMessageIsSkipped(void)
+{
+	MIKMIDISystemExclusiveAssemblerParser parser;
+	Start(&parser, 4);
+	const uint8_t tooLong[] = {0xF0, 0x01, 0x02, 0x03, 0x04, 0xF7, 0x90, 60, 100};
+	Parse(&parser, tooLong, sizeof(tooLong));
+	CHECK(TheRecording.cancelled == 1);
+	CHECK(TheRecording.finished == 0);
+	CHECK(parser.discardedMessageCount == 1);
+	CHECK(parser.state == MIKMIDISystemExclusiveAssemblerStateIdle);
+	CHECK(TheRecording.ordinaryLength == 3);
+
+	// The end delimiter counts toward the limit too.
+	const uint8_t endTooLong[] = {0xF0, 0x01, 0x02, 0x03, 0xF7};
+	Parse(&parser, endTooLong, sizeof(endTooLong));
+	CHECK(TheRecording.finished == 0);
+	CHECK(parser.discardedMessageCount == 2);
+
+	const uint8_t fits[] = {0xF0, 0x01, 0x02, 0xF7};
+	Parse(&parser, fits, sizeof(fits));
+	CHECK(TheRecording.finished == 1);
+	CHECK(parser.discardedMessageCount == 2);
+}
+
+static void testCancelOnlyCountsMessageInProgress(void)
+{
+	MIKMIDISystemExclusiveAssemblerParser parser;
+	Start(&parser, SIZE_MAX);
+	MIKMIDISystemExclusiveAssemblerCancel(&parser, &Callbacks, &TheRecording);
+	CHECK(parser.discardedMessageCount == 0);
+	const uint8_t packet[] = {0xF0, 0x01};
+	Parse(&parser, packet, sizeof(packet));
+	MIKMIDISystemExclusiveAssemblerCancel(&parser, &Callbacks, &TheRecording);
+	CHECK(parser.discardedMessageCount == 1);
+	CHECK(TheRecording.cancelled == 1);
+	CHECK(parser.state == MIKMIDISystemExclusiveAssemblerStateIdle);
+}
+
+static void testBackToBackMessages(void)
+{
+	MIKMIDISystemExclusiveAssemblerParser parser;
+	Start(&parser, SIZE_MAX);
+	const uint8_t packet[] = {0xF0, 0x01, 0xF7, 0xF0, 0x02, 0x03, 0xF7};
+	Parse(&parser, packet, sizeof(packet));
+	CHECK(TheRecording.begun == 2);
+	CHECK(TheRecording.finished == 2);
+	CHECK(TheRecording.messageLength == 4);
+	CHECK(TheRecording.ordinaryLength == 0);
+}
+
+int main(void)
+{
+	RUN(testOrdinaryPacketIsLeftAlone);
+	RUN(testMessageAcrossPackets);
+	RUN(testRealtimeBytesArePulledOut);
+	RUN(testStatusByteCancelsMessage);
+	RUN(testTooLongMessageIsSkipped);
+	RUN(testCancelOnlyCountsMessageInProgress);
+	RUN(testBackToBackMessages);
+	return TestResult();
+}
@@ -0,0 +1,94 @@
+//
+//  MotionDetectorBenchmark.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include <stdlib.h>
+#include "TestSupport.h"
+#include "MotionDetectorFixture.h"
+
+/*
+ * Measures the detector on a sequence of 8-bit luma frames.
+ *
+ * usage: MotionDetectorBenchmark [frames.raw width height]
+ *
+ * A recorded sequence is a file of width * height byte frames back to back,
+ * e.g. made with ffmpeg -i clip.mov -vf scale=128:96 -pix_fmt gray -f rawvideo frames.raw.
+ * Without one, a synthetic scene with sensor noise and a passing object is used.
+ */
+
+static uint8_t *MakeSyntheticSequence(size_t width, size_t height, size_t frames)
+{
+	size_t pixels = width * height;
+	uint8_t *sequence = malloc(pixels * frames);
+	uint32_t seed = 1;
+	for (size_t frame = 0; frame < frames; frame++) {
+		uint8_t *luma = sequence + frame * pixels;
+		MotionDetectorFixtureFill(luma, pixels, 110, 6, &seed);
+		if (frame % 200 >= 150) {
+			MotionDetectorFixtureSquare(luma, width, height, (frame % 50) * 2, height / 3, height / 4, 220);
+		}
+	}
+	return sequence;
+}
+
+static uint8_t *LoadSequence(const char *path, size_t pixels, size_t *frames)
+{
+	FILE *file = fopen(path, "rb");
+	if (!file) {
+		return NULL;
+	}
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	*frames = (size_t)length / pixels;
+	uint8_t *sequence = malloc(*frames * pixels);
+	if (!sequence || fread(sequence, pixels, *frames, file) != *frames) {
+		free(sequence);
+		sequence = NULL;
+	}
+	fclose(file);
+	return sequence;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t width = 128;
+	size_t height = 96;
+	size_t frames = 1200;
+	uint8_t *sequence;
+	if (argc >= 4) {
+		width = (size_t)atol(argv[2]);
+		height = (size_t)atol(argv[3]);
+		sequence = LoadSequence(argv[1], width * height, &frames);
+		if (!sequence || frames == 0) {
+			fprintf(stderr, "To read %s is failed.\n", argv[1]);
+			return 1;
+		}
+	} else {
+		sequence = MakeSyntheticSequence(width, height, frames);
+	}
+
+	MotionDetectorState detector;
+	MotionDetectorInit(&detector, width, height, 8);
+	unsigned triggers = 0;
+	const unsigned rounds = 20;
+	double start = TestSeconds();
+	for (unsigned round = 0; round < rounds; round++) {
+		MotionDetectorReset(&detector);
+		for (size_t frame = 0; frame < frames; frame++) {
+			if (MotionDetectorProcess(&detector, sequence + frame * width * height)) {
+				triggers++;
+			}
+		}
+	}
+	double elapsed = TestSeconds() - start;
+	double processed = (double)frames * rounds;
+	printf("motion detector %zux%zu: %.2f us/frame, %.0f frames/s, %u triggers in %zu frames\n", width, height, elapsed / processed * 1e6, processed / elapsed, triggers / rounds, frames);
+
+	MotionDetectorDestroy(&detector);
+	free(sequence);
+	return 0;
+}
@@ -0,0 +1,44 @@
+//
+//  MotionDetectorFixture.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#ifndef ImageCaptureSample_MotionDetectorFixture_h
+#define ImageCaptureSample_MotionDetectorFixture_h
+
+#include "TestSupport.h"
+#include "MotionDetectorCore.h"
+
+/*
+ * Makes synthetic scenes to feed MotionDetectorCore.h.
+ */
+
+/**
+ * Fills a frame with a flat level plus uniform noise of +-noise levels.
+ */
+static inline void MotionDetectorFixtureFill(uint8_t *luma, size_t pixels, int level, int noise, uint32_t *random)
+{
+	for (size_t index = 0; index < pixels; index++) {
+		int value = level;
+		if (noise > 0) {
+			value += (int)(TestRandom(random) % (uint32_t)(2 * noise + 1)) - noise;
+		}
+		luma[index] = (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+	}
+}
+
+/**
+ * Draws a filled square at (x, y).
+ */
+static inline void MotionDetectorFixtureSquare(uint8_t *luma, size_t width, size_t height, size_t x, size_t y, size_t size, uint8_t level)
+{
+	for (size_t row = y; row < y + size && row < height; row++) {
+		for (size_t column = x; column < x + size && column < width; column++) {
+			luma[row * width + column] = level;
+		}
+	}
+}
+
+#endif
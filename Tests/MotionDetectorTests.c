@@ -0,0 +1,299 @@
+//
+//  MotionDetectorTests.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include "TestSupport.h"
+#include "MotionDetectorFixture.h"
+
+enum { kWidth = 128, kHeight = 96, kBlockSize = 8, kPixels = kWidth * kHeight };
+
+/**
+ * Feeds frames of a flat scene and returns the number of triggers after warm-up.
+ */
+static unsigned CountTriggers(MotionDetectorState *detector, unsigned frames, int (*level)(unsigned frame), int noise, uint32_t seed)
+{
+	static uint8_t luma[kPixels];
+	unsigned triggers = 0;
+	for (unsigned frame = 0; frame < frames; frame++) {
+		MotionDetectorFixtureFill(luma, kPixels, level(frame), noise, &seed);
+		if (MotionDetectorProcess(detector, luma)) {
+			triggers++;
+		}
+	}
+	return triggers;
+}
+
+static int SteadyLevel(unsigned frame)
+{
+	(void)frame;
+	return 120;
+}
+
+static int DriftingLevel(unsigned frame)
+{
+	// Auto exposure hunting slowly over ten seconds at 30 fps.
+	return 60 + (int)(frame * 120 / 300);
+}
+
+static void testSensorNoiseDoesNotTrigger(void)
+{
+	MotionDetectorState detector;
+	MotionDetectorInit(&detector, kWidth, kHeight, kBlockSize);
+	CHECK(CountTriggers(&detector, 300, SteadyLevel, 8, 1) == 0);
+	MotionDetectorDestroy(&detector);
+}
+
+static void testExposureDriftDoesNotTrigger(void)
+{
+	MotionDetectorState detector;
+	MotionDetectorInit(&detector, kWidth, kHeight, kBlockSize);
+	CHECK(CountTriggers(&detector, 300, DriftingLevel, 4, 2) == 0);
+	MotionDetectorDestroy(&detector);
+}
+
+static void testBackgroundSettlesOnBrighterScene(void)
+{
+	// Stepping the 8-bit background with a floored shift left it 7 levels
+	// below a brighter scene for good, eating into the block threshold.
+	static uint8_t luma[kPixels];
+	MotionDetectorState detector;
+	MotionDetectorInit(&detector, kWidth, kHeight, kBlockSize);
+	uint32_t seed = 3;
+	MotionDetectorFixtureFill(luma, kPixels, 40, 0, &seed);
+	MotionDetectorProcess(&detector, luma);
+	MotionDetectorFixtureFill(luma, kPixels, 200, 0, &seed);
+	for (unsigned frame = 0; frame < 200; frame++) {
+		MotionDetectorProcess(&detector, luma);
+	}
+	CHECK(detector.background[0] == 200);
+	CHECK(detector.background[kPixels - 1] == 200);
+	CHECK(detector.motionScore == 0);
+	MotionDetectorDestroy(&detector);
+}
+
+static void testBackgroundSettlesOnDarkerScene(void)
+{
+	static uint8_t luma[kPixels];
+	MotionDetectorState detector;
+	MotionDetectorInit(&detector, kWidth, kHeight, kBlockSize);
+	uint32_t seed = 4;
+	MotionDetectorFixtureFill(luma, kPixels, 200, 0, &seed);
+	MotionDetectorProcess(&detector, luma);
+	MotionDetectorFixtureFill(luma, kPixels, 40, 0, &seed);
+	for (unsigned frame = 0; frame < 200; frame++) {
+		MotionDetectorProcess(&detector, luma);
+	}
+	CHECK(detector.background[0] == 40);
+	CHECK(detector.background[kPixels - 1] == 40);
+	MotionDetectorDestroy(&detector);
+}
+
+static void testBackgroundHasNoBiasUnderNoise(void)
+{
+	static uint8_t luma[kPixels];
+	MotionDetectorState detector;
+	MotionDetectorInit(&detector, kWidth, kHeight, kBlockSize);
+	uint32_t seed = 5;
+	for (unsigned frame = 0; frame < 400; frame++) {
+		MotionDetectorFixtureFill(luma, kPixels, 128, 6, &seed);
+		MotionDetectorProcess(&detector, luma);
+	}
+	double sum = 0;
+	for (size_t index = 0; index < kPixels; index++) {
+		sum += detector.background[index];
+	}
+	CHECK_NEAR(sum / kPixels, 128, 0.25);
+	MotionDetectorDestroy(&detector);
+}
+
+static void testHotPixelDoesNotTrigger(void)
+{
+	static uint8_t luma[kPixels];
+	MotionDetectorState detector;
+	MotionDetectorInit(&detector, kWidth, kHeight, kBlockSize);
+	uint32_t seed = 6;
+	unsigned triggers = 0;
+	for (unsigned frame = 0; frame < 120; frame++) {
+		MotionDetectorFixtureFill(luma, kPixels, 90, 3, &seed);
+		if (frame % 2 == 0) {
+			// A blinking pixel in every block.
+			for (size_t y = 0; y < kHeight; y += kBlockSize) {
+				for (size_t x = 0; x < kWidth; x += kBlockSize) {
+					luma[y * kWidth + x] = 255;
+				}
+			}
+		}
+		if (MotionDetectorProcess(&detector, luma)) {
+			triggers++;
+		}
+	}
+	CHECK(triggers == 0);
+	MotionDetectorDestroy(&detector);
+}
+
+static void testMotionOutsideRegionDoesNotTrigger(void)
+{
+	static uint8_t luma[kPixels];
+	MotionDetectorState detector;
+	MotionDetectorInit(&detector, kWidth, kHeight, kBlockSize);
+	// Watch the right half only.
+	MotionDetectorSetRegion(&detector, 0.5, 0, 1, 1);
+	uint32_t seed = 7;
+	unsigned triggers = 0;
+	for (unsigned frame = 0; frame < 120; frame++) {
+		MotionDetectorFixtureFill(luma, kPixels, 100, 4, &seed);
+		MotionDetectorFixtureSquare(luma, kWidth, kHeight, frame % 40, 20 + frame % 50, 24, 240);
+		if (MotionDetectorProcess(&detector, luma)) {
+			triggers++;
+		}
+	}
+	CHECK(triggers == 0);
+	MotionDetectorDestroy(&detector);
+}
+
+static void testObjectEnteringRegionTriggers(void)
+{
+	static uint8_t luma[kPixels];
+	MotionDetectorState detector;
+	MotionDetectorInit(&detector, kWidth, kHeight, kBlockSize);
+	uint32_t seed = 8;
+	int firstTrigger = -1;
+	for (unsigned frame = 0; frame < 60; frame++) {
+		MotionDetectorFixtureFill(luma, kPixels, 100, 4, &seed);
+		if (frame >= 30) {
+			MotionDetectorFixtureSquare(luma, kWidth, kHeight, 40 + (frame - 30) * 2, 30, 24, 230);
+		}
+		if (MotionDetectorProcess(&detector, luma) && firstTrigger < 0) {
+			firstTrigger = (int)frame;
+		}
+	}
+	CHECK(firstTrigger == 30);
+	MotionDetectorDestroy(&detector);
+}
+
+static void testWarmUpSuppressesTriggers(void)
+{
+	static uint8_t luma[kPixels];
+	MotionDetectorState detector;
+	MotionDetectorInit(&detector, kWidth, kHeight, kBlockSize);
+	uint32_t seed = 9;
+	unsigned triggers = 0;
+	for (unsigned frame = 0; frame < detector.warmUpFrames; frame++) {
+		MotionDetectorFixtureFill(luma, kPixels, (frame % 2) ? 20 : 220, 0, &seed);
+		if (MotionDetectorProcess(&detector, luma)) {
+			triggers++;
+		}
+	}
+	CHECK(triggers == 0);
+	CHECK(detector.motionScore > 0.5f);
+	MotionDetectorDestroy(&detector);
+}
+
+static void testResetRestartsWarmUp(void)
+{
+	static uint8_t luma[kPixels];
+	MotionDetectorState detector;
+	MotionDetectorInit(&detector, kWidth, kHeight, kBlockSize);
+	uint32_t seed = 11;
+	for (unsigned frame = 0; frame < 20; frame++) {
+		MotionDetectorFixtureFill(luma, kPixels, 100, 2, &seed);
+		MotionDetectorProcess(&detector, luma);
+	}
+	MotionDetectorFixtureFill(luma, kPixels, 220, 2, &seed);
+	CHECK(MotionDetectorProcess(&detector, luma));
+	MotionDetectorReset(&detector);
+	// The new scene starts the background, and nothing is reported during warm-up.
+	CHECK(!MotionDetectorProcess(&detector, luma));
+	CHECK(detector.background[0] >= 218);
+	MotionDetectorFixtureFill(luma, kPixels, 20, 2, &seed);
+	CHECK(!MotionDetectorProcess(&detector, luma));
+	CHECK(detector.motionScore == 1);
+	MotionDetectorDestroy(&detector);
+}
+
+static void testRegionCoversTouchedBlocks(void)
+{
+	MotionDetectorState detector;
+	MotionDetectorInit(&detector, kWidth, kHeight, kBlockSize);
+	CHECK(detector.firstColumn == 0 && detector.lastColumn == 16);
+	CHECK(detector.firstRow == 0 && detector.lastRow == 12);
+	MotionDetectorSetRegion(&detector, 0.1, 0.25, 0.5, 0.6);
+	CHECK(detector.firstColumn == 1 && detector.lastColumn == 8);
+	CHECK(detector.firstRow == 3 && detector.lastRow == 8);
+	// Clipped to the frame.
+	MotionDetectorSetRegion(&detector, -1, 0.5, 3, 2);
+	CHECK(detector.firstColumn == 0 && detector.lastColumn == 16);
+	CHECK(detector.firstRow == 6 && detector.lastRow == 12);
+	MotionDetectorDestroy(&detector);
+}
+
+static void testRegionOutsideFrameNeverTriggers(void)
+{
+	static uint8_t luma[kPixels];
+	MotionDetectorState detector;
+	MotionDetectorInit(&detector, kWidth, kHeight, kBlockSize);
+	MotionDetectorSetRegion(&detector, 1.5, 0, 2, 1);
+	CHECK(detector.firstColumn == detector.lastColumn);
+	detector.warmUpFrames = 0;
+	uint32_t seed = 12;
+	unsigned triggers = 0;
+	for (unsigned frame = 0; frame < 20; frame++) {
+		MotionDetectorFixtureFill(luma, kPixels, (frame % 2) ? 20 : 220, 0, &seed);
+		if (MotionDetectorProcess(&detector, luma)) {
+			triggers++;
+		}
+	}
+	CHECK(triggers == 0);
+	CHECK(detector.motionScore == 0);
+	MotionDetectorDestroy(&detector);
+}
+
+static void testFrameSmallerThanBlockIsRejected(void)
+{
+	MotionDetectorState detector;
+	CHECK(!MotionDetectorInit(&detector, 4, 96, 8));
+	MotionDetectorDestroy(&detector);
+	CHECK(!MotionDetectorInit(&detector, 128, 96, 0));
+	MotionDetectorDestroy(&detector);
+}
+
+static void testBlockSADMatchesReference(void)
+{
+	static uint8_t a[kPixels];
+	static uint8_t b[kPixels];
+	uint32_t seed = 10;
+	MotionDetectorFixtureFill(a, kPixels, 128, 127, &seed);
+	MotionDetectorFixtureFill(b, kPixels, 128, 127, &seed);
+	for (size_t blockSize = 4; blockSize <= 16; blockSize += 4) {
+		uint32_t expected = 0;
+		for (size_t y = 0; y < blockSize; y++) {
+			for (size_t x = 0; x < blockSize; x++) {
+				int difference = (int)a[y * kWidth + x + 3] - (int)b[y * kWidth + x + 3];
+				expected += (uint32_t)abs(difference);
+			}
+		}
+		CHECK(MotionDetectorBlockSAD(a + 3, b + 3, kWidth, blockSize) == expected);
+	}
+}
+
+int main(void)
+{
+	RUN(testSensorNoiseDoesNotTrigger);
+	RUN(testExposureDriftDoesNotTrigger);
+	RUN(testBackgroundSettlesOnBrighterScene);
+	RUN(testBackgroundSettlesOnDarkerScene);
+	RUN(testBackgroundHasNoBiasUnderNoise);
+	RUN(testHotPixelDoesNotTrigger);
+	RUN(testMotionOutsideRegionDoesNotTrigger);
+	RUN(testObjectEnteringRegionTriggers);
+	RUN(testWarmUpSuppressesTriggers);
+	RUN(testResetRestartsWarmUp);
+	RUN(testRegionCoversTouchedBlocks);
+	RUN(testRegionOutsideFrameNeverTriggers);
+	RUN(testFrameSmallerThanBlockIsRejected);
+	RUN(testBlockSADMatchesReference);
+	return TestResult();
+}
@@ -0,0 +1,155 @@
+//
+//  ObjectTrackerBenchmark.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include <stdlib.h>
+#include "TestSupport.h"
+#include "ObjectTrackerFixture.h"
+
+/*
+ * Measures the tracker on a sequence of 8-bit luma frames with ground truth boxes.
+ *
+ * usage: ObjectTrackerBenchmark [frames.raw width height boxes.txt]
+ *
+ * A recorded sequence is a file of width * height byte frames back to back,
+ * e.g. made with ffmpeg -i clip.mov -vf scale=160:120 -pix_fmt gray -f rawvideo frames.raw,
+ * and a text file of one "x y width height" box of the subject per frame, in pixels.
+ * Without them, a synthetic subject moving over a textured background is used.
+ *
+ * The tracker starts on the center of the first box. When it loses the subject or
+ * drifts off its box, it is counted as a failure and restarted on the box of that frame.
+ */
+
+enum { kTemplateSize = 16 };
+
+typedef struct {
+	double x;
+	double y;
+	double width;
+	double height;
+} Box;
+
+static uint8_t *MakeSyntheticSequence(size_t width, size_t height, size_t frames, Box *boxes)
+{
+	const size_t subjectSize = 24;
+	size_t pixels = width * height;
+	uint8_t *sequence = malloc(pixels * frames);
+	uint32_t seed = 1;
+	for (size_t frame = 0; frame < frames; frame++) {
+		double x, y;
+		ObjectTrackerFixturePath(frame, width, height, subjectSize, &x, &y);
+		// The light changes slowly, as when a cloud passes.
+		double gain = 1.0 + 0.15 * sin(2 * kObjectTrackerFixturePi * frame / 400.0);
+		ObjectTrackerFixtureFrame(sequence + frame * pixels, width, height, (size_t)x, (size_t)y, subjectSize, gain, 4, &seed);
+		boxes[frame] = (Box){x, y, subjectSize, subjectSize};
+	}
+	return sequence;
+}
+
+static uint8_t *LoadSequence(const char *path, size_t pixels, size_t *frames)
+{
+	FILE *file = fopen(path, "rb");
+	if (!file) {
+		return NULL;
+	}
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	*frames = (size_t)length / pixels;
+	uint8_t *sequence = malloc(*frames * pixels);
+	if (!sequence || fread(sequence, pixels, *frames, file) != *frames) {
+		free(sequence);
+		sequence = NULL;
+	}
+	fclose(file);
+	return sequence;
+}
+
+static Box *LoadBoxes(const char *path, size_t frames)
+{
+	FILE *file = fopen(path, "r");
+	if (!file) {
+		return NULL;
+	}
+	Box *boxes = malloc(frames * sizeof(Box));
+	for (size_t frame = 0; boxes && frame < frames; frame++) {
+		Box *box = &boxes[frame];
+		if (fscanf(file, "%lf %lf %lf %lf", &box->x, &box->y, &box->width, &box->height) != 4) {
+			free(boxes);
+			boxes = NULL;
+		}
+	}
+	fclose(file);
+	return boxes;
+}
+
+static bool Start(ObjectTrackerState *tracker, const uint8_t *luma, const Box *box, size_t width, size_t height)
+{
+	return ObjectTrackerStart(tracker, (box->x + box->width / 2) / width, (box->y + box->height / 2) / height, luma);
+}
+
+int main(int argc, char *argv[])
+{
+	size_t width = 160;
+	size_t height = 120;
+	size_t frames = 1200;
+	uint8_t *sequence;
+	Box *boxes;
+	if (argc >= 5) {
+		width = (size_t)atol(argv[2]);
+		height = (size_t)atol(argv[3]);
+		sequence = LoadSequence(argv[1], width * height, &frames);
+		if (!sequence || frames == 0) {
+			fprintf(stderr, "To read %s is failed.\n", argv[1]);
+			return 1;
+		}
+		boxes = LoadBoxes(argv[4], frames);
+		if (!boxes) {
+			fprintf(stderr, "To read %zu boxes from %s is failed.\n", frames, argv[4]);
+			return 1;
+		}
+	} else {
+		boxes = malloc(frames * sizeof(Box));
+		sequence = MakeSyntheticSequence(width, height, frames, boxes);
+	}
+
+	ObjectTrackerState tracker;
+	if (!ObjectTrackerInit(&tracker, width, height, kTemplateSize)) {
+		fprintf(stderr, "The frame is smaller than the template.\n");
+		return 1;
+	}
+	unsigned failures = 0;
+	double errorSum = 0;
+	size_t measured = 0;
+	double processing = 0;
+	Start(&tracker, sequence, &boxes[0], width, height);
+	for (size_t frame = 1; frame < frames; frame++) {
+		const uint8_t *luma = sequence + frame * width * height;
+		const Box *box = &boxes[frame];
+		double start = TestSeconds();
+		bool tracking = ObjectTrackerProcess(&tracker, luma);
+		processing += TestSeconds() - start;
+
+		double centerX = tracker.templateX + kTemplateSize / 2.0;
+		double centerY = tracker.templateY + kTemplateSize / 2.0;
+		double errorX = centerX - (box->x + box->width / 2);
+		double errorY = centerY - (box->y + box->height / 2);
+		bool onBox = fabs(errorX) <= box->width / 2 && fabs(errorY) <= box->height / 2;
+		if (!tracking || !onBox) {
+			failures++;
+			Start(&tracker, luma, box, width, height);
+			continue;
+		}
+		errorSum += sqrt(errorX * errorX + errorY * errorY);
+		measured++;
+	}
+	printf("object tracker %zux%zu: %.1f us/frame, %.2f px mean center error, %u failures in %zu frames\n", width, height, processing / (frames - 1) * 1e6, measured > 0 ? errorSum / measured : 0.0, failures, frames);
+
+	ObjectTrackerDestroy(&tracker);
+	free(boxes);
+	free(sequence);
+	return 0;
+}
@@ -0,0 +1,67 @@
+//
+//  ObjectTrackerFixture.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#ifndef ImageCaptureSample_ObjectTrackerFixture_h
+#define ImageCaptureSample_ObjectTrackerFixture_h
+
+#include "TestSupport.h"
+#include "ObjectTrackerCore.h"
+
+/*
+ * Makes synthetic scenes to feed ObjectTrackerCore.h: a textured subject
+ * moving over a textured background, with known positions.
+ */
+
+/** M_PI is not in C99. */
+#define kObjectTrackerFixturePi 3.14159265358979323846
+
+/**
+ * Returns a repeatable texture level of a cell.
+ */
+static inline uint8_t ObjectTrackerFixtureTexture(size_t column, size_t row, uint32_t seed)
+{
+	uint32_t hash = (uint32_t)column * 73856093u ^ (uint32_t)row * 19349663u ^ seed * 83492791u;
+	hash ^= hash >> 13;
+	hash *= 0x5bd1e995u;
+	hash ^= hash >> 15;
+	return (uint8_t)hash;
+}
+
+/**
+ * Returns the top left corner of the subject in a frame, on a slow figure eight.
+ */
+static inline void ObjectTrackerFixturePath(size_t frame, size_t width, size_t height, size_t subjectSize, double *x, double *y)
+{
+	double centerX = width / 2.0 + width / 3.0 * sin(2 * kObjectTrackerFixturePi * frame / 240.0);
+	double centerY = height / 2.0 + height / 4.0 * sin(2 * kObjectTrackerFixturePi * frame / 120.0);
+	*x = round(centerX - subjectSize / 2.0);
+	*y = round(centerY - subjectSize / 2.0);
+}
+
+/**
+ * Draws the background, the subject at (subjectX, subjectY) with its levels scaled by gain,
+ * and uniform noise of +-noise levels.
+ */
+static inline void ObjectTrackerFixtureFrame(uint8_t *luma, size_t width, size_t height, size_t subjectX, size_t subjectY, size_t subjectSize, double gain, int noise, uint32_t *random)
+{
+	for (size_t row = 0; row < height; row++) {
+		for (size_t column = 0; column < width; column++) {
+			int value;
+			if (column >= subjectX && column < subjectX + subjectSize && row >= subjectY && row < subjectY + subjectSize) {
+				value = (int)((20 + ObjectTrackerFixtureTexture((column - subjectX) / 2, (row - subjectY) / 2, 2) % 200) * gain);
+			} else {
+				value = 60 + ObjectTrackerFixtureTexture(column / 6, row / 6, 1) % 80;
+			}
+			if (noise > 0) {
+				value += (int)(TestRandom(random) % (uint32_t)(2 * noise + 1)) - noise;
+			}
+			luma[row * width + column] = (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,146 @@
+//
+//  ObjectTrackerTests.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include "TestSupport.h"
+#include "ObjectTrackerFixture.h"
+
+enum
+{
+	kWidth = 160,
+	kHeight = 120,
+	kTemplateSize = 16,
+	kSubjectSize = 24,
+};
+
+static uint8_t Luma[kWidth * kHeight];
+
+/**
+ * Starts a tracker on the center of the subject of the first frame of the path.
+ */
+static bool StartOnSubject(ObjectTrackerState *tracker, uint32_t *random)
+{
+	double x, y;
+	ObjectTrackerFixturePath(0, kWidth, kHeight, kSubjectSize, &x, &y);
+	ObjectTrackerFixtureFrame(Luma, kWidth, kHeight, (size_t)x, (size_t)y, kSubjectSize, 1.0, 3, random);
+	return ObjectTrackerStart(tracker, (x + kSubjectSize / 2.0) / kWidth, (y + kSubjectSize / 2.0) / kHeight, Luma);
+}
+
+static void testFollowsMovingSubject(void)
+{
+	ObjectTrackerState tracker;
+	CHECK(ObjectTrackerInit(&tracker, kWidth, kHeight, kTemplateSize));
+	uint32_t random = 1;
+	CHECK(StartOnSubject(&tracker, &random));
+	double maximumError = 0;
+	int lost = 0;
+	for (size_t frame = 1; frame < 480; frame++) {
+		double x, y;
+		ObjectTrackerFixturePath(frame, kWidth, kHeight, kSubjectSize, &x, &y);
+		ObjectTrackerFixtureFrame(Luma, kWidth, kHeight, (size_t)x, (size_t)y, kSubjectSize, 1.0, 3, &random);
+		if (!ObjectTrackerProcess(&tracker, Luma)) {
+			lost++;
+			break;
+		}
+		// The template is the middle of the subject.
+		double offset = (kSubjectSize - kTemplateSize) / 2.0;
+		double error = fmax(fabs(tracker.templateX - (x + offset)), fabs(tracker.templateY - (y + offset)));
+		maximumError = fmax(maximumError, error);
+	}
+	CHECK(lost == 0);
+	CHECK(maximumError <= 1);
+	ObjectTrackerDestroy(&tracker);
+}
+
+static void testFlatAreaIsNotTracked(void)
+{
+	ObjectTrackerState tracker;
+	ObjectTrackerInit(&tracker, kWidth, kHeight, kTemplateSize);
+	for (size_t index = 0; index < kWidth * kHeight; index++) {
+		Luma[index] = 128;
+	}
+	CHECK(!ObjectTrackerStart(&tracker, 0.5, 0.5, Luma));
+	CHECK(!tracker.tracking);
+	CHECK(!ObjectTrackerProcess(&tracker, Luma));
+	ObjectTrackerDestroy(&tracker);
+}
+
+static void testSubjectThatLeavesIsLost(void)
+{
+	ObjectTrackerState tracker;
+	ObjectTrackerInit(&tracker, kWidth, kHeight, kTemplateSize);
+	uint32_t random = 2;
+	CHECK(StartOnSubject(&tracker, &random));
+	// The subject jumps much further than the search radius.
+	ObjectTrackerFixtureFrame(Luma, kWidth, kHeight, 0, 0, kSubjectSize, 1.0, 3, &random);
+	CHECK(!ObjectTrackerProcess(&tracker, Luma));
+	CHECK(!tracker.tracking);
+	CHECK(tracker.confidence < tracker.lostThreshold);
+	ObjectTrackerDestroy(&tracker);
+}
+
+static void testTemplateFollowsConfidentMatches(void)
+{
+	ObjectTrackerState tracker;
+	ObjectTrackerInit(&tracker, kWidth, kHeight, kTemplateSize);
+	uint32_t random = 3;
+	CHECK(StartOnSubject(&tracker, &random));
+	float before = tracker.templateLuma[0];
+
+	// The subject brightens; the correlation does not change, but the template follows it.
+	double x, y;
+	ObjectTrackerFixturePath(0, kWidth, kHeight, kSubjectSize, &x, &y);
+	for (int frame = 0; frame < 64; frame++) {
+		ObjectTrackerFixtureFrame(Luma, kWidth, kHeight, (size_t)x, (size_t)y, kSubjectSize, 1.2, 0, &random);
+		CHECK(ObjectTrackerProcess(&tracker, Luma));
+	}
+	size_t offset = (kSubjectSize - kTemplateSize) / 2;
+	float target = Luma[((size_t)y + offset) * kWidth + (size_t)x + offset];
+	CHECK_NEAR(tracker.templateLuma[0], target, 1.0);
+	CHECK(tracker.templateLuma[0] != before);
+
+	// Without confident matches the template stays.
+	tracker.updateThreshold = 1.1f;
+	float held = tracker.templateLuma[0];
+	ObjectTrackerFixtureFrame(Luma, kWidth, kHeight, (size_t)x, (size_t)y, kSubjectSize, 1.0, 0, &random);
+	CHECK(ObjectTrackerProcess(&tracker, Luma));
+	CHECK(tracker.templateLuma[0] == held);
+	ObjectTrackerDestroy(&tracker);
+}
+
+static void testStartIsKeptWithinFrame(void)
+{
+	ObjectTrackerState tracker;
+	ObjectTrackerInit(&tracker, kWidth, kHeight, kTemplateSize);
+	uint32_t random = 4;
+	ObjectTrackerFixtureFrame(Luma, kWidth, kHeight, 0, 0, kSubjectSize, 1.0, 0, &random);
+	ObjectTrackerStart(&tracker, 0, 0, Luma);
+	CHECK(tracker.templateX == 0);
+	CHECK(tracker.templateY == 0);
+	ObjectTrackerStart(&tracker, 1, 1, Luma);
+	CHECK(tracker.templateX == kWidth - kTemplateSize);
+	CHECK(tracker.templateY == kHeight - kTemplateSize);
+	ObjectTrackerDestroy(&tracker);
+}
+
+static void testInitRejectsTemplateLargerThanFrame(void)
+{
+	ObjectTrackerState tracker;
+	CHECK(!ObjectTrackerInit(&tracker, 8, 32, 16));
+	CHECK(!ObjectTrackerInit(&tracker, 32, 32, 0));
+	ObjectTrackerDestroy(&tracker);
+}
+
+int main(void)
+{
+	RUN(testFollowsMovingSubject);
+	RUN(testFlatAreaIsNotTracked);
+	RUN(testSubjectThatLeavesIsLost);
+	RUN(testTemplateFollowsConfidentMatches);
+	RUN(testStartIsKeptWithinFrame);
+	RUN(testInitRejectsTemplateLargerThanFrame);
+	return TestResult();
+}
@@ -0,0 +1,75 @@
+//
+//  TestSupport.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#ifndef ImageCaptureSample_TestSupport_h
+#define ImageCaptureSample_TestSupport_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * A minimal harness for the plain C parts of the app, so they can be checked
+ * off the device. A test is a function; CHECK records a failure and goes on.
+ */
+
+static int TestFailures = 0;
+
+#define CHECK(condition) do { \
+	if (!(condition)) { \
+		fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+		TestFailures++; \
+	} \
+} while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) do { \
+	double checkActual = (double)(actual); \
+	double checkExpected = (double)(expected); \
+	if (!(checkActual >= checkExpected - (tolerance) && checkActual <= checkExpected + (tolerance))) { \
+		fprintf(stderr, "%s:%d: check failed: %s is %g, expected %g\n", __FILE__, __LINE__, #actual, checkActual, checkExpected); \
+		TestFailures++; \
+	} \
+} while (0)
+
+#define RUN(test) do { \
+	int failuresBefore = TestFailures; \
+	test(); \
+	printf("%s %s\n", TestFailures == failuresBefore ? "ok  " : "FAIL", #test); \
+} while (0)
+
+/**
+ * Returns 0 if all checks passed, for main to return.
+ */
+static inline int TestResult(void)
+{
+	if (TestFailures > 0) {
+		printf("%d check(s) failed\n", TestFailures);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * A deterministic pseudo random sequence, so runs are repeatable.
+ */
+static inline uint32_t TestRandom(uint32_t *state)
+{
+	*state = *state * 1664525u + 1013904223u;
+	return *state >> 8;
+}
+
+/**
+ * Returns a monotonic time in seconds for the benchmarks.
+ */
+static inline double TestSeconds(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+#endif
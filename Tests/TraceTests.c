@@ -0,0 +1,236 @@
+//
+//  TraceTests.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include <pthread.h>
+#include <string.h>
+#include "TestSupport.h"
+#include "TraceCore.h"
+
+static TraceEventRing Ring;
+static TraceEvent Events[kTraceRingCapacity];
+
+static void ResetRing(void)
+{
+	memset(&Ring, 0, sizeof(Ring));
+}
+
+/**
+ * Returns the text the writer holds, or "" if it holds none.
+ */
+static const char *WrittenText(const TraceWriter *writer)
+{
+	return writer->buffer ? writer->buffer : "";
+}
+
+static void testCopiesEventsInOrder(void)
+{
+	ResetRing();
+	for (int index = 0; index < 10; index++) {
+		TraceEventRingAppend(&Ring, 100 + index, "event", 'i', index);
+	}
+	size_t count = TraceEventRingCopy(&Ring, Events, 0);
+	CHECK(count == 10);
+	for (size_t index = 0; index < count; index++) {
+		CHECK(Events[index].timestamp == 100 + index);
+		CHECK(Events[index].argument == (int64_t)index);
+	}
+}
+
+static void testKeepsLatestWhenFull(void)
+{
+	ResetRing();
+	int total = kTraceRingCapacity * 2 + 5;
+	for (int index = 0; index < total; index++) {
+		TraceEventRingAppend(&Ring, index, "event", 'C', index);
+	}
+	size_t count = TraceEventRingCopy(&Ring, Events, 0);
+	CHECK(count == kTraceRingCapacity - 1);
+	CHECK(Events[0].argument == total - (kTraceRingCapacity - 1));
+	CHECK(Events[count - 1].argument == total - 1);
+}
+
+static void testSkipsEventsBeforeClear(void)
+{
+	ResetRing();
+	for (int index = 0; index < 20; index++) {
+		TraceEventRingAppend(&Ring, index, "event", 'B', 0);
+	}
+	size_t count = TraceEventRingCopy(&Ring, Events, 15);
+	CHECK(count == 5);
+	CHECK(Events[0].timestamp == 15);
+}
+
+static void testRestartHidesEarlierEvents(void)
+{
+	ResetRing();
+	for (int index = 0; index < 20; index++) {
+		TraceEventRingAppend(&Ring, index, "old", 'i', index);
+	}
+	TraceEventRingRestart(&Ring);
+	CHECK(Ring.count == 20);
+	CHECK(TraceEventRingCopy(&Ring, Events, 0) == 0);
+	for (int index = 0; index < 5; index++) {
+		TraceEventRingAppend(&Ring, 100 + index, "new", 'i', index);
+	}
+	size_t count = TraceEventRingCopy(&Ring, Events, 0);
+	CHECK(count == 5);
+	for (size_t index = 0; index < count; index++) {
+		CHECK(strcmp(Events[index].name, "new") == 0);
+		CHECK(Events[index].argument == (int64_t)index);
+	}
+}
+
+static volatile int WriterDone = 0;
+
+static void *WriteEvents(void *context)
+{
+	(void)context;
+	for (int64_t index = 1; index <= 2000000; index++) {
+		// The timestamp and the argument agree in every whole event.
+		TraceEventRingAppend(&Ring, (uint64_t)index, "event", 'C', index);
+	}
+	__sync_synchronize();
+	WriterDone = 1;
+	return NULL;
+}
+
+/**
+ * Appends as WriteEvents does, but hands the ring over to a new thread every so often;
+ * the argument counts from zero again after each handover.
+ */
+static void *WriteEventsWithRestarts(void *context)
+{
+	(void)context;
+	int64_t argument = 0;
+	for (int64_t index = 1; index <= 2000000; index++) {
+		if (index % 5000 == 0) {
+			TraceEventRingRestart(&Ring);
+			argument = 0;
+		}
+		TraceEventRingAppend(&Ring, (uint64_t)index, "event", 'C', argument++);
+	}
+	__sync_synchronize();
+	WriterDone = 1;
+	return NULL;
+}
+
+static void testCopyWhileRestartingSkipsEarlierThreads(void)
+{
+	ResetRing();
+	WriterDone = 0;
+	pthread_t writer;
+	if (pthread_create(&writer, NULL, WriteEventsWithRestarts, NULL) != 0) {
+		CHECK(!"the writer thread could not start");
+		return;
+	}
+	int copies = 0;
+	int mixed = 0;
+	while (!WriterDone) {
+		size_t count = TraceEventRingCopy(&Ring, Events, 0);
+		// Only the events of the latest thread are copied, so they are contiguous and in order.
+		for (size_t index = 1; index < count; index++) {
+			if (Events[index].argument != Events[index - 1].argument + 1 || Events[index].timestamp != Events[index - 1].timestamp + 1) {
+				mixed++;
+			}
+		}
+		copies++;
+	}
+	pthread_join(writer, NULL);
+	CHECK(copies > 0);
+	CHECK(mixed == 0);
+}
+
+static void testCopyWhileWritingHasNoTornEvents(void)
+{
+	ResetRing();
+	WriterDone = 0;
+	pthread_t writer;
+	if (pthread_create(&writer, NULL, WriteEvents, NULL) != 0) {
+		CHECK(!"the writer thread could not start");
+		return;
+	}
+	int copies = 0;
+	int torn = 0;
+	int unordered = 0;
+	while (!WriterDone) {
+		size_t count = TraceEventRingCopy(&Ring, Events, 0);
+		for (size_t index = 0; index < count; index++) {
+			if (Events[index].timestamp != (uint64_t)Events[index].argument) {
+				torn++;
+			}
+			if (index > 0 && Events[index].argument != Events[index - 1].argument + 1) {
+				unordered++;
+			}
+		}
+		copies++;
+	}
+	pthread_join(writer, NULL);
+	CHECK(copies > 0);
+	CHECK(torn == 0);
+	CHECK(unordered == 0);
+}
+
+static void testFormatsEvents(void)
+{
+	TraceWriter writer;
+	TraceWriterInit(&writer);
+	TraceEvent begin = {1000, "liveview.decode", 0, 'B'};
+	TraceWriterAppendEvent(&writer, &begin, 1.5, 42, 7);
+	CHECK(strcmp(WrittenText(&writer), "{\"name\":\"liveview.decode\",\"ph\":\"B\",\"ts\":1.500,\"pid\":42,\"tid\":7}") == 0);
+	TraceWriterDestroy(&writer);
+
+	TraceEvent counter = {1000, "midi.commands", 3, 'C'};
+	TraceWriterAppendEvent(&writer, &counter, 2.0, 42, 7);
+	CHECK(strcmp(WrittenText(&writer), "{\"name\":\"midi.commands\",\"ph\":\"C\",\"ts\":2.000,\"pid\":42,\"tid\":7,\"args\":{\"midi.commands\":3}}") == 0);
+	TraceWriterDestroy(&writer);
+
+	TraceEvent instant = {1000, "midi.action", -2, 'i'};
+	TraceWriterAppendEvent(&writer, &instant, 0.25, 42, 7);
+	CHECK(strcmp(WrittenText(&writer), "{\"name\":\"midi.action\",\"ph\":\"i\",\"ts\":0.250,\"pid\":42,\"tid\":7,\"s\":\"t\",\"args\":{\"value\":-2}}") == 0);
+	TraceWriterDestroy(&writer);
+}
+
+static void testEscapesThreadNames(void)
+{
+	TraceWriter writer;
+	TraceWriterInit(&writer);
+	TraceWriterAppendThreadName(&writer, "com.\"queue\"\\\n", 1, 2);
+	CHECK(strcmp(WrittenText(&writer), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"com.\\\"queue\\\"\\\\\\u000a\"}}") == 0);
+	TraceWriterDestroy(&writer);
+}
+
+static void testWriterGrows(void)
+{
+	TraceWriter writer;
+	TraceWriterInit(&writer);
+	TraceEvent event = {1000, "event", 0, 'E'};
+	size_t single = 0;
+	for (int index = 0; index < 10000; index++) {
+		TraceWriterAppendEvent(&writer, &event, 1.0, 1, 1);
+		if (index == 0) {
+			single = writer.length;
+		}
+	}
+	CHECK(!writer.failed);
+	CHECK(writer.length == single * 10000);
+	CHECK(strlen(WrittenText(&writer)) == writer.length);
+	TraceWriterDestroy(&writer);
+}
+
+int main(void)
+{
+	RUN(testCopiesEventsInOrder);
+	RUN(testKeepsLatestWhenFull);
+	RUN(testSkipsEventsBeforeClear);
+	RUN(testRestartHidesEarlierEvents);
+	RUN(testCopyWhileWritingHasNoTornEvents);
+	RUN(testCopyWhileRestartingSkipsEarlierThreads);
+	RUN(testFormatsEvents);
+	RUN(testEscapesThreadNames);
+	RUN(testWriterGrows);
+	return TestResult();
+}
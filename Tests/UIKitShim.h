@@ -0,0 +1,80 @@
+//
+//  UIKitShim.h
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#ifndef ImageCaptureSample_UIKitShim_h
+#define ImageCaptureSample_UIKitShim_h
+
+#include <math.h>
+
+/*
+ * The few Core Graphics and UIKit definitions the plain C headers of the app use,
+ * with the same layout and values, for building them off the device.
+ * Define SHIM_CGFLOAT_IS_FLOAT to check the 32-bit devices, where CGFloat is float.
+ */
+
+#ifdef SHIM_CGFLOAT_IS_FLOAT
+typedef float CGFloat;
+#else
+typedef double CGFloat;
+#endif
+
+struct CGPoint { CGFloat x; CGFloat y; };
+typedef struct CGPoint CGPoint;
+struct CGSize { CGFloat width; CGFloat height; };
+typedef struct CGSize CGSize;
+struct CGRect { CGPoint origin; CGSize size; };
+typedef struct CGRect CGRect;
+
+static inline CGPoint CGPointMake(CGFloat x, CGFloat y)
+{
+	CGPoint point = { x, y };
+	return point;
+}
+
+static inline CGSize CGSizeMake(CGFloat width, CGFloat height)
+{
+	CGSize size = { width, height };
+	return size;
+}
+
+static inline CGRect CGRectMake(CGFloat x, CGFloat y, CGFloat width, CGFloat height)
+{
+	CGRect rect = { { x, y }, { width, height } };
+	return rect;
+}
+
+static inline CGFloat CGRectGetMaxX(CGRect rect)
+{
+	return rect.origin.x + rect.size.width;
+}
+
+static inline CGFloat CGRectGetMaxY(CGRect rect)
+{
+	return rect.origin.y + rect.size.height;
+}
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#define ABS(a) ((a) < 0 ? -(a) : (a))
+
+typedef enum {
+	UIViewContentModeScaleToFill,
+	UIViewContentModeScaleAspectFit,
+	UIViewContentModeScaleAspectFill,
+	UIViewContentModeRedraw,
+	UIViewContentModeCenter,
+	UIViewContentModeTop,
+	UIViewContentModeBottom,
+	UIViewContentModeLeft,
+	UIViewContentModeRight,
+	UIViewContentModeTopLeft,
+	UIViewContentModeTopRight,
+	UIViewContentModeBottomLeft,
+	UIViewContentModeBottomRight,
+} UIViewContentMode;
+
+#endif
@@ -0,0 +1,295 @@
+//
+//  ZoomControllerTests.c
+//  ImageCaptureSample
+//
+//  Copyright (c) 2014 Olympus Imaging Corporation. All rights reserved.
+//
+
+#include "TestSupport.h"
+#include "ZoomControllerCore.h"
+
+/*
+ * Runs the drive decisions against a simulated lens on a millisecond clock.
+ *
+ * The lens takes a request kArrival seconds after it is issued, and the request
+ * returns kReturn seconds after it is issued. While it moves, the lens reports its
+ * focal length every kReportInterval seconds, and it reports when it stops.
+ */
+
+#define kMinimum 14.0f
+#define kMaximum 42.0f
+#define kNormalSpeed 10.0f
+#define kFastSpeed 25.0f
+#define kArrival 0.04
+#define kReturn 0.08
+#define kReportInterval 0.03
+#define kStep 0.001
+
+typedef enum {
+	LensStopped,
+	LensSpeed,
+	LensTarget,
+} LensMode;
+
+typedef struct {
+	ZoomControllerState controller;
+	double now;
+	float focalLength;
+	LensMode mode;
+	float velocity;
+	float target;
+	bool requestPending;
+	bool requestArrived;
+	ZoomControllerRequest request;
+	double issueTime;
+	bool failRequests;
+	double nextReport;
+	/** The farthest the lens went past the target of a speed drive. */
+	float farthest;
+} Simulation;
+
+static void Start(Simulation *simulation, float focalLength)
+{
+	*simulation = (Simulation){.focalLength = focalLength};
+	ZoomControllerInit(&simulation->controller);
+}
+
+static void Drive(Simulation *simulation)
+{
+	ZoomControllerRequest request = ZoomControllerNextRequest(&simulation->controller, simulation->focalLength, kMinimum, kMaximum);
+	if (request == ZoomControllerRequestNone) {
+		return;
+	}
+	simulation->request = request;
+	simulation->requestPending = true;
+	simulation->requestArrived = false;
+	simulation->issueTime = simulation->now;
+}
+
+static void SetTarget(Simulation *simulation, float focalLength)
+{
+	ZoomControllerSetTarget(&simulation->controller, focalLength, simulation->focalLength, kMinimum, kMaximum);
+	Drive(simulation);
+}
+
+static void ApplyRequest(Simulation *simulation)
+{
+	const ZoomControllerState *controller = &simulation->controller;
+	switch (simulation->request) {
+		case ZoomControllerRequestSpeed:
+			simulation->mode = LensSpeed;
+			simulation->velocity = controller->driveDirection * (controller->driveFast ? kFastSpeed : kNormalSpeed);
+			break;
+		case ZoomControllerRequestTarget:
+			simulation->mode = LensTarget;
+			simulation->target = controller->driveFocalLength;
+			break;
+		case ZoomControllerRequestStop:
+			simulation->mode = LensStopped;
+			break;
+		case ZoomControllerRequestNone:
+			break;
+	}
+	simulation->nextReport = simulation->now + kReportInterval;
+}
+
+/**
+ * Moves the lens one step; returns true if it stopped on its own.
+ */
+static bool MoveLens(Simulation *simulation)
+{
+	if (simulation->mode == LensSpeed) {
+		simulation->focalLength += simulation->velocity * (float)kStep;
+		if (simulation->focalLength <= kMinimum || simulation->focalLength >= kMaximum) {
+			simulation->focalLength = fmaxf(kMinimum, fminf(simulation->focalLength, kMaximum));
+			simulation->mode = LensStopped;
+			return true;
+		}
+	} else if (simulation->mode == LensTarget) {
+		float distance = simulation->target - simulation->focalLength;
+		float step = kNormalSpeed * (float)kStep;
+		if (fabsf(distance) <= step) {
+			simulation->focalLength = simulation->target;
+			simulation->mode = LensStopped;
+			return true;
+		}
+		simulation->focalLength += (distance > 0) ? step : -step;
+	}
+	return false;
+}
+
+static void Run(Simulation *simulation, double seconds)
+{
+	double end = simulation->now + seconds;
+	while (simulation->now < end) {
+		simulation->now += kStep;
+		bool wasMoving = (simulation->mode != LensStopped);
+		if (simulation->requestPending && !simulation->requestArrived && simulation->now >= simulation->issueTime + kArrival) {
+			simulation->requestArrived = true;
+			if (!simulation->failRequests) {
+				ApplyRequest(simulation);
+			}
+		}
+		bool stoppedByItself = MoveLens(simulation);
+		bool moving = (simulation->mode != LensStopped);
+		if (simulation->controller.targetFocalLength > 0) {
+			float overshoot = (simulation->focalLength - simulation->controller.targetFocalLength) * (float)simulation->controller.driveDirection;
+			simulation->farthest = fmaxf(simulation->farthest, overshoot);
+		}
+		if ((moving && simulation->now >= simulation->nextReport) || (wasMoving && !moving)) {
+			ZoomControllerObserveFocalLength(&simulation->controller, simulation->focalLength, simulation->now);
+			simulation->nextReport = simulation->now + kReportInterval;
+			Drive(simulation);
+		}
+		if ((stoppedByItself || (wasMoving && !moving)) && ZoomControllerObserveStop(&simulation->controller)) {
+			Drive(simulation);
+		}
+		if (simulation->requestPending && simulation->now >= simulation->issueTime + kReturn) {
+			simulation->requestPending = false;
+			ZoomControllerFinishRequest(&simulation->controller, !simulation->failRequests, kReturn, simulation->mode != LensStopped);
+			if (!simulation->failRequests) {
+				Drive(simulation);
+			}
+		}
+	}
+}
+
+static void testLongMoveDrivesBySpeedAndSettles(void)
+{
+	Simulation simulation;
+	Start(&simulation, kMinimum);
+	SetTarget(&simulation, 40);
+	CHECK(simulation.request == ZoomControllerRequestSpeed);
+	CHECK(simulation.controller.driveFast);
+	Run(&simulation, 3);
+	CHECK_NEAR(simulation.focalLength, 40, simulation.controller.tolerance);
+	CHECK(!simulation.controller.hasTarget);
+	CHECK(simulation.controller.driveState == ZoomControllerDriveStateIdle);
+	// A speed drive, its stop and at most one correction.
+	CHECK(simulation.controller.roundTrips <= 3);
+	// Stopping early by the latency keeps the lens from running past the target.
+	CHECK(simulation.farthest <= simulation.controller.tolerance);
+}
+
+static void testShortMoveDrivesToFocalLength(void)
+{
+	Simulation simulation;
+	Start(&simulation, 20);
+	SetTarget(&simulation, 24);
+	CHECK(simulation.request == ZoomControllerRequestTarget);
+	Run(&simulation, 1);
+	CHECK_NEAR(simulation.focalLength, 24, 1e-3);
+	CHECK(simulation.controller.roundTrips == 1);
+	CHECK(simulation.controller.driveState == ZoomControllerDriveStateIdle);
+}
+
+static void testFaderSweepCoalesces(void)
+{
+	Simulation simulation;
+	Start(&simulation, kMinimum);
+	for (unsigned value = 0; value <= 127; value++) {
+		SetTarget(&simulation, ZoomControllerFocalLengthForValue(value, false, 0, 0, kMinimum, kMaximum));
+		Run(&simulation, 0.002);
+	}
+	Run(&simulation, 3);
+	// The 128 values of the sweep cost a handful of requests.
+	CHECK_NEAR(simulation.focalLength, kMaximum, simulation.controller.tolerance);
+	CHECK(simulation.controller.coalescedTargets >= 120);
+	CHECK(simulation.controller.roundTrips <= 6);
+}
+
+static void testNewTargetStopsTargetDrive(void)
+{
+	Simulation simulation;
+	Start(&simulation, 20);
+	SetTarget(&simulation, 26);
+	Run(&simulation, 0.1);
+	SetTarget(&simulation, 24);
+	Run(&simulation, 2);
+	CHECK_NEAR(simulation.focalLength, 24, simulation.controller.tolerance);
+	CHECK(simulation.controller.roundTrips >= 3);
+	CHECK(simulation.controller.coalescedTargets == 1);
+}
+
+static void testDropTargetStopsSpeedDrive(void)
+{
+	Simulation simulation;
+	Start(&simulation, kMinimum);
+	SetTarget(&simulation, kMaximum);
+	Run(&simulation, 0.3);
+	ZoomControllerDropTarget(&simulation.controller);
+	Drive(&simulation);
+	float dropped = simulation.focalLength;
+	Run(&simulation, 1);
+	CHECK(simulation.mode == LensStopped);
+	CHECK(simulation.controller.driveState == ZoomControllerDriveStateIdle);
+	CHECK(simulation.controller.roundTrips == 2);
+	CHECK(simulation.focalLength < dropped + kFastSpeed * kArrival + 0.1f);
+}
+
+static void testFailedRequestDropsTarget(void)
+{
+	Simulation simulation;
+	Start(&simulation, 20);
+	simulation.failRequests = true;
+	SetTarget(&simulation, 30);
+	Run(&simulation, 1);
+	CHECK(!simulation.controller.hasTarget);
+	CHECK(simulation.controller.trackingError == 0);
+	CHECK(simulation.controller.driveState == ZoomControllerDriveStateIdle);
+	CHECK(simulation.controller.roundTrips == 1);
+	CHECK(simulation.focalLength == 20);
+}
+
+static void testDriveEndingBeforeItsRequestReturns(void)
+{
+	Simulation simulation;
+	Start(&simulation, 20);
+	simulation.controller.tolerance = 0.1f;
+	SetTarget(&simulation, 20.2f);
+	Run(&simulation, 1);
+	CHECK_NEAR(simulation.focalLength, 20.2, 1e-3);
+	CHECK(simulation.controller.driveState == ZoomControllerDriveStateIdle);
+	CHECK(simulation.controller.roundTrips == 1);
+}
+
+static void testTargetIsClipped(void)
+{
+	Simulation simulation;
+	Start(&simulation, 20);
+	SetTarget(&simulation, 100);
+	CHECK(simulation.controller.targetFocalLength == kMaximum);
+	ZoomControllerState controller;
+	ZoomControllerInit(&controller);
+	ZoomControllerSetTarget(&controller, 20, 20, 30, 30);
+	CHECK(!controller.hasTarget);
+}
+
+static void testFocalLengthForValue(void)
+{
+	CHECK_NEAR(ZoomControllerFocalLengthForValue(0, false, 0, 0, kMinimum, kMaximum), kMinimum, 1e-4);
+	CHECK_NEAR(ZoomControllerFocalLengthForValue(127, false, 0, 0, kMinimum, kMaximum), kMaximum, 1e-4);
+	CHECK_NEAR(ZoomControllerFocalLengthForValue(200, false, 0, 0, kMinimum, kMaximum), kMaximum, 1e-4);
+	// Positions are even in ratio, so the middle is the geometric mean.
+	float middle = ZoomControllerFocalLengthForValue(127, false, 0, 0, 10, 40);
+	CHECK_NEAR(ZoomControllerFocalLengthForValue(64, false, 0, 0, 10, 40) * ZoomControllerFocalLengthForValue(63, false, 0, 0, 10, 40), middle * 10, 0.5);
+	CHECK(isnan(ZoomControllerFocalLengthForValue(0, true, 20, 1.02f, kMinimum, kMaximum)));
+	CHECK(isnan(ZoomControllerFocalLengthForValue(64, true, 20, 1.02f, kMinimum, kMaximum)));
+	CHECK_NEAR(ZoomControllerFocalLengthForValue(1, true, 20, 1.02f, kMinimum, kMaximum), 20.4, 1e-4);
+	CHECK_NEAR(ZoomControllerFocalLengthForValue(127, true, 20, 1.02f, kMinimum, kMaximum), 20 / 1.02, 1e-4);
+	CHECK_NEAR(ZoomControllerFocalLengthForValue(62, true, 20, 1.02f, kMinimum, kMaximum), 20 * pow(1.02, 62), 1e-3);
+}
+
+int main(void)
+{
+	RUN(testLongMoveDrivesBySpeedAndSettles);
+	RUN(testShortMoveDrivesToFocalLength);
+	RUN(testFaderSweepCoalesces);
+	RUN(testNewTargetStopsTargetDrive);
+	RUN(testDropTargetStopsSpeedDrive);
+	RUN(testFailedRequestDropsTarget);
+	RUN(testDriveEndingBeforeItsRequestReturns);
+	RUN(testTargetIsClipped);
+	RUN(testFocalLengthForValue);
+	return TestResult();
+}